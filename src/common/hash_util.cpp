@@ -0,0 +1,15 @@
+#include "hash_util.h"
+
+namespace pmkutil
+{
+	uint64_t HashBytes(const void* data, size_t size, uint64_t hash)
+	{
+		const uint8_t* bytes{ static_cast<const uint8_t*>(data) };
+		for (size_t i{ 0 }; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pmkutil
+{
+	// Incrementally hash bytes with 64 bit FNV-1a.
+	uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+}
@@ -5,6 +5,8 @@
 #include <fstream>
 #include <unordered_set>
 #include <algorithm>
+#include <thread>
+#include <cstring>
 #include "imgui.h"
 #include "glm/gtx/vector_angle.hpp"
 #include "glm/gtx/quaternion.hpp"
@@ -12,6 +14,7 @@
 
 #include "user_shader_util.h"
 #include "gui.h"
+#include "particle_gen_cpu.h"
 
 #undef max
 #undef min
@@ -425,6 +428,8 @@ void Editor::NewProject(const std::filesystem::path& proj_dir)
 {
 	std::filesystem::create_directories(proj_dir / ASSETS_RELATIVE_PATH); // Make the directory if it doesn't exist.
 	project_directory_ = proj_dir;
+	pumpkin_->SetParticleGenCacheDirectory(project_directory_ / PROJECT_DATA_RELATIVE_PATH / PARTICLE_GEN_CACHE_RELATIVE_PATH, PARTICLE_GEN_CACHE_MAX_SIZE);
+	shader_cache_.Initialize(project_directory_ / PROJECT_DATA_RELATIVE_PATH / SHADER_CACHE_RELATIVE_PATH, SHADER_CACHE_MAX_SIZE);
 	SaveProject(); // Save so the empty project can be loaded again if user doesn't ever save this project.
 }
 
@@ -436,6 +441,8 @@ ProjectLoadGuiInfo Editor::LoadProject(const std::filesystem::path& proj_dir)
 
 	project_directory_ = proj_dir;
 	auto project_data_path{ project_directory_ / PROJECT_DATA_RELATIVE_PATH };
+	pumpkin_->SetParticleGenCacheDirectory(project_data_path / PARTICLE_GEN_CACHE_RELATIVE_PATH, PARTICLE_GEN_CACHE_MAX_SIZE);
+	shader_cache_.Initialize(project_data_path / SHADER_CACHE_RELATIVE_PATH, SHADER_CACHE_MAX_SIZE);
 	std::ifstream f(project_data_path / PROJECT_DATA_JSON_NAME);
 	nlohmann::json j{ nlohmann::json::parse(f) };
 
@@ -500,12 +507,38 @@ ProjectLoadGuiInfo Editor::LoadProject(const std::filesystem::path& proj_dir)
 		particle_node_ = node_map_[particle_node_id];
 	}
 
-	for (auto& json_shader : j[jsonkey::SHADERS])
+	// Only shaders whose source or includes changed since they were last compiled are recompiled, in parallel.
+	std::vector<std::filesystem::path> glsl_paths{};
+	for (auto& json_shader : j[jsonkey::SHADERS]) {
+		glsl_paths.push_back(std::string{ json_shader[jsonkey::GLSL_PATH] });
+	}
+	std::vector<CompiledShader> compiled_shaders{ shader_cache_.Compile(glsl_paths) };
+
+	std::vector<std::filesystem::path> spirv_paths{};
+	for (uint32_t i{ 0 }; i < (uint32_t)compiled_shaders.size(); ++i)
 	{
-		std::string spirv_path{ json_shader[jsonkey::SPIRV_PATH] };
-		pumpkin_->ImportShader(std::filesystem::path{ spirv_path });
-		shaders_.push_back(new EditorShader{ json_shader });
+		nlohmann::json& json_shader{ j[jsonkey::SHADERS][i] };
+
+		// If the source no longer compiles, fall back to cached SPIR-V along with the UBO layout it was compiled with,
+		// since the layout parsed from the broken source may not match it.
+		if (!compiled_shaders[i].succeeded)
+		{
+			std::filesystem::path saved_spirv_path{ std::string{ json_shader[jsonkey::SPIRV_PATH] } };
+			if (shader_cache_.FindFallback(glsl_paths[i], saved_spirv_path, &compiled_shaders[i])) {
+				logger::Error("Failed to compile %s, using its last cached SPIR-V.\n", glsl_paths[i].string().c_str());
+			}
+			else
+			{
+				// Nothing is cached for projects saved without the cache, so only the SPIR-V is known.
+				logger::Error("Failed to compile %s, using the SPIR-V it was saved with. Its UBO layout may not match.\n", glsl_paths[i].string().c_str());
+				compiled_shaders[i].spirv_path = saved_spirv_path;
+			}
+		}
+
+		spirv_paths.push_back(compiled_shaders[i].spirv_path);
+		shaders_.push_back(new EditorShader{ json_shader, compiled_shaders[i] });
 	}
+	pumpkin_->ImportShaders(spirv_paths);
 
 	ProjectLoadGuiInfo gui_info{};
 
@@ -995,11 +1028,11 @@ EditorTexture* Editor::GetTexture(uint32_t texture_index)
 
 uint32_t Editor::ImportShader(const std::filesystem::path& shader_path)
 {
-	std::filesystem::path spirv_path{};
-	if (CompileShader(shader_path, &spirv_path))
+	CompiledShader compiled{ shader_cache_.Compile({ shader_path })[0] };
+	if (compiled.succeeded)
 	{
-		pumpkin_->ImportShader(spirv_path);
-		EditorShader* shader{ new EditorShader{shader_path, spirv_path, shader_path.filename().string()} };
+		pumpkin_->ImportShader(compiled.spirv_path);
+		EditorShader* shader{ new EditorShader{shader_path, compiled, shader_path.filename().string()} };
 		shaders_.push_back(shader);
 		return (uint32_t)(shaders_.size() - 1);
 	}
@@ -1036,6 +1069,31 @@ uint32_t Editor::UpdateParticleGenShaderCustomUBO()
 	return GenerateVoxels();
 }
 
+void Editor::ValidateParticleGenKernel()
+{
+	particle_gen_kernel_mismatch_count_ = NULL_INDEX;
+	if (particle_gen_shader_idx_ == NULL_INDEX) {
+		return;
+	}
+
+	// The CPU kernels are ports of the sample game's particle gen shaders, so pick the kernel by shader file name.
+	const std::string shader_name{ shaders_[particle_gen_shader_idx_]->GetGlslPath().filename().string() };
+	renderer::ParticleGenKernel kernel{ nullptr };
+	if (shader_name == "rb.comp") {
+		kernel = renderer::SphereProductKernel;
+	}
+	else if (shader_name == "particle_gen_cube.comp") {
+		kernel = renderer::BoxFillKernel;
+	}
+	else
+	{
+		logger::Error("No CPU kernel for particle gen shader %s\n", shader_name.c_str());
+		return;
+	}
+
+	particle_gen_kernel_mismatch_count_ = pumpkin_->ValidateParticleGenKernel(kernel, shaders_[particle_gen_shader_idx_]->GetCustomUniformBuffer().GetBuffer());
+}
+
 glm::vec2 Editor::WorldToScreenSpace(const glm::vec3& world_pos) const
 {
 	const renderer::Extent& viewport_extent{ gui_.GetViewportExtent() };
@@ -1294,6 +1352,37 @@ void Editor::UpdateRigidBodyOverlayEnabled()
 	pumpkin_->SetRigidBodyOverlayEnabled(show_rigid_body_normals_);
 }
 
+void Editor::UpdateFluidSurfaceEnabled()
+{
+	pumpkin_->SetFluidSurfaceEnabled(fluid_surface_enabled_);
+}
+
+void Editor::UpdateChunkStreamingEnabled()
+{
+	if (!chunk_streaming_enabled_)
+	{
+		pumpkin_->DisableChunkStreaming();
+		return;
+	}
+
+	const pmk::ChunkStreamingSettings settings{
+		.load_radius = 3.0f,
+		.unload_radius = 4.0f,
+		.memory_budget = 256ull * 1024 * 1024,
+		.worker_count = std::max(std::thread::hardware_concurrency() / 2, 1u),
+		.max_integrations_per_update = 4,
+		.cache_directory = project_directory_ / PROJECT_DATA_RELATIVE_PATH / CHUNK_CACHE_RELATIVE_PATH,
+	};
+
+	const renderer::SphereProductParameters parameters{ .radius = 300.0f, .center = { 32.0f, 40.0f, 32.0f } };
+	std::vector<std::byte> custom_ubo(sizeof(parameters));
+	std::memcpy(custom_ubo.data(), &parameters, sizeof(parameters));
+
+	pumpkin_->EnableChunkStreaming(settings, [custom_ubo](const glm::ivec3& chunk_coord) {
+		return renderer::GenerateKernelChunk(renderer::SphereProductKernel, chunk_coord, custom_ubo);
+		});
+}
+
 EditorNode* Editor::CreateNode(pmk::Node* pmk_node, const std::string& name)
 {
 	EditorNode* editor_node{ new EditorNode{ pmk_node, name } };
@@ -1437,28 +1526,24 @@ char* EditorTexture::GetNameBuffer() const
 	return name_buffer_;
 }
 
-EditorShader::EditorShader(const std::filesystem::path& glsl_path, const std::filesystem::path& spirv_path, const std::string& name)
+EditorShader::EditorShader(const std::filesystem::path& glsl_path, const CompiledShader& compiled, const std::string& name)
 	: custom_ubo_{}
 	, glsl_path_{ glsl_path }
-	, spirv_path_{ spirv_path }
+	, spirv_path_{ compiled.spirv_path }
 	, name_buffer_{ new char[NAME_BUFFER_SIZE] {} }
 {
-	ShaderParser parser{};
-	parser.Parse(glsl_path);
-	custom_ubo_ = parser.GetUniformBuffer();
+	custom_ubo_.Initialize(compiled.ubo_members);
 
 	strcpy_s(name_buffer_, std::min(NAME_BUFFER_SIZE, (uint32_t)(name.size() + 1)), name.c_str());
 }
 
-EditorShader::EditorShader(nlohmann::json& j)
+EditorShader::EditorShader(nlohmann::json& j, const CompiledShader& compiled)
 	: custom_ubo_{}
 	, glsl_path_{ std::string{j[jsonkey::GLSL_PATH]} }
-	, spirv_path_{ std::string{j[jsonkey::SPIRV_PATH]} }
+	, spirv_path_{ compiled.spirv_path }
 	, name_buffer_{ new char[NAME_BUFFER_SIZE] {} }
 {
-	ShaderParser parser{};
-	parser.Parse(glsl_path_);
-	custom_ubo_ = parser.GetUniformBuffer();
+	custom_ubo_.Initialize(compiled.ubo_members);
 
 	uint32_t buffer_offset{ 0 };
 	std::byte* buffer{ custom_ubo_.GetBuffer().data() };
@@ -1534,6 +1619,11 @@ char* EditorShader::GetNameBuffer() const
 	return name_buffer_;
 }
 
+const std::filesystem::path& EditorShader::GetGlslPath() const
+{
+	return glsl_path_;
+}
+
 UniformBuffer& EditorShader::GetCustomUniformBuffer()
 {
 	return custom_ubo_;
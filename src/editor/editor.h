@@ -25,6 +25,12 @@ const std::filesystem::path SETTINGS_DEFAULT_LAYOUT_NAME{ "default_imgui_layout.
 const std::filesystem::path VERTEX_DATA_FILE_NAME{ "vertex_data.bin" };
 const std::filesystem::path INDEX_DATA_FILE_NAME{ "index_data.bin" };
 const std::filesystem::path TEXTURE_DATA_FILE_NAME{ "texture_data.bin" };
+const std::filesystem::path PARTICLE_GEN_CACHE_RELATIVE_PATH{ "particle_gen_cache" };
+const std::filesystem::path SHADER_CACHE_RELATIVE_PATH{ "shader_cache" };
+const std::filesystem::path CHUNK_CACHE_RELATIVE_PATH{ "chunk_cache" };
+
+constexpr uint64_t PARTICLE_GEN_CACHE_MAX_SIZE{ 512ull * 1024 * 1024 }; // In bytes.
+constexpr uint64_t SHADER_CACHE_MAX_SIZE{ 64ull * 1024 * 1024 };        // In bytes.
 
 enum class TransformType {
 	NONE,
@@ -144,14 +150,17 @@ private:
 class EditorShader
 {
 public:
-	EditorShader(const std::filesystem::path& glsl_path, const std::filesystem::path& spirv_path, const std::string& name);
+	EditorShader(const std::filesystem::path& glsl_path, const CompiledShader& compiled, const std::string& name);
 
-	EditorShader(nlohmann::json& j);
+	// Takes the SPIR-V path and UBO layout from compiled, since the shader is recompiled if it changed since the project was saved.
+	EditorShader(nlohmann::json& j, const CompiledShader& compiled);
 
 	~EditorShader();
 
 	char* GetNameBuffer() const;
 
+	const std::filesystem::path& GetGlslPath() const;
+
 	UniformBuffer& GetCustomUniformBuffer();
 
 	nlohmann::json ToJson() const;
@@ -427,6 +436,14 @@ private:
 
 	void UpdateRigidBodyOverlayEnabled();
 
+	void UpdateFluidSurfaceEnabled();
+
+	// Compare the CPU kernel matching the particle gen shader against the shader's output for its current custom UBO.
+	void ValidateParticleGenKernel();
+
+	// Stream chunks around the camera, filled by the sphere product CPU kernel. Used to profile streaming without a scene.
+	void UpdateChunkStreamingEnabled();
+
 	EditorNode* CreateNode(pmk::Node* pmk_node, const std::string& name);
 
 	EditorNode* CreateNode(const std::string& name);
@@ -446,6 +463,7 @@ private:
 	std::vector<EditorConstraint*> constraints_{};            // List of XPBD constraints in same order as Pumpkin's XPBD constraints list, so constraint index is valid here too.
 	std::vector<EditorTexture*> textures_{};                  // List of EditorTextures in same order as the renderer's texture list, so texture index is valid here too.
 	std::vector<EditorShader*> shaders_{};                    // List of EditorShaders, containing path to SPIRV files to be passed to renderer.
+	ShaderCache shader_cache_{};                              // Compiled user shaders of the project, so they're only recompiled when their source changes.
 
 	std::filesystem::path project_directory_{};                  // The root directory of the user's project.
 	std::filesystem::path active_selection_file_{};              // The actively selected file.
@@ -457,9 +475,12 @@ private:
 
 	EditorNode* particle_node_{};
 	uint32_t particle_gen_shader_idx_{ NULL_INDEX };
+	uint32_t particle_gen_kernel_mismatch_count_{ NULL_INDEX }; // Result of the last ValidateParticleGenKernel, or NULL_INDEX if it couldn't run.
 	bool show_particle_grid_{};
 	bool use_particle_depth_{};
 	bool show_rigid_body_normals_{};
+	bool fluid_surface_enabled_{};
+	bool chunk_streaming_enabled_{};
 	ParticleColorMode particle_color_mode_{};
 	float particle_color_max_value_{ 1.0f };
 	float node_color_max_value_{ 0.05f };
@@ -440,24 +440,35 @@ void EditorGui::NodeProperties()
 
 		ImGui::Text("Position");
 		ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-		ImGui::DragFloat3("##Position", glm::value_ptr(active_node->node->position), 0.1f);
+		if (ImGui::DragFloat3("##Position", glm::value_ptr(active_node->node->position), 0.1f)) {
+			active_node->node->transform_edited = true;
+		}
 
 		ImGui::Text("Scale");
 		ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-		ImGui::DragFloat3("##Scale", glm::value_ptr(active_node->node->scale), 0.1f);
+		if (ImGui::DragFloat3("##Scale", glm::value_ptr(active_node->node->scale), 0.1f)) {
+			active_node->node->transform_edited = true;
+		}
 
 		auto& rot{ active_node->node->rotation };
 		ImGui::Text("Rotation");
 		ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-		ImGui::Text("%.2f  %.2f  %.2f  %.2f", rot.x, rot.y, rot.z, rot.w);
+		if (ImGui::DragFloat4("##Rotation", glm::value_ptr(rot), 0.01f))
+		{
+			rot = glm::normalize(rot);
+			active_node->node->transform_edited = true;
+		}
 		ImGui::Dummy(ImVec2{ 0.0f, 20.0f }); // Spacing.
 
 		RenderMaterials(active_node);
 
 		// Rigid body gui.
-		pmk::RigidBody* rb{ active_node->node->rigid_body };
-		if (rb)
+		pmk::RigidBodyArena& rb_arena{ editor_->pumpkin_->GetScene().GetRigidBodyArena() };
+		uint32_t rb_idx{ rb_arena.DenseIndex(active_node->node->rigid_body) };
+		if (rb_idx != NULL_INDEX)
 		{
+			pmk::RigidBody& rb{ rb_arena.Body(rb_idx) };
+
 			ImGui::Dummy(ImVec2{ 0.0f, 20.0f }); // Spacing.
 			ImGui::Separator();
 			ImGui::Dummy(ImVec2{ 0.0f, 20.0f }); // Spacing.
@@ -466,19 +477,31 @@ void EditorGui::NodeProperties()
 
 			ImGui::Text("Immovable");
 			ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-			ImGui::Checkbox("##Immovable", &rb->immovable);
+			if (ImGui::Checkbox("##Immovable", &rb.immovable))
+			{
+				rb_arena.UpdateMassProperties(rb_idx);
+				rb_arena.Wake(rb_idx);
+			}
 
 			ImGui::Text("Mass");
 			ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-			ImGui::DragFloat("##RigidBodyMass", &rb->mass, 0.01f);
+			if (ImGui::DragFloat("##RigidBodyMass", &rb.mass, 0.01f))
+			{
+				rb_arena.UpdateMassProperties(rb_idx);
+				rb_arena.Wake(rb_idx);
+			}
 
 			ImGui::Text("Velocity");
 			ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-			ImGui::DragFloat3("##Velocity", glm::value_ptr(rb->velocity), 0.1f);
+			if (ImGui::DragFloat3("##Velocity", glm::value_ptr(rb_arena.velocities[rb_idx]), 0.1f)) {
+				rb_arena.Wake(rb_idx);
+			}
 
 			ImGui::Text("Angular vel");
 			ImGui::SameLine(NODE_PROPERTY_ALIGNMENT);
-			ImGui::DragFloat3("##AngularVelocity", glm::value_ptr(rb->angular_velocity), 0.1f);
+			if (ImGui::DragFloat3("##AngularVelocity", glm::value_ptr(rb_arena.angular_velocities[rb_idx]), 0.1f)) {
+				rb_arena.Wake(rb_idx);
+			}
 
 			ImGui::Dummy(ImVec2{ 0.0f, 20.0f }); // Spacing.
 			ImGui::Text("Debug rendering");
@@ -1170,6 +1193,18 @@ void EditorGui::VoxelEditor()
 		editor_->UpdateRigidBodyOverlayEnabled();
 	}
 
+	ImGui::Text("Fluid surface");
+	ImGui::SameLine(SHADER_PROPERTY_ALIGNMENT);
+	if (ImGui::Checkbox("##FluidSurface", &editor_->fluid_surface_enabled_)) {
+		editor_->UpdateFluidSurfaceEnabled();
+	}
+
+	ImGui::Text("Stream chunks");
+	ImGui::SameLine(SHADER_PROPERTY_ALIGNMENT);
+	if (ImGui::Checkbox("##StreamChunks", &editor_->chunk_streaming_enabled_)) {
+		editor_->UpdateChunkStreamingEnabled();
+	}
+
 	ImGui::End();
 }
 
@@ -1198,6 +1233,33 @@ void EditorGui::Debug()
 	ImGui::Text("%.3f ms", frame_milliseconds);
 	ImGui::Text("%.1f fps", fps_);
 
+	const renderer::RasterPassStats& raster_stats{ editor_->pumpkin_->GetRasterPassStats() };
+	ImGui::Text("%u raster draws in %u draw calls, %u binds", raster_stats.draw_count, raster_stats.draw_call_count, raster_stats.bind_count);
+
+	const renderer::TlasBuildStats& tlas_stats{ editor_->pumpkin_->GetTlasBuildStats() };
+	ImGui::Text("TLAS %s with %u instances, %u written", tlas_stats.refit ? "refit" : "rebuilt", tlas_stats.instance_count, tlas_stats.written_instance_count);
+	ImGui::Text("%.3f ms TLAS build", tlas_stats.build_time_ms);
+
+	const pmk::RigidBodySleepStats& sleep_stats{ editor_->pumpkin_->GetScene().GetRigidBodySleepStats() };
+	ImGui::Text("%u rigid bodies sleeping, %u awake", sleep_stats.sleeping_count, sleep_stats.awake_count);
+	ImGui::Text("%u rigid body islands", sleep_stats.island_count);
+	ImGui::Text("%u rigid body pair tests skipped", sleep_stats.skipped_pair_count);
+
+	if (editor_->chunk_streaming_enabled_)
+	{
+		const pmk::ChunkStreamingStats& streaming_stats{ editor_->pumpkin_->GetChunkStreamingStats() };
+		ImGui::Text("%u chunks resident, %.1f MB", streaming_stats.resident_count, streaming_stats.resident_bytes / (1024.0f * 1024.0f));
+		ImGui::Text("%u chunks loading, %u evicted", streaming_stats.pending_count, streaming_stats.evicted_count);
+		ImGui::Text("%.3f ms worst chunk streaming update", streaming_stats.worst_update_time * 1000.0f);
+	}
+
+	if (ImGui::Button("Validate CPU particle gen kernel")) {
+		editor_->ValidateParticleGenKernel();
+	}
+	if (editor_->particle_gen_kernel_mismatch_count_ != NULL_INDEX) {
+		ImGui::Text("%u voxels differ from the particle gen shader", editor_->particle_gen_kernel_mismatch_count_);
+	}
+
 	ImGui::End();
 }
 
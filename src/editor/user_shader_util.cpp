@@ -4,11 +4,31 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <chrono>
+#include <functional>
 #include "glm/glm.hpp"
 #include "imgui.h"
 
 #include "string_util.h"
 #include "logger.h"
+#include "hash_util.h"
+
+const std::string GLSLANG_OPTIONS{ "--target-env spirv1.6" }; // Part of the shader cache key, so changing options recompiles.
+const std::string SHADER_CACHE_SPIRV_EXTENSION{ ".spv" };
+const std::string SHADER_CACHE_UBO_EXTENSION{ ".json" };
+
+namespace jsonkey
+{
+	const std::string MEMBER_SIZE{ "size" };
+	const std::string MEMBER_OFFSET{ "offset" };
+	const std::string MEMBER_ARRAY_COUNT{ "array_count" };
+	const std::string SHADER_CACHE_SOURCE{ "source" };
+	const std::string SHADER_CACHE_UBO{ "ubo" };
+}
 
 void ShaderParser::Parse(const std::filesystem::path& shader_path)
 {
@@ -194,14 +214,12 @@ void ShaderParser::ParseUniformBufferBody(const std::string& ubo_body)
 	uniform_buffer_.Initialize(member_variables);
 }
 
-bool CompileShader(const std::filesystem::path& shader_path, std::filesystem::path* out_spirv_path)
+bool CompileShader(const std::filesystem::path& shader_path, const std::filesystem::path& spirv_path)
 {
 	const std::filesystem::path vulkan_sdk_path{ getenv("VULKAN_SDK") };
 	const std::filesystem::path glsl_validator{ vulkan_sdk_path / "Bin/glslangValidator.exe" };
-	const std::filesystem::path spirv_path{ shader_path.parent_path() / (shader_path.filename().string() + ".spv") };
-	*out_spirv_path = spirv_path;
 
-	const std::string command_line{ glsl_validator.string() + " -V " + shader_path.string() + " -o " + spirv_path.string() + " --target-env spirv1.6" };
+	const std::string command_line{ glsl_validator.string() + " -V " + shader_path.string() + " -o " + spirv_path.string() + " " + GLSLANG_OPTIONS };
 	bool compilation_succeeded{ true };
 
 	// Attempt to compile shader.
@@ -240,6 +258,346 @@ bool CompileShader(const std::filesystem::path& shader_path, std::filesystem::pa
 	return compilation_succeeded;
 }
 
+// Hash a shader's source and, recursively, every file it includes. Includes resolve relative to the including file,
+// the same as glslangValidator does without -I.
+static uint64_t HashShaderSource(const std::filesystem::path& shader_path, std::unordered_set<std::string>* visited, uint64_t hash)
+{
+	std::string canonical{ std::filesystem::weakly_canonical(shader_path).string() };
+	if (!visited->insert(canonical).second) {
+		return hash;
+	}
+
+	std::ifstream file{ shader_path, std::ios::binary };
+	std::stringstream source{};
+	source << file.rdbuf();
+	std::string text{ source.str() };
+
+	// Hash the path too, so a missing include still changes the key once it's created.
+	hash = pmkutil::HashBytes(canonical.data(), canonical.size(), hash);
+	hash = pmkutil::HashBytes(text.data(), text.size(), hash);
+
+	std::istringstream lines{ text };
+	std::string line{};
+	while (std::getline(lines, line))
+	{
+		size_t directive_idx{ line.find("#include") };
+		if (directive_idx == std::string::npos || line.find_first_not_of(" \t") != directive_idx) {
+			continue;
+		}
+
+		size_t open_idx{ line.find_first_of("\"<", directive_idx) };
+		size_t close_idx{ open_idx == std::string::npos ? std::string::npos : line.find_first_of("\">", open_idx + 1) };
+		if (close_idx != std::string::npos) {
+			hash = HashShaderSource(shader_path.parent_path() / line.substr(open_idx + 1, close_idx - open_idx - 1), visited, hash);
+		}
+	}
+
+	return hash;
+}
+
+// Read the UBO layout of a cache entry, and the canonical path of the shader it was compiled from.
+static bool ReadCacheEntry(const std::filesystem::path& ubo_path, std::string* out_source, std::vector<MemberVariable>* out_members)
+{
+	std::ifstream ubo_file{ ubo_path };
+	if (!ubo_file.is_open()) {
+		return false;
+	}
+
+	nlohmann::json j = nlohmann::json::parse(ubo_file, nullptr, false); // Brace initializing would wrap it in an array.
+	if (!j.is_object() || !j[jsonkey::SHADER_CACHE_SOURCE].is_string() || !j[jsonkey::SHADER_CACHE_UBO].is_array()) {
+		return false;
+	}
+
+	*out_source = j[jsonkey::SHADER_CACHE_SOURCE].get<std::string>();
+	out_members->clear();
+	for (const nlohmann::json& member_json : j[jsonkey::SHADER_CACHE_UBO])
+	{
+		out_members->push_back(MemberVariable{
+			.name = member_json[jsonkey::MEMBER_NAME].get<std::string>(),
+			.type = (MemberType)member_json[jsonkey::MEMBER_TYPE].get<uint32_t>(),
+			.size = member_json[jsonkey::MEMBER_SIZE].get<uint32_t>(),
+			.offset = member_json[jsonkey::MEMBER_OFFSET].get<uint32_t>(),
+			.array_count = member_json[jsonkey::MEMBER_ARRAY_COUNT].get<uint32_t>(),
+		});
+	}
+	return true;
+}
+
+static void WriteCacheEntry(const std::filesystem::path& ubo_path, const std::string& source, const std::vector<MemberVariable>& members)
+{
+	nlohmann::json ubo_json = nlohmann::json::array();
+	for (const MemberVariable& member : members)
+	{
+		nlohmann::json member_json{};
+		member_json[jsonkey::MEMBER_NAME] = member.name;
+		member_json[jsonkey::MEMBER_TYPE] = (uint32_t)member.type;
+		member_json[jsonkey::MEMBER_SIZE] = member.size;
+		member_json[jsonkey::MEMBER_OFFSET] = member.offset;
+		member_json[jsonkey::MEMBER_ARRAY_COUNT] = member.array_count;
+		ubo_json += member_json;
+	}
+
+	nlohmann::json j{};
+	j[jsonkey::SHADER_CACHE_SOURCE] = source;
+	j[jsonkey::SHADER_CACHE_UBO] = ubo_json;
+
+	std::ofstream o{ ubo_path };
+	o << j << '\n';
+	if (!o.good()) {
+		logger::Error("Failed to write shader cache entry %s.\n", ubo_path.string().c_str());
+	}
+}
+
+void ShaderCache::Initialize(const std::filesystem::path& directory, uint64_t max_size_bytes)
+{
+	directory_ = directory;
+	max_size_bytes_ = max_size_bytes;
+	use_counter_ = 0;
+	entries_.clear();
+	stats_ = {};
+
+	if (directory_.empty()) {
+		return;
+	}
+	std::filesystem::create_directories(directory_); // Make the directory if it doesn't exist.
+
+	// The UBO layout is written after the SPIR-V, so it marks a complete entry. RecordUse() refreshes its last write time,
+	// so ordering by it carries recency over between sessions.
+	std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> existing{};
+	for (const auto& dir_entry : std::filesystem::directory_iterator{ directory_ })
+	{
+		if (!dir_entry.is_regular_file() || dir_entry.path().extension() != SHADER_CACHE_UBO_EXTENSION) {
+			continue;
+		}
+
+		uint64_t key{};
+		std::istringstream{ dir_entry.path().stem().string() } >> std::hex >> key;
+
+		std::error_code error{};
+		uint64_t spirv_size{ std::filesystem::file_size(EntryPath(key, SHADER_CACHE_SPIRV_EXTENSION), error) };
+		if (error) {
+			continue;
+		}
+
+		entries_[key] = Entry{ .size_bytes = dir_entry.file_size() + spirv_size, .last_use = 0 };
+		existing.emplace_back(dir_entry.last_write_time(), key);
+		stats_.size_bytes += entries_[key].size_bytes;
+	}
+
+	std::sort(existing.begin(), existing.end());
+	for (const auto& [time, key] : existing) {
+		entries_[key].last_use = ++use_counter_;
+	}
+	stats_.entry_count = (uint32_t)entries_.size();
+
+	EvictLeastRecentlyUsed(use_counter_ + 1);
+}
+
+std::vector<CompiledShader> ShaderCache::Compile(const std::vector<std::filesystem::path>& shader_paths)
+{
+	std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
+
+	std::vector<uint64_t> keys(shader_paths.size());
+	std::vector<uint32_t> indices(shader_paths.size());
+	std::iota(indices.begin(), indices.end(), 0);
+	std::for_each(std::execution::par, indices.begin(), indices.end(), [&](uint32_t i) {
+		keys[i] = Key(shader_paths[i]);
+		});
+
+	// Shaders with the same key would compile to the same files at the same time, so each key is only compiled once.
+	std::unordered_map<uint64_t, uint32_t> key_to_unique{};
+	std::vector<uint32_t> unique_shaders{}; // Index of the first shader with each key.
+	std::vector<uint32_t> shader_to_unique(shader_paths.size());
+	for (uint32_t i{ 0 }; i < (uint32_t)shader_paths.size(); ++i)
+	{
+		auto [it, inserted] { key_to_unique.try_emplace(keys[i], (uint32_t)unique_shaders.size()) };
+		if (inserted) {
+			unique_shaders.push_back(i);
+		}
+		shader_to_unique[i] = it->second;
+	}
+
+	// Each shader compiles in its own glslangValidator process, so they're launched in parallel.
+	std::vector<CompiledShader> unique_compiled(unique_shaders.size());
+	std::vector<uint8_t> hits(unique_shaders.size());
+	indices.resize(unique_shaders.size());
+	std::for_each(std::execution::par, indices.begin(), indices.end(), [&](uint32_t u) {
+		bool hit{};
+		unique_compiled[u] = CompileOne(shader_paths[unique_shaders[u]], keys[unique_shaders[u]], &hit);
+		hits[u] = hit;
+		});
+
+	// Entries are indexed after the parallel compile, since the index isn't thread safe.
+	uint64_t first_use{ use_counter_ + 1 };
+	if (!directory_.empty())
+	{
+		for (uint32_t u{ 0 }; u < (uint32_t)unique_shaders.size(); ++u)
+		{
+			if (unique_compiled[u].succeeded) {
+				RecordUse(keys[unique_shaders[u]]);
+			}
+		}
+		EvictLeastRecentlyUsed(first_use);
+	}
+
+	std::vector<CompiledShader> compiled_shaders(shader_paths.size());
+	for (uint32_t i{ 0 }; i < (uint32_t)shader_paths.size(); ++i) {
+		compiled_shaders[i] = unique_compiled[shader_to_unique[i]];
+	}
+
+	uint32_t hit_count{ (uint32_t)std::count(hits.begin(), hits.end(), (uint8_t)1) };
+	stats_.hit_count += hit_count;
+	stats_.miss_count += (uint32_t)unique_shaders.size() - hit_count;
+
+	std::chrono::steady_clock::time_point end_time{ std::chrono::steady_clock::now() };
+	stats_.last_compile_ms = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0f;
+	logger::Print("Compiled %u shaders in %.1f ms, %u of %u unique ones from the shader cache.\n",
+		(uint32_t)shader_paths.size(), stats_.last_compile_ms, hit_count, (uint32_t)unique_shaders.size());
+
+	return compiled_shaders;
+}
+
+bool ShaderCache::FindFallback(const std::filesystem::path& shader_path, const std::filesystem::path& saved_spirv_path, CompiledShader* out_compiled) const
+{
+	if (directory_.empty()) {
+		return false;
+	}
+
+	const std::string canonical{ std::filesystem::weakly_canonical(shader_path).string() };
+	std::string source{};
+	std::vector<MemberVariable> members{};
+
+	// Projects saved with the cache point at an entry, whose layout is next to it.
+	std::filesystem::path saved_ubo_path{ saved_spirv_path };
+	saved_ubo_path.replace_extension(SHADER_CACHE_UBO_EXTENSION);
+	if (saved_spirv_path.extension() == SHADER_CACHE_SPIRV_EXTENSION && std::filesystem::exists(saved_spirv_path) &&
+		ReadCacheEntry(saved_ubo_path, &source, &members) && source == canonical)
+	{
+		*out_compiled = CompiledShader{ .succeeded = true, .spirv_path = saved_spirv_path, .ubo_members = members };
+		return true;
+	}
+
+	// Otherwise use the shader's most recently used entry, if any are left.
+	std::vector<std::pair<uint64_t, uint64_t>> by_use{};
+	for (const auto& [key, entry] : entries_) {
+		by_use.emplace_back(entry.last_use, key);
+	}
+	std::sort(by_use.begin(), by_use.end(), std::greater{});
+
+	for (const auto& [last_use, key] : by_use)
+	{
+		if (ReadCacheEntry(EntryPath(key, SHADER_CACHE_UBO_EXTENSION), &source, &members) && source == canonical)
+		{
+			*out_compiled = CompiledShader{ .succeeded = true, .spirv_path = EntryPath(key, SHADER_CACHE_SPIRV_EXTENSION), .ubo_members = members };
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const ShaderCacheStats& ShaderCache::GetStats() const
+{
+	return stats_;
+}
+
+uint64_t ShaderCache::Key(const std::filesystem::path& shader_path) const
+{
+	std::unordered_set<std::string> visited{};
+	uint64_t key{ pmkutil::HashBytes(GLSLANG_OPTIONS.data(), GLSLANG_OPTIONS.size()) };
+	return HashShaderSource(shader_path, &visited, key);
+}
+
+CompiledShader ShaderCache::CompileOne(const std::filesystem::path& shader_path, uint64_t key, bool* out_hit) const
+{
+	CompiledShader compiled{};
+	*out_hit = false;
+
+	if (directory_.empty())
+	{
+		compiled.spirv_path = shader_path.parent_path() / (shader_path.filename().string() + ".spv");
+		compiled.succeeded = CompileShader(shader_path, compiled.spirv_path);
+
+		ShaderParser parser{};
+		parser.Parse(shader_path);
+		compiled.ubo_members = parser.GetUniformBuffer().GetMembers();
+		return compiled;
+	}
+
+	compiled.spirv_path = EntryPath(key, SHADER_CACHE_SPIRV_EXTENSION);
+	std::filesystem::path ubo_path{ EntryPath(key, SHADER_CACHE_UBO_EXTENSION) };
+
+	// The UBO layout is written last, so its presence marks a complete entry.
+	std::string source{};
+	if (std::filesystem::exists(compiled.spirv_path) && ReadCacheEntry(ubo_path, &source, &compiled.ubo_members))
+	{
+		compiled.succeeded = true;
+		*out_hit = true;
+		return compiled;
+	}
+
+	compiled.succeeded = CompileShader(shader_path, compiled.spirv_path);
+
+	ShaderParser parser{};
+	parser.Parse(shader_path);
+	compiled.ubo_members = parser.GetUniformBuffer().GetMembers();
+
+	// Failures aren't cached, so they're retried once the source is fixed.
+	if (compiled.succeeded) {
+		WriteCacheEntry(ubo_path, std::filesystem::weakly_canonical(shader_path).string(), compiled.ubo_members);
+	}
+
+	return compiled;
+}
+
+std::filesystem::path ShaderCache::EntryPath(uint64_t key, const std::string& extension) const
+{
+	std::ostringstream name{};
+	name << std::hex << key << extension;
+	return directory_ / name.str();
+}
+
+void ShaderCache::RecordUse(uint64_t key)
+{
+	std::filesystem::path ubo_path{ EntryPath(key, SHADER_CACHE_UBO_EXTENSION) };
+	std::error_code error{};
+	std::filesystem::last_write_time(ubo_path, std::filesystem::file_time_type::clock::now(), error);
+
+	uint64_t size_bytes{ std::filesystem::file_size(ubo_path, error) };
+	size_bytes += error ? 0 : std::filesystem::file_size(EntryPath(key, SHADER_CACHE_SPIRV_EXTENSION), error);
+	if (error) {
+		return;
+	}
+
+	auto it{ entries_.find(key) };
+	if (it != entries_.end()) {
+		stats_.size_bytes -= it->second.size_bytes;
+	}
+	entries_[key] = Entry{ .size_bytes = size_bytes, .last_use = ++use_counter_ };
+	stats_.size_bytes += size_bytes;
+	stats_.entry_count = (uint32_t)entries_.size();
+}
+
+void ShaderCache::EvictLeastRecentlyUsed(uint64_t protected_use)
+{
+	while (stats_.size_bytes > max_size_bytes_ && !entries_.empty())
+	{
+		auto oldest{ std::min_element(entries_.begin(), entries_.end(),
+			[](const auto& a, const auto& b) { return a.second.last_use < b.second.last_use; }) };
+		if (oldest->second.last_use >= protected_use) {
+			break;
+		}
+
+		// Remove the UBO layout first, so a partly removed entry isn't complete.
+		std::error_code error{};
+		std::filesystem::remove(EntryPath(oldest->first, SHADER_CACHE_UBO_EXTENSION), error);
+		std::filesystem::remove(EntryPath(oldest->first, SHADER_CACHE_SPIRV_EXTENSION), error);
+		stats_.size_bytes -= oldest->second.size_bytes;
+		entries_.erase(oldest);
+	}
+	stats_.entry_count = (uint32_t)entries_.size();
+}
+
 void UniformBuffer::Initialize(const std::vector<MemberVariable>& members)
 {
 	uint32_t buffer_size{ 0 };
@@ -261,6 +619,11 @@ const std::vector<std::byte>& UniformBuffer::GetBuffer() const
 	return uniform_buffer_;
 }
 
+const std::vector<MemberVariable>& UniformBuffer::GetMembers() const
+{
+	return members_;
+}
+
 bool UniformBuffer::DrawGui(float alignment)
 {
 	bool value_changed{ false };
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "nlohmann/json.hpp"
 
 namespace jsonkey
@@ -54,6 +55,8 @@ public:
 
 	nlohmann::json ToJson() const;
 
+	const std::vector<MemberVariable>& GetMembers() const;
+
 private:
 	std::vector<MemberVariable> members_{};   // Type info about each of the members of the UBO struct.
 	std::vector<std::byte> uniform_buffer_{}; // A byte buffer the same size as the shader's uniform buffer.
@@ -81,4 +84,66 @@ private:
 };
 
 // Returns true if compilation succeeds, otherwise returns false.
-bool CompileShader(const std::filesystem::path& shader_path, std::filesystem::path* out_spirv_path);
+bool CompileShader(const std::filesystem::path& shader_path, const std::filesystem::path& spirv_path);
+
+// SPIR-V and parsed custom UBO layout of a user shader.
+struct CompiledShader
+{
+	bool succeeded; // False if compilation failed. The UBO is still parsed.
+	std::filesystem::path spirv_path;
+	std::vector<MemberVariable> ubo_members;
+};
+
+struct ShaderCacheStats
+{
+	uint32_t hit_count;
+	uint32_t miss_count;
+	uint32_t entry_count;
+	uint64_t size_bytes;
+	float last_compile_ms; // Time the last Compile() call took.
+};
+
+// Disk cache of compiled user shaders and their parsed UBO layouts, keyed by a hash of the shader source
+// and every file it includes, so editing an include recompiles the shaders that use it.
+// The least recently used entries are removed once the cache grows past its size cap.
+class ShaderCache
+{
+public:
+	// Index the entries already in the directory. An empty directory disables the cache, so shaders are compiled next to their source every time.
+	void Initialize(const std::filesystem::path& directory, uint64_t max_size_bytes);
+
+	// Compile shaders in parallel, reusing cached results of those whose source and includes haven't changed.
+	// Results are in the order of shader_paths.
+	std::vector<CompiledShader> Compile(const std::vector<std::filesystem::path>& shader_paths);
+
+	// Find SPIR-V and its UBO layout for a shader that no longer compiles. That's saved_spirv_path if it's a cache entry,
+	// otherwise the shader's most recently used entry. Returns false if neither is cached.
+	bool FindFallback(const std::filesystem::path& shader_path, const std::filesystem::path& saved_spirv_path, CompiledShader* out_compiled) const;
+
+	const ShaderCacheStats& GetStats() const;
+
+private:
+	struct Entry
+	{
+		uint64_t size_bytes; // Of both the SPIR-V and the UBO layout.
+		uint64_t last_use;   // Larger is more recent.
+	};
+
+	uint64_t Key(const std::filesystem::path& shader_path) const;
+
+	CompiledShader CompileOne(const std::filesystem::path& shader_path, uint64_t key, bool* out_hit) const;
+
+	std::filesystem::path EntryPath(uint64_t key, const std::string& extension) const;
+
+	// Mark an entry as the most recently used, indexing it if it was just written.
+	void RecordUse(uint64_t key);
+
+	// Entries used at or after protected_use are kept even over the size cap, since their SPIR-V is about to be loaded.
+	void EvictLeastRecentlyUsed(uint64_t protected_use);
+
+	std::filesystem::path directory_{};
+	uint64_t max_size_bytes_{};
+	uint64_t use_counter_{};
+	std::unordered_map<uint64_t, Entry> entries_{};
+	ShaderCacheStats stats_{};
+};
@@ -0,0 +1,317 @@
+#include "chunk_streaming.h"
+
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include "tracy/Tracy.hpp"
+#include "logger.h"
+#include "common_constants.h"
+#include "voxel_codec.h"
+
+namespace pmk
+{
+	static bool WriteChunk(const std::filesystem::path& path, const renderer::VoxelChunk& chunk)
+	{
+		std::ofstream file{ path, std::ios::out | std::ios::binary };
+		if (!file.is_open()) {
+			return false;
+		}
+
+		std::vector<uint8_t> data{ renderer::EncodeVoxelChunk(chunk) };
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		return file.good();
+	}
+
+	static bool ReadChunk(const std::filesystem::path& path, renderer::VoxelChunk* out_chunk)
+	{
+		std::ifstream file{ path, std::ios::ate | std::ios::binary };
+		if (!file.is_open()) {
+			return false;
+		}
+
+		std::vector<uint8_t> data((size_t)file.tellg());
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		return file.good() && renderer::DecodeVoxelChunk(data, out_chunk);
+	}
+
+	size_t ChunkCoordinateHash::operator()(const glm::ivec3& chunk_coord) const
+	{
+		// Large primes spatial hash.
+		// Cast through uint32_t so negative coordinates don't sign extend into the upper bits.
+		return ((size_t)(uint32_t)chunk_coord.x * 73856093) ^ ((size_t)(uint32_t)chunk_coord.y * 19349663) ^ ((size_t)(uint32_t)chunk_coord.z * 83492791);
+	}
+
+	void ChunkStreamer::Initialize(const ChunkStreamingSettings& settings, ChunkGenerator&& generator)
+	{
+		if (settings.unload_radius <= settings.load_radius) {
+			logger::Error("Chunk unload radius should be larger than the load radius.\n");
+		}
+
+		settings_ = settings;
+		generator_ = std::move(generator);
+		stats_ = {};
+		std::filesystem::create_directories(settings_.cache_directory); // Make the directory if it doesn't exist.
+
+		uint32_t worker_count{ std::max(settings_.worker_count, 1u) };
+		for (uint32_t i{ 0 }; i < worker_count; ++i) {
+			workers_.emplace_back([this](std::stop_token stop_token) { WorkerLoop(stop_token); });
+		}
+	}
+
+	void ChunkStreamer::CleanUp()
+	{
+		for (std::jthread& worker : workers_) {
+			worker.request_stop();
+		}
+		workers_.clear(); // Joins the workers.
+
+		resident_chunks_.clear();
+		loaded_chunks_.clear();
+		evicted_chunks_.clear();
+		pending_loads_.clear();
+		pending_writes_.clear();
+		on_disk_.clear();
+		load_queue_.clear();
+		write_queue_.clear();
+		finished_jobs_.clear();
+	}
+
+	void ChunkStreamer::Update(const glm::vec3& focus_position)
+	{
+		ZoneScoped;
+		auto start{ std::chrono::high_resolution_clock::now() };
+
+		focus_ = focus_position / CHUNK_WIDTH;
+		loaded_chunks_.clear();
+		evicted_chunks_.clear();
+		IntegrateFinishedJobs();
+		EvictChunks();
+		QueueLoads();
+
+		stats_.resident_count = (uint32_t)resident_chunks_.size();
+		stats_.pending_count = (uint32_t)pending_loads_.size();
+		stats_.last_update_time = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+		stats_.worst_update_time = std::max(stats_.worst_update_time, stats_.last_update_time);
+	}
+
+	const renderer::VoxelChunk* ChunkStreamer::GetChunk(const glm::ivec3& chunk_coord) const
+	{
+		auto it{ resident_chunks_.find(chunk_coord) };
+		return (it == resident_chunks_.end()) ? nullptr : &it->second;
+	}
+
+	const std::vector<glm::ivec3>& ChunkStreamer::GetLoadedChunks() const
+	{
+		return loaded_chunks_;
+	}
+
+	const std::vector<glm::ivec3>& ChunkStreamer::GetEvictedChunks() const
+	{
+		return evicted_chunks_;
+	}
+
+	const ChunkStreamingStats& ChunkStreamer::GetStats() const
+	{
+		return stats_;
+	}
+
+	glm::ivec3 ChunkStreamer::WorldToChunkCoordinate(const glm::vec3& world_position)
+	{
+		return glm::ivec3{ glm::floor(world_position / CHUNK_WIDTH) };
+	}
+
+	void ChunkStreamer::WorkerLoop(std::stop_token stop_token)
+	{
+		while (true)
+		{
+			Job job{};
+			{
+				std::unique_lock lock{ mutex_ };
+				job_available_.wait(lock, stop_token, [&]() { return !write_queue_.empty() || !load_queue_.empty(); });
+
+				// Writes go first since they free memory and unblock loads of the same chunk.
+				if (!write_queue_.empty())
+				{
+					job = std::move(write_queue_.back());
+					write_queue_.pop_back();
+				}
+				else if (!stop_token.stop_requested() && !load_queue_.empty())
+				{
+					job = std::move(load_queue_.back());
+					load_queue_.pop_back();
+				}
+				else {
+					return;
+				}
+			}
+
+			std::filesystem::path path{ ChunkPath(job.chunk_coord) };
+			switch (job.type)
+			{
+			case JobType::GENERATE:
+				job.chunk = generator_(job.chunk_coord);
+				break;
+			case JobType::READ:
+				if (!ReadChunk(path, &job.chunk))
+				{
+					logger::Error("Failed to read chunk file %s, generating the chunk instead.\n", path.string().c_str());
+					job.chunk = generator_(job.chunk_coord);
+				}
+				break;
+			case JobType::WRITE:
+				if (!WriteChunk(path, job.chunk)) {
+					logger::Error("Failed to write chunk file %s.\n", path.string().c_str());
+				}
+				job.chunk = {}; // Release the memory before handing the job back.
+				break;
+			}
+
+			std::lock_guard lock{ mutex_ };
+			finished_jobs_.push_back(std::move(job));
+		}
+	}
+
+	float ChunkStreamer::ChunkDistance(const glm::ivec3& chunk_coord) const
+	{
+		return glm::distance(glm::vec3{ chunk_coord } + 0.5f, focus_);
+	}
+
+	std::filesystem::path ChunkStreamer::ChunkPath(const glm::ivec3& chunk_coord) const
+	{
+		return settings_.cache_directory /
+			("chunk_" + std::to_string(chunk_coord.x) + "_" + std::to_string(chunk_coord.y) + "_" + std::to_string(chunk_coord.z) + ".bin");
+	}
+
+	void ChunkStreamer::Evict(const glm::ivec3& chunk_coord)
+	{
+		auto it{ resident_chunks_.find(chunk_coord) };
+		stats_.resident_bytes -= it->second.MemoryUsage();
+		pending_writes_.insert(chunk_coord);
+		{
+			std::lock_guard lock{ mutex_ };
+			write_queue_.push_back(Job{ .type = JobType::WRITE, .chunk_coord = chunk_coord, .chunk = std::move(it->second) });
+		}
+		resident_chunks_.erase(it);
+		evicted_chunks_.push_back(chunk_coord);
+		job_available_.notify_one();
+	}
+
+	void ChunkStreamer::IntegrateFinishedJobs()
+	{
+		ZoneScoped;
+
+		// Take every finished write but only a bounded number of loads, so a burst of loads is spread over several updates.
+		std::vector<Job> jobs{};
+		{
+			std::lock_guard lock{ mutex_ };
+			std::vector<Job> deferred_jobs{};
+			uint32_t load_count{ 0 };
+			for (Job& job : finished_jobs_)
+			{
+				if (job.type == JobType::WRITE || load_count++ < settings_.max_integrations_per_update) {
+					jobs.push_back(std::move(job));
+				}
+				else {
+					deferred_jobs.push_back(std::move(job));
+				}
+			}
+			finished_jobs_ = std::move(deferred_jobs);
+		}
+
+		for (Job& job : jobs)
+		{
+			if (job.type == JobType::WRITE)
+			{
+				pending_writes_.erase(job.chunk_coord);
+				on_disk_.insert(job.chunk_coord);
+				++stats_.evicted_count;
+				continue;
+			}
+
+			pending_loads_.erase(job.chunk_coord);
+			stats_.resident_bytes += job.chunk.MemoryUsage();
+			resident_chunks_.emplace(job.chunk_coord, std::move(job.chunk));
+			loaded_chunks_.push_back(job.chunk_coord);
+		}
+	}
+
+	void ChunkStreamer::EvictChunks()
+	{
+		ZoneScoped;
+
+		std::vector<glm::ivec3> far_chunks{};
+		std::vector<std::pair<float, glm::ivec3>> candidates{};
+		for (const auto& [chunk_coord, chunk] : resident_chunks_)
+		{
+			float distance{ ChunkDistance(chunk_coord) };
+			if (distance > settings_.unload_radius) {
+				far_chunks.push_back(chunk_coord);
+			}
+			else if (distance > settings_.load_radius) {
+				candidates.emplace_back(distance, chunk_coord);
+			}
+		}
+
+		for (const glm::ivec3& chunk_coord : far_chunks) {
+			Evict(chunk_coord);
+		}
+
+		// Chunks between the load and unload radius are kept while memory allows, farthest evicted first.
+		std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+		for (const auto& [distance, chunk_coord] : candidates)
+		{
+			if (stats_.resident_bytes <= settings_.memory_budget) {
+				break;
+			}
+			Evict(chunk_coord);
+		}
+	}
+
+	void ChunkStreamer::QueueLoads()
+	{
+		ZoneScoped;
+
+		std::lock_guard lock{ mutex_ };
+
+		// Requeue from scratch so priorities follow the focus and chunks that left the load radius are dropped.
+		for (const Job& job : load_queue_) {
+			pending_loads_.erase(job.chunk_coord);
+		}
+		load_queue_.clear();
+
+		if (stats_.resident_bytes > settings_.memory_budget) {
+			return;
+		}
+
+		glm::ivec3 min_coord{ glm::floor(focus_ - settings_.load_radius) };
+		glm::ivec3 max_coord{ glm::ceil(focus_ + settings_.load_radius) };
+		for (int32_t z{ min_coord.z }; z <= max_coord.z; ++z)
+		{
+			for (int32_t y{ min_coord.y }; y <= max_coord.y; ++y)
+			{
+				for (int32_t x{ min_coord.x }; x <= max_coord.x; ++x)
+				{
+					glm::ivec3 chunk_coord{ x, y, z };
+					if (ChunkDistance(chunk_coord) > settings_.load_radius ||
+						resident_chunks_.contains(chunk_coord) ||
+						pending_loads_.contains(chunk_coord) ||
+						pending_writes_.contains(chunk_coord))
+					{
+						continue;
+					}
+
+					JobType type{ on_disk_.contains(chunk_coord) ? JobType::READ : JobType::GENERATE };
+					load_queue_.push_back(Job{ .type = type, .chunk_coord = chunk_coord, .chunk = {} });
+					pending_loads_.insert(chunk_coord);
+				}
+			}
+		}
+
+		std::sort(load_queue_.begin(), load_queue_.end(),
+			[&](const Job& a, const Job& b) { return ChunkDistance(a.chunk_coord) > ChunkDistance(b.chunk_coord); });
+
+		job_available_.notify_all();
+	}
+}
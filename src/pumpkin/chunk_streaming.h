@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "glm/glm.hpp"
+
+#include "voxel_chunk.h"
+
+namespace pmk
+{
+	// Creates the voxels of the chunk at the given chunk coordinate. Called from worker threads, so it must not use the renderer.
+	using ChunkGenerator = std::function<renderer::VoxelChunk(const glm::ivec3& chunk_coord)>;
+
+	struct ChunkStreamingSettings
+	{
+		float load_radius;                      // In chunks. Chunks with their center within this distance of the focus are loaded.
+		float unload_radius;                    // In chunks. Resident chunks past this distance are evicted. Larger than load_radius to prevent thrashing.
+		size_t memory_budget;                   // In bytes. Loading stops and chunks outside load_radius are evicted, farthest first, while resident chunks exceed it.
+		uint32_t worker_count;
+		uint32_t max_integrations_per_update;   // Loaded chunks made resident per Update(), to bound the main thread stall.
+		std::filesystem::path cache_directory;  // Evicted chunks are written here and read back instead of being generated again.
+	};
+
+	struct ChunkStreamingStats
+	{
+		uint32_t resident_count;
+		uint32_t pending_count;        // Chunks queued or being loaded by a worker.
+		uint32_t evicted_count;        // Chunks written to disk since initialization.
+		size_t resident_bytes;
+		float last_update_time;        // In seconds, main thread time of the last Update().
+		float worst_update_time;       // In seconds, worst main thread time of Update() since initialization.
+	};
+
+	struct ChunkCoordinateHash
+	{
+		size_t operator()(const glm::ivec3& chunk_coord) const;
+	};
+
+	// Keeps the chunks around a focus position resident, such as around the camera.
+	// Chunks are generated or read from disk on worker threads, nearest first, and handed to the main thread in Update().
+	// Chunks past the unload radius or over the memory budget are written to disk on the worker threads.
+	class ChunkStreamer
+	{
+	public:
+		void Initialize(const ChunkStreamingSettings& settings, ChunkGenerator&& generator);
+
+		// Stops the workers, discarding queued loads but finishing queued evictions.
+		void CleanUp();
+
+		// Integrate loaded chunks, evict far chunks, and queue loads around focus_position, which is in world space.
+		void Update(const glm::vec3& focus_position);
+
+		// Returns nullptr if the chunk is not resident.
+		const renderer::VoxelChunk* GetChunk(const glm::ivec3& chunk_coord) const;
+
+		// Chunks made resident by the last Update(). Some may have been evicted again by the same Update().
+		const std::vector<glm::ivec3>& GetLoadedChunks() const;
+
+		// Chunks evicted by the last Update().
+		const std::vector<glm::ivec3>& GetEvictedChunks() const;
+
+		const ChunkStreamingStats& GetStats() const;
+
+		static glm::ivec3 WorldToChunkCoordinate(const glm::vec3& world_position);
+
+	private:
+		enum class JobType
+		{
+			GENERATE,
+			READ,
+			WRITE,
+		};
+
+		struct Job
+		{
+			JobType type;
+			glm::ivec3 chunk_coord;
+			renderer::VoxelChunk chunk; // Input of WRITE jobs, output of GENERATE and READ jobs.
+		};
+
+		void WorkerLoop(std::stop_token stop_token);
+
+		// Distance in chunks from the focus to the center of the chunk.
+		float ChunkDistance(const glm::ivec3& chunk_coord) const;
+
+		std::filesystem::path ChunkPath(const glm::ivec3& chunk_coord) const;
+
+		// Move a resident chunk to a WRITE job.
+		void Evict(const glm::ivec3& chunk_coord);
+
+		void IntegrateFinishedJobs();
+
+		void EvictChunks();
+
+		void QueueLoads();
+
+		ChunkStreamingSettings settings_{};
+		ChunkGenerator generator_{};
+		glm::vec3 focus_{};  // In chunks.
+		ChunkStreamingStats stats_{};
+		std::vector<glm::ivec3> loaded_chunks_{};
+		std::vector<glm::ivec3> evicted_chunks_{};
+
+		// Only accessed by the main thread.
+		std::unordered_map<glm::ivec3, renderer::VoxelChunk, ChunkCoordinateHash> resident_chunks_{};
+		std::unordered_set<glm::ivec3, ChunkCoordinateHash> pending_loads_{};  // Queued or being loaded by a worker.
+		std::unordered_set<glm::ivec3, ChunkCoordinateHash> pending_writes_{}; // Not loaded again until written, so stale files are never read.
+		std::unordered_set<glm::ivec3, ChunkCoordinateHash> on_disk_{};
+
+		// Shared with the workers and guarded by mutex_.
+		std::vector<Job> load_queue_{};   // Sorted farthest first, so the nearest chunk is popped from the back.
+		std::vector<Job> write_queue_{};
+		std::vector<Job> finished_jobs_{};
+		std::mutex mutex_{};
+		std::condition_variable_any job_available_{};
+
+		std::vector<std::jthread> workers_{};
+	};
+}
@@ -0,0 +1,416 @@
+#include "connected_components.h"
+
+#include <algorithm>
+#include <execution>
+#include <ranges>
+#include <unordered_map>
+#include <numeric>
+#include "tracy/Tracy.hpp"
+
+#include "common_constants.h"
+
+namespace pmk
+{
+	// Raw moments of a set of voxels. Doubles since second moments of a full chunk overflow float precision.
+	struct PartialMassProperties
+	{
+		uint32_t voxel_count{};
+		double mass{};
+		glm::dvec3 first_moment{};    // Sum of m * r.
+		glm::dvec3 second_moment{};   // Sum of m * r.x^2, m * r.y^2, m * r.z^2.
+		glm::dvec3 product_moment{};  // Sum of m * r.x * r.y, m * r.x * r.z, m * r.y * r.z.
+		glm::uvec3 min_extents{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+		glm::uvec3 max_extents{};
+
+		void Add(const glm::uvec3& coord, double voxel_mass)
+		{
+			glm::dvec3 r{ coord };
+			++voxel_count;
+			mass += voxel_mass;
+			first_moment += voxel_mass * r;
+			second_moment += voxel_mass * r * r;
+			product_moment += voxel_mass * glm::dvec3{ r.x * r.y, r.x * r.z, r.y * r.z };
+			min_extents = glm::min(min_extents, coord);
+			max_extents = glm::max(max_extents, coord);
+		}
+
+		void Merge(const PartialMassProperties& other)
+		{
+			voxel_count += other.voxel_count;
+			mass += other.mass;
+			first_moment += other.first_moment;
+			second_moment += other.second_moment;
+			product_moment += other.product_moment;
+			min_extents = glm::min(min_extents, other.min_extents);
+			max_extents = glm::max(max_extents, other.max_extents);
+		}
+	};
+
+	// Find with path halving. Only safe when no other thread is writing to the same tree.
+	static uint32_t FindRoot(std::vector<uint32_t>& parents, uint32_t idx)
+	{
+		while (parents[idx] != idx)
+		{
+			parents[idx] = parents[parents[idx]];
+			idx = parents[idx];
+		}
+		return idx;
+	}
+
+	// Find without writing, so threads can query in parallel once all unions are done.
+	static uint32_t FindRootConst(const std::vector<uint32_t>& parents, uint32_t idx)
+	{
+		while (parents[idx] != idx) {
+			idx = parents[idx];
+		}
+		return idx;
+	}
+
+	// Link the larger root to the smaller root, so the root of each component is its lowest voxel index.
+	static void Union(std::vector<uint32_t>& parents, uint32_t a, uint32_t b)
+	{
+		uint32_t root_a{ FindRoot(parents, a) };
+		uint32_t root_b{ FindRoot(parents, b) };
+		if (root_a < root_b) {
+			parents[root_b] = root_a;
+		}
+		else if (root_b < root_a) {
+			parents[root_a] = root_b;
+		}
+	}
+
+	std::vector<VoxelComponent> LabelVoxelComponents(
+		const renderer::VoxelChunk& voxel_chunk,
+		const MaterialMask& material_mask,
+		const MaterialMasses& material_masses,
+		std::vector<uint32_t>* out_labels)
+	{
+		ZoneScoped;
+
+		const glm::uvec3 dimensions{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() };
+		const glm::uvec3 block_dimensions{ (dimensions + LABELING_BLOCK_WIDTH - 1u) / LABELING_BLOCK_WIDTH };
+		const uint32_t block_count{ block_dimensions.x * block_dimensions.y * block_dimensions.z };
+		const uint32_t slice{ dimensions.x * dimensions.y };
+
+		auto included = [&](uint32_t idx) {
+			uint8_t material{ voxel_chunk.Index(idx).physics_material_index };
+			return material != renderer::PHYSICS_MATERIAL_EMPTY_INDEX && material_mask[material];
+			};
+
+		// Voxels outside every component have a parent of NULL_INDEX.
+		std::vector<uint32_t> parents(voxel_chunk.VoxelCount(), NULL_INDEX);
+		std::vector<std::unordered_map<uint32_t, PartialMassProperties>> block_partials(block_count);
+
+		// Label each block independently. Unions only touch voxels within the block, so blocks don't contend.
+		auto blocks{ std::views::iota(0u, block_count) };
+		std::for_each(std::execution::par, blocks.begin(), blocks.end(),
+			[&](uint32_t block_idx) {
+				glm::uvec3 block{
+					block_idx % block_dimensions.x,
+					(block_idx / block_dimensions.x) % block_dimensions.y,
+					block_idx / (block_dimensions.x * block_dimensions.y) };
+				if (voxel_chunk.IsBrickEmpty(block)) {
+					return;
+				}
+
+				glm::uvec3 begin{ block * LABELING_BLOCK_WIDTH };
+				glm::uvec3 end{ glm::min(begin + LABELING_BLOCK_WIDTH, dimensions) };
+
+				for (uint32_t k{ begin.z }; k < end.z; ++k)
+				{
+					for (uint32_t j{ begin.y }; j < end.y; ++j)
+					{
+						for (uint32_t i{ begin.x }; i < end.x; ++i)
+						{
+							uint32_t idx{ i + j * dimensions.x + k * slice };
+							if (!included(idx)) {
+								continue;
+							}
+
+							parents[idx] = idx;
+							if (i > begin.x && parents[idx - 1] != NULL_INDEX) {
+								Union(parents, idx, idx - 1);
+							}
+							if (j > begin.y && parents[idx - dimensions.x] != NULL_INDEX) {
+								Union(parents, idx, idx - dimensions.x);
+							}
+							if (k > begin.z && parents[idx - slice] != NULL_INDEX) {
+								Union(parents, idx, idx - slice);
+							}
+						}
+					}
+				}
+
+				// Accumulate mass properties per local root while the block is still in cache.
+				std::unordered_map<uint32_t, PartialMassProperties>& partials{ block_partials[block_idx] };
+				for (uint32_t k{ begin.z }; k < end.z; ++k)
+				{
+					for (uint32_t j{ begin.y }; j < end.y; ++j)
+					{
+						for (uint32_t i{ begin.x }; i < end.x; ++i)
+						{
+							uint32_t idx{ i + j * dimensions.x + k * slice };
+							if (parents[idx] == NULL_INDEX) {
+								continue;
+							}
+
+							uint8_t material{ voxel_chunk.Index(idx).physics_material_index };
+							partials[FindRoot(parents, idx)].Add({ i, j, k }, material_masses[material]);
+						}
+					}
+				}
+			});
+
+		// Union across block faces.
+		auto union_face = [&](uint32_t idx, uint32_t neighbor_idx) {
+			if (parents[idx] != NULL_INDEX && parents[neighbor_idx] != NULL_INDEX) {
+				Union(parents, idx, neighbor_idx);
+			}
+			};
+
+		// Only faces between two occupied blocks can connect components.
+		for (uint32_t block_idx{ 0 }; block_idx < block_count; ++block_idx)
+		{
+			glm::uvec3 block{
+				block_idx % block_dimensions.x,
+				(block_idx / block_dimensions.x) % block_dimensions.y,
+				block_idx / (block_dimensions.x * block_dimensions.y) };
+			if (voxel_chunk.IsBrickEmpty(block)) {
+				continue;
+			}
+
+			glm::uvec3 begin{ block * LABELING_BLOCK_WIDTH };
+			glm::uvec3 end{ glm::min(begin + LABELING_BLOCK_WIDTH, dimensions) };
+			const uint32_t strides[3]{ 1, dimensions.x, slice };
+
+			for (uint32_t axis{ 0 }; axis < 3; ++axis)
+			{
+				glm::uvec3 neighbor_block{ block };
+				if (neighbor_block[axis] == 0) {
+					continue;
+				}
+				--neighbor_block[axis];
+				if (voxel_chunk.IsBrickEmpty(neighbor_block)) {
+					continue;
+				}
+
+				// Walk the face of the block on the lower side of the axis.
+				glm::uvec3 face_end{ end };
+				face_end[axis] = begin[axis] + 1;
+				for (uint32_t k{ begin.z }; k < face_end.z; ++k)
+				{
+					for (uint32_t j{ begin.y }; j < face_end.y; ++j)
+					{
+						for (uint32_t i{ begin.x }; i < face_end.x; ++i)
+						{
+							uint32_t idx{ i + j * dimensions.x + k * slice };
+							union_face(idx, idx - strides[axis]);
+						}
+					}
+				}
+			}
+		}
+
+		// Merge the block partial sums by their final root.
+		std::unordered_map<uint32_t, PartialMassProperties> merged{};
+		for (const auto& partials : block_partials)
+		{
+			for (const auto& [local_root, partial] : partials) {
+				merged[FindRoot(parents, local_root)].Merge(partial);
+			}
+		}
+
+		std::vector<uint32_t> roots{};
+		roots.reserve(merged.size());
+		for (const auto& [root, partial] : merged) {
+			roots.push_back(root);
+		}
+		std::sort(roots.begin(), roots.end());
+
+		std::vector<VoxelComponent> components(roots.size());
+		std::unordered_map<uint32_t, uint32_t> root_to_component{};
+		for (uint32_t c{ 0 }; c < (uint32_t)roots.size(); ++c)
+		{
+			const PartialMassProperties& p{ merged[roots[c]] };
+			root_to_component[roots[c]] = c;
+
+			glm::dvec3 com{ p.first_moment / p.mass };
+
+			// Second moments about the center of mass from the raw moments.
+			glm::dvec3 s{ p.second_moment - p.mass * com * com };
+			glm::dvec3 prod{ p.product_moment - p.mass * glm::dvec3{ com.x * com.y, com.x * com.z, com.y * com.z } };
+
+			// Moments are in voxel coordinates, so scale to meters squared.
+			constexpr double width_sqr{ (double)PARTICLE_WIDTH * (double)PARTICLE_WIDTH };
+			float xx{ (float)((s.y + s.z) * width_sqr) };
+			float yy{ (float)((s.x + s.z) * width_sqr) };
+			float zz{ (float)((s.x + s.y) * width_sqr) };
+			float xy{ (float)(-prod.x * width_sqr) };
+			float xz{ (float)(-prod.y * width_sqr) };
+			float yz{ (float)(-prod.z * width_sqr) };
+
+			components[c] = VoxelComponent{
+				.root = roots[c],
+				.voxel_count = p.voxel_count,
+				.mass = (float)p.mass,
+				.center_of_mass = glm::vec3{ com },
+				.inertia_tensor = glm::mat3{
+					xx, xy, xz,
+					xy, yy, yz,
+					xz, yz, zz,
+				},
+				.min_extents = p.min_extents,
+				.max_extents = p.max_extents,
+			};
+		}
+
+		if (out_labels)
+		{
+			out_labels->resize(parents.size());
+			auto indices{ std::views::iota(0u, (uint32_t)parents.size()) };
+			std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+				[&](uint32_t idx) {
+					(*out_labels)[idx] = parents[idx] == NULL_INDEX ? NULL_INDEX : root_to_component.at(FindRootConst(parents, idx));
+				});
+		}
+
+		return components;
+	}
+
+	std::vector<std::vector<uint32_t>> FindDetachedFragments(const renderer::VoxelChunk& voxel_chunk, const std::vector<glm::uvec3>& seeds)
+	{
+		ZoneScoped;
+
+		constexpr uint32_t steps_per_turn{ 64 }; // Voxels each flood fill visits before the next one takes its turn.
+		constexpr glm::ivec3 offsets[6]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+		struct FloodFill
+		{
+			std::vector<uint32_t> stack;
+			std::vector<uint32_t> members;
+		};
+
+		std::vector<FloodFill> fills{};
+		std::vector<uint32_t> parents{};
+		std::vector<uint32_t> owners(voxel_chunk.VoxelCount(), NULL_INDEX);
+
+		for (const glm::uvec3& seed : seeds)
+		{
+			if (!voxel_chunk.InBounds(seed) || voxel_chunk.IsEmpty(seed)) {
+				continue;
+			}
+
+			uint32_t idx{ voxel_chunk.CoordinateToIndex(seed) };
+			if (owners[idx] != NULL_INDEX) {
+				continue;
+			}
+
+			uint32_t fill{ (uint32_t)fills.size() };
+			owners[idx] = fill;
+			fills.push_back(FloodFill{ .stack = { idx }, .members = { idx } });
+			parents.push_back(fill);
+		}
+
+		if (fills.size() <= 1) {
+			return {};
+		}
+
+		// Merge the smaller flood fill into the larger, returning the surviving root.
+		auto merge = [&](uint32_t a, uint32_t b) {
+			if (fills[a].members.size() < fills[b].members.size()) {
+				std::swap(a, b);
+			}
+			parents[b] = a;
+			fills[a].stack.insert(fills[a].stack.end(), fills[b].stack.begin(), fills[b].stack.end());
+			fills[a].members.insert(fills[a].members.end(), fills[b].members.begin(), fills[b].members.end());
+			fills[b] = {};
+			return a;
+			};
+
+		std::vector<uint32_t> live(fills.size());
+		std::iota(live.begin(), live.end(), 0u);
+		std::vector<uint32_t> finished{};
+		std::vector<uint8_t> listed(fills.size());
+
+		// A flood fill with an empty stack has visited every voxel it can reach, so once at most one is still
+		// growing, the others are closed off from it.
+		while (live.size() > 1)
+		{
+			std::fill(listed.begin(), listed.end(), 0);
+			for (uint32_t fill : live)
+			{
+				// Flood fills merged earlier this round only take one turn.
+				fill = FindRoot(parents, fill);
+				if (listed[fill]) {
+					continue;
+				}
+				listed[fill] = 1;
+
+				for (uint32_t step{ 0 }; step < steps_per_turn && !fills[fill].stack.empty(); ++step)
+				{
+					uint32_t idx{ fills[fill].stack.back() };
+					fills[fill].stack.pop_back();
+					glm::uvec3 coord{ voxel_chunk.IndexToCoordinate(idx) };
+
+					for (const glm::ivec3& offset : offsets)
+					{
+						glm::uvec3 neighbor{ glm::ivec3{ coord } + offset };
+						if (!voxel_chunk.InBounds(neighbor) || voxel_chunk.IsEmpty(neighbor)) {
+							continue;
+						}
+
+						uint32_t neighbor_idx{ voxel_chunk.CoordinateToIndex(neighbor) };
+						uint32_t owner{ owners[neighbor_idx] };
+						if (owner == NULL_INDEX)
+						{
+							owners[neighbor_idx] = fill;
+							fills[fill].stack.push_back(neighbor_idx);
+							fills[fill].members.push_back(neighbor_idx);
+						}
+						else
+						{
+							uint32_t owner_root{ FindRoot(parents, owner) };
+							if (owner_root != fill) {
+								fill = merge(fill, owner_root);
+							}
+						}
+					}
+				}
+			}
+
+			std::vector<uint32_t> next_live{};
+			std::fill(listed.begin(), listed.end(), 0);
+			for (uint32_t fill : live)
+			{
+				fill = FindRoot(parents, fill);
+				if (listed[fill]) {
+					continue;
+				}
+				listed[fill] = 1;
+
+				if (fills[fill].stack.empty()) {
+					finished.push_back(fill);
+				}
+				else {
+					next_live.push_back(fill);
+				}
+			}
+			live = std::move(next_live);
+		}
+
+		// If every flood fill finished, the body split into closed parts and the largest one stays.
+		if (live.empty())
+		{
+			auto largest{ std::max_element(finished.begin(), finished.end(),
+				[&](uint32_t a, uint32_t b) { return fills[a].members.size() < fills[b].members.size(); }) };
+			finished.erase(largest);
+		}
+
+		std::vector<std::vector<uint32_t>> fragments{};
+		fragments.reserve(finished.size());
+		for (uint32_t fill : finished) {
+			fragments.push_back(std::move(fills[fill].members));
+		}
+		return fragments;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include "glm/glm.hpp"
+
+#include "voxel_chunk.h"
+
+namespace pmk
+{
+	constexpr uint32_t LABELING_BLOCK_WIDTH{ renderer::VOXEL_BRICK_WIDTH }; // Voxels along each dimension of a block labeled by a single thread, one block per voxel brick.
+
+	// Per material lookup tables, indexed by physics material index.
+	using MaterialMask = std::array<uint8_t, 256>;
+	using MaterialMasses = std::array<float, 256>;
+
+	// Connected voxels and their mass properties.
+	struct VoxelComponent
+	{
+		uint32_t root;             // Lowest voxel index in the component.
+		uint32_t voxel_count;
+		float mass;                // In kilograms.
+		glm::vec3 center_of_mass;  // In voxel coordinates.
+		glm::mat3 inertia_tensor;  // In kilogram meter squared, about the center of mass.
+		glm::uvec3 min_extents;
+		glm::uvec3 max_extents;
+	};
+
+	// Label 6-connected voxels whose material is set in material_mask, and compute the mass, center of mass,
+	// and inertia tensor of each component in the same pass.
+	//
+	// The chunk is split into blocks that are labeled in parallel with union-find, each accumulating partial sums per local root.
+	// Blocks are the voxel bricks of the chunk, so empty bricks are skipped.
+	// Roots are then merged across block faces and the partial sums are merged by their final root.
+	//
+	// Components are ordered by root. If out_labels is not null it is filled with the component index of each voxel,
+	// or NULL_INDEX for voxels not in any component.
+	std::vector<VoxelComponent> LabelVoxelComponents(
+		const renderer::VoxelChunk& voxel_chunk,
+		const MaterialMask& material_mask,
+		const MaterialMasses& material_masses,
+		std::vector<uint32_t>* out_labels);
+
+	// Find the parts of the chunk that are no longer connected to the rest after voxels were removed.
+	// Seeds are occupied voxels next to the removed voxels, and a flood fill grows from each seed in turn,
+	// merging when they meet. A flood fill that runs out of voxels has enclosed a fragment, so the cost is
+	// proportional to the size of the fragments rather than the size of the chunk.
+	//
+	// Returns the voxel indices of each fragment. The largest part is never returned as a fragment.
+	std::vector<std::vector<uint32_t>> FindDetachedFragments(const renderer::VoxelChunk& voxel_chunk, const std::vector<glm::uvec3>& seeds);
+}
@@ -0,0 +1,368 @@
+#include "distance_field.h"
+
+#include <algorithm>
+#include <execution>
+#include <ranges>
+#include <cmath>
+#include "tracy/Tracy.hpp"
+
+#include "common_constants.h"
+
+namespace pmk
+{
+	constexpr uint32_t BRICK_OUTSIDE{ NULL_INDEX };     // Brick is entirely outside the narrow band, so every sample is +band.
+	constexpr uint32_t BRICK_INSIDE{ NULL_INDEX - 1 };  // Brick is entirely inside the narrow band, so every sample is -band.
+	constexpr float EDT_INFINITY{ 1.0e20f };            // Finite stand-in for infinity so the transform never computes inf - inf.
+
+	// One dimensional squared Euclidean distance transform from Felzenszwalb and Huttenlocher,
+	// "Distance Transforms of Sampled Functions". Computes d[q] = min_p((q - p)^2 + f[p]) in linear time.
+	static void DistanceTransform1D(const std::vector<float>& f, std::vector<float>& d, std::vector<int32_t>& v, std::vector<float>& z)
+	{
+		const int32_t n{ (int32_t)f.size() };
+		int32_t k{ 0 };
+		v[0] = 0;
+		z[0] = -EDT_INFINITY;
+		z[1] = EDT_INFINITY;
+
+		for (int32_t q{ 1 }; q < n; ++q)
+		{
+			float s{ ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]) };
+			while (s <= z[k])
+			{
+				--k;
+				s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+			}
+			++k;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = EDT_INFINITY;
+		}
+
+		k = 0;
+		for (int32_t q{ 0 }; q < n; ++q)
+		{
+			while (z[k + 1] < q) {
+				++k;
+			}
+			float diff{ (float)(q - v[k]) };
+			d[q] = diff * diff + f[v[k]];
+		}
+	}
+
+	// Apply the one dimensional transform along every line of the grid in the given axis.
+	static void DistanceTransformAxis(std::vector<float>& grid, const glm::uvec3& dimensions, uint32_t axis)
+	{
+		const uint32_t slice{ dimensions.x * dimensions.y };
+		const uint32_t strides[3]{ 1, dimensions.x, slice };
+		const uint32_t n{ dimensions[axis] };
+		const uint32_t u_axis{ (axis + 1) % 3 };
+		const uint32_t v_axis{ (axis + 2) % 3 };
+		const uint32_t line_count{ dimensions[u_axis] * dimensions[v_axis] };
+
+		auto lines{ std::views::iota(0u, line_count) };
+		std::for_each(std::execution::par, lines.begin(), lines.end(),
+			[&](uint32_t line) {
+				std::vector<float> f(n);
+				std::vector<float> d(n);
+				std::vector<int32_t> v(n);
+				std::vector<float> z(n + 1);
+
+				uint32_t u{ line % dimensions[u_axis] };
+				uint32_t w{ line / dimensions[u_axis] };
+				uint32_t start{ u * strides[u_axis] + w * strides[v_axis] };
+
+				for (uint32_t i{ 0 }; i < n; ++i) {
+					f[i] = grid[start + i * strides[axis]];
+				}
+
+				DistanceTransform1D(f, d, v, z);
+
+				for (uint32_t i{ 0 }; i < n; ++i) {
+					grid[start + i * strides[axis]] = d[i];
+				}
+			});
+	}
+
+	// Clamped signed distances of a window of the padded sample grid, given by its origin and dimensions in samples.
+	// Voxels outside the window are ignored, so the window must extend past the samples of interest by more than the band.
+	static std::vector<float> ComputeWindowField(const renderer::VoxelChunk& voxel_chunk, const glm::uvec3& window_origin, const glm::uvec3& window_dimensions)
+	{
+		const uint32_t slice{ window_dimensions.x * window_dimensions.y };
+		const uint32_t sample_count{ slice * window_dimensions.z };
+
+		// Squared distance to the nearest occupied voxel, and to the nearest empty voxel.
+		std::vector<float> outside(sample_count, EDT_INFINITY);
+		std::vector<float> inside(sample_count, 0.0f);
+		std::vector<uint8_t> occupied(sample_count, 0);
+
+		// Voxels of the chunk that overlap the window.
+		const glm::ivec3 voxel_dimensions{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() };
+		const glm::ivec3 voxel_begin{ glm::max(glm::ivec3{ window_origin } - (int32_t)DISTANCE_FIELD_PADDING, glm::ivec3{ 0 }) };
+		const glm::ivec3 voxel_end{ glm::min(glm::ivec3{ window_origin + window_dimensions } - (int32_t)DISTANCE_FIELD_PADDING, voxel_dimensions) };
+
+		if (glm::all(glm::lessThan(voxel_begin, voxel_end)))
+		{
+			voxel_chunk.ForEachOccupied(glm::uvec3{ voxel_begin }, glm::uvec3{ voxel_end - 1 }, [&](uint32_t voxel_idx, const glm::uvec3& coord, const renderer::Voxel& voxel) {
+				glm::uvec3 sample{ coord + DISTANCE_FIELD_PADDING - window_origin };
+				uint32_t idx{ sample.x + sample.y * window_dimensions.x + sample.z * slice };
+				occupied[idx] = 1;
+				outside[idx] = 0.0f;
+				inside[idx] = EDT_INFINITY;
+				});
+		}
+
+		for (uint32_t axis{ 0 }; axis < 3; ++axis)
+		{
+			DistanceTransformAxis(outside, window_dimensions, axis);
+			DistanceTransformAxis(inside, window_dimensions, axis);
+		}
+
+		// Distances are between voxel centers, so offset by half a voxel to put the zero crossing on the voxel faces.
+		std::vector<float> field(sample_count);
+		auto indices{ std::views::iota(0u, sample_count) };
+		std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+			[&](uint32_t idx) {
+				float distance{ occupied[idx] ? 0.5f - std::sqrt(inside[idx]) : std::sqrt(outside[idx]) - 0.5f };
+				field[idx] = std::clamp(distance, -DISTANCE_FIELD_BAND, DISTANCE_FIELD_BAND);
+			});
+
+		return field;
+	}
+
+	void SparseDistanceField::Build(const renderer::VoxelChunk& voxel_chunk)
+	{
+		ZoneScoped;
+
+		glm::uvec3 voxel_dimensions{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() };
+		glm::uvec3 padded_dimensions{ voxel_dimensions + 2u * DISTANCE_FIELD_PADDING };
+
+		// Round the sample grid up to whole bricks so every brick is fully populated.
+		brick_dimensions_ = (padded_dimensions + DISTANCE_FIELD_BRICK_WIDTH - 1u) / DISTANCE_FIELD_BRICK_WIDTH;
+		sample_dimensions_ = brick_dimensions_ * DISTANCE_FIELD_BRICK_WIDTH;
+
+		const uint32_t slice{ sample_dimensions_.x * sample_dimensions_.y };
+		std::vector<float> field{ ComputeWindowField(voxel_chunk, glm::uvec3{ 0 }, sample_dimensions_) };
+
+		// Only keep the bricks that intersect the narrow band.
+		brick_map_.clear();
+		brick_map_.resize((size_t)brick_dimensions_.x * brick_dimensions_.y * brick_dimensions_.z, BRICK_OUTSIDE);
+		bricks_.clear();
+		free_bricks_.clear();
+
+		for (uint32_t bz{ 0 }; bz < brick_dimensions_.z; ++bz)
+		{
+			for (uint32_t by{ 0 }; by < brick_dimensions_.y; ++by)
+			{
+				for (uint32_t bx{ 0 }; bx < brick_dimensions_.x; ++bx)
+				{
+					uint32_t brick_idx{ bx + by * brick_dimensions_.x + bz * brick_dimensions_.x * brick_dimensions_.y };
+					glm::uvec3 origin{ glm::uvec3{ bx, by, bz } * DISTANCE_FIELD_BRICK_WIDTH };
+
+					float min_distance{ DISTANCE_FIELD_BAND };
+					float max_distance{ -DISTANCE_FIELD_BAND };
+					for (uint32_t k{ 0 }; k < DISTANCE_FIELD_BRICK_WIDTH; ++k)
+					{
+						for (uint32_t j{ 0 }; j < DISTANCE_FIELD_BRICK_WIDTH; ++j)
+						{
+							for (uint32_t i{ 0 }; i < DISTANCE_FIELD_BRICK_WIDTH; ++i)
+							{
+								float distance{ field[(origin.x + i) + (origin.y + j) * sample_dimensions_.x + (origin.z + k) * slice] };
+								min_distance = std::min(min_distance, distance);
+								max_distance = std::max(max_distance, distance);
+							}
+						}
+					}
+
+					if (min_distance >= DISTANCE_FIELD_BAND) {
+						continue; // Already BRICK_OUTSIDE.
+					}
+					if (max_distance <= -DISTANCE_FIELD_BAND)
+					{
+						brick_map_[brick_idx] = BRICK_INSIDE;
+						continue;
+					}
+
+					brick_map_[brick_idx] = (uint32_t)(bricks_.size() / DISTANCE_FIELD_BRICK_SAMPLE_COUNT);
+					for (uint32_t k{ 0 }; k < DISTANCE_FIELD_BRICK_WIDTH; ++k)
+					{
+						for (uint32_t j{ 0 }; j < DISTANCE_FIELD_BRICK_WIDTH; ++j)
+						{
+							for (uint32_t i{ 0 }; i < DISTANCE_FIELD_BRICK_WIDTH; ++i) {
+								bricks_.push_back(field[(origin.x + i) + (origin.y + j) * sample_dimensions_.x + (origin.z + k) * slice]);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void SparseDistanceField::Update(const renderer::VoxelChunk& voxel_chunk, const glm::uvec3& min_coord, const glm::uvec3& max_coord)
+	{
+		ZoneScoped;
+
+		// A clamped sample only depends on voxels closer than the band, so only samples this close to the edits can change,
+		// and they only need the voxels this much further out.
+		const int32_t reach{ (int32_t)std::ceil(DISTANCE_FIELD_BAND) + 1 };
+		const glm::ivec3 last_sample{ glm::ivec3{ sample_dimensions_ } - 1 };
+
+		glm::ivec3 dirty_min{ glm::max(glm::ivec3{ min_coord } + (int32_t)DISTANCE_FIELD_PADDING - reach, glm::ivec3{ 0 }) };
+		glm::ivec3 dirty_max{ glm::min(glm::ivec3{ max_coord } + (int32_t)DISTANCE_FIELD_PADDING + reach, last_sample) };
+		glm::ivec3 window_min{ glm::max(dirty_min - reach, glm::ivec3{ 0 }) };
+		glm::ivec3 window_max{ glm::min(dirty_max + reach, last_sample) };
+
+		glm::uvec3 window_dimensions{ window_max - window_min + 1 };
+		std::vector<float> field{ ComputeWindowField(voxel_chunk, glm::uvec3{ window_min }, window_dimensions) };
+		const uint32_t window_slice{ window_dimensions.x * window_dimensions.y };
+
+		glm::uvec3 brick_min{ glm::uvec3{ dirty_min } / DISTANCE_FIELD_BRICK_WIDTH };
+		glm::uvec3 brick_max{ glm::uvec3{ dirty_max } / DISTANCE_FIELD_BRICK_WIDTH };
+		for (uint32_t bz{ brick_min.z }; bz <= brick_max.z; ++bz)
+		{
+			for (uint32_t by{ brick_min.y }; by <= brick_max.y; ++by)
+			{
+				for (uint32_t bx{ brick_min.x }; bx <= brick_max.x; ++bx)
+				{
+					uint32_t brick_idx{ bx + by * brick_dimensions_.x + bz * brick_dimensions_.x * brick_dimensions_.y };
+					glm::ivec3 origin{ glm::uvec3{ bx, by, bz } * DISTANCE_FIELD_BRICK_WIDTH };
+
+					// Allocate implicit bricks filled with their implicit value, reusing freed slots first.
+					uint32_t brick{ brick_map_[brick_idx] };
+					if (brick == BRICK_OUTSIDE || brick == BRICK_INSIDE)
+					{
+						float fill{ brick == BRICK_OUTSIDE ? DISTANCE_FIELD_BAND : -DISTANCE_FIELD_BAND };
+						if (free_bricks_.empty())
+						{
+							brick = (uint32_t)(bricks_.size() / DISTANCE_FIELD_BRICK_SAMPLE_COUNT);
+							bricks_.resize(bricks_.size() + DISTANCE_FIELD_BRICK_SAMPLE_COUNT, fill);
+						}
+						else
+						{
+							brick = free_bricks_.back();
+							free_bricks_.pop_back();
+							std::fill_n(bricks_.begin() + (size_t)brick * DISTANCE_FIELD_BRICK_SAMPLE_COUNT, DISTANCE_FIELD_BRICK_SAMPLE_COUNT, fill);
+						}
+						brick_map_[brick_idx] = brick;
+					}
+
+					glm::ivec3 begin{ glm::max(origin, dirty_min) };
+					glm::ivec3 end{ glm::min(origin + (int32_t)DISTANCE_FIELD_BRICK_WIDTH - 1, dirty_max) };
+					for (int32_t k{ begin.z }; k <= end.z; ++k)
+					{
+						for (int32_t j{ begin.y }; j <= end.y; ++j)
+						{
+							for (int32_t i{ begin.x }; i <= end.x; ++i)
+							{
+								glm::ivec3 local{ glm::ivec3{ i, j, k } - origin };
+								glm::ivec3 window{ glm::ivec3{ i, j, k } - window_min };
+								bricks_[brick * DISTANCE_FIELD_BRICK_SAMPLE_COUNT + local.x + local.y * DISTANCE_FIELD_BRICK_WIDTH + local.z * DISTANCE_FIELD_BRICK_WIDTH * DISTANCE_FIELD_BRICK_WIDTH] =
+									field[window.x + window.y * window_dimensions.x + window.z * window_slice];
+							}
+						}
+					}
+
+					// Free bricks that left the narrow band, such as bricks that were carved away, so the field stays sparse.
+					auto samples{ bricks_.begin() + (size_t)brick * DISTANCE_FIELD_BRICK_SAMPLE_COUNT };
+					auto [min_distance, max_distance] { std::minmax_element(samples, samples + DISTANCE_FIELD_BRICK_SAMPLE_COUNT) };
+					if (*min_distance >= DISTANCE_FIELD_BAND || *max_distance <= -DISTANCE_FIELD_BAND)
+					{
+						brick_map_[brick_idx] = *min_distance >= DISTANCE_FIELD_BAND ? BRICK_OUTSIDE : BRICK_INSIDE;
+						free_bricks_.push_back(brick);
+					}
+				}
+			}
+		}
+	}
+
+	float SparseDistanceField::Distance(const glm::vec3& coord_space) const
+	{
+		float c[8]{};
+		glm::vec3 t{};
+		GatherCorners(coord_space, c, &t);
+
+		float c00{ glm::mix(c[0], c[1], t.x) };
+		float c10{ glm::mix(c[2], c[3], t.x) };
+		float c01{ glm::mix(c[4], c[5], t.x) };
+		float c11{ glm::mix(c[6], c[7], t.x) };
+		return glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+	}
+
+	float SparseDistanceField::DistanceAndGradient(const glm::vec3& coord_space, glm::vec3* out_gradient) const
+	{
+		float c[8]{};
+		glm::vec3 t{};
+		GatherCorners(coord_space, c, &t);
+
+		float c00{ glm::mix(c[0], c[1], t.x) };
+		float c10{ glm::mix(c[2], c[3], t.x) };
+		float c01{ glm::mix(c[4], c[5], t.x) };
+		float c11{ glm::mix(c[6], c[7], t.x) };
+		float c0{ glm::mix(c00, c10, t.y) };
+		float c1{ glm::mix(c01, c11, t.y) };
+
+		// Partial derivatives of the trilinear interpolation.
+		float dx00{ c[1] - c[0] };
+		float dx10{ c[3] - c[2] };
+		float dx01{ c[5] - c[4] };
+		float dx11{ c[7] - c[6] };
+		*out_gradient = glm::vec3{
+			glm::mix(glm::mix(dx00, dx10, t.y), glm::mix(dx01, dx11, t.y), t.z),
+			glm::mix(c10 - c00, c11 - c01, t.z),
+			c1 - c0,
+		};
+
+		return glm::mix(c0, c1, t.z);
+	}
+
+	uint32_t SparseDistanceField::GetAllocatedBrickCount() const
+	{
+		return (uint32_t)(bricks_.size() / DISTANCE_FIELD_BRICK_SAMPLE_COUNT - free_bricks_.size());
+	}
+
+	float SparseDistanceField::Sample(int32_t i, int32_t j, int32_t k) const
+	{
+		// Casting to unsigned makes negative coordinates out of bounds as well.
+		if ((uint32_t)i >= sample_dimensions_.x || (uint32_t)j >= sample_dimensions_.y || (uint32_t)k >= sample_dimensions_.z) {
+			return DISTANCE_FIELD_BAND;
+		}
+
+		uint32_t bx{ (uint32_t)i / DISTANCE_FIELD_BRICK_WIDTH };
+		uint32_t by{ (uint32_t)j / DISTANCE_FIELD_BRICK_WIDTH };
+		uint32_t bz{ (uint32_t)k / DISTANCE_FIELD_BRICK_WIDTH };
+		uint32_t brick{ brick_map_[bx + by * brick_dimensions_.x + bz * brick_dimensions_.x * brick_dimensions_.y] };
+
+		if (brick == BRICK_OUTSIDE) {
+			return DISTANCE_FIELD_BAND;
+		}
+		if (brick == BRICK_INSIDE) {
+			return -DISTANCE_FIELD_BAND;
+		}
+
+		uint32_t local{
+			((uint32_t)i % DISTANCE_FIELD_BRICK_WIDTH) +
+			((uint32_t)j % DISTANCE_FIELD_BRICK_WIDTH) * DISTANCE_FIELD_BRICK_WIDTH +
+			((uint32_t)k % DISTANCE_FIELD_BRICK_WIDTH) * DISTANCE_FIELD_BRICK_WIDTH * DISTANCE_FIELD_BRICK_WIDTH };
+		return bricks_[brick * DISTANCE_FIELD_BRICK_SAMPLE_COUNT + local];
+	}
+
+	void SparseDistanceField::GatherCorners(const glm::vec3& coord_space, float out_corners[8], glm::vec3* out_t) const
+	{
+		glm::vec3 grid_pos{ coord_space + (float)DISTANCE_FIELD_PADDING };
+		glm::vec3 base{ glm::floor(grid_pos) };
+		*out_t = grid_pos - base;
+
+		int32_t i{ (int32_t)base.x };
+		int32_t j{ (int32_t)base.y };
+		int32_t k{ (int32_t)base.z };
+
+		// Corner index is dx + 2 * dy + 4 * dz.
+		out_corners[0] = Sample(i, j, k);
+		out_corners[1] = Sample(i + 1, j, k);
+		out_corners[2] = Sample(i, j + 1, k);
+		out_corners[3] = Sample(i + 1, j + 1, k);
+		out_corners[4] = Sample(i, j, k + 1);
+		out_corners[5] = Sample(i + 1, j, k + 1);
+		out_corners[6] = Sample(i, j + 1, k + 1);
+		out_corners[7] = Sample(i + 1, j + 1, k + 1);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "glm/glm.hpp"
+
+#include "voxel_chunk.h"
+
+namespace pmk
+{
+	constexpr uint32_t DISTANCE_FIELD_BRICK_WIDTH{ 8 };   // Samples along each dimension of a brick.
+	constexpr uint32_t DISTANCE_FIELD_BRICK_SAMPLE_COUNT{ DISTANCE_FIELD_BRICK_WIDTH * DISTANCE_FIELD_BRICK_WIDTH * DISTANCE_FIELD_BRICK_WIDTH };
+	constexpr uint32_t DISTANCE_FIELD_PADDING{ 2 };       // Samples of padding around the voxels so the field extends outside the surface.
+	constexpr float DISTANCE_FIELD_BAND{ 3.0f };          // Distances are clamped to [-band, band], in voxel widths.
+
+	// Sparse signed distance field of a voxel chunk, stored as a brick map.
+	// Only bricks containing samples within the narrow band around the surface are allocated.
+	// Bricks entirely outside the band are implicitly +band, and bricks entirely inside are implicitly -band.
+	//
+	// All positions are in coordinate space, where one unit is one voxel width and voxel centers lie on integer coordinates.
+	// Distances are in voxel widths, negative inside the voxels.
+	class SparseDistanceField
+	{
+	public:
+		// Build the distance field from the voxels of a chunk. Called when the rigid body is created or its chunk is resized.
+		void Build(const renderer::VoxelChunk& voxel_chunk);
+
+		// Recompute the samples affected by voxel edits between min_coord and max_coord inclusive, in voxel coordinates.
+		// Bricks that leave the narrow band are freed and their slots reused. The chunk dimensions must be unchanged since the field was built.
+		void Update(const renderer::VoxelChunk& voxel_chunk, const glm::uvec3& min_coord, const glm::uvec3& max_coord);
+
+		// Trilinearly interpolated signed distance at the coordinate space position.
+		float Distance(const glm::vec3& coord_space) const;
+
+		// Trilinearly interpolated signed distance and its gradient at the coordinate space position.
+		// The gradient is the derivative of the interpolation so normals are continuous across voxel faces.
+		float DistanceAndGradient(const glm::vec3& coord_space, glm::vec3* out_gradient) const;
+
+		// Number of bricks with allocated samples, not counting freed slots.
+		uint32_t GetAllocatedBrickCount() const;
+
+	private:
+		// Sample of the padded grid, returning band values for implicit bricks and out of bounds samples.
+		float Sample(int32_t i, int32_t j, int32_t k) const;
+
+		// Gather the 8 samples surrounding the position. Returns the interpolation weights in out_t.
+		void GatherCorners(const glm::vec3& coord_space, float out_corners[8], glm::vec3* out_t) const;
+
+		glm::uvec3 sample_dimensions_{};   // Dimensions of the padded sample grid.
+		glm::uvec3 brick_dimensions_{};    // Number of bricks along each dimension.
+		std::vector<uint32_t> brick_map_{}; // Index into bricks_ of each brick, or one of the implicit brick sentinels.
+		std::vector<float> bricks_{};       // Allocated brick samples, DISTANCE_FIELD_BRICK_SAMPLE_COUNT per brick.
+		std::vector<uint32_t> free_bricks_{}; // Slots of bricks_ freed by Update(), reused before growing bricks_.
+	};
+}
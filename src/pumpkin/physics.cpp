@@ -54,6 +54,10 @@ namespace pmk
 		constexpr uint32_t substeps{ 3 };
 		float h{ delta_time / substeps };
 
+		if (rigid_body_context_.GetPhysicsUpdateEnabled()) {
+			rigid_body_context_.GetArena().PullEditedNodes();
+		}
+
 		for (uint32_t i{ 0 }; i < substeps; ++i)
 		{
 			rigid_body_context_.PhysicsUpdate(h);
@@ -61,6 +65,10 @@ namespace pmk
 			rigid_body_context_.UpdateFromParticles(h, voxel_context_.GetXPBDContext());
 		}
 
+		if (rigid_body_context_.GetPhysicsUpdateEnabled()) {
+			rigid_body_context_.GetArena().PushToNodes();
+		}
+
 #ifdef EDITOR_ENABLED
 		if (rigid_body_context_.GetPhysicsUpdateEnabled()) {
 			rigid_body_context_.GenerateDynamicDebugRbVoxelInstances();
@@ -185,6 +193,26 @@ namespace pmk
 		return physics_materials_[physics_mat_index];
 	}
 
+	RigidBodyArena& PhysicsContext::GetRigidBodyArena()
+	{
+		return rigid_body_context_.GetArena();
+	}
+
+	const RigidBodySleepStats& PhysicsContext::GetRigidBodySleepStats() const
+	{
+		return rigid_body_context_.GetSleepStats();
+	}
+
+	std::vector<RigidBodyHandle> PhysicsContext::RemoveRigidBodyVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords)
+	{
+		return rigid_body_context_.RemoveVoxels(handle, coords);
+	}
+
+	void PhysicsContext::AddRigidBodyVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels)
+	{
+		rigid_body_context_.AddVoxels(handle, voxels);
+	}
+
 	XPBDConstraint* PhysicsContext::NewConstraint()
 	{
 		FluidCollisionConstraint* constraint{ new FluidCollisionConstraint{} };
@@ -321,6 +349,11 @@ namespace pmk
 		UpdatePhysicsRenderMaterials();
 	}
 
+	void PhysicsContext::SetFluidSurfaceEnabled(bool enabled)
+	{
+		voxel_context_.SetFluidSurfaceEnabled(enabled);
+	}
+
 #ifdef EDITOR_ENABLED
 	void PhysicsContext::SetMPMDebugParticleGenEnabled(bool enabled)
 	{
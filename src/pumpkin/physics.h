@@ -56,6 +56,16 @@ namespace pmk
 
 		PhysicsMaterial* GetPhysicsMaterial(uint8_t physics_mat_index);
 
+		RigidBodyArena& GetRigidBodyArena();
+
+		const RigidBodySleepStats& GetRigidBodySleepStats() const;
+
+		// Remove voxels of a rigid body, splitting off disconnected parts into new rigid bodies, which are returned.
+		std::vector<RigidBodyHandle> RemoveRigidBodyVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords);
+
+		// Add or replace voxels within the voxel chunk of a rigid body.
+		void AddRigidBodyVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels);
+
 		XPBDConstraint* NewConstraint();
 
 		void DeleteConstraint(uint32_t selected_idx);
@@ -80,6 +90,9 @@ namespace pmk
 
 		void LoadPhysicsMaterials(nlohmann::json& j);
 
+		// Mesh particles of fluid materials as a smooth surface instead of cubes.
+		void SetFluidSurfaceEnabled(bool enabled);
+
 #ifdef EDITOR_ENABLED
 		void SetMPMDebugParticleGenEnabled(bool enabled);
 
@@ -37,6 +37,28 @@ namespace pmk
 			scene_.ParticlePhysicsUpdate(PHYSICS_UPDATE_TIME);
 			physics_time_accumulator_ = 0.0f;
 		}
+
+		if (chunk_streaming_enabled_)
+		{
+			chunk_streamer_.Update(scene_.GetCamera().position);
+			IntegrateStreamedChunks();
+		}
+	}
+
+	void Pumpkin::IntegrateStreamedChunks()
+	{
+		ZoneScoped;
+		for (const glm::ivec3& chunk_coord : chunk_streamer_.GetEvictedChunks()) {
+			scene_.RemoveStreamedChunk(chunk_coord);
+		}
+
+		// Chunks loaded and evicted by the same update are no longer resident.
+		for (const glm::ivec3& chunk_coord : chunk_streamer_.GetLoadedChunks())
+		{
+			if (const renderer::VoxelChunk* chunk{ chunk_streamer_.GetChunk(chunk_coord) }) {
+				scene_.AddStreamedChunk(chunk_coord, *chunk);
+			}
+		}
 	}
 
 	void Pumpkin::HostRenderWork()
@@ -63,6 +85,7 @@ namespace pmk
 
 	void Pumpkin::CleanUp()
 	{
+		DisableChunkStreaming();
 		scene_.CleanUp();
 		renderer_.CleanUp();
 		glfwDestroyWindow(window_);
@@ -279,6 +302,11 @@ namespace pmk
 	{
 		renderer_.UpdateParticleGenShaderCustomUBO(custom_ubo);
 	}
+
+	uint32_t Pumpkin::ValidateParticleGenKernel(renderer::ParticleGenKernel kernel, const std::vector<std::byte>& custom_ubo)
+	{
+		return renderer_.ValidateParticleGenKernel(kernel, custom_ubo);
+	}
 #endif
 
 	void Pumpkin::QueueRaycast(const glm::vec3& origin, const glm::vec3& direction)
@@ -335,6 +363,88 @@ namespace pmk
 		renderer_.ImportShader(spirv_path);
 	}
 
+	void Pumpkin::ImportShaders(const std::vector<std::filesystem::path>& spirv_paths)
+	{
+		renderer_.ImportShaders(spirv_paths);
+	}
+
+	void Pumpkin::SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes)
+	{
+		renderer_.SetParticleGenCacheDirectory(directory, max_size_bytes);
+	}
+
+	const renderer::ParticleGenCacheStats& Pumpkin::GetParticleGenCacheStats() const
+	{
+		return renderer_.GetParticleGenCacheStats();
+	}
+
+	const renderer::DynamicParticleMeshStats& Pumpkin::GetDynamicParticleMeshStats() const
+	{
+		return renderer_.GetDynamicParticleMeshStats();
+	}
+
+	const renderer::TlasBuildStats& Pumpkin::GetTlasBuildStats() const
+	{
+		return renderer_.GetTlasBuildStats();
+	}
+
+	const renderer::DynamicBlasStats& Pumpkin::GetDynamicBlasStats() const
+	{
+		return renderer_.GetDynamicBlasStats();
+	}
+
+	const renderer::UploaderStats& Pumpkin::GetUploaderStats() const
+	{
+		return renderer_.GetUploaderStats();
+	}
+
+	std::vector<renderer::MemoryHeapStats> Pumpkin::GetMemoryHeapStats() const
+	{
+		return renderer_.GetMemoryHeapStats();
+	}
+
+	const renderer::PipelineCacheStats& Pumpkin::GetPipelineCacheStats() const
+	{
+		return renderer_.GetPipelineCacheStats();
+	}
+
+	void Pumpkin::SetFluidSurfaceEnabled(bool enabled)
+	{
+		scene_.SetFluidSurfaceEnabled(enabled);
+	}
+
+	const renderer::RasterPassStats& Pumpkin::GetRasterPassStats() const
+	{
+		return renderer_.GetRasterPassStats();
+	}
+
+	void Pumpkin::EnableChunkStreaming(const ChunkStreamingSettings& settings, ChunkGenerator&& generator)
+	{
+		DisableChunkStreaming();
+		chunk_streamer_.Initialize(settings, std::move(generator));
+		chunk_streaming_enabled_ = true;
+	}
+
+	void Pumpkin::DisableChunkStreaming()
+	{
+		if (chunk_streaming_enabled_)
+		{
+			chunk_streamer_.CleanUp();
+			scene_.RemoveStreamedChunks();
+			chunk_streaming_enabled_ = false;
+		}
+	}
+
+	const renderer::VoxelChunk* Pumpkin::GetStreamedChunk(const glm::ivec3& chunk_coord) const
+	{
+		return chunk_streaming_enabled_ ? chunk_streamer_.GetChunk(chunk_coord) : nullptr;
+	}
+
+	const ChunkStreamingStats& Pumpkin::GetChunkStreamingStats() const
+	{
+		return chunk_streamer_.GetStats();
+	}
+
 	void Pumpkin::UpdateDeltaTime()
 	{
 		auto current_time{ std::chrono::steady_clock::now() };
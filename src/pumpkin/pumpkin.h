@@ -8,6 +8,7 @@
 
 #include "vulkan_renderer.h"
 #include "scene.h"
+#include "chunk_streaming.h"
 
 namespace pmk
 {
@@ -127,6 +128,9 @@ namespace pmk
 		void SetParticleGenShader(uint32_t shader_idx, uint32_t custom_ubo_size);
 
 		void UpdateParticleGenShaderCustomUBO(const std::vector<std::byte>& custom_ubo);
+
+		// Number of voxels where the current particle gen shader and the CPU kernel disagree for the custom UBO.
+		uint32_t ValidateParticleGenKernel(renderer::ParticleGenKernel kernel, const std::vector<std::byte>& custom_ubo);
 #endif
 
 		void QueueRaycast(const glm::vec3& origin, const glm::vec3& direction);
@@ -145,10 +149,48 @@ namespace pmk
 
 		void ImportShader(const std::filesystem::path& spirv_path);
 
+		void ImportShaders(const std::vector<std::filesystem::path>& spirv_paths);
+
+		// Cache particle gen shader outputs in the directory, up to max_size_bytes. An empty directory disables the cache.
+		void SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes);
+
+		const renderer::ParticleGenCacheStats& GetParticleGenCacheStats() const;
+
+		const renderer::DynamicParticleMeshStats& GetDynamicParticleMeshStats() const;
+
+		const renderer::TlasBuildStats& GetTlasBuildStats() const;
+
+		const renderer::DynamicBlasStats& GetDynamicBlasStats() const;
+
+		const renderer::UploaderStats& GetUploaderStats() const;
+
+		std::vector<renderer::MemoryHeapStats> GetMemoryHeapStats() const;
+
+		const renderer::PipelineCacheStats& GetPipelineCacheStats() const;
+
+		// Mesh particles of fluid materials, those with a fluid collision constraint, as a smooth surface instead of cubes.
+		void SetFluidSurfaceEnabled(bool enabled);
+
+		const renderer::RasterPassStats& GetRasterPassStats() const;
+
+		// Keep the chunks around the camera resident, made by the generator or read back from the cache directory.
+		// Restarts streaming if it was already enabled.
+		void EnableChunkStreaming(const ChunkStreamingSettings& settings, ChunkGenerator&& generator);
+
+		void DisableChunkStreaming();
+
+		// Returns nullptr if the chunk is not resident or streaming is disabled.
+		const renderer::VoxelChunk* GetStreamedChunk(const glm::ivec3& chunk_coord) const;
+
+		const ChunkStreamingStats& GetChunkStreamingStats() const;
+
 	private:
 		// General work the host needs to do each frame.
 		void HostWork();
 
+		// Render the chunks the streamer loaded in its last update, and stop rendering the ones it evicted.
+		void IntegrateStreamedChunks();
+
 		// Work the host needs to do that modifies the render objects.
 		void HostRenderWork();
 
@@ -157,6 +199,8 @@ namespace pmk
 		GLFWwindow* window_{};
 		renderer::VulkanRenderer renderer_{};
 		Scene scene_{};
+		ChunkStreamer chunk_streamer_{};
+		bool chunk_streaming_enabled_{};
 
 		float delta_time_{};
 		float physics_time_accumulator_{};
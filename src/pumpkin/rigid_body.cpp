@@ -1,12 +1,13 @@
 #include "rigid_body.h"
 
 #include <algorithm>
-#include <queue>
 #include <execution>
-#include <atomic>
+#include <ranges>
+#include <numeric>
 #include "glm/gtc/quaternion.hpp"
 
 #include "scene.h"
+#include "connected_components.h"
 
 namespace pmk
 {
@@ -26,32 +27,25 @@ namespace pmk
 		return {};
 	}
 
-	std::optional<glm::uvec3> RigidBody::GetCollisionCoordinate(const glm::mat4& inv_world_transform, const glm::vec3& global_pos) const
+	glm::vec3 RigidBody::GlobalToCoordinate(const glm::mat4& inv_world_transform, const glm::vec3& global_pos) const
 	{
 		glm::vec3 coord_space{ glm::vec3{inv_world_transform * glm::vec4{global_pos, 1.0f}} / PARTICLE_WIDTH };
-		coord_space += center_of_mass;
+		return coord_space + center_of_mass;
+	}
 
-		uint32_t potential_collision_count{};
-		std::array<glm::uvec3, 8> potential_collisions{ voxel_chunk.GetPotentialCollisions(coord_space, &potential_collision_count) };
+	glm::vec3 RigidBody::SurfaceNormal(const glm::mat4& world_transform, const glm::vec3& coord_space, const glm::vec3& gradient) const
+	{
+		glm::vec3 local_normal{ gradient };
 
-		float closest_sqr{ std::numeric_limits<float>::infinity() };
-		uint32_t closest_idx{};
-		for (uint32_t i{ 0 }; i < potential_collision_count; ++i)
-		{
-			float distance_sqr{ glm::distance2(coord_space, glm::vec3{ potential_collisions[i] }) };
-			if (distance_sqr < closest_sqr)
-			{
-				closest_sqr = distance_sqr;
-				closest_idx = i;
-			}
+		// Gradient vanishes deep inside or far outside the narrow band, so fall back to pointing away from the center of mass.
+		if (glm::dot(local_normal, local_normal) < 1.0e-8f) {
+			local_normal = coord_space - center_of_mass;
 		}
-
-		// Check if it's less than one since we are coord space, where 1 voxel width is 1 unit.
-		if (closest_sqr < 1.0f) {
-			return std::make_optional(potential_collisions[closest_idx]);
+		if (glm::dot(local_normal, local_normal) < 1.0e-8f) {
+			local_normal = glm::vec3{ 0.0f, 1.0f, 0.0f };
 		}
 
-		return std::nullopt;
+		return glm::normalize(glm::mat3{ world_transform } * local_normal);
 	}
 
 	glm::vec3 RigidBody::CoordinateToGlobal(const glm::mat4& world_transform, const glm::uvec3& voxel_coord) const
@@ -63,28 +57,294 @@ namespace pmk
 		return glm::vec3{ world_space };
 	}
 
-	glm::vec3 RigidBody::VelocityProject(const glm::vec3& particle_velocity, const glm::vec3& particle_normal, const glm::vec3& node_position) const
+	RigidBodyHandle RigidBodyArena::Add(RigidBody&& rigid_body, Node* node)
+	{
+		uint32_t slot{ (uint32_t)slot_to_dense_.size() };
+		if (vacant_slots_.empty())
+		{
+			slot_to_dense_.push_back(NULL_INDEX);
+			slot_generations_.push_back(0);
+		}
+		else
+		{
+			slot = vacant_slots_.back();
+			vacant_slots_.pop_back();
+		}
+
+		uint32_t dense_idx{ Size() };
+		slot_to_dense_[slot] = dense_idx;
+		dense_to_slot_.push_back(slot);
+
+		positions.push_back(node->position);
+		rotations.push_back(node->rotation);
+		velocities.push_back({});
+		angular_velocities.push_back({});
+		previous_positions.push_back(node->position);
+		previous_rotations.push_back(node->rotation);
+		inverse_masses.push_back({});
+		inertia_tensors.push_back({});
+		inverse_inertia_tensors.push_back({});
+		immovable.push_back({});
+		point_masses.push_back(rigid_body.voxel_chunk.IsPointMass());
+		world_transforms.push_back({});
+		inv_world_transforms.push_back({});
+		sleep_timers.push_back({});
+		sleeping.push_back({});
+		pending_transform_uploads.push_back(renderer::FRAMES_IN_FLIGHT);
+		bodies_.push_back(std::move(rigid_body));
+		nodes_.push_back(node);
+
+		UpdateMassProperties(dense_idx);
+
+		return RigidBodyHandle{ slot, slot_generations_[slot] };
+	}
+
+	// Move the last element into idx and pop the back.
+	template<typename T>
+	static void SwapRemove(std::vector<T>& v, uint32_t idx)
+	{
+		if (idx != (uint32_t)v.size() - 1) {
+			v[idx] = std::move(v.back());
+		}
+		v.pop_back();
+	}
+
+	void RigidBodyArena::Remove(RigidBodyHandle handle)
 	{
-		glm::vec3 world_velocity{ WorldVelocity(node_position) };
-		return world_velocity + BoundaryProject(particle_velocity - world_velocity, particle_normal, boundary_condition, dynamic_friction);
+		uint32_t dense_idx{ DenseIndex(handle) };
+		if (dense_idx == NULL_INDEX)
+		{
+			logger::Error("Removing rigid body with stale handle.\n");
+			return;
+		}
+
+		// The last rigid body is moved into the removed one's dense index.
+		uint32_t last_slot{ dense_to_slot_.back() };
+		slot_to_dense_[last_slot] = dense_idx;
+
+		SwapRemove(positions, dense_idx);
+		SwapRemove(rotations, dense_idx);
+		SwapRemove(velocities, dense_idx);
+		SwapRemove(angular_velocities, dense_idx);
+		SwapRemove(previous_positions, dense_idx);
+		SwapRemove(previous_rotations, dense_idx);
+		SwapRemove(inverse_masses, dense_idx);
+		SwapRemove(inertia_tensors, dense_idx);
+		SwapRemove(inverse_inertia_tensors, dense_idx);
+		SwapRemove(immovable, dense_idx);
+		SwapRemove(point_masses, dense_idx);
+		SwapRemove(world_transforms, dense_idx);
+		SwapRemove(inv_world_transforms, dense_idx);
+		SwapRemove(sleep_timers, dense_idx);
+		SwapRemove(sleeping, dense_idx);
+		SwapRemove(pending_transform_uploads, dense_idx);
+		SwapRemove(bodies_, dense_idx);
+		SwapRemove(nodes_, dense_idx);
+		SwapRemove(dense_to_slot_, dense_idx);
+
+		slot_to_dense_[handle.slot] = NULL_INDEX;
+		++slot_generations_[handle.slot];
+		vacant_slots_.push_back(handle.slot);
+	}
+
+	void RigidBodyArena::Clear()
+	{
+		// Invalidate outstanding handles rather than reusing generations.
+		for (uint32_t slot : dense_to_slot_)
+		{
+			slot_to_dense_[slot] = NULL_INDEX;
+			++slot_generations_[slot];
+			vacant_slots_.push_back(slot);
+		}
+
+		positions.clear();
+		rotations.clear();
+		velocities.clear();
+		angular_velocities.clear();
+		previous_positions.clear();
+		previous_rotations.clear();
+		inverse_masses.clear();
+		inertia_tensors.clear();
+		inverse_inertia_tensors.clear();
+		immovable.clear();
+		point_masses.clear();
+		world_transforms.clear();
+		inv_world_transforms.clear();
+		sleep_timers.clear();
+		sleeping.clear();
+		pending_transform_uploads.clear();
+		bodies_.clear();
+		nodes_.clear();
+		dense_to_slot_.clear();
+	}
+
+	uint32_t RigidBodyArena::Size() const
+	{
+		return (uint32_t)bodies_.size();
+	}
+
+	uint32_t RigidBodyArena::DenseIndex(RigidBodyHandle handle) const
+	{
+		if (handle.slot >= (uint32_t)slot_to_dense_.size() || slot_generations_[handle.slot] != handle.generation) {
+			return NULL_INDEX;
+		}
+		return slot_to_dense_[handle.slot];
 	}
 
-	glm::vec3 RigidBody::WorldVelocity(const glm::vec3& world_position) const
+	RigidBodyHandle RigidBodyArena::Handle(uint32_t dense_idx) const
 	{
-		return velocity + glm::cross(angular_velocity, world_position - node->position);
+		uint32_t slot{ dense_to_slot_[dense_idx] };
+		return RigidBodyHandle{ slot, slot_generations_[slot] };
 	}
 
-	void RigidBody::ApplyImpulse(const glm::vec3& impulse, const glm::vec3& point_of_application)
+	RigidBody& RigidBodyArena::Body(uint32_t dense_idx)
 	{
+		return bodies_[dense_idx];
+	}
+
+	const RigidBody& RigidBodyArena::Body(uint32_t dense_idx) const
+	{
+		return bodies_[dense_idx];
+	}
+
+	Node* RigidBodyArena::GetNode(uint32_t dense_idx) const
+	{
+		return nodes_[dense_idx];
+	}
+
+	void RigidBodyArena::UpdateMassProperties(uint32_t dense_idx)
+	{
+		const RigidBody& rb{ bodies_[dense_idx] };
+		immovable[dense_idx] = rb.immovable;
+		inverse_masses[dense_idx] = rb.immovable ? 0.0f : 1.0f / rb.mass;
+		inertia_tensors[dense_idx] = rb.inertia_tensor;
+		inverse_inertia_tensors[dense_idx] = rb.immovable || point_masses[dense_idx] ? glm::mat3{} : glm::inverse(rb.inertia_tensor);
+	}
+
+	glm::mat4 RigidBodyArena::WorldTransform(uint32_t dense_idx) const
+	{
+		// Rigid body nodes are children of the root node, so their local transform is their world transform.
+		glm::mat4 transform{ glm::mat4_cast(rotations[dense_idx]) };
+		transform[3] = glm::vec4{ positions[dense_idx], 1.0f };
+		return transform;
+	}
+
+	void RigidBodyArena::CacheTransforms()
+	{
+		auto indices{ std::views::iota(0u, Size()) };
+		std::for_each(std::execution::par_unseq, indices.begin(), indices.end(),
+			[&](uint32_t i) {
+				// Sleeping rigid bodies don't move, so their cached transforms are still valid.
+				if (sleeping[i]) {
+					return;
+				}
+				world_transforms[i] = WorldTransform(i);
+				inv_world_transforms[i] = glm::inverse(world_transforms[i]);
+			});
+	}
+
+	void RigidBodyArena::PullFromNodes()
+	{
+		WakeAll();
+		for (uint32_t i{ 0 }; i < Size(); ++i)
+		{
+			positions[i] = nodes_[i]->position;
+			rotations[i] = nodes_[i]->rotation;
+			UpdateMassProperties(i);
+		}
+		CacheTransforms();
+	}
+
+	void RigidBodyArena::PushToNodes()
+	{
+		for (uint32_t i{ 0 }; i < Size(); ++i)
+		{
+			if (sleeping[i]) {
+				continue;
+			}
+
+			nodes_[i]->position = positions[i];
+			nodes_[i]->rotation = rotations[i];
+			pending_transform_uploads[i] = renderer::FRAMES_IN_FLIGHT;
+		}
+	}
+
+	void RigidBodyArena::PullEditedNodes()
+	{
+		for (uint32_t i{ 0 }; i < Size(); ++i)
+		{
+			Node* node{ nodes_[i] };
+			if (!node->transform_edited) {
+				continue;
+			}
+
+			positions[i] = node->position;
+			rotations[i] = node->rotation;
+			previous_positions[i] = node->position;
+			previous_rotations[i] = node->rotation;
+			world_transforms[i] = WorldTransform(i);
+			inv_world_transforms[i] = glm::inverse(world_transforms[i]);
+			pending_transform_uploads[i] = renderer::FRAMES_IN_FLIGHT;
+			node->transform_edited = false;
+			Wake(i);
+		}
+	}
+
+	void RigidBodyArena::Wake(uint32_t dense_idx)
+	{
+		sleeping[dense_idx] = false;
+		sleep_timers[dense_idx] = 0.0f;
+	}
+
+	void RigidBodyArena::WakeAll()
+	{
+		std::fill(sleeping.begin(), sleeping.end(), (uint8_t)false);
+		std::fill(sleep_timers.begin(), sleep_timers.end(), 0.0f);
+	}
+
+	bool RigidBodyArena::ConsumeTransformUpload(RigidBodyHandle handle)
+	{
+		uint32_t dense_idx{ DenseIndex(handle) };
+		if (dense_idx == NULL_INDEX) {
+			return true;
+		}
+
+		if (pending_transform_uploads[dense_idx] > 0)
+		{
+			--pending_transform_uploads[dense_idx];
+			return true;
+		}
+		return !sleeping[dense_idx];
+	}
+
+	glm::vec3 RigidBodyArena::WorldVelocity(uint32_t dense_idx, const glm::vec3& world_position) const
+	{
+		return velocities[dense_idx] + glm::cross(angular_velocities[dense_idx], world_position - positions[dense_idx]);
+	}
+
+	glm::vec3 RigidBodyArena::VelocityProject(uint32_t dense_idx, const glm::vec3& particle_velocity, const glm::vec3& particle_normal, const glm::vec3& world_position) const
+	{
+		const RigidBody& rb{ bodies_[dense_idx] };
+		glm::vec3 world_velocity{ WorldVelocity(dense_idx, world_position) };
+		return world_velocity + BoundaryProject(particle_velocity - world_velocity, particle_normal, rb.boundary_condition, rb.dynamic_friction);
+	}
+
+	void RigidBodyArena::ApplyImpulse(uint32_t dense_idx, const glm::vec3& impulse, const glm::vec3& point_of_application)
+	{
+		Wake(dense_idx);
+
+		glm::vec3& velocity{ velocities[dense_idx] };
+		glm::vec3& angular_velocity{ angular_velocities[dense_idx] };
+
 		// Calculate the change in linear velocity due to the impulse.
-		glm::vec3 linear_velocity_change{ impulse / mass };
+		glm::vec3 linear_velocity_change{ impulse * inverse_masses[dense_idx] };
 
 		// Update the linear velocity.
 		velocity += linear_velocity_change;
 
 		// Calculate the change in angular velocity due to the impulse.
-		glm::vec3 r{ point_of_application - node->position };
-		glm::vec3 angular_velocity_change{ glm::inverse(inertia_tensor) * glm::cross(r, impulse) };
+		glm::vec3 r{ point_of_application - positions[dense_idx] };
+		glm::vec3 angular_velocity_change{ inverse_inertia_tensors[dense_idx] * glm::cross(r, impulse) };
 
 		// Update the angular velocity.
 		angular_velocity += angular_velocity_change;
@@ -128,9 +388,7 @@ namespace pmk
 
 	void XPBDRigidBodyContext::CleanUp()
 	{
-		for (RigidBody* rb : rigid_bodies_) {
-			delete rb;
-		}
+		arena_.Clear();
 	}
 
 	void XPBDRigidBodyContext::PhysicsUpdate(float delta_time)
@@ -143,26 +401,36 @@ namespace pmk
 
 		// TODO: detect collision between all pairs of rigid bodies after doing large scale sweep.
 
-		std::for_each(std::execution::par, rigid_bodies_.begin(), rigid_bodies_.end(),
-			[&](RigidBody* rb) {
-				rb->previous_position = rb->node->position;
-				rb->velocity = rb->immovable ? glm::vec3{} : rb->velocity + delta_time * gravity;
-				rb->node->position += delta_time * rb->velocity;
+		auto indices{ std::views::iota(0u, arena_.Size()) };
+		std::for_each(std::execution::par, indices.begin(), indices.end(),
+			[&](uint32_t i) {
+				if (arena_.sleeping[i]) {
+					return;
+				}
+
+				glm::vec3& position{ arena_.positions[i] };
+				glm::quat& rotation{ arena_.rotations[i] };
+				glm::vec3& velocity{ arena_.velocities[i] };
+				glm::vec3& angular_velocity{ arena_.angular_velocities[i] };
+				const glm::mat3& inertia_tensor{ arena_.inertia_tensors[i] };
+
+				arena_.previous_positions[i] = position;
+				velocity = arena_.immovable[i] ? glm::vec3{} : velocity + delta_time * gravity;
+				position += delta_time * velocity;
 
-				rb->previous_rotation = rb->node->rotation;
-				rb->angular_velocity = rb->immovable ? glm::vec3{} : rb->angular_velocity + delta_time * glm::inverse(rb->inertia_tensor) * (-glm::cross(rb->angular_velocity, rb->inertia_tensor * rb->angular_velocity));
+				arena_.previous_rotations[i] = rotation;
+				angular_velocity = arena_.immovable[i] ? glm::vec3{} : angular_velocity + delta_time * arena_.inverse_inertia_tensors[i] * (-glm::cross(angular_velocity, inertia_tensor * angular_velocity));
 
-				if (!rb->voxel_chunk.IsPointMass())
+				if (!arena_.point_masses[i])
 				{
-					rb->node->rotation += delta_time * 0.5f * glm::quat{ 0.0f, rb->angular_velocity.x, rb->angular_velocity.y, rb->angular_velocity.z } *rb->node->rotation;
-					rb->node->rotation = glm::normalize(rb->node->rotation);
+					rotation += delta_time * 0.5f * glm::quat{ 0.0f, angular_velocity.x, angular_velocity.y, angular_velocity.z } *rotation;
+					rotation = glm::normalize(rotation);
 				}
-
-				// Precalculate rigid body transforms.
-				rb->cached_world_transform = rb->node->GetWorldTransform();
-				rb->cached_inv_world_transform = glm::inverse(rb->cached_world_transform);
 			});
 
+		// Precalculate rigid body transforms.
+		arena_.CacheTransforms();
+
 		SolvePositions(delta_time);
 
 		//SolveVelocities();
@@ -180,28 +448,49 @@ namespace pmk
 			if (collision.rb_index == NULL_INDEX) {
 				continue;
 			}
-			RigidBody* rb{ rigid_bodies_[collision.rb_index] };
 
-			rb->node->position += collision.rb_delta_position;
-			rb->node->rotation += collision.rb_delta_rotation;
+			// Particles resting on a sleeping rigid body only wake it if they push hard enough.
+			uint32_t rb_idx{ collision.rb_index };
+			if (arena_.sleeping[rb_idx])
+			{
+				if (glm::length(collision.rb_delta_position) < SLEEP_LINEAR_VELOCITY_THRESHOLD * delta_time) {
+					continue;
+				}
+				arena_.Wake(rb_idx);
+			}
+
+			arena_.positions[rb_idx] += collision.rb_delta_position;
+			arena_.rotations[rb_idx] += collision.rb_delta_rotation;
 		}
 
-		std::for_each(std::execution::par, rigid_bodies_.begin(), rigid_bodies_.end(),
-			[&](RigidBody* rb) {
-				rb->velocity = (rb->node->position - rb->previous_position) / delta_time;
-				if (!rb->voxel_chunk.IsPointMass())
+		auto indices{ std::views::iota(0u, arena_.Size()) };
+		std::for_each(std::execution::par, indices.begin(), indices.end(),
+			[&](uint32_t i) {
+				if (arena_.sleeping[i])
 				{
-					glm::quat delta_q{ rb->node->rotation * glm::inverse(rb->previous_rotation) };
-					rb->angular_velocity = 2.0f * glm::vec3{ delta_q.x, delta_q.y, delta_q.z } / delta_time;
+					arena_.velocities[i] = {};
+					arena_.angular_velocities[i] = {};
+					return;
+				}
+
+				arena_.velocities[i] = (arena_.positions[i] - arena_.previous_positions[i]) / delta_time;
+				if (!arena_.point_masses[i])
+				{
+					glm::quat delta_q{ arena_.rotations[i] * glm::inverse(arena_.previous_rotations[i]) };
+					arena_.angular_velocities[i] = 2.0f * glm::vec3{ delta_q.x, delta_q.y, delta_q.z } / delta_time;
 					if (delta_q.w < 0) {
-						rb->angular_velocity = -rb->angular_velocity;
+						arena_.angular_velocities[i] = -arena_.angular_velocities[i];
 					}
 				}
 			});
+
+		UpdateSleeping(delta_time);
 	}
 
 	void XPBDRigidBodyContext::EnablePhysicsUpdate()
 	{
+		// Nodes may have been moved in the editor while the simulation was paused.
+		arena_.PullFromNodes();
 		update_physics_ = true;
 	}
 
@@ -218,130 +507,386 @@ namespace pmk
 	void XPBDRigidBodyContext::ResetRigidBodies()
 	{
 		DisablePhysicsUpdate();
-		for (RigidBody* rb : rigid_bodies_) {
-			scene_->DestroyNode(rb->node);
-			delete rb;
+		for (uint32_t i{ 0 }; i < arena_.Size(); ++i) {
+			scene_->DestroyNode(arena_.GetNode(i));
 		}
-		rigid_bodies_.clear();
+		arena_.Clear();
 	}
 
-	const std::vector<RigidBody*>& XPBDRigidBodyContext::GetRigidBodies() const
+	const RigidBodyArena& XPBDRigidBodyContext::GetArena() const
 	{
-		return rigid_bodies_;
+		return arena_;
 	}
 
-	std::vector<RigidBody*>& XPBDRigidBodyContext::GetRigidBodies()
+	RigidBodyArena& XPBDRigidBodyContext::GetArena()
 	{
-		return rigid_bodies_;
+		return arena_;
 	}
 
 	std::vector<uint32_t> XPBDRigidBodyContext::CreateRigidBodiesByConnectedness(renderer::VoxelChunk& voxel_chunk, bool* out_is_empty)
 	{
-		// Create a mask to quickly test if a static particle has a rigid body material.
-		std::vector<uint8_t> rigid_body_mask(physics_materials_->size());
-		std::transform(physics_materials_->begin(), physics_materials_->end(), rigid_body_mask.begin(),
-			[](const pmk::PhysicsMaterial* m) { return m->rigid_body; });
-
-		for (uint32_t i{ 0 }; i < CHUNK_ROW_VOXEL_COUNT; ++i)
+		// Lookup tables to quickly test if a voxel has a rigid body material, and get its mass.
+		MaterialMask rigid_body_mask{};
+		MaterialMasses voxel_masses{};
+		const uint32_t material_count{ physics_materials_->empty() ? 0 : (uint32_t)renderer::PHYSICS_MATERIAL_EMPTY_INDEX };
+		for (uint32_t material{ 0 }; material < material_count; ++material)
 		{
-			for (uint32_t j{ 0 }; j < CHUNK_ROW_VOXEL_COUNT; ++j)
-			{
-				for (uint32_t k{ 0 }; k < CHUNK_ROW_VOXEL_COUNT; ++k)
-				{
-					renderer::Voxel& p{ voxel_chunk.Coordinate(i, j, k) };
-
-					if (p.physics_material_index == renderer::PHYSICS_MATERIAL_EMPTY_INDEX) {
-						continue;
-					}
-
 #ifdef EDITOR_ENABLED
-					// For editor convenience we just use available physics material if enough haven't been created yet.
-					uint32_t idx{ std::min((uint32_t)p.physics_material_index, (uint32_t)(physics_materials_->size() - 1)) };
+			// For editor convenience we just use available physics material if enough haven't been created yet.
+			uint32_t idx{ std::min(material, (uint32_t)(physics_materials_->size() - 1)) };
 #else
-					uint32_t idx{ (uint32_t)p.physics_material_index };
+			if (material >= (uint32_t)physics_materials_->size()) {
+				break;
+			}
+			uint32_t idx{ material };
 #endif
+			rigid_body_mask[material] = (*physics_materials_)[idx]->rigid_body;
+			voxel_masses[material] = GetVoxelMass(idx);
+		}
 
-					if (rigid_body_mask[idx])
-					{
-						glm::vec3 center_of_mass{};
-						RigidBodyFloodFill({ i, j, k }, voxel_chunk, rigid_body_mask);
-					}
-				}
+		std::vector<uint32_t> labels{};
+		std::vector<VoxelComponent> components{ LabelVoxelComponents(voxel_chunk, rigid_body_mask, voxel_masses, &labels) };
+
+		// Move the voxels of each component out of the chunk, relative to the component's min extents.
+		std::vector<std::vector<std::pair<renderer::Voxel, glm::uvec3>>> component_voxels(components.size());
+		for (uint32_t c{ 0 }; c < (uint32_t)components.size(); ++c) {
+			component_voxels[c].reserve(components[c].voxel_count);
+		}
+
+		std::vector<glm::uvec3> moved_coords{};
+		voxel_chunk.ForEachOccupied([&](uint32_t idx, const glm::uvec3& coord, const renderer::Voxel& voxel) {
+			uint32_t c{ labels[idx] };
+			if (c == NULL_INDEX) {
+				return;
 			}
+
+			component_voxels[c].push_back({ voxel, coord - components[c].min_extents });
+			moved_coords.push_back(coord);
+			});
+
+		const renderer::Voxel empty_voxel{ .physics_material_index = renderer::PHYSICS_MATERIAL_EMPTY_INDEX };
+		for (const glm::uvec3& coord : moved_coords) {
+			voxel_chunk.SetVoxel(coord, empty_voxel);
 		}
 
-		// Check for existence of non-rigid body voxels remaining.
-		std::atomic_bool voxel_chunk_empty{ true };
-		std::for_each(
-			std::execution::par,
-			voxel_chunk.GetVoxels().begin(),
-			voxel_chunk.GetVoxels().end(),
-			[&](renderer::Voxel v) {
-				if (v.physics_material_index != renderer::PHYSICS_MATERIAL_EMPTY_INDEX) {
-					voxel_chunk_empty.store(false, std::memory_order_relaxed);
-				}
+		// Build the voxel chunks and distance fields in parallel. Nodes and render objects are created serially afterwards.
+		std::vector<RigidBody> rigid_bodies(components.size());
+		auto component_indices{ std::views::iota(0u, (uint32_t)components.size()) };
+		std::for_each(std::execution::par, component_indices.begin(), component_indices.end(),
+			[&](uint32_t c) {
+				const VoxelComponent& component{ components[c] };
+				glm::uvec3 dimensions{ component.max_extents - component.min_extents + glm::uvec3{1, 1, 1} };
+
+				rigid_bodies[c] = RigidBody{
+					.mass = component.mass,
+					.center_of_mass = component.center_of_mass - glm::vec3{ component.min_extents },
+					.inertia_tensor = component.inertia_tensor,
+					.voxel_chunk = renderer::VoxelChunk(dimensions.x, dimensions.y, dimensions.z, std::move(component_voxels[c])),
+				};
+				rigid_bodies[c].distance_field.Build(rigid_bodies[c].voxel_chunk);
 			});
 
-		*out_is_empty = voxel_chunk_empty.load(std::memory_order_relaxed);
+		for (uint32_t c{ 0 }; c < (uint32_t)components.size(); ++c)
+		{
+			glm::vec3 world_position{ PARTICLE_WIDTH * (glm::vec3{ components[c].min_extents } + rigid_bodies[c].center_of_mass) };
+			CreateRigidBody(world_position, glm::quat{ 1.0f, 0.0f, 0.0f, 0.0f }, std::move(rigid_bodies[c]));
+		}
+
+		// Check for existence of non-rigid body voxels remaining.
+		*out_is_empty = voxel_chunk.OccupiedVoxelCount() == 0;
 
 		std::vector<uint32_t> node_ids{};
-		node_ids.resize(rigid_bodies_.size());
-		std::transform(rigid_bodies_.begin(), rigid_bodies_.end(), node_ids.begin(),
-			[](RigidBody* rb) { return rb->node->node_id; });
+		node_ids.resize(arena_.Size());
+		for (uint32_t i{ 0 }; i < arena_.Size(); ++i) {
+			node_ids[i] = arena_.GetNode(i)->node_id;
+		}
 		return node_ids;
 	}
 
-	std::array<CollisionPair, MAX_COLLISION_PAIRS> XPBDRigidBodyContext::ComputeCollisionPairs(const RigidBody* a, const RigidBody* b, uint32_t* out_count) const
+	// Add (sign of 1) or remove (sign of -1) the mass of a voxel at coord,
+	// keeping the inertia tensor about the new center of mass with the parallel axis theorem.
+	static void AccumulateVoxelMass(float* mass, glm::vec3* center_of_mass, glm::mat3* inertia_tensor, const glm::vec3& coord, float voxel_mass, float sign)
+	{
+		// Inertia tensor of a unit point mass offset by d voxels.
+		auto point_inertia = [](const glm::vec3& d) {
+			return (glm::dot(d, d) * glm::mat3{ 1.0f } - glm::outerProduct(d, d)) * (PARTICLE_WIDTH * PARTICLE_WIDTH);
+			};
+
+		float new_mass{ *mass + sign * voxel_mass };
+		if (new_mass <= 0.0f)
+		{
+			*mass = 0.0f;
+			*inertia_tensor = glm::mat3{ 0.0f };
+			return;
+		}
+
+		glm::vec3 new_center_of_mass{ (*mass * *center_of_mass + sign * voxel_mass * coord) / new_mass };
+		*inertia_tensor += *mass * point_inertia(*center_of_mass - new_center_of_mass) + sign * voxel_mass * point_inertia(coord - new_center_of_mass);
+		*mass = new_mass;
+		*center_of_mass = new_center_of_mass;
+	}
+
+	std::vector<RigidBodyHandle> XPBDRigidBodyContext::RemoveVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords)
+	{
+		ZoneScoped;
+
+		uint32_t idx{ arena_.DenseIndex(handle) };
+		if (idx == NULL_INDEX)
+		{
+			logger::Error("Cannot remove voxels from a removed rigid body.\n");
+			return {};
+		}
+
+		constexpr glm::ivec3 offsets[6]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		const renderer::Voxel empty_voxel{ .physics_material_index = renderer::PHYSICS_MATERIAL_EMPTY_INDEX };
+
+		RigidBody& rb{ arena_.Body(idx) };
+		renderer::VoxelChunk& voxel_chunk{ rb.voxel_chunk };
+		const glm::vec3 previous_center_of_mass{ rb.center_of_mass };
+		const glm::mat4 previous_transform{ arena_.world_transforms[idx] };
+		const glm::quat rotation{ arena_.rotations[idx] };
+		const glm::vec3 velocity{ arena_.velocities[idx] };
+		const glm::vec3 angular_velocity{ arena_.angular_velocities[idx] };
+
+		glm::uvec3 min_coord{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+		glm::uvec3 max_coord{};
+		std::vector<glm::uvec3> seeds{};
+		for (const glm::uvec3& coord : coords)
+		{
+			if (!voxel_chunk.InBounds(coord) || voxel_chunk.IsEmpty(coord)) {
+				continue;
+			}
+
+			float voxel_mass{ GetVoxelMass(voxel_chunk.Coordinate(coord).physics_material_index) };
+			AccumulateVoxelMass(&rb.mass, &rb.center_of_mass, &rb.inertia_tensor, glm::vec3{ coord }, voxel_mass, -1.0f);
+			voxel_chunk.SetVoxel(coord, empty_voxel);
+			min_coord = glm::min(min_coord, coord);
+			max_coord = glm::max(max_coord, coord);
+
+			// Only neighbors of removed voxels can have lost their connection to the rest of the rigid body.
+			for (const glm::ivec3& offset : offsets) {
+				seeds.push_back(glm::uvec3{ glm::ivec3{ coord } + offset });
+			}
+		}
+
+		if (seeds.empty()) {
+			return {};
+		}
+
+		// Move the voxels of each fragment into a rigid body of its own.
+		std::vector<std::vector<uint32_t>> fragments{ FindDetachedFragments(voxel_chunk, seeds) };
+		std::vector<RigidBody> fragment_bodies(fragments.size());
+		std::vector<std::vector<std::pair<renderer::Voxel, glm::uvec3>>> fragment_voxels(fragments.size());
+		std::vector<glm::uvec3> fragment_min_extents(fragments.size());
+		for (uint32_t f{ 0 }; f < (uint32_t)fragments.size(); ++f)
+		{
+			RigidBody& fragment{ fragment_bodies[f] };
+			fragment.dynamic_friction = rb.dynamic_friction;
+			fragment.immovable = rb.immovable;
+			fragment.boundary_condition = rb.boundary_condition;
+
+			glm::uvec3 fragment_min{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+			fragment_voxels[f].reserve(fragments[f].size());
+			for (uint32_t voxel_idx : fragments[f])
+			{
+				glm::uvec3 coord{ voxel_chunk.IndexToCoordinate(voxel_idx) };
+				renderer::Voxel voxel{ voxel_chunk.Index(voxel_idx) };
+				float voxel_mass{ GetVoxelMass(voxel.physics_material_index) };
+
+				AccumulateVoxelMass(&rb.mass, &rb.center_of_mass, &rb.inertia_tensor, glm::vec3{ coord }, voxel_mass, -1.0f);
+				AccumulateVoxelMass(&fragment.mass, &fragment.center_of_mass, &fragment.inertia_tensor, glm::vec3{ coord }, voxel_mass, 1.0f);
+				voxel_chunk.SetVoxel(coord, empty_voxel);
+
+				fragment_voxels[f].push_back({ voxel, coord });
+				fragment_min = glm::min(fragment_min, coord);
+				min_coord = glm::min(min_coord, coord);
+				max_coord = glm::max(max_coord, coord);
+			}
+			fragment_min_extents[f] = fragment_min;
+		}
+
+		// Build the fragment voxel chunks and distance fields in parallel, with coordinates relative to their min extents.
+		auto fragment_indices{ std::views::iota(0u, (uint32_t)fragments.size()) };
+		std::for_each(std::execution::par, fragment_indices.begin(), fragment_indices.end(),
+			[&](uint32_t f) {
+				RigidBody& fragment{ fragment_bodies[f] };
+				glm::uvec3 max_extents{};
+				for (auto& [voxel, coord] : fragment_voxels[f])
+				{
+					coord -= fragment_min_extents[f];
+					max_extents = glm::max(max_extents, coord);
+				}
+
+				fragment.center_of_mass -= glm::vec3{ fragment_min_extents[f] };
+				fragment.voxel_chunk = renderer::VoxelChunk(max_extents.x + 1, max_extents.y + 1, max_extents.z + 1, std::move(fragment_voxels[f]));
+				fragment.distance_field.Build(fragment.voxel_chunk);
+			});
+
+		// Every voxel was removed.
+		if (voxel_chunk.OccupiedVoxelCount() == 0)
+		{
+			scene_->DestroyNode(arena_.GetNode(idx));
+			arena_.Remove(handle);
+		}
+		else {
+			OnVoxelsEdited(idx, previous_center_of_mass, min_coord, max_coord);
+		}
+
+		// Fragments keep the motion of the rigid body at their center of mass. Adding to the arena invalidates rb.
+		std::vector<RigidBodyHandle> fragment_handles{};
+		fragment_handles.reserve(fragments.size());
+		for (uint32_t f{ 0 }; f < (uint32_t)fragments.size(); ++f)
+		{
+			glm::vec3 local_center_of_mass{ PARTICLE_WIDTH * (fragment_bodies[f].center_of_mass + glm::vec3{ fragment_min_extents[f] } - previous_center_of_mass) };
+			glm::vec3 world_position{ previous_transform * glm::vec4{ local_center_of_mass, 1.0f } };
+			glm::vec3 lever_arm{ rotation * local_center_of_mass };
+
+			RigidBodyHandle fragment_handle{ CreateRigidBody(world_position, rotation, std::move(fragment_bodies[f])) };
+			uint32_t fragment_idx{ arena_.DenseIndex(fragment_handle) };
+			arena_.velocities[fragment_idx] = velocity + glm::cross(angular_velocity, lever_arm);
+			arena_.angular_velocities[fragment_idx] = angular_velocity;
+			arena_.world_transforms[fragment_idx] = arena_.WorldTransform(fragment_idx);
+			arena_.inv_world_transforms[fragment_idx] = glm::inverse(arena_.world_transforms[fragment_idx]);
+			fragment_handles.push_back(fragment_handle);
+		}
+
+		return fragment_handles;
+	}
+
+	void XPBDRigidBodyContext::AddVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels)
+	{
+		ZoneScoped;
+
+		uint32_t idx{ arena_.DenseIndex(handle) };
+		if (idx == NULL_INDEX)
+		{
+			logger::Error("Cannot add voxels to a removed rigid body.\n");
+			return;
+		}
+
+		RigidBody& rb{ arena_.Body(idx) };
+		renderer::VoxelChunk& voxel_chunk{ rb.voxel_chunk };
+		const glm::vec3 previous_center_of_mass{ rb.center_of_mass };
+
+		glm::uvec3 min_coord{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+		glm::uvec3 max_coord{};
+		for (const auto& [voxel, coord] : voxels)
+		{
+			if (!voxel_chunk.InBounds(coord))
+			{
+				logger::Error("Voxel added outside of the rigid body's voxel chunk.\n");
+				continue;
+			}
+			if (voxel.physics_material_index == renderer::PHYSICS_MATERIAL_EMPTY_INDEX) {
+				continue;
+			}
+
+			// Replacing a voxel removes the mass of the old one.
+			if (!voxel_chunk.IsEmpty(coord)) {
+				AccumulateVoxelMass(&rb.mass, &rb.center_of_mass, &rb.inertia_tensor, glm::vec3{ coord }, GetVoxelMass(voxel_chunk.Coordinate(coord).physics_material_index), -1.0f);
+			}
+			AccumulateVoxelMass(&rb.mass, &rb.center_of_mass, &rb.inertia_tensor, glm::vec3{ coord }, GetVoxelMass(voxel.physics_material_index), 1.0f);
+			voxel_chunk.SetVoxel(coord, voxel);
+			min_coord = glm::min(min_coord, coord);
+			max_coord = glm::max(max_coord, coord);
+		}
+
+		if (min_coord.x != UINT32_MAX) {
+			OnVoxelsEdited(idx, previous_center_of_mass, min_coord, max_coord);
+		}
+	}
+
+	std::array<CollisionPair, MAX_COLLISION_PAIRS> XPBDRigidBodyContext::ComputeCollisionPairs(uint32_t a_idx, uint32_t b_idx, uint32_t* out_count) const
 	{
 		std::array<CollisionPair, MAX_COLLISION_PAIRS> collision_pairs{};
-		const RigidBody* small{ a }; // Rigid body with fewer outer voxels.
-		const RigidBody* big{ b };   // Rigid body with more outer voxels.
+		uint32_t small_idx{ a_idx }; // Rigid body with fewer outer voxels.
+		uint32_t big_idx{ b_idx };   // Rigid body with more outer voxels.
 
 		bool ab_swap{ false };
-		if (small->voxel_chunk.GetOuterVoxels().size() > big->voxel_chunk.GetOuterVoxels().size())
+		if (arena_.Body(small_idx).voxel_chunk.GetOuterVoxels().size() > arena_.Body(big_idx).voxel_chunk.GetOuterVoxels().size())
 		{
-			std::swap(small, big);
+			std::swap(small_idx, big_idx);
 			ab_swap = true;
 		}
 
-		// TODO: Make this multithreaded.
+		const RigidBody& small{ arena_.Body(small_idx) };
+		const RigidBody& big{ arena_.Body(big_idx) };
+		const glm::mat4& small_transform{ arena_.world_transforms[small_idx] };
+		const glm::mat4& small_inv_transform{ arena_.inv_world_transforms[small_idx] };
+		const glm::mat4& big_transform{ arena_.world_transforms[big_idx] };
+		const glm::mat4& big_inv_transform{ arena_.inv_world_transforms[big_idx] };
+
+		// Each outer voxel of the small body is a sphere tested against the distance field of the big body.
+		// Keep the deepest contacts when there are more than MAX_COLLISION_PAIRS.
+		std::array<float, MAX_COLLISION_PAIRS> depths{};
 		uint32_t collision_pair_idx{ 0 };
-		for (const renderer::OuterVoxel& ov : small->voxel_chunk.GetOuterVoxels())
+		for (const renderer::OuterVoxel& ov : small.voxel_chunk.GetOuterVoxels())
 		{
-			glm::uvec3 small_coord{ ov.coord };
-			glm::vec3 global_pos{ small->CoordinateToGlobal(small->cached_world_transform, small_coord) };
-			std::optional<glm::uvec3> big_coord{ big->GetCollisionCoordinate(big->cached_inv_world_transform, global_pos) };
+			glm::vec3 global_pos{ small.CoordinateToGlobal(small_transform, ov.coord) };
+			glm::vec3 big_coord{ big.GlobalToCoordinate(big_inv_transform, global_pos) };
 
-			bool in_bounds{ big_coord.has_value() };
+			glm::vec3 gradient{};
+			float distance{ big.distance_field.DistanceAndGradient(big_coord, &gradient) };
 
-			if (in_bounds && !big->voxel_chunk.IsEmpty(big_coord.value()))
-			{
-				collision_pairs[collision_pair_idx++] = ab_swap ? CollisionPair{ big_coord.value(), small_coord } : CollisionPair{ small_coord, big_coord.value() };
+			// Distance is in voxel widths, and the voxel sphere has a radius of half a voxel width.
+			float depth{ 0.5f - distance };
+			if (depth <= 0.0f) {
+				continue;
+			}
 
-				if (collision_pair_idx == MAX_COLLISION_PAIRS) {
-					break;
+			uint32_t slot{ collision_pair_idx };
+			if (collision_pair_idx == MAX_COLLISION_PAIRS)
+			{
+				slot = (uint32_t)(std::min_element(depths.begin(), depths.end()) - depths.begin());
+				if (depths[slot] >= depth) {
+					continue;
 				}
 			}
+			else {
+				++collision_pair_idx;
+			}
+
+			// Normal points out of the big body, towards the small body.
+			glm::vec3 n{ big.SurfaceNormal(big_transform, big_coord, gradient) };
+			glm::vec3 small_point{ global_pos - n * PARTICLE_RADIUS };
+			glm::vec3 big_point{ global_pos - n * (distance * PARTICLE_WIDTH) };
+			glm::vec3 small_local{ small_inv_transform * glm::vec4{ small_point, 1.0f } };
+			glm::vec3 big_local{ big_inv_transform * glm::vec4{ big_point, 1.0f } };
+
+			// A is the small body unless they were swapped, and the normal points from A to B.
+			collision_pairs[slot] = ab_swap ? CollisionPair{ big_local, small_local, n } : CollisionPair{ small_local, big_local, -n };
+			depths[slot] = depth;
 		}
 
 		*out_count = collision_pair_idx;
 		return collision_pairs;
 	}
 
-	std::optional<glm::vec3> XPBDRigidBodyContext::ComputeParticleCollision(const RigidBody* rb, const glm::vec3& particle_position) const
+	std::optional<ParticleRigidBodyContact> XPBDRigidBodyContext::ComputeParticleCollision(uint32_t rb_idx, const glm::vec3& particle_position) const
 	{
-		std::optional<glm::uvec3> rb_voxel_coord{ rb->GetCollisionCoordinate(rb->cached_inv_world_transform, particle_position) };
+		const RigidBody& rb{ arena_.Body(rb_idx) };
+		glm::vec3 coord_space{ rb.GlobalToCoordinate(arena_.inv_world_transforms[rb_idx], particle_position) };
 
-		if (rb_voxel_coord.has_value())
-		{
-			// Local position of voxel center.
-			glm::vec3 r_local{ ((glm::vec3)rb_voxel_coord.value() - rb->center_of_mass) * PARTICLE_WIDTH };
-			// World position of voxel center.
-			glm::vec3 world_pos{ glm::vec3{rb->cached_world_transform * glm::vec4{r_local, 1.0f}} };
-			return std::make_optional(world_pos);
+		// Cheap rejection before sampling the distance field.
+		glm::vec3 dimensions{ rb.voxel_chunk.GetWidth(), rb.voxel_chunk.GetHeight(), rb.voxel_chunk.GetDepth() };
+		if (glm::any(glm::lessThan(coord_space, glm::vec3{ -1.0f })) || glm::any(glm::greaterThan(coord_space, dimensions))) {
+			return std::nullopt;
 		}
 
-		return std::nullopt;
+		glm::vec3 gradient{};
+		float distance{ rb.distance_field.DistanceAndGradient(coord_space, &gradient) };
+
+		// Particle has a radius of half a voxel width.
+		if (distance >= 0.5f) {
+			return std::nullopt;
+		}
+
+		glm::vec3 n{ rb.SurfaceNormal(arena_.world_transforms[rb_idx], coord_space, gradient) };
+		return std::make_optional(ParticleRigidBodyContact{
+			.position = particle_position - n * (distance * PARTICLE_WIDTH),
+			.normal = n,
+			.c = (distance - 0.5f) * PARTICLE_WIDTH,
+		});
 	}
 
 #ifdef EDITOR_ENABLED
@@ -361,19 +906,20 @@ namespace pmk
 		}
 
 		size_t outer_voxel_count{};
-		for (const RigidBody* rb : rigid_bodies_) {
-			outer_voxel_count += rb->voxel_chunk.GetOuterVoxels().size();
+		for (uint32_t i{ 0 }; i < arena_.Size(); ++i) {
+			outer_voxel_count += arena_.Body(i).voxel_chunk.GetOuterVoxels().size();
 		}
 
 		std::vector<renderer::RigidBodyDebugVoxelInstance> debug_instances{};
 		debug_instances.reserve(outer_voxel_count);
-		for (const RigidBody* rb : rigid_bodies_)
+		for (uint32_t i{ 0 }; i < arena_.Size(); ++i)
 		{
-			glm::mat3 rotation{ glm::toMat3(rb->node->rotation) };
-			for (const renderer::OuterVoxel& ov : rb->voxel_chunk.GetOuterVoxels())
+			const RigidBody& rb{ arena_.Body(i) };
+			glm::mat3 rotation{ glm::toMat3(arena_.rotations[i]) };
+			for (const renderer::OuterVoxel& ov : rb.voxel_chunk.GetOuterVoxels())
 			{
 				renderer::RigidBodyDebugVoxelInstance debug_instance{
-					.position = rb->CoordinateToGlobal(rb->cached_world_transform, ov.coord),
+					.position = rb.CoordinateToGlobal(arena_.world_transforms[i], ov.coord),
 					.normal = rotation * ov.normal,
 				};
 
@@ -387,7 +933,7 @@ namespace pmk
 
 	void XPBDRigidBodyContext::SolvePositions(float h)
 	{
-		if (rigid_bodies_.empty()) {
+		if (arena_.Size() == 0) {
 			return;
 		}
 
@@ -396,76 +942,85 @@ namespace pmk
 		constexpr float alpha{ compliance };
 		float alpha_tilde{ alpha / (h * h) };
 
+		contact_pairs_.clear();
+		sleep_stats_.skipped_pair_count = 0;
+
 		// TODO: Don't check every pair of rigid bodies.
-		for (uint32_t a_idx{ 0 }; a_idx < (uint32_t)rigid_bodies_.size() - 1; ++a_idx)
+		for (uint32_t a_idx{ 0 }; a_idx < arena_.Size() - 1; ++a_idx)
 		{
-			for (uint32_t b_idx{ a_idx + 1 }; b_idx < (uint32_t)rigid_bodies_.size(); ++b_idx)
+			for (uint32_t b_idx{ a_idx + 1 }; b_idx < arena_.Size(); ++b_idx)
 			{
-				RigidBody* rb_a{ rigid_bodies_[a_idx] };
-				RigidBody* rb_b{ rigid_bodies_[b_idx] };
+				// Neither rigid body can move, so there is nothing to solve.
+				bool a_resting{ arena_.sleeping[a_idx] || arena_.immovable[a_idx] };
+				bool b_resting{ arena_.sleeping[b_idx] || arena_.immovable[b_idx] };
+				if (a_resting && b_resting)
+				{
+					++sleep_stats_.skipped_pair_count;
+					continue;
+				}
 
 				uint32_t count{};
-				auto collision_pairs{ ComputeCollisionPairs(rb_a, rb_b, &count) };
+				auto collision_pairs{ ComputeCollisionPairs(a_idx, b_idx, &count) };
+				if (count == 0) {
+					continue;
+				}
+
+				// A sleeping rigid body touched by an awake one joins its island, and UpdateSleeping() decides whether it wakes.
+				// Until then it is solved as if it were immovable.
+				contact_pairs_.push_back({ a_idx, b_idx });
+
+				glm::vec3& position_a{ arena_.positions[a_idx] };
+				glm::vec3& position_b{ arena_.positions[b_idx] };
+				glm::quat& rotation_a{ arena_.rotations[a_idx] };
+				glm::quat& rotation_b{ arena_.rotations[b_idx] };
+				const float inv_m1{ a_resting ? 0.0f : arena_.inverse_masses[a_idx] };
+				const float inv_m2{ b_resting ? 0.0f : arena_.inverse_masses[b_idx] };
+				const glm::mat3 inertia_tensor_inv_a{ a_resting ? glm::mat3{} : arena_.inverse_inertia_tensors[a_idx] };
+				const glm::mat3 inertia_tensor_inv_b{ b_resting ? glm::mat3{} : arena_.inverse_inertia_tensors[b_idx] };
 
 				for (uint32_t i{ 0 }; i < count; ++i)
 				{
 					CollisionPair& cp{ collision_pairs[i] };
-					// Local position of voxel centers.
-					glm::vec3 r1_local{ ((glm::vec3)cp.coordinate_a - rb_a->center_of_mass) * PARTICLE_WIDTH };
-					glm::vec3 r2_local{ ((glm::vec3)cp.coordinate_b - rb_b->center_of_mass) * PARTICLE_WIDTH };
-
-					glm::vec3 world_center_of_mass_a{ rb_a->node->position };
-					glm::vec3 world_center_of_mass_b{ rb_b->node->position };
 
-					// World position of voxel centers.
-					glm::vec3 world_pos_a{ glm::vec3{rb_a->node->GetWorldTransform() * glm::vec4{r1_local, 1.0f}} };
-					glm::vec3 world_pos_b{ glm::vec3{rb_b->node->GetWorldTransform() * glm::vec4{r2_local, 1.0f}} };
+					// World position of contact points.
+					glm::vec3 world_pos_a{ glm::vec3{arena_.WorldTransform(a_idx) * glm::vec4{cp.local_point_a, 1.0f}} };
+					glm::vec3 world_pos_b{ glm::vec3{arena_.WorldTransform(b_idx) * glm::vec4{cp.local_point_b, 1.0f}} };
 
-					glm::vec3 delta_x{ world_pos_b - world_pos_a };
-					float c{ glm::length(delta_x) };
-
-					if (c > PARTICLE_WIDTH) {
+					// Penetration depth along the contact normal. Earlier contacts may have already separated the bodies.
+					const glm::vec3& n{ cp.normal };
+					float c{ glm::dot(world_pos_a - world_pos_b, n) };
+					if (c <= 0.0f) {
 						continue;
 					}
 
-					glm::vec3 n{ delta_x / c };
-					c = std::fabsf(c - PARTICLE_WIDTH); // Distance between sphere surfaces instead of sphere centers.
-
-					// Change world positions to be points on surface of sphere instead of center.
-					world_pos_a += n * PARTICLE_RADIUS;
-					world_pos_b -= n * PARTICLE_RADIUS;
-					glm::vec3 r1{ world_pos_a - world_center_of_mass_a };
-					glm::vec3 r2{ world_pos_b - world_center_of_mass_b };
+					glm::vec3 r1{ world_pos_a - position_a };
+					glm::vec3 r2{ world_pos_b - position_b };
 
-					float m1{ rb_a->immovable ? std::numeric_limits<float>::infinity() : rb_a->mass };
-					float m2{ rb_b->immovable ? std::numeric_limits<float>::infinity() : rb_b->mass };
 					glm::vec3 r1_cross_n{ glm::cross(r1, n) };
 					glm::vec3 r2_cross_n{ glm::cross(r2, n) };
-					glm::mat3 inertia_tensor_inv_a{ rb_a->immovable || rb_a->voxel_chunk.IsPointMass() ? glm::mat3{} : glm::inverse(rb_a->inertia_tensor) };
-					glm::mat3 inertia_tensor_inv_b{ rb_b->immovable || rb_b->voxel_chunk.IsPointMass() ? glm::mat3{} : glm::inverse(rb_b->inertia_tensor) };
-					float w1{ (1.0f / m1) + glm::dot(r1_cross_n, inertia_tensor_inv_a * r1_cross_n) };
-					float w2{ (1.0f / m2) + glm::dot(r2_cross_n, inertia_tensor_inv_b * r2_cross_n) };
+					float w1{ inv_m1 + glm::dot(r1_cross_n, inertia_tensor_inv_a * r1_cross_n) };
+					float w2{ inv_m2 + glm::dot(r2_cross_n, inertia_tensor_inv_b * r2_cross_n) };
 
 					float lambda{ -c / (w1 + w2 + alpha_tilde) };
 					glm::vec3 p{ lambda * n };
 
-					if (!rb_a->immovable)
+					if (!a_resting)
 					{
-						rb_a->node->position += p / m1;
-						if (!rb_a->voxel_chunk.IsPointMass())
+						position_a += p * inv_m1;
+						if (!arena_.point_masses[a_idx])
 						{
 							glm::vec3 tmp1{ inertia_tensor_inv_a * glm::cross(r1, p) };
-							rb_a->node->rotation += 0.5f * glm::quat{ 0.0f, tmp1.x, tmp1.y, tmp1.z } *rb_a->node->rotation;
+							rotation_a += 0.5f * glm::quat{ 0.0f, tmp1.x, tmp1.y, tmp1.z } *rotation_a;
 						}
 					}
 
-					if (!rb_b->immovable)
+					if (!b_resting)
 					{
-						rb_b->node->position -= p / m2;
-						if (!rb_b->voxel_chunk.IsPointMass())
+						position_b -= p * inv_m2;
+						if (!arena_.point_masses[b_idx])
 						{
 							glm::vec3 tmp2{ inertia_tensor_inv_b * glm::cross(r2, p) };
-							rb_b->node->rotation -= 0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *rb_b->node->rotation;
+							rotation_b -= 0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *rotation_b;
 						}
 					}
 				}
@@ -473,125 +1028,94 @@ namespace pmk
 		}
 	}
 
-	// Returns true when the given coordinate is inside the region that flood fill is filling.
-	static bool FloodFillInside(const glm::uvec3& coord, renderer::VoxelChunk& voxel_chunk, const std::vector<uint8_t>& material_mask)
+	static uint32_t IslandRoot(std::vector<uint32_t>& parents, uint32_t idx)
 	{
-		// We only check upper condition since negative uints will overflow anyway.
-		bool x_out_bounds{ coord.x >= CHUNK_ROW_VOXEL_COUNT };
-		bool y_out_bounds{ coord.y >= CHUNK_ROW_VOXEL_COUNT };
-		bool z_out_bounds{ coord.z >= CHUNK_ROW_VOXEL_COUNT };
-
-		if (x_out_bounds || y_out_bounds || z_out_bounds) {
-			return false;
-		}
-
-		uint32_t idx{ voxel_chunk.Coordinate(coord).physics_material_index };
-
-#ifdef EDITOR_ENABLED
-		// For editor convenience we just use available physics material if enough haven't been created yet.
-		if (idx != renderer::PHYSICS_MATERIAL_EMPTY_INDEX) {
-			idx = std::min(idx, (uint32_t)material_mask.size() - 1);
+		while (parents[idx] != idx)
+		{
+			parents[idx] = parents[parents[idx]]; // Path halving.
+			idx = parents[idx];
 		}
-#endif
-
-		return idx == renderer::PHYSICS_MATERIAL_EMPTY_INDEX ? false : material_mask[idx];
+		return idx;
 	}
 
-	static renderer::Voxel FloodFillSet(uint32_t idx, renderer::VoxelChunk& voxel_chunk)
+	void XPBDRigidBodyContext::UpdateSleeping(float h)
 	{
-		renderer::Voxel voxel{
-			.physics_material_index = voxel_chunk.Index(idx).physics_material_index
-		};
-		voxel_chunk.Index(idx).physics_material_index = renderer::PHYSICS_MATERIAL_EMPTY_INDEX;
-		return voxel;
-	}
-
-	static void FloodFillScan(
-		uint32_t lx,
-		uint32_t rx,
-		uint32_t y,
-		uint32_t z,
-		std::queue<glm::uvec3>& queue,
-		renderer::VoxelChunk& voxel_chunk,
-		const std::vector<uint8_t>& material_mask)
-	{
-		bool span_added{ false };
+		const uint32_t rb_count{ arena_.Size() };
 
-		for (uint32_t x{ lx }; x < rx; ++x)
+		// Advance sleep timers of awake rigid bodies.
+		constexpr float linear_threshold_sqr{ SLEEP_LINEAR_VELOCITY_THRESHOLD * SLEEP_LINEAR_VELOCITY_THRESHOLD };
+		constexpr float angular_threshold_sqr{ SLEEP_ANGULAR_VELOCITY_THRESHOLD * SLEEP_ANGULAR_VELOCITY_THRESHOLD };
+		for (uint32_t i{ 0 }; i < rb_count; ++i)
 		{
-			if (!FloodFillInside({ x, y, z }, voxel_chunk, material_mask)) {
-				span_added = false;
-			}
-			else if (!span_added)
-			{
-				queue.push({ x, y, z });
-				span_added = true;
+			if (arena_.sleeping[i] || arena_.immovable[i]) {
+				continue;
 			}
+
+			bool resting{
+				glm::dot(arena_.velocities[i], arena_.velocities[i]) < linear_threshold_sqr &&
+				glm::dot(arena_.angular_velocities[i], arena_.angular_velocities[i]) < angular_threshold_sqr };
+			arena_.sleep_timers[i] = resting ? arena_.sleep_timers[i] + h : 0.0f;
 		}
-	}
 
-	// Creates rigid body based on connected voxels, and adds to rigid_bodies_.
-	void XPBDRigidBodyContext::RigidBodyFloodFill(const glm::uvec3& coordinate, renderer::VoxelChunk& voxel_chunk, const std::vector<uint8_t>& material_mask)
-	{
-		std::vector<std::pair<renderer::Voxel, glm::uvec3>> voxel_pairs{};
-		glm::uvec3 min_extents{ UINT_MAX, UINT_MAX, UINT_MAX };
-		glm::uvec3 max_extents{};
-		glm::vec3 center_of_mass{};
-		glm::mat3 intertia_tensor{};
-		float rigid_body_mass{};
-		std::queue<glm::uvec3> queue{};
-		queue.push(coordinate);
+		// Group rigid bodies into islands by contact. Immovable rigid bodies don't join islands,
+		// otherwise everything resting on the ground would be a single island.
+		std::vector<uint32_t> parents(rb_count);
+		std::iota(parents.begin(), parents.end(), 0u);
+		for (const auto& [a, b] : contact_pairs_)
+		{
+			if (arena_.immovable[a] || arena_.immovable[b]) {
+				continue;
+			}
+			parents[IslandRoot(parents, a)] = IslandRoot(parents, b);
+		}
 
-		while (!queue.empty())
+		// An island sleeps only when every rigid body in it has been resting long enough.
+		// Sleeping rigid bodies have timers from before they slept, so an awake, moving rigid body wakes its whole island.
+		std::vector<uint8_t> island_can_sleep(rb_count, true);
+		for (uint32_t i{ 0 }; i < rb_count; ++i)
 		{
-			glm::uvec3 coord{ queue.front() };
-			queue.pop();
-			uint32_t lx{ coord.x };
-
-			// Update extents.
-			min_extents.x = std::min(min_extents.x, coord.x);
-			min_extents.y = std::min(min_extents.y, coord.y);
-			min_extents.z = std::min(min_extents.z, coord.z);
-			max_extents.x = std::max(max_extents.x, coord.x);
-			max_extents.y = std::max(max_extents.y, coord.y);
-			max_extents.z = std::max(max_extents.z, coord.z);
-
-			glm::uvec3 next_coord{ lx - 1, coord.y, coord.z };
-			while (FloodFillInside(next_coord, voxel_chunk, material_mask))
-			{
-				voxel_pairs.push_back({ FloodFillSet(voxel_chunk.CoordinateToIndex(next_coord), voxel_chunk), next_coord });
-				const float voxel_mass{ GetVoxelMass(voxel_pairs.back().first.physics_material_index) };
-				rigid_body_mass += voxel_mass;
-				center_of_mass += voxel_mass * glm::vec3{ next_coord };
+			if (!arena_.immovable[i] && arena_.sleep_timers[i] < SLEEP_TIME) {
+				island_can_sleep[IslandRoot(parents, i)] = false;
+			}
+		}
 
-				// Update x extents.
-				min_extents.x = std::min(min_extents.x, coord.x);
+		sleep_stats_.awake_count = 0;
+		sleep_stats_.sleeping_count = 0;
+		sleep_stats_.island_count = 0;
+		for (uint32_t i{ 0 }; i < rb_count; ++i)
+		{
+			if (arena_.immovable[i]) {
+				continue;
+			}
 
-				--lx;
-				next_coord = { lx - 1, coord.y, coord.z };
+			uint32_t root{ IslandRoot(parents, i) };
+			if (root == i) {
+				++sleep_stats_.island_count;
 			}
 
-			while (FloodFillInside(coord, voxel_chunk, material_mask))
+			if (island_can_sleep[root])
 			{
-				voxel_pairs.push_back({ FloodFillSet(voxel_chunk.CoordinateToIndex(coord), voxel_chunk), coord });
-				const float voxel_mass{ GetVoxelMass(voxel_pairs.back().first.physics_material_index) };
-				rigid_body_mass += voxel_mass;
-				center_of_mass += voxel_mass * glm::vec3{ coord };
-
-				// Update x extents.
-				max_extents.x = std::max(max_extents.x, coord.x);
-
-				++coord.x;
+				if (!arena_.sleeping[i])
+				{
+					arena_.sleeping[i] = true;
+					arena_.velocities[i] = {};
+					arena_.angular_velocities[i] = {};
+				}
+				++sleep_stats_.sleeping_count;
+			}
+			else
+			{
+				if (arena_.sleeping[i]) {
+					arena_.Wake(i);
+				}
+				++sleep_stats_.awake_count;
 			}
-
-			FloodFillScan(lx, coord.x, coord.y + 1, coord.z, queue, voxel_chunk, material_mask);
-			FloodFillScan(lx, coord.x, coord.y - 1, coord.z, queue, voxel_chunk, material_mask);
-			FloodFillScan(lx, coord.x, coord.y, coord.z + 1, queue, voxel_chunk, material_mask);
-			FloodFillScan(lx, coord.x, coord.y, coord.z - 1, queue, voxel_chunk, material_mask);
 		}
+	}
 
-		center_of_mass /= rigid_body_mass;
-		CreateRigidBody(min_extents, max_extents, std::move(voxel_pairs), std::move(center_of_mass), rigid_body_mass);
+	const RigidBodySleepStats& XPBDRigidBodyContext::GetSleepStats() const
+	{
+		return sleep_stats_;
 	}
 
 	float XPBDRigidBodyContext::GetVoxelMass(uint32_t physics_material_index) const
@@ -604,87 +1128,38 @@ namespace pmk
 		return density * PARTICLE_VOLUME;
 	}
 
-	glm::mat3 XPBDRigidBodyContext::ComputeInertiaTensor(const renderer::VoxelChunk& voxel_chunk, const glm::vec3& center_of_mass)
+	RigidBodyHandle XPBDRigidBodyContext::CreateRigidBody(const glm::vec3& world_position, const glm::quat& rotation, RigidBody&& rigid_body)
 	{
-		float xx{};
-		float yy{};
-		float zz{};
-		float xy{};
-		float yz{};
-		float xz{};
-
-		for (uint32_t i{ 0 }; i < voxel_chunk.GetWidth(); ++i)
-		{
-			for (uint32_t j{ 0 }; j < voxel_chunk.GetHeight(); ++j)
-			{
-				for (uint32_t k{ 0 }; k < voxel_chunk.GetDepth(); ++k)
-				{
-					uint8_t physics_mat_index{ voxel_chunk.Coordinate(i, j, k).physics_material_index };
-					if (physics_mat_index == renderer::PHYSICS_MATERIAL_EMPTY_INDEX) {
-						continue;
-					}
-
-					glm::vec3 r{ i, j, k };
-					glm::vec3 delta_r{ (r - center_of_mass) * PARTICLE_WIDTH };
-
-					// The square of the cross product matrix of deltra_r.
-					float x2{ delta_r.x * delta_r.x };
-					float y2{ delta_r.y * delta_r.y };
-					float z2{ delta_r.z * delta_r.z };
-					float x_times_y{ delta_r.x * delta_r.y };
-					float x_times_z{ delta_r.x * delta_r.z };
-					float y_times_z{ delta_r.y * delta_r.z };
-					float mass{ GetVoxelMass(physics_mat_index) };
-
-					xx += (y2 + z2) * mass;
-					yy += (x2 + z2) * mass;
-					zz += (x2 + y2) * mass;
-					xy -= x_times_y * mass;
-					yz -= y_times_z * mass;
-					xz -= x_times_z * mass;
-				}
-			}
-		}
-
-		return glm::mat3{
-			xx, xy, xz,
-			xy, yy, yz,
-			xz, yz, zz,
-		};
+		Node* node{ scene_->CreateNode() };
+		node->SetWorldPosition(world_position);
+		node->SetWorldRotation(rotation);
+		scene_->AddRenderObjectToNode(node, renderer_->CreateBlankRenderObject());
+		renderer_->GenerateStaticParticleMesh(node->render_object, rigid_body.voxel_chunk, PARTICLE_WIDTH * rigid_body.center_of_mass);
+		node->rigid_body = arena_.Add(std::move(rigid_body), node);
+		return node->rigid_body;
 	}
 
-	void XPBDRigidBodyContext::CreateRigidBody(
-		const glm::uvec3& min_extents,
-		const glm::uvec3& max_extents,
-		std::vector<std::pair<renderer::Voxel, glm::uvec3>>&& voxel_pairs,
-		glm::vec3&& center_of_mass,
-		float mass)
+	void XPBDRigidBodyContext::OnVoxelsEdited(uint32_t dense_idx, const glm::vec3& previous_center_of_mass, const glm::uvec3& min_coord, const glm::uvec3& max_coord)
 	{
-		// Subtract min extents to make all coordinates relative to it.
-		std::for_each(
-			std::execution::par,
-			voxel_pairs.begin(),
-			voxel_pairs.end(),
-			[&](std::pair<renderer::Voxel, glm::uvec3>& pair)
-			{
-				pair.second -= min_extents;
-			});
-		center_of_mass -= min_extents;
-		glm::uvec3 dimensions{ max_extents - min_extents + glm::uvec3{1, 1, 1} };
-
-		auto voxel_chunk{ renderer::VoxelChunk(dimensions.x, dimensions.y, dimensions.z, std::move(voxel_pairs)) };
-		RigidBody* rigid_body{ new RigidBody{
-			.node = scene_->CreateNode(),
-			.mass = mass,
-			.center_of_mass = center_of_mass,
-			.inertia_tensor = ComputeInertiaTensor(voxel_chunk, center_of_mass),
-			.voxel_chunk = std::move(voxel_chunk),
-		} };
-
-		rigid_body->node->rigid_body = rigid_body;
-		rigid_body->node->SetWorldPosition(PARTICLE_WIDTH * (glm::vec3{ min_extents } + rigid_body->center_of_mass));
-		scene_->AddRenderObjectToNode(rigid_body->node, renderer_->CreateBlankRenderObject());
-		renderer_->GenerateStaticParticleMesh(rigid_body->node->render_object, rigid_body->voxel_chunk, PARTICLE_WIDTH * rigid_body->center_of_mass);
-		rigid_bodies_.push_back(rigid_body);
+		RigidBody& rb{ arena_.Body(dense_idx) };
+		Node* node{ arena_.GetNode(dense_idx) };
+
+		// Positions are of the center of mass, so move them with it to keep the voxels in place.
+		glm::vec3 offset{ arena_.rotations[dense_idx] * ((rb.center_of_mass - previous_center_of_mass) * PARTICLE_WIDTH) };
+		arena_.positions[dense_idx] += offset;
+		arena_.previous_positions[dense_idx] += offset;
+		node->position = arena_.positions[dense_idx];
+		arena_.world_transforms[dense_idx] = arena_.WorldTransform(dense_idx);
+		arena_.inv_world_transforms[dense_idx] = glm::inverse(arena_.world_transforms[dense_idx]);
+		arena_.pending_transform_uploads[dense_idx] = renderer::FRAMES_IN_FLIGHT;
+
+		arena_.point_masses[dense_idx] = rb.voxel_chunk.IsPointMass();
+		arena_.UpdateMassProperties(dense_idx);
+		arena_.Wake(dense_idx);
+
+		rb.voxel_chunk.RebuildOuterVoxels();
+		rb.distance_field.Update(rb.voxel_chunk, min_coord, max_coord);
+
+		renderer_->UpdateStaticParticleMesh(node->render_object, rb.voxel_chunk, PARTICLE_WIDTH * rb.center_of_mass, min_coord, max_coord);
 	}
 }
@@ -8,11 +8,16 @@
 
 #include "vulkan_renderer.h"
 #include "constraint.h"
+#include "distance_field.h"
 
 namespace pmk
 {
 	constexpr uint32_t MAX_COLLISION_PAIRS{ 8 }; // Maximum collision pairs between two voxel objects.
 
+	constexpr float SLEEP_LINEAR_VELOCITY_THRESHOLD{ 0.05f };  // In meters per second.
+	constexpr float SLEEP_ANGULAR_VELOCITY_THRESHOLD{ 0.05f }; // In radians per second.
+	constexpr float SLEEP_TIME{ 0.5f };                        // Seconds every rigid body in an island must be below the thresholds before the island sleeps.
+
 	class XPBDRigidBodyContext;
 
 	class RigidBodyConstraint : public XPBDConstraint
@@ -46,45 +51,149 @@ namespace pmk
 
 	struct Node;
 
+	// Rigid body data that the solver reads rarely. Hot per-body state lives in RigidBodyArena.
 	struct RigidBody
 	{
-		Node* node;                 // Rigid body transform is stored in node.
 		float mass;                 // In kilograms.
 		float dynamic_friction;     // Dimensionless.
 		glm::vec3 center_of_mass;   // Relative to voxel coordinates.
 		glm::mat3 inertia_tensor;   // In kilogram meter squared.
-		glm::vec3 velocity;         // In meters per second.
-		glm::vec3 angular_velocity; // In radians per second.
 		bool immovable;
 		BoundaryCondition boundary_condition;
 
-		glm::vec3 previous_position;
-		glm::quat previous_rotation;
 		renderer::VoxelChunk voxel_chunk;
+		SparseDistanceField distance_field{}; // Built from voxel_chunk when the rigid body is created.
 
-		glm::mat4 cached_world_transform{};
-		glm::mat4 cached_inv_world_transform{};
-
-		// Given voxel world space position, get the voxel coordinate from rb that collides with it.
-		// Returns empty optional if no solution.
-		std::optional<glm::uvec3> GetCollisionCoordinate(const glm::mat4& inv_world_transform, const glm::vec3& global_pos) const;
+		// Convert world space position to coordinate space, where one unit is one voxel width.
+		glm::vec3 GlobalToCoordinate(const glm::mat4& inv_world_transform, const glm::vec3& global_pos) const;
 
 		// Convert voxel coordinate to world space position.
 		glm::vec3 CoordinateToGlobal(const glm::mat4& world_transform, const glm::uvec3& voxel_coord) const;
 
-		// Projects incompatible particle velocity to rigid body.
-		glm::vec3 VelocityProject(const glm::vec3& particle_velocity, const glm::vec3& particle_normal, const glm::vec3& node_position) const;
+		// Outward surface normal in world space at the coordinate space position, from the distance field gradient.
+		glm::vec3 SurfaceNormal(const glm::mat4& world_transform, const glm::vec3& coord_space, const glm::vec3& gradient) const;
+	};
+
+	// Handle to a rigid body in a RigidBodyArena. The generation detects handles to removed rigid bodies.
+	struct RigidBodyHandle
+	{
+		uint32_t slot{ NULL_INDEX };
+		uint32_t generation{};
+
+		bool IsNull() const { return slot == NULL_INDEX; }
+	};
+
+	// Contiguous storage of rigid bodies.
+	// Solver state is stored as parallel arrays indexed by dense index, so solver passes are linear scans.
+	// Dense indices change when rigid bodies are removed, so hold a RigidBodyHandle across frames.
+	// The node of each rigid body is a side table, synchronized with PullFromNodes() and PushToNodes().
+	class RigidBodyArena
+	{
+	public:
+		RigidBodyHandle Add(RigidBody&& rigid_body, Node* node);
+
+		void Remove(RigidBodyHandle handle);
+
+		void Clear();
+
+		uint32_t Size() const;
+
+		// Returns NULL_INDEX if the handle refers to a removed rigid body.
+		uint32_t DenseIndex(RigidBodyHandle handle) const;
+
+		RigidBodyHandle Handle(uint32_t dense_idx) const;
+
+		RigidBody& Body(uint32_t dense_idx);
+
+		const RigidBody& Body(uint32_t dense_idx) const;
+
+		Node* GetNode(uint32_t dense_idx) const;
+
+		// Recompute inverse mass and inertia. Should be called after mass, inertia_tensor or immovable are mutated.
+		void UpdateMassProperties(uint32_t dense_idx);
+
+		// World transform from current position and rotation.
+		glm::mat4 WorldTransform(uint32_t dense_idx) const;
+
+		// Precalculate world_transforms and inv_world_transforms of every awake rigid body.
+		void CacheTransforms();
+
+		// Copy node transforms into the arena, so edits made while paused are simulated. Wakes every rigid body.
+		void PullFromNodes();
+
+		// Copy arena transforms of awake rigid bodies to the nodes. Called once per frame after the physics update.
+		void PushToNodes();
+
+		// Copy the transforms of nodes with transform_edited set into the arena and wake their rigid bodies.
+		// Called before each physics update, so PushToNodes() doesn't overwrite the edits.
+		void PullEditedNodes();
 
 		// Get the velocity of a rigid body at a given world space position.
-		glm::vec3 WorldVelocity(const glm::vec3& world_position) const;
+		glm::vec3 WorldVelocity(uint32_t dense_idx, const glm::vec3& world_position) const;
+
+		// Wake the rigid body and restart its sleep timer.
+		void Wake(uint32_t dense_idx);
+
+		// Wake every rigid body.
+		void WakeAll();
+
+		// Returns true if the node's render object transform should be uploaded this frame.
+		// Sleeping rigid bodies stop uploading once every frame in flight has their final transform.
+		bool ConsumeTransformUpload(RigidBodyHandle handle);
+
+		// Projects incompatible particle velocity to rigid body.
+		glm::vec3 VelocityProject(uint32_t dense_idx, const glm::vec3& particle_velocity, const glm::vec3& particle_normal, const glm::vec3& world_position) const;
+
+		// Wakes the rigid body.
+		void ApplyImpulse(uint32_t dense_idx, const glm::vec3& impulse, const glm::vec3& point_of_application);
+
+		// Solver state, indexed by dense index.
+		std::vector<glm::vec3> positions{};
+		std::vector<glm::quat> rotations{};
+		std::vector<glm::vec3> velocities{};         // In meters per second.
+		std::vector<glm::vec3> angular_velocities{}; // In radians per second.
+		std::vector<glm::vec3> previous_positions{};
+		std::vector<glm::quat> previous_rotations{};
+		std::vector<float> inverse_masses{};               // Zero for immovable rigid bodies.
+		std::vector<glm::mat3> inertia_tensors{};
+		std::vector<glm::mat3> inverse_inertia_tensors{};  // Zero for immovable rigid bodies and point masses.
+		std::vector<uint8_t> immovable{};
+		std::vector<uint8_t> point_masses{};               // Rotation is not integrated for point masses.
+		std::vector<glm::mat4> world_transforms{};
+		std::vector<glm::mat4> inv_world_transforms{};
+		std::vector<float> sleep_timers{};                 // Seconds the rigid body has been below the sleep thresholds.
+		std::vector<uint8_t> sleeping{};
+		std::vector<uint8_t> pending_transform_uploads{};  // Frames in flight that have yet to receive the latest transform.
 
-		void ApplyImpulse(const glm::vec3& impulse, const glm::vec3& point_of_application);
+	private:
+		std::vector<RigidBody> bodies_{};
+		std::vector<Node*> nodes_{};
+		std::vector<uint32_t> dense_to_slot_{};
+		std::vector<uint32_t> slot_to_dense_{};
+		std::vector<uint32_t> slot_generations_{};
+		std::vector<uint32_t> vacant_slots_{};
 	};
 
 	struct CollisionPair
 	{
-		glm::uvec3 coordinate_a; // Colliding voxel of object A.
-		glm::uvec3 coordinate_b; // Colliding voxel of object B.
+		glm::vec3 local_point_a; // Contact point on object A, relative to its center of mass in local space.
+		glm::vec3 local_point_b; // Contact point on object B, relative to its center of mass in local space.
+		glm::vec3 normal;        // World space contact normal pointing from A to B.
+	};
+
+	struct ParticleRigidBodyContact
+	{
+		glm::vec3 position; // World space point on the rigid body surface closest to the particle.
+		glm::vec3 normal;   // World space outward normal of the rigid body surface.
+		float c;            // Constraint value, negative when the particle penetrates the rigid body.
+	};
+
+	struct RigidBodySleepStats
+	{
+		uint32_t awake_count;
+		uint32_t sleeping_count;
+		uint32_t island_count;         // Islands of rigid bodies connected by contacts, excluding immovable rigid bodies.
+		uint32_t skipped_pair_count;   // Pair tests skipped because both rigid bodies were sleeping or immovable.
 	};
 
 	class Scene;
@@ -109,20 +218,31 @@ namespace pmk
 
 		void ResetRigidBodies();
 
-		const std::vector<RigidBody*>& GetRigidBodies() const;
+		const RigidBodyArena& GetArena() const;
 
-		std::vector<RigidBody*>& GetRigidBodies();
+		RigidBodyArena& GetArena();
 
-		// Populate rigid_bodies_ with rigid bodies made from connected voxels sharing
+		// Populate the arena with rigid bodies made from connected voxels sharing
 		// the same rigid body physics material.
 		// Removes the rigid body voxels from input voxels.
 		// Returns list of node indices/IDs created from rigid bodies.
 		std::vector<uint32_t> CreateRigidBodiesByConnectedness(renderer::VoxelChunk& voxel_chunk, bool* out_is_empty);
 
-		std::array<CollisionPair, MAX_COLLISION_PAIRS> ComputeCollisionPairs(const RigidBody* a, const RigidBody* b, uint32_t* out_count) const;
+		// Remove voxels of a rigid body, given in its voxel coordinates. Mass properties are updated incrementally
+		// and parts that are no longer connected are split off into new rigid bodies, which are returned.
+		// The rigid body is removed if no voxels remain.
+		std::vector<RigidBodyHandle> RemoveVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords);
+
+		// Add or replace voxels of a rigid body, given in its voxel coordinates. Coordinates must be within the rigid body's voxel chunk.
+		void AddVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels);
+
+		std::array<CollisionPair, MAX_COLLISION_PAIRS> ComputeCollisionPairs(uint32_t a_idx, uint32_t b_idx, uint32_t* out_count) const;
+
+		// If collision occurs then return the contact between the particle and the rigid body surface. Empty optional means no collision occurred.
+		std::optional<ParticleRigidBodyContact> ComputeParticleCollision(uint32_t rb_idx, const glm::vec3& particle_position) const;
 
-		// If collision occurs then return world position of rigid body voxel that p collides with. Empty optional means no collision occurred.
-		std::optional<glm::vec3> ComputeParticleCollision(const RigidBody* rb, const glm::vec3& particle_position) const;
+		// Sleep statistics from the last substep.
+		const RigidBodySleepStats& GetSleepStats() const;
 
 #ifdef EDITOR_ENABLED
 		void SetRigidBodyOverlayEnabled(bool enabled);
@@ -133,22 +253,22 @@ namespace pmk
 	private:
 		void SolvePositions(float h);
 
-		void RigidBodyFloodFill(const glm::uvec3& coordinate, renderer::VoxelChunk& voxel_chunk, const std::vector<uint8_t>& material_mask);
+		// Advance sleep timers, then put islands to sleep or wake them as a whole.
+		void UpdateSleeping(float h);
 
 		float GetVoxelMass(uint32_t physics_material_index) const;
 
-		glm::mat3 ComputeInertiaTensor(const renderer::VoxelChunk& voxel_chunk, const glm::vec3& center_of_mass);
+		// Create the node and render object of a rigid body with its center of mass at world_position, and add it to the arena.
+		RigidBodyHandle CreateRigidBody(const glm::vec3& world_position, const glm::quat& rotation, RigidBody&& rigid_body);
 
-		void CreateRigidBody(
-			const glm::uvec3& min_extents,
-			const glm::uvec3& max_extents,
-			std::vector<std::pair<renderer::Voxel, glm::uvec3>>&& voxel_pairs,
-			glm::vec3&& center_of_mass,
-			float mass);
+		// Update the arena, distance field, outer voxels and mesh of a rigid body after voxels between min_coord and max_coord changed.
+		void OnVoxelsEdited(uint32_t dense_idx, const glm::vec3& previous_center_of_mass, const glm::uvec3& min_coord, const glm::uvec3& max_coord);
 
 		renderer::VulkanRenderer* renderer_{};
 		Scene* scene_{};
-		std::vector<RigidBody*> rigid_bodies_{};
+		RigidBodyArena arena_{};
+		std::vector<std::pair<uint32_t, uint32_t>> contact_pairs_{}; // Dense indices of rigid body pairs in contact this substep.
+		RigidBodySleepStats sleep_stats_{};
 		bool update_physics_{};
 #ifdef EDITOR_ENABLED
 		bool generate_rb_voxel_instances_{};
@@ -11,6 +11,7 @@
 #pragma warning( pop )
 
 #include "logger.h"
+#include "common_constants.h"
 #include "mesh.h"
 #include "glm/gtx/transform.hpp"
 
@@ -83,6 +84,7 @@ namespace pmk
 	{
 		// Because (parent world space transform) * (local transform) = (world transform).
 		position = glm::inverse(parent_->GetWorldTransform()) * glm::vec4{ world_position, 1.0f };
+		transform_edited = true;
 	}
 
 	glm::vec3 Node::GetWorldPosition() const
@@ -93,6 +95,7 @@ namespace pmk
 	void Node::SetWorldRotation(const glm::quat& world_rotation)
 	{
 		rotation = glm::inverse(parent_->GetWorldRotation()) * world_rotation;
+		transform_edited = true;
 	}
 
 	glm::quat Node::GetWorldRotation() const
@@ -135,6 +138,7 @@ namespace pmk
 		scale = { l1, l2, l3 };
 		position = glm::vec3(transform[3]);
 		rotation = glm::quat_cast(rot_mat);
+		transform_edited = true;
 	}
 
 	bool Node::HasAncestor(Node* node)
@@ -286,6 +290,11 @@ namespace pmk
 		physics_context_.SetRigidBodyOverlayEnabled(enabled);
 	}
 
+	void Scene::SetFluidSurfaceEnabled(bool enabled)
+	{
+		physics_context_.SetFluidSurfaceEnabled(enabled);
+	}
+
 	void Scene::UploadRenderObjectsRec(Node* root, const glm::mat4& parent_transform)
 	{
 		glm::mat4 local_transform{ root->GetLocalTransform() };
@@ -293,8 +302,8 @@ namespace pmk
 		// rather than needing to recurse back up at each step to get the world transform.
 		glm::mat4 world_transform{ parent_transform * local_transform };
 
-		// Not every node has a render object.
-		if (root->render_object != renderer::NULL_HANDLE) {
+		// Not every node has a render object. Sleeping rigid bodies keep the transform already uploaded, unless their node was edited.
+		if (root->render_object != renderer::NULL_HANDLE && physics_context_.GetRigidBodyArena().ConsumeTransformUpload(root->rigid_body)) {
 			renderer_->SetRenderObjectTransform(root->render_object, world_transform);
 		}
 
@@ -305,7 +314,13 @@ namespace pmk
 
 	void Scene::UploadRenderObjects()
 	{
+		// Rigid bodies moved by the editor are woken and upload their new transform, even while the simulation is paused.
+		physics_context_.GetRigidBodyArena().PullEditedNodes();
 		UploadRenderObjectsRec(root_node_, glm::mat4(1.0f));
+
+		for (const auto& [chunk_coord, render_object] : streamed_chunk_render_objects_) {
+			renderer_->SetRenderObjectTransform(render_object, glm::translate(glm::vec3{ chunk_coord } * CHUNK_WIDTH));
+		}
 	}
 
 	void Scene::UploadCamera()
@@ -393,6 +408,36 @@ namespace pmk
 		}
 	}
 
+	void Scene::AddStreamedChunk(const glm::ivec3& chunk_coord, const renderer::VoxelChunk& chunk)
+	{
+		if (chunk.OccupiedVoxelCount() == 0) {
+			return;
+		}
+
+		renderer::RenderObjectHandle render_object{ renderer_->CreateBlankRenderObject() };
+		renderer_->GenerateStaticParticleMesh(render_object, chunk);
+		streamed_chunk_render_objects_[chunk_coord] = render_object;
+	}
+
+	void Scene::RemoveStreamedChunk(const glm::ivec3& chunk_coord)
+	{
+		auto it{ streamed_chunk_render_objects_.find(chunk_coord) };
+		if (it == streamed_chunk_render_objects_.end()) {
+			return;
+		}
+
+		renderer_->QueueDestroyRenderObject(it->second);
+		streamed_chunk_render_objects_.erase(it);
+	}
+
+	void Scene::RemoveStreamedChunks()
+	{
+		for (const auto& [chunk_coord, render_object] : streamed_chunk_render_objects_) {
+			renderer_->QueueDestroyRenderObject(render_object);
+		}
+		streamed_chunk_render_objects_.clear();
+	}
+
 	void Scene::ParticlePhysicsUpdate(float delta_time)
 	{
 		physics_context_.PhysicsUpdate(delta_time);
@@ -433,6 +478,26 @@ namespace pmk
 		return physics_context_.GetPhysicsMaterial(physics_mat_index);
 	}
 
+	RigidBodyArena& Scene::GetRigidBodyArena()
+	{
+		return physics_context_.GetRigidBodyArena();
+	}
+
+	const RigidBodySleepStats& Scene::GetRigidBodySleepStats() const
+	{
+		return physics_context_.GetRigidBodySleepStats();
+	}
+
+	std::vector<RigidBodyHandle> Scene::RemoveRigidBodyVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords)
+	{
+		return physics_context_.RemoveRigidBodyVoxels(handle, coords);
+	}
+
+	void Scene::AddRigidBodyVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels)
+	{
+		physics_context_.AddRigidBodyVoxels(handle, voxels);
+	}
+
 	XPBDConstraint* Scene::NewConstraint()
 	{
 		return physics_context_.NewConstraint();
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <array>
 #include <string>
 #include <filesystem>
@@ -11,6 +12,7 @@
 
 #include "vulkan_renderer.h"
 #include "physics.h"
+#include "chunk_streaming.h"
 
 namespace pmk
 {
@@ -18,13 +20,17 @@ namespace pmk
 	{
 		const uint32_t node_id;
 		renderer::RenderObjectHandle render_object{ renderer::NULL_HANDLE };
-		RigidBody* rigid_body{};
+		RigidBodyHandle rigid_body{};
 
 		// Each transform is in local space of parent.
 		glm::vec3 position{};
 		glm::vec3 scale{ 1.0f, 1.0f, 1.0f };
 		glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
 
+		// Set when the transform is changed outside of the physics simulation, such as by the editor. The setters below set it,
+		// direct writes to the transform must set it themselves. Cleared once the rigid body of the node has picked up the change.
+		bool transform_edited{};
+
 		Node* GetParent() const;
 
 		const std::unordered_set<Node*>& GetChildren() const;
@@ -113,6 +119,9 @@ namespace pmk
 
 		void SetRigidBodyOverlayEnabled(bool enabled);
 
+		// Mesh particles of fluid materials as a smooth surface instead of cubes.
+		void SetFluidSurfaceEnabled(bool enabled);
+
 		// Update all render objects transforms to reflect their containing node.
 		void UploadRenderObjects();
 
@@ -135,6 +144,14 @@ namespace pmk
 
 		void AddRenderObjectToNode(Node* node, renderer::RenderObjectHandle handle);
 
+		// Render a streamed chunk at its place in the world. Streamed chunks aren't nodes, so they can't be selected and aren't simulated.
+		void AddStreamedChunk(const glm::ivec3& chunk_coord, const renderer::VoxelChunk& chunk);
+
+		// Does nothing if the chunk isn't rendered.
+		void RemoveStreamedChunk(const glm::ivec3& chunk_coord);
+
+		void RemoveStreamedChunks();
+
 		void ParticlePhysicsUpdate(float delta_time);
 
 		PhysicsMaterial* NewPhysicsMaterial();
@@ -153,6 +170,16 @@ namespace pmk
 
 		PhysicsMaterial* GetPhysicsMaterial(uint8_t physics_mat_index);
 
+		RigidBodyArena& GetRigidBodyArena();
+
+		const RigidBodySleepStats& GetRigidBodySleepStats() const;
+
+		// Remove voxels of a rigid body, splitting off disconnected parts into new rigid bodies, which are returned.
+		std::vector<RigidBodyHandle> RemoveRigidBodyVoxels(RigidBodyHandle handle, const std::vector<glm::uvec3>& coords);
+
+		// Add or replace voxels within the voxel chunk of a rigid body.
+		void AddRigidBodyVoxels(RigidBodyHandle handle, const std::vector<std::pair<renderer::Voxel, glm::uvec3>>& voxels);
+
 		XPBDConstraint* NewConstraint();
 
 		void DeleteConstraint(uint32_t constraint_index);
@@ -187,5 +214,6 @@ namespace pmk
 		std::unordered_map<renderer::RenderObjectHandle, Node*> render_object_node_map_{}; // Map render object handles to nodes. This won't contain nodes without render objects.
 		PhysicsContext physics_context_{};
 		std::stack<uint32_t> vacant_node_indices_{}; // Unused node indices from deleted nodes to recycle.
+		std::unordered_map<glm::ivec3, renderer::RenderObjectHandle, ChunkCoordinateHash> streamed_chunk_render_objects_{}; // Empty chunks have no render object.
 	};
 }
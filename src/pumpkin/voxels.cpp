@@ -69,49 +69,30 @@ namespace pmk
 		}
 
 		particle_node_ = node;
-		renderer_->InvokeParticleGenShader(node->render_object, &voxel_chunk_.GetVoxels(), &voxel_chunk_.GetSideFlags());
+		std::vector<renderer::Voxel> voxels{};
+		std::vector<uint8_t> side_flags{};
+		renderer_->InvokeParticleGenShader(node->render_object, &voxels, &side_flags);
+		voxel_chunk_.AssignDense(voxels, side_flags);
 		ResetParticles();
 		renderer_->UpdateMaterials();
 
-		generated_voxel_count_ = 0;
-		for (uint32_t i{ 0 }; i < voxel_chunk_.VoxelCount(); ++i)
-		{
-			if (!voxel_chunk_.IsEmpty(i)) {
-				++generated_voxel_count_;
-			}
-		}
+		generated_voxel_count_ = voxel_chunk_.OccupiedVoxelCount();
 		return generated_voxel_count_;
 	}
 
 	void VoxelContext::TransferStaticParticlesToXPBD()
 	{
-		uint32_t particle_count{ 0 };
-		for (uint32_t i{ 0 }; i < voxel_chunk_.VoxelCount(); ++i)
-		{
-			if (voxel_chunk_.IsEmpty(i)) {
-				continue;
-			}
-
-			++particle_count;
-		}
-
 		std::vector<XPBDParticle> xpbd_particles{};
-		xpbd_particles.reserve(particle_count);
-
-		uint32_t position_idx{ 0 };
-		for (uint32_t i{ 0 }; i < voxel_chunk_.VoxelCount(); ++i)
-		{
-			if (voxel_chunk_.IsEmpty(i)) {
-				continue;
-			}
+		xpbd_particles.reserve(voxel_chunk_.OccupiedVoxelCount());
 
-			glm::uvec3 coord{ voxel_chunk_.IndexToCoordinate(i) };
-			glm::vec3 pos{ PARTICLE_WIDTH * glm::vec3{ coord } };;
+		voxel_chunk_.ForEachOccupied([&](uint32_t idx, const glm::uvec3& coord, const renderer::Voxel& voxel) {
+			glm::vec3 pos{ PARTICLE_WIDTH * glm::vec3{ coord } };
 
 			XPBDParticle xpbd_particle{
 				.key = {}, // Set later.
 				.velocity = glm::vec3{0.0f, 0.0f, 0.0f},
-				.physics_material_index = voxel_chunk_.Index(i).physics_material_index,
+				.physics_material_index = voxel.physics_material_index,
+				.exposed_faces = {}, // Set later.
 				.s = {
 					.position = pos,
 					.predicted_position = pos,
@@ -121,7 +102,7 @@ namespace pmk
 			};
 
 			xpbd_particles.push_back(xpbd_particle);
-		}
+			});
 
 		xpbd_context_.Initialize(std::move(xpbd_particles), CHUNK_WIDTH, jacobi_constraints_, physics_materials_);
 	}
@@ -155,9 +136,37 @@ namespace pmk
 
 	void VoxelContext::GenerateDynamicMesh()
 	{
+		xpbd_context_.UpdateExposedFaces();
 		GenerateDynamicParticleMesh(particle_node_->render_object, xpbd_context_.GetParticles());
 	}
 
+	void VoxelContext::SetFluidSurfaceEnabled(bool enabled)
+	{
+		fluid_surface_enabled_ = enabled;
+		renderer_->SetFluidSurfaceMaterials(enabled ? GetFluidSurfaceMaterials() : std::vector<uint8_t>{});
+	}
+
+	std::vector<uint8_t> VoxelContext::GetFluidSurfaceMaterials() const
+	{
+		std::vector<uint8_t> fluid_materials{};
+		for (uint32_t mat_idx{ 0 }; mat_idx < (uint32_t)physics_materials_->size(); ++mat_idx)
+		{
+			uint32_t mask{ (*physics_materials_)[mat_idx]->jacobi_constraints_mask };
+			uint32_t i{ 0 };
+			while (mask)
+			{
+				if ((mask & 1) && dynamic_cast<const FluidCollisionConstraint*>((*jacobi_constraints_)[i]))
+				{
+					fluid_materials.push_back((uint8_t)mat_idx);
+					break;
+				}
+				mask >>= 1;
+				++i;
+			}
+		}
+		return fluid_materials;
+	}
+
 #ifdef EDITOR_ENABLED
 	void VoxelContext::SetMPMDebugParticleGenEnabled(bool enabled)
 	{
@@ -190,7 +199,15 @@ namespace pmk
 
 		{
 			ZoneScopedN("Generate mesh");
-			renderer_->CmdGenerateDynamicParticleMesh(ro_target, (const std::byte*)particles.data(), (uint32_t)particles.size(), offsetof(XPBDParticle, s.position), sizeof(XPBDParticle), mat_ranges);
+			if (fluid_surface_enabled_)
+			{
+				// Fluid surfaces are only extracted on the CPU. Constraints of materials can change at any time, so look them up each mesh.
+				renderer_->SetFluidSurfaceMaterials(GetFluidSurfaceMaterials());
+				renderer_->GenerateDynamicParticleMesh(ro_target, (const std::byte*)particles.data(), offsetof(XPBDParticle, s.position), offsetof(XPBDParticle, exposed_faces), sizeof(XPBDParticle), mat_ranges);
+			}
+			else {
+				renderer_->GenerateProceduralParticleMesh(ro_target, (const std::byte*)particles.data(), offsetof(XPBDParticle, s.position), offsetof(XPBDParticle, exposed_faces), sizeof(XPBDParticle), mat_ranges);
+			}
 		}
 
 #ifdef EDITOR_ENABLED
@@ -218,20 +235,18 @@ namespace pmk
 		}
 
 		std::vector<XPBDParticle> dynamic_particles{};
-		for (uint32_t i{ 0 }; i < CHUNK_TOTAL_VOXEL_COUNT; ++i)
-		{
-
-			if (voxel_chunk.IsEmpty(i) || voxel_chunk.IsOccluded(i)) {
-				continue;
+		voxel_chunk.ForEachOccupied([&](uint32_t idx, const glm::uvec3& coord, const renderer::Voxel& voxel) {
+			if (voxel_chunk.IsOccluded(idx)) {
+				return;
 			}
 
 			XPBDParticle particle{
 				.s = {
-					.position = PARTICLE_WIDTH * glm::vec3(voxel_chunk_.IndexToCoordinate(i)),
+					.position = PARTICLE_WIDTH * glm::vec3(coord),
 				},
 			};
 			dynamic_particles.push_back(particle);
-		}
+			});
 		return dynamic_particles;
 	}
 
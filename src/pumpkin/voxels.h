@@ -50,6 +50,9 @@ namespace pmk
 
 		void GenerateDynamicMesh();
 
+		// Mesh particles of fluid materials as a smooth surface instead of cubes. The mesh is then built on the CPU.
+		void SetFluidSurfaceEnabled(bool enabled);
+
 #ifdef EDITOR_ENABLED
 		void SetMPMDebugParticleGenEnabled(bool enabled);
 #endif
@@ -63,9 +66,13 @@ namespace pmk
 
 		void GenerateDynamicDebugMPMParticleInstances() const;
 
+		// Physics materials with a fluid collision constraint.
+		std::vector<uint8_t> GetFluidSurfaceMaterials() const;
+
 		renderer::VoxelChunk voxel_chunk_{ CHUNK_ROW_VOXEL_COUNT, CHUNK_ROW_VOXEL_COUNT, CHUNK_ROW_VOXEL_COUNT };
 		bool has_played_{}; // True if the particle simulation has been played yet.
 		bool update_physics_{};
+		bool fluid_surface_enabled_{};
 #ifdef EDITOR_ENABLED
 		bool generate_mpm_particle_instances_{};
 #endif
@@ -267,6 +267,48 @@ namespace pmk
 		return particle_keys_;
 	}
 
+	void XPBDParticleContext::UpdateExposedFaces()
+	{
+		ZoneScoped;
+
+		// A neighbor covers a face when it is beside the face within these tolerances.
+		constexpr float lateral_tolerance{ 0.25f * PARTICLE_WIDTH };
+		constexpr float max_axial_distance{ 1.25f * PARTICLE_WIDTH };
+		constexpr uint8_t all_sides{ 0x3F };
+
+		auto indices{ std::views::iota(0u, (uint32_t)particles_.size()) };
+		std::for_each(std::execution::par, indices.begin(), indices.end(),
+			[&](uint32_t i) {
+				XPBDParticle& p{ particles_[i] };
+				uint8_t covered{ 0 };
+
+				// Particles start on grid cell boundaries, so a neighbor can be two cells away. Searching around the
+				// particle shifted half a width towards each corner covers every neighbor on the positive and negative sides.
+				for (float shift : { PARTICLE_RADIUS, -PARTICLE_RADIUS })
+				{
+					for (const XPBDParticle& neighbor : GetParticlesByProximity(p.s.position + shift))
+					{
+						glm::vec3 offset{ neighbor.s.position - p.s.position };
+						glm::vec3 distance{ glm::abs(offset) };
+						for (uint32_t axis{ 0 }; axis < 3; ++axis)
+						{
+							if (distance[axis] == 0.0f || distance[axis] > max_axial_distance ||
+								distance[(axis + 1) % 3] > lateral_tolerance ||
+								distance[(axis + 2) % 3] > lateral_tolerance)
+							{
+								continue;
+							}
+
+							// Positive side of an axis is the lower bit of each pair, like VoxelSidesFlagBits.
+							covered |= (uint8_t)(1 << (2 * axis + (offset[axis] > 0.0f ? 0 : 1)));
+						}
+					}
+				}
+
+				p.exposed_faces = ~covered & all_sides;
+			});
+	}
+
 	RigidBodyParticleCollisionInfo& XPBDParticleContext::GetRigidBodyCollision(uint32_t particle_idx)
 	{
 		return rb_collisions_[particle_idx];
@@ -627,26 +669,21 @@ namespace pmk
 		// Detect rigid body collisions.
 		RigidBodyParticleCollisionInfo& rb_collision{ p_context->GetRigidBodyCollision(particle_idx) };
 		rb_collision.rb_index = NULL_INDEX;
-		uint32_t rb_idx{ 0 };
-		for (const RigidBody* rb : rb_context->GetRigidBodies())
+		const RigidBodyArena& arena{ rb_context->GetArena() };
+		for (uint32_t rb_idx{ 0 }; rb_idx < arena.Size(); ++rb_idx)
 		{
-			std::optional<glm::vec3> rb_voxel_pos{ rb_context->ComputeParticleCollision(rb, p1.predicted_position) };
+			std::optional<ParticleRigidBodyContact> contact{ rb_context->ComputeParticleCollision(rb_idx, p1.predicted_position) };
 
-			if (rb_voxel_pos.has_value())
+			if (contact.has_value())
 			{
-				glm::vec3 diff{ p1.predicted_position - rb_voxel_pos.value() };
-				float distance{ glm::length(diff) };
-				float c{ distance - PARTICLE_WIDTH };
-				glm::vec3 grad_c{ diff / distance };
-
+				float c{ contact->c };
 
 				// Rigid body update that will be applied during rigid body physics update.
-				glm::vec3& n{ grad_c };
-				glm::vec3 world_pos_b = rb_voxel_pos.value() - n * PARTICLE_RADIUS;
-				glm::vec3 r{ rb_voxel_pos.value() - rb->node->position };
-				float rb_inv_mass{ rb->immovable ? 0.0f : (1.0f / rb->mass) };
+				const glm::vec3& n{ contact->normal };
+				glm::vec3 r{ contact->position - arena.positions[rb_idx] };
+				float rb_inv_mass{ arena.inverse_masses[rb_idx] };
 				glm::vec3 r_cross_n{ glm::cross(r, n) };
-				glm::mat3 inertia_tensor_inv_b{ rb->immovable || rb->voxel_chunk.IsPointMass() ? glm::mat3{} : glm::inverse(rb->inertia_tensor) };
+				const glm::mat3& inertia_tensor_inv_b{ arena.inverse_inertia_tensors[rb_idx] };
 				float rb_weight{ rb_inv_mass + glm::dot(r_cross_n, inertia_tensor_inv_b * r_cross_n) };
 				float lambda{ -c / (p1.inverse_mass + rb_weight + collision_compliance_term) };
 				glm::vec3 p{ lambda * n };
@@ -656,21 +693,20 @@ namespace pmk
 
 				// Record rigid body's change in position and rotation.
 				// For now just overwrite previous rigid body collisions this particle had. So particle will currently only influence one rigid body per time step.
-				if (!rb->immovable)
+				if (!arena.immovable[rb_idx])
 				{
 					rb_collision.rb_index = rb_idx;
 					rb_collision.rb_delta_position = -p * rb_inv_mass;
-					if (rb->voxel_chunk.IsPointMass()) {
+					if (arena.point_masses[rb_idx]) {
 						rb_collision.rb_delta_rotation = {};
 					}
 					else
 					{
 						glm::vec3 tmp2{ inertia_tensor_inv_b * glm::cross(r, p) };
-						rb_collision.rb_delta_rotation = -0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *rb->node->rotation;
+						rb_collision.rb_delta_rotation = -0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *arena.rotations[rb_idx];
 					}
 				}
 			}
-			++rb_idx;
 		}
 
 		return particle_delta_x;
@@ -782,26 +818,21 @@ namespace pmk
 		// Detect rigid body collisions.
 		RigidBodyParticleCollisionInfo& rb_collision{ p_context->GetRigidBodyCollision(particle_idx) };
 		rb_collision.rb_index = NULL_INDEX;
-		uint32_t rb_idx{ 0 };
-		for (const RigidBody* rb : rb_context->GetRigidBodies())
+		const RigidBodyArena& arena{ rb_context->GetArena() };
+		for (uint32_t rb_idx{ 0 }; rb_idx < arena.Size(); ++rb_idx)
 		{
-			std::optional<glm::vec3> rb_voxel_pos{ rb_context->ComputeParticleCollision(rb, p1.predicted_position) };
+			std::optional<ParticleRigidBodyContact> contact{ rb_context->ComputeParticleCollision(rb_idx, p1.predicted_position) };
 
-			if (rb_voxel_pos.has_value())
+			if (contact.has_value())
 			{
-				glm::vec3 diff{ p1.predicted_position - rb_voxel_pos.value() };
-				float distance{ glm::length(diff) };
-				float c{ distance - PARTICLE_WIDTH };
-				glm::vec3 grad_c{ diff / distance };
-
+				float c{ contact->c };
 
 				// Rigid body update that will be applied during rigid body physics update.
-				glm::vec3& n{ grad_c };
-				glm::vec3 world_pos_b = rb_voxel_pos.value() - n * PARTICLE_RADIUS;
-				glm::vec3 r{ rb_voxel_pos.value() - rb->node->position };
-				float rb_inv_mass{ rb->immovable ? 0.0f : (1.0f / rb->mass) };
+				const glm::vec3& n{ contact->normal };
+				glm::vec3 r{ contact->position - arena.positions[rb_idx] };
+				float rb_inv_mass{ arena.inverse_masses[rb_idx] };
 				glm::vec3 r_cross_n{ glm::cross(r, n) };
-				glm::mat3 inertia_tensor_inv_b{ rb->immovable || rb->voxel_chunk.IsPointMass() ? glm::mat3{} : glm::inverse(rb->inertia_tensor) };
+				const glm::mat3& inertia_tensor_inv_b{ arena.inverse_inertia_tensors[rb_idx] };
 				float rb_weight{ rb_inv_mass + glm::dot(r_cross_n, inertia_tensor_inv_b * r_cross_n) };
 				float lambda{ -c / (p1.inverse_mass + rb_weight + compliance_term) };
 				glm::vec3 p{ lambda * n };
@@ -811,21 +842,20 @@ namespace pmk
 
 				// Record rigid body's change in position and rotation.
 				// For now just overwrite previous rigid body collisions this particle had. So particle will currently only influence one rigid body per time step.
-				if (!rb->immovable)
+				if (!arena.immovable[rb_idx])
 				{
 					rb_collision.rb_index = rb_idx;
 					rb_collision.rb_delta_position = -p * rb_inv_mass;
-					if (rb->voxel_chunk.IsPointMass()) {
+					if (arena.point_masses[rb_idx]) {
 						rb_collision.rb_delta_rotation = {};
 					}
 					else
 					{
 						glm::vec3 tmp2{ inertia_tensor_inv_b * glm::cross(r, p) };
-						rb_collision.rb_delta_rotation = -0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *rb->node->rotation;
+						rb_collision.rb_delta_rotation = -0.5f * glm::quat{ 0.0f, tmp2.x, tmp2.y, tmp2.z } *arena.rotations[rb_idx];
 					}
 				}
 			}
-			++rb_idx;
 		}
 
 		return p1_delta_x;
@@ -27,6 +27,7 @@ namespace pmk
 		uint64_t key;       // Sort the particles optimally for lookup and for the cache.
 		glm::vec3 velocity; // Meters per second.
 		uint8_t physics_material_index;
+		uint8_t exposed_faces; // Sides not covered by an adjacent particle, in renderer::VoxelSidesFlagBits order. Only used for meshing.
 
 		// XPBDParticle members to copy to XPBDParticle after sort.
 		struct
@@ -43,7 +44,7 @@ namespace pmk
 
 	struct RigidBodyParticleCollisionInfo
 	{
-		uint32_t rb_index;
+		uint32_t rb_index; // Dense index into RigidBodyArena.
 		glm::vec3 rb_delta_position;
 		glm::quat rb_delta_rotation;
 	};
@@ -237,6 +238,10 @@ namespace pmk
 
 		const std::vector<uint32_t>& GetParticleKeys() const;
 
+		// Find which faces of each particle's cube are not covered by an adjacent particle using the hash grid.
+		// Must be called before the particles are reordered after a simulation step.
+		void UpdateExposedFaces();
+
 		RigidBodyParticleCollisionInfo& GetRigidBodyCollision(uint32_t particle_idx);
 
 		ProximityContainer GetParticlesByProximity(const glm::vec3& position);
@@ -143,14 +143,27 @@ namespace renderer
 		float priority{ 1.0f };
 
 		graphics_queue_family_ = ChooseGraphicsQueueFamilyIndex();
-
-		VkDeviceQueueCreateInfo graphics_queue_info{
-			.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-			.queueFamilyIndex = graphics_queue_family_,
-			.queueCount = 1,
-			.pQueuePriorities = &priority,
+		transfer_queue_family_ = ChooseTransferQueueFamilyIndex();
+
+		std::vector<VkDeviceQueueCreateInfo> queue_infos{
+			VkDeviceQueueCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+				.queueFamilyIndex = graphics_queue_family_,
+				.queueCount = 1,
+				.pQueuePriorities = &priority,
+			}
 		};
 
+		if (transfer_queue_family_ != graphics_queue_family_)
+		{
+			queue_infos.push_back(VkDeviceQueueCreateInfo{
+				.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+				.queueFamilyIndex = transfer_queue_family_,
+				.queueCount = 1,
+				.pQueuePriorities = &priority,
+			});
+		}
+
 		logger::Print("Enabling the following device extensions:\n");
 		for (const char* extension : required_device_extensions) {
 			logger::Print("\t%s\n", extension);
@@ -201,18 +214,21 @@ namespace renderer
 			.descriptorBindingPartiallyBound = VK_TRUE,
 			.runtimeDescriptorArray = VK_TRUE,
 			.scalarBlockLayout = VK_TRUE,
+			.timelineSemaphore = VK_TRUE,
 			.bufferDeviceAddress = VK_TRUE,
 		};
 
 		VkPhysicalDeviceFeatures features{
+			.multiDrawIndirect = VK_TRUE,
+			.drawIndirectFirstInstance = VK_TRUE,
 			.shaderInt64 = VK_TRUE,
 		};
 
 		VkDeviceCreateInfo device_info{
 			.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
 			.pNext = &features_12,
-			.queueCreateInfoCount = 1,
-			.pQueueCreateInfos = &graphics_queue_info,
+			.queueCreateInfoCount = (uint32_t)queue_infos.size(),
+			.pQueueCreateInfos = queue_infos.data(),
 			.enabledExtensionCount = (uint32_t)required_device_extensions.size(),
 			.ppEnabledExtensionNames = required_device_extensions.data(),
 			.pEnabledFeatures = &features,
@@ -224,6 +240,7 @@ namespace renderer
 		volkLoadDevice(device);
 
 		vkGetDeviceQueue(device, graphics_queue_family_, 0, &graphics_queue);
+		vkGetDeviceQueue(device, transfer_queue_family_, 0, &transfer_queue);
 	}
 
 	void Context::CleanUp()
@@ -252,6 +269,11 @@ namespace renderer
 		return graphics_queue_family_;
 	}
 
+	uint32_t Context::GetTransferQueueFamilyIndex()
+	{
+		return transfer_queue_family_;
+	}
+
 
 
 	// Helper functions ----------------------------------------------------------------------------------------
@@ -396,6 +418,26 @@ namespace renderer
 		return graphics_family;
 	}
 
+	uint32_t Context::ChooseTransferQueueFamilyIndex()
+	{
+		uint32_t prop_count{};
+		vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &prop_count, nullptr);
+		std::vector<VkQueueFamilyProperties> properties(prop_count);
+		vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &prop_count, properties.data());
+
+		for (uint32_t i{ 0 }; i < prop_count; ++i)
+		{
+			VkQueueFlags flags{ properties[i].queueFlags };
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				logger::Print("Using dedicated transfer queue family %u.\n\n", i);
+				return i;
+			}
+		}
+
+		return graphics_queue_family_;
+	}
+
 	void Context::CheckDeviceExtensionsSupported(const std::vector<const char*>& requested_extensions)
 	{
 		// Get supported extension properties.
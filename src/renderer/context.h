@@ -43,12 +43,17 @@ namespace renderer
 
 		uint32_t GetGraphicsQueueFamilyIndex();
 
+		// Same as the graphics family if the device has no transfer only family.
+		uint32_t GetTransferQueueFamilyIndex();
+
 		VkInstance instance{};
 		GLFWwindow* window{};
 		VkSurfaceKHR surface{};
 		VkPhysicalDevice physical_device{};
 		VkDevice device{};
 		VkQueue graphics_queue{};
+		VkQueue transfer_queue{};         // Same as graphics_queue if there is no dedicated transfer queue family.
+		VkPipelineCache pipeline_cache{}; // Created and saved by PipelineCache, and passed to all pipeline creation.
 
 	private:
 		void InitializeInstance();
@@ -72,9 +77,13 @@ namespace renderer
 
 		uint32_t ChooseGraphicsQueueFamilyIndex();
 
+		// Prefer a family with transfer but not graphics or compute support, which is usually backed by a DMA engine.
+		uint32_t ChooseTransferQueueFamilyIndex();
+
 		void CheckDeviceExtensionsSupported(const std::vector<const char*>& requested_extensions);
 
 		VkDebugUtilsMessengerEXT debug_messenger_{};
 		uint32_t graphics_queue_family_{};
+		uint32_t transfer_queue_family_{};
 	};
 }
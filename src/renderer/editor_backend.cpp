@@ -14,7 +14,7 @@
 namespace renderer
 {
 	constexpr uint32_t EDITOR_CAMERA_UBO_SET{ 0 };
-	constexpr uint32_t EDITOR_RENDER_OBJECT_UBO_SET{ 1 };
+	constexpr uint32_t EDITOR_RENDER_OBJECT_DATA_SET{ 1 };
 
 	constexpr uint32_t EDITOR_OUTLINE_SET{ 0 };
 	constexpr uint32_t EDITOR_MASK_TEXTURE_BINDING{ 0 };
@@ -400,24 +400,19 @@ namespace renderer
 		renderer_->vulkan_util_.TransferBufferToDevice(line_vertices, physics_debug_.line_vertices);
 		renderer_->vulkan_util_.Submit();
 
-		// Make pipelines.
+		// Make pipelines, which don't depend on each other so they're created in parallel.
 		std::vector<DescriptorSetLayoutResource> mask_set_layouts{
 			renderer_->camera_layout_resource_,
 			renderer_->render_object_layout_resource_,
 		};
 
-		mask_pipeline_.Initialize(
-			context,
-			mask_set_layouts,
-			{},
-			MASK_COLOR_FORMAT,
-			VK_FORMAT_UNDEFINED,
-			VertexAttributes::POSITION,
-			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-			SPIRV_PREFIX / "render_object_transform.vert.spv",
-			SPIRV_PREFIX / "mask.frag.spv");
-		NameObject(context_->device, mask_pipeline_.pipeline, "Mask_Pipeline");
-		NameObject(context_->device, mask_pipeline_.layout, "Mask_Pipeline_Layout");
+		VkPushConstantRange render_object_constant_range{
+			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+			.offset = 0,
+			.size = sizeof(RenderObjectPushConstant),
+		};
+
+		std::vector<VkPushConstantRange> render_object_constant_ranges{ render_object_constant_range };
 
 		std::vector<DescriptorSetLayoutResource> outline_set_layouts{ outline_layout_resource_ };
 
@@ -429,74 +424,96 @@ namespace renderer
 
 		std::vector<VkPushConstantRange> outline_push_constant_ranges{ color_push_constant_range };
 
-		outline_pipeline_.Initialize(
-			context,
-			outline_set_layouts,
-			outline_push_constant_ranges,
-			FINAL_IMAGE_FORMAT,
-			VK_FORMAT_UNDEFINED,
-			VertexAttributes::NONE,
-			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-			SPIRV_PREFIX / "fullscreen_triangle.vert.spv",
-			SPIRV_PREFIX / "outline.frag.spv");
-		NameObject(context_->device, outline_pipeline_.pipeline, "Outline_Pipeline");
-		NameObject(context_->device, outline_pipeline_.layout, "Outline_Pipeline_Layout");
-
 		std::vector<DescriptorSetLayoutResource> grid_set_layouts{
 			renderer_->camera_layout_resource_,
 			renderer_->render_object_layout_resource_,
 		};
 
-		grid_pipeline_.Initialize(
-			context,
-			grid_set_layouts,
-			{},
-			FINAL_IMAGE_FORMAT,
-			renderer_->GetDepthImageFormat(),
-			VertexAttributes::POSITION,
-			VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
-			SPIRV_PREFIX / "render_object_transform.vert.spv",
-			SPIRV_PREFIX / "grid.frag.spv");
-		NameObject(context_->device, grid_pipeline_.pipeline, "Grid_Pipeline");
-		NameObject(context_->device, grid_pipeline_.layout, "Grid_Pipeline_Layout");
-
+		// Color mode constants follow the render object index, which is only used by the vertex stage.
 		VkPushConstantRange particle_constant_range{
 			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-			.offset = 0,
+			.offset = sizeof(RenderObjectPushConstant),
 			.size = sizeof(ColorModePushConstant),
 		};
 
-		std::vector<VkPushConstantRange> particle_raster_constant_ranges{ particle_constant_range };
-
-		particle_raster_pipeline_.Initialize(
-			context,
-			grid_set_layouts,
-			particle_raster_constant_ranges,
-			FINAL_IMAGE_FORMAT,
-			renderer_->GetDepthImageFormat(),
-			VertexAttributes::XPBD_PARTICLE,
-			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-			SPIRV_PREFIX / "particles.vert.spv",
-			SPIRV_PREFIX / "particles.frag.spv");
-		NameObject(context_->device, particle_raster_pipeline_.pipeline, "Particle_Raster_Pipeline");
-		NameObject(context_->device, particle_raster_pipeline_.layout, "Particle_Raster_Pipeline_Layout");
+		std::vector<VkPushConstantRange> particle_raster_constant_ranges{ render_object_constant_range, particle_constant_range };
 
 		std::vector<DescriptorSetLayoutResource> rigid_body_set_layouts{
 			renderer_->camera_layout_resource_,
 		};
 
-		rigid_body_line_pipeline_.Initialize(
-			context,
-			rigid_body_set_layouts,
-			{},
-			FINAL_IMAGE_FORMAT,
-			renderer_->GetDepthImageFormat(),
-			VertexAttributes::RIGID_BODY_VOXEL,
-			VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
-			SPIRV_PREFIX / "rigid_body.vert.spv",
-			SPIRV_PREFIX / "rigid_body.frag.spv");
-		NameObject(context_->device, rigid_body_line_pipeline_.pipeline, "Rigid_Body_Pipeline");
-		NameObject(context_->device, rigid_body_line_pipeline_.layout, "Rigid_Body_Pipeline_Layout");
+		CreatePipelinesInParallel({
+			[&]() {
+				mask_pipeline_.Initialize(
+					context,
+					mask_set_layouts,
+					render_object_constant_ranges,
+					MASK_COLOR_FORMAT,
+					VK_FORMAT_UNDEFINED,
+					VertexAttributes::POSITION,
+					VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+					SPIRV_PREFIX / "render_object_transform.vert.spv",
+					SPIRV_PREFIX / "mask.frag.spv");
+				NameObject(context_->device, mask_pipeline_.pipeline, "Mask_Pipeline");
+				NameObject(context_->device, mask_pipeline_.layout, "Mask_Pipeline_Layout");
+			},
+			[&]() {
+				outline_pipeline_.Initialize(
+					context,
+					outline_set_layouts,
+					outline_push_constant_ranges,
+					FINAL_IMAGE_FORMAT,
+					VK_FORMAT_UNDEFINED,
+					VertexAttributes::NONE,
+					VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+					SPIRV_PREFIX / "fullscreen_triangle.vert.spv",
+					SPIRV_PREFIX / "outline.frag.spv");
+				NameObject(context_->device, outline_pipeline_.pipeline, "Outline_Pipeline");
+				NameObject(context_->device, outline_pipeline_.layout, "Outline_Pipeline_Layout");
+			},
+			[&]() {
+				grid_pipeline_.Initialize(
+					context,
+					grid_set_layouts,
+					render_object_constant_ranges,
+					FINAL_IMAGE_FORMAT,
+					renderer_->GetDepthImageFormat(),
+					VertexAttributes::POSITION,
+					VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+					SPIRV_PREFIX / "render_object_transform.vert.spv",
+					SPIRV_PREFIX / "grid.frag.spv");
+				NameObject(context_->device, grid_pipeline_.pipeline, "Grid_Pipeline");
+				NameObject(context_->device, grid_pipeline_.layout, "Grid_Pipeline_Layout");
+			},
+			[&]() {
+				particle_raster_pipeline_.Initialize(
+					context,
+					grid_set_layouts,
+					particle_raster_constant_ranges,
+					FINAL_IMAGE_FORMAT,
+					renderer_->GetDepthImageFormat(),
+					VertexAttributes::XPBD_PARTICLE,
+					VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+					SPIRV_PREFIX / "particles.vert.spv",
+					SPIRV_PREFIX / "particles.frag.spv");
+				NameObject(context_->device, particle_raster_pipeline_.pipeline, "Particle_Raster_Pipeline");
+				NameObject(context_->device, particle_raster_pipeline_.layout, "Particle_Raster_Pipeline_Layout");
+			},
+			[&]() {
+				rigid_body_line_pipeline_.Initialize(
+					context,
+					rigid_body_set_layouts,
+					{},
+					FINAL_IMAGE_FORMAT,
+					renderer_->GetDepthImageFormat(),
+					VertexAttributes::RIGID_BODY_VOXEL,
+					VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+					SPIRV_PREFIX / "rigid_body.vert.spv",
+					SPIRV_PREFIX / "rigid_body.frag.spv");
+				NameObject(context_->device, rigid_body_line_pipeline_.pipeline, "Rigid_Body_Pipeline");
+				NameObject(context_->device, rigid_body_line_pipeline_.layout, "Rigid_Body_Pipeline_Layout");
+			},
+		});
 
 		physics_debug_.render_object_index = NULL_INDEX;
 
@@ -863,6 +880,16 @@ namespace renderer
 			0,
 			nullptr);
 
+		vkCmdBindDescriptorSets(
+			cmd,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			mask_pipeline_.layout,
+			EDITOR_RENDER_OBJECT_DATA_SET,
+			1,
+			&renderer_->GetCurrentFrame().object_data_descriptor_set_resource.descriptor_set,
+			0,
+			nullptr);
+
 		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mask_pipeline_.pipeline);
 
 		VkDeviceSize zero_offset{ 0 };
@@ -873,19 +900,14 @@ namespace renderer
 				continue;
 			}
 			RenderObject* render_object{ renderer_->GetCurrentFrame().render_objects[render_object_index] };
-			if (!render_object) {
+
+			// Procedural meshes have no triangles to outline.
+			if (!render_object || renderer_->meshes_[render_object->mesh_idx]->procedural) {
 				continue;
 			}
 
-			vkCmdBindDescriptorSets(
-				cmd,
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				mask_pipeline_.layout,
-				EDITOR_RENDER_OBJECT_UBO_SET,
-				1,
-				&render_object->ubo_descriptor_set_resource.descriptor_set,
-				0,
-				nullptr);
+			RenderObjectPushConstant push_constant{ .object_index = render_object_index };
+			vkCmdPushConstants(cmd, mask_pipeline_.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(RenderObjectPushConstant), &push_constant);
 
 			for (auto& geometry : renderer_->meshes_[render_object->mesh_idx]->geometries)
 			{
@@ -1031,19 +1053,20 @@ namespace renderer
 			cmd,
 			particle_raster_pipeline_.layout,
 			VK_SHADER_STAGE_FRAGMENT_BIT,
-			0,
+			sizeof(RenderObjectPushConstant),
 			sizeof(ColorModePushConstant),
 			&physics_debug_.particle_push_constant);
 
-		RenderObject* render_object{ renderer_->GetCurrentFrame().render_objects[physics_debug_.render_object_index] };
+		RenderObjectPushConstant render_object_push_constant{ .object_index = physics_debug_.render_object_index };
+		vkCmdPushConstants(cmd, particle_raster_pipeline_.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(RenderObjectPushConstant), &render_object_push_constant);
 
 		vkCmdBindDescriptorSets(
 			cmd,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			particle_raster_pipeline_.layout,
-			EDITOR_RENDER_OBJECT_UBO_SET,
+			EDITOR_RENDER_OBJECT_DATA_SET,
 			1,
-			&render_object->ubo_descriptor_set_resource.descriptor_set,
+			&renderer_->GetCurrentFrame().object_data_descriptor_set_resource.descriptor_set,
 			0,
 			nullptr);
 
@@ -1116,15 +1139,16 @@ namespace renderer
 		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, grid_pipeline_.pipeline);
 
 		VkDeviceSize zero_offset{ 0 };
-		RenderObject* render_object{ renderer_->GetCurrentFrame().render_objects[physics_debug_.render_object_index] };
+		RenderObjectPushConstant push_constant{ .object_index = physics_debug_.render_object_index };
+		vkCmdPushConstants(cmd, grid_pipeline_.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(RenderObjectPushConstant), &push_constant);
 
 		vkCmdBindDescriptorSets(
 			cmd,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			grid_pipeline_.layout,
-			EDITOR_RENDER_OBJECT_UBO_SET,
+			EDITOR_RENDER_OBJECT_DATA_SET,
 			1,
-			&render_object->ubo_descriptor_set_resource.descriptor_set,
+			&renderer_->GetCurrentFrame().object_data_descriptor_set_resource.descriptor_set,
 			0,
 			nullptr);
 
@@ -0,0 +1,361 @@
+#include "fluid_surface.h"
+
+#include <execution>
+#include <algorithm>
+#include <ranges>
+#include <unordered_map>
+#include <array>
+#include <numbers>
+#include "tracy/Tracy.hpp"
+
+namespace renderer
+{
+	constexpr int32_t FLUID_BRICK_WIDTH{ 8 }; // Samples per dimension of a brick.
+	constexpr int32_t FLUID_BRICK_SAMPLE_COUNT{ FLUID_BRICK_WIDTH * FLUID_BRICK_WIDTH * FLUID_BRICK_WIDTH };
+	constexpr int32_t FLUID_PADDED_WIDTH{ FLUID_BRICK_WIDTH + 3 }; // One sample before and two after, for the cells and gradients at the brick edges.
+	constexpr uint32_t FLUID_NO_VERTEX{ ~0u };
+
+	// Density samples of a block of the sparse grid. Cells are owned by the brick of their minimum corner sample.
+	struct FluidBrick
+	{
+		glm::ivec3 coord;
+		std::vector<uint32_t> particles;     // Particles whose kernel reaches a sample of this brick.
+		std::vector<float> densities;
+		std::vector<uint32_t> cell_vertices; // Index into vertices of the surface vertex of each cell, or FLUID_NO_VERTEX.
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		uint32_t first_vertex;               // Offset of vertices in the output geometry.
+		uint32_t first_index;                // Offset of indices in the output geometry.
+	};
+
+	static uint64_t BrickKey(const glm::ivec3& coord)
+	{
+		constexpr int32_t bias{ 1 << 20 };
+		return (uint64_t)(coord.x + bias) | ((uint64_t)(coord.y + bias) << 21) | ((uint64_t)(coord.z + bias) << 42);
+	}
+
+	// Brick containing the sample at the given grid coordinate.
+	static glm::ivec3 SampleToBrick(const glm::ivec3& sample)
+	{
+		return glm::ivec3{ glm::floor(glm::vec3{ sample } / (float)FLUID_BRICK_WIDTH) };
+	}
+
+	static int32_t SampleIndex(const glm::ivec3& local)
+	{
+		return local.x + local.y * FLUID_BRICK_WIDTH + local.z * FLUID_BRICK_WIDTH * FLUID_BRICK_WIDTH;
+	}
+
+	static int32_t PaddedIndex(const glm::ivec3& local)
+	{
+		return (local.x + 1) + (local.y + 1) * FLUID_PADDED_WIDTH + (local.z + 1) * FLUID_PADDED_WIDTH * FLUID_PADDED_WIDTH;
+	}
+
+	void ExtractFluidSurface(
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t stride,
+		uint32_t first,
+		uint32_t count,
+		const FluidSurfaceSettings& settings,
+		Geometry* out_geometry)
+	{
+		ZoneScoped;
+
+		out_geometry->vertices.clear();
+		out_geometry->indices.clear();
+		if (count == 0) {
+			return;
+		}
+
+		const float inv_spacing{ 1.0f / settings.sample_spacing };
+		const float radius_squared{ settings.kernel_radius * settings.kernel_radius };
+
+		// Density deep inside particles packed PARTICLE_WIDTH apart, the integral of the (1 - r^2/R^2)^3 kernel over the ball.
+		// Densities are divided by it so the iso value doesn't depend on the kernel radius.
+		const float relative_radius{ settings.kernel_radius / PARTICLE_WIDTH };
+		const float full_density{ 4.0f * std::numbers::pi_v<float> * 16.0f / 315.0f * relative_radius * relative_radius * relative_radius };
+
+		auto position_of = [&](uint32_t p) {
+			return *reinterpret_cast<const glm::vec3*>(positions + p * stride + offset);
+			};
+		auto footprint_min = [&](const glm::vec3& position) {
+			return glm::ivec3{ glm::ceil((position - settings.kernel_radius) * inv_spacing) };
+			};
+		auto footprint_max = [&](const glm::vec3& position) {
+			return glm::ivec3{ glm::floor((position + settings.kernel_radius) * inv_spacing) };
+			};
+
+		std::vector<FluidBrick> bricks{};
+		std::unordered_map<uint64_t, uint32_t> brick_indices{};
+		auto find_brick = [&](const glm::ivec3& coord) -> const FluidBrick* {
+			auto it{ brick_indices.find(BrickKey(coord)) };
+			return it == brick_indices.end() ? nullptr : &bricks[it->second];
+			};
+
+		{
+			ZoneScopedN("Bin particles");
+			for (uint32_t p{ first }; p < first + count; ++p)
+			{
+				const glm::vec3 position{ position_of(p) };
+				const glm::ivec3 sample_min{ footprint_min(position) };
+				const glm::ivec3 brick_max{ SampleToBrick(footprint_max(position)) };
+				const glm::ivec3 splat_min{ SampleToBrick(sample_min) };
+
+				// Cells just below the footprint can cross the surface too, so their bricks must exist even though they get no density.
+				const glm::ivec3 brick_min{ SampleToBrick(sample_min - 1) };
+				for (int32_t z{ brick_min.z }; z <= brick_max.z; ++z)
+				{
+					for (int32_t y{ brick_min.y }; y <= brick_max.y; ++y)
+					{
+						for (int32_t x{ brick_min.x }; x <= brick_max.x; ++x)
+						{
+							const glm::ivec3 coord{ x, y, z };
+							auto [it, inserted] { brick_indices.try_emplace(BrickKey(coord), (uint32_t)bricks.size()) };
+							if (inserted) {
+								bricks.push_back(FluidBrick{ .coord = coord });
+							}
+							if (glm::all(glm::greaterThanEqual(coord, splat_min))) {
+								bricks[it->second].particles.push_back(p);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		auto brick_range{ std::views::iota(0u, (uint32_t)bricks.size()) };
+		{
+			ZoneScopedN("Splat particles");
+			// Each brick gathers its own particles, so bricks are splatted in parallel without atomics.
+			std::for_each(std::execution::par, brick_range.begin(), brick_range.end(),
+				[&](uint32_t b) {
+					FluidBrick& brick{ bricks[b] };
+					const glm::ivec3 brick_origin{ brick.coord * FLUID_BRICK_WIDTH };
+					brick.densities.assign(FLUID_BRICK_SAMPLE_COUNT, 0.0f);
+
+					for (uint32_t p : brick.particles)
+					{
+						const glm::vec3 position{ position_of(p) };
+						const glm::ivec3 sample_min{ glm::max(footprint_min(position) - brick_origin, glm::ivec3{ 0 }) };
+						const glm::ivec3 sample_max{ glm::min(footprint_max(position) - brick_origin, glm::ivec3{ FLUID_BRICK_WIDTH - 1 }) };
+						for (int32_t z{ sample_min.z }; z <= sample_max.z; ++z)
+						{
+							for (int32_t y{ sample_min.y }; y <= sample_max.y; ++y)
+							{
+								for (int32_t x{ sample_min.x }; x <= sample_max.x; ++x)
+								{
+									const glm::vec3 d{ glm::vec3{ brick_origin + glm::ivec3{ x, y, z } } * settings.sample_spacing - position };
+									const float q{ glm::dot(d, d) / radius_squared };
+									if (q < 1.0f)
+									{
+										const float w{ 1.0f - q };
+										brick.densities[SampleIndex(glm::ivec3{ x, y, z })] += w * w * w / full_density;
+									}
+								}
+							}
+						}
+					}
+				});
+		}
+
+		// Samples of a brick with a margin from its neighbors. Missing neighbors are empty.
+		auto gather_padded = [&](const FluidBrick& brick, std::vector<float>* out_padded) {
+			out_padded->assign(FLUID_PADDED_WIDTH * FLUID_PADDED_WIDTH * FLUID_PADDED_WIDTH, 0.0f);
+			for (int32_t i{ 0 }; i < 27; ++i)
+			{
+				const glm::ivec3 n{ i % 3 - 1, (i / 3) % 3 - 1, i / 9 - 1 };
+				const FluidBrick* neighbor{ find_brick(brick.coord + n) };
+				if (!neighbor) {
+					continue;
+				}
+
+				const glm::ivec3 local_min{ glm::max(n * FLUID_BRICK_WIDTH, glm::ivec3{ -1 }) };
+				const glm::ivec3 local_max{ glm::min(n * FLUID_BRICK_WIDTH + FLUID_BRICK_WIDTH - 1, glm::ivec3{ FLUID_BRICK_WIDTH + 1 }) };
+				for (int32_t z{ local_min.z }; z <= local_max.z; ++z)
+				{
+					for (int32_t y{ local_min.y }; y <= local_max.y; ++y)
+					{
+						for (int32_t x{ local_min.x }; x <= local_max.x; ++x)
+						{
+							const glm::ivec3 local{ x, y, z };
+							(*out_padded)[PaddedIndex(local)] = neighbor->densities[SampleIndex(local - n * FLUID_BRICK_WIDTH)];
+						}
+					}
+				}
+			}
+			};
+
+		{
+			ZoneScopedN("Place vertices");
+			std::for_each(std::execution::par, brick_range.begin(), brick_range.end(),
+				[&](uint32_t b) {
+					FluidBrick& brick{ bricks[b] };
+					const glm::ivec3 brick_origin{ brick.coord * FLUID_BRICK_WIDTH };
+					brick.cell_vertices.assign(FLUID_BRICK_SAMPLE_COUNT, FLUID_NO_VERTEX);
+
+					std::vector<float> padded{};
+					gather_padded(brick, &padded);
+					auto density = [&](const glm::ivec3& local) {
+						return padded[PaddedIndex(local)];
+						};
+
+					for (int32_t cell_idx{ 0 }; cell_idx < FLUID_BRICK_SAMPLE_COUNT; ++cell_idx)
+					{
+						const glm::ivec3 cell{ cell_idx % FLUID_BRICK_WIDTH, (cell_idx / FLUID_BRICK_WIDTH) % FLUID_BRICK_WIDTH, cell_idx / (FLUID_BRICK_WIDTH * FLUID_BRICK_WIDTH) };
+
+						// Corner i is offset by bit 0 in x, bit 1 in y and bit 2 in z.
+						std::array<float, 8> corner_densities{};
+						uint32_t inside_mask{ 0 };
+						for (uint32_t i{ 0 }; i < 8; ++i)
+						{
+							corner_densities[i] = density(cell + glm::ivec3{ i & 1, (i >> 1) & 1, (i >> 2) & 1 });
+							inside_mask |= corner_densities[i] > settings.iso_value ? 1u << i : 0u;
+						}
+						if (inside_mask == 0 || inside_mask == 0xFF) {
+							continue;
+						}
+
+						// Place the vertex at the mean of the crossings on the cell's 12 edges.
+						glm::vec3 crossing_sum{ 0.0f };
+						float crossing_count{ 0.0f };
+						glm::vec3 gradient{ 0.0f };
+						for (uint32_t i{ 0 }; i < 8; ++i)
+						{
+							const glm::vec3 corner{ (float)(i & 1), (float)((i >> 1) & 1), (float)((i >> 2) & 1) };
+							for (uint32_t axis{ 0 }; axis < 3; ++axis)
+							{
+								const uint32_t j{ i | (1u << axis) };
+								if (j == i || ((inside_mask >> i) & 1) == ((inside_mask >> j) & 1)) {
+									continue;
+								}
+								const float t{ (settings.iso_value - corner_densities[i]) / (corner_densities[j] - corner_densities[i]) };
+								glm::vec3 crossing{ corner };
+								crossing[axis] = t;
+								crossing_sum += crossing;
+								crossing_count += 1.0f;
+							}
+						}
+						const glm::vec3 vertex_local{ crossing_sum / crossing_count };
+
+						// Trilinearly interpolate the central difference gradients of the corners.
+						for (uint32_t i{ 0 }; i < 8; ++i)
+						{
+							const glm::ivec3 corner{ i & 1, (i >> 1) & 1, (i >> 2) & 1 };
+							const glm::vec3 weights{ glm::mix(1.0f - vertex_local, vertex_local, glm::vec3{ corner }) };
+							const glm::ivec3 s{ cell + corner };
+							const glm::vec3 corner_gradient{
+								density(s + glm::ivec3{ 1, 0, 0 }) - density(s - glm::ivec3{ 1, 0, 0 }),
+								density(s + glm::ivec3{ 0, 1, 0 }) - density(s - glm::ivec3{ 0, 1, 0 }),
+								density(s + glm::ivec3{ 0, 0, 1 }) - density(s - glm::ivec3{ 0, 0, 1 }),
+							};
+							gradient += weights.x * weights.y * weights.z * corner_gradient;
+						}
+
+						// Density falls off outwards, so the normal is against the gradient.
+						const float gradient_length{ glm::length(gradient) };
+						const glm::vec3 normal{ gradient_length > 0.0f ? -gradient / gradient_length : glm::vec3{ 0.0f, 1.0f, 0.0f } };
+						const glm::vec3 tangent_reference{ std::abs(normal.y) < 0.9f ? glm::vec3{ 0.0f, 1.0f, 0.0f } : glm::vec3{ 1.0f, 0.0f, 0.0f } };
+
+						Vertex vertex{};
+						vertex.position = glm::vec4{ (glm::vec3{ brick_origin + cell } + vertex_local) * settings.sample_spacing, 0.0f };
+						vertex.normal = glm::vec4{ normal, 0.0f };
+						vertex.tangent = glm::vec4{ glm::normalize(glm::cross(tangent_reference, normal)), 0.0f };
+						brick.cell_vertices[cell_idx] = (uint32_t)brick.vertices.size();
+						brick.vertices.push_back(vertex);
+					}
+				});
+		}
+
+		uint32_t vertex_count{ 0 };
+		for (FluidBrick& brick : bricks)
+		{
+			brick.first_vertex = vertex_count;
+			vertex_count += (uint32_t)brick.vertices.size();
+		}
+
+		{
+			ZoneScopedN("Connect vertices");
+			std::for_each(std::execution::par, brick_range.begin(), brick_range.end(),
+				[&](uint32_t b) {
+					FluidBrick& brick{ bricks[b] };
+
+					std::vector<float> padded{};
+					gather_padded(brick, &padded);
+
+					// Cells around an edge can be in the bricks below this one, indexed by which coordinates are negative.
+					std::array<const FluidBrick*, 8> lower_bricks{};
+					for (uint32_t i{ 0 }; i < 8; ++i) {
+						lower_bricks[i] = find_brick(brick.coord - glm::ivec3{ i & 1, (i >> 1) & 1, (i >> 2) & 1 });
+					}
+					auto cell_vertex = [&](const glm::ivec3& cell) {
+						const glm::ivec3 below{ glm::lessThan(cell, glm::ivec3{ 0 }) };
+						const FluidBrick* owner{ lower_bricks[below.x | (below.y << 1) | (below.z << 2)] };
+						if (!owner) {
+							return FLUID_NO_VERTEX;
+						}
+						const uint32_t v{ owner->cell_vertices[SampleIndex(cell + below * FLUID_BRICK_WIDTH)] };
+						return v == FLUID_NO_VERTEX ? v : owner->first_vertex + v;
+						};
+
+					// Each edge from a sample of this brick in the positive direction of an axis that crosses the surface
+					// is shared by 4 cells, whose vertices make a quad.
+					for (int32_t sample_idx{ 0 }; sample_idx < FLUID_BRICK_SAMPLE_COUNT; ++sample_idx)
+					{
+						const glm::ivec3 s{ sample_idx % FLUID_BRICK_WIDTH, (sample_idx / FLUID_BRICK_WIDTH) % FLUID_BRICK_WIDTH, sample_idx / (FLUID_BRICK_WIDTH * FLUID_BRICK_WIDTH) };
+						const bool inside{ padded[PaddedIndex(s)] > settings.iso_value };
+
+						for (int32_t axis{ 0 }; axis < 3; ++axis)
+						{
+							glm::ivec3 e_axis{ 0 };
+							e_axis[axis] = 1;
+							if (inside == (padded[PaddedIndex(s + e_axis)] > settings.iso_value)) {
+								continue;
+							}
+
+							glm::ivec3 e_u{ 0 };
+							glm::ivec3 e_v{ 0 };
+							e_u[(axis + 1) % 3] = 1;
+							e_v[(axis + 2) % 3] = 1;
+
+							// Counter clockwise around the positive axis, which is outwards when the fluid is at s.
+							const std::array<uint32_t, 4> quad{
+								cell_vertex(s - e_u - e_v),
+								cell_vertex(s - e_v),
+								cell_vertex(s),
+								cell_vertex(s - e_u),
+							};
+							if (std::find(quad.begin(), quad.end(), FLUID_NO_VERTEX) != quad.end()) {
+								continue;
+							}
+
+							if (inside) {
+								brick.indices.insert(brick.indices.end(), { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] });
+							}
+							else {
+								brick.indices.insert(brick.indices.end(), { quad[0], quad[2], quad[1], quad[0], quad[3], quad[2] });
+							}
+						}
+					}
+				});
+		}
+
+		uint32_t index_count{ 0 };
+		for (FluidBrick& brick : bricks)
+		{
+			brick.first_index = index_count;
+			index_count += (uint32_t)brick.indices.size();
+		}
+
+		{
+			ZoneScopedN("Gather geometry");
+			out_geometry->vertices.resize(vertex_count);
+			out_geometry->indices.resize(index_count);
+			std::for_each(std::execution::par, brick_range.begin(), brick_range.end(),
+				[&](uint32_t b) {
+					const FluidBrick& brick{ bricks[b] };
+					std::copy(brick.vertices.begin(), brick.vertices.end(), out_geometry->vertices.begin() + brick.first_vertex);
+					std::copy(brick.indices.begin(), brick.indices.end(), out_geometry->indices.begin() + brick.first_index);
+				});
+		}
+	}
+}
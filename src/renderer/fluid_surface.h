@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "common_constants.h"
+
+#include "mesh.h"
+
+namespace renderer
+{
+	struct FluidSurfaceSettings
+	{
+		float sample_spacing{ 2.0f * PARTICLE_WIDTH }; // Distance between density samples. Larger is fewer triangles but less detail.
+		float kernel_radius{ 2.0f * PARTICLE_WIDTH };  // Particles add density to samples within this distance.
+		float iso_value{ 0.5f };                       // Density of the surface, where the inside of a tightly packed fluid is 1.
+	};
+
+	// Reconstruct a smooth surface around particles instead of meshing each one as a cube.
+	// Particles are splatted onto a sparse grid of density samples, then a surface is extracted with surface nets,
+	// the dual contouring variant that places each vertex at the mean of its cell's edge crossings.
+	// Vertices are shared between the triangles of adjacent cells, and normals come from the density gradient.
+	// Positions should be an array of glm::vec3 with arbitrary stride between each. Stride is in bytes.
+	// Replaces the vertices and indices of out_geometry.
+	void ExtractFluidSurface(
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t stride,
+		uint32_t first,
+		uint32_t count,
+		const FluidSurfaceSettings& settings,
+		Geometry* out_geometry);
+}
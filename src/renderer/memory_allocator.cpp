@@ -178,6 +178,78 @@ namespace renderer
 		};
 	}
 
+	BufferResource Allocator::CreateMappedBufferResource(
+		VkDeviceSize size,
+		VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags properties,
+		void** out_mapped)
+	{
+		VkBufferCreateInfo buffer_info{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.flags = 0,
+			.size = size,
+			.usage = usage,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.queueFamilyIndexCount = 0,
+			.pQueueFamilyIndices = nullptr, // Ignored for sharing mode exclusive.
+		};
+
+		VkBuffer buffer{};
+		VkResult result{ vkCreateBuffer(context_->device, &buffer_info, nullptr, &buffer) };
+		CheckResult(result, "Failed to create buffer.");
+
+		VkMemoryRequirements memory_requirements{};
+		vkGetBufferMemoryRequirements(context_->device, buffer, &memory_requirements);
+
+		// Memory can only be mapped once, so the buffer can't share its allocation with buffers that other code maps.
+		VkDeviceMemory* memory{};
+		VkDeviceSize offset{ FindMemory((uint64_t)buffer, 1, memory_requirements, properties | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &memory, true) };
+
+		result = vkBindBufferMemory(context_->device, buffer, *memory, offset);
+		CheckResult(result, "Failed to bind buffer to memory.");
+
+		Allocation* allocation{ allocation_info_map_.at((uint64_t)buffer).allocation };
+		result = vkMapMemory(context_->device, allocation->memory, 0, VK_WHOLE_SIZE, 0, &allocation->mapped);
+		CheckResult(result, "Failed to map buffer memory.");
+		*out_mapped = allocation->mapped;
+
+		return BufferResource{
+			.buffer = buffer,
+			.memory = memory,
+			.size = size,
+			.offset = offset,
+		};
+	}
+
+	void Allocator::FlushBufferResource(const BufferResource& buffer_resource, VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto iter{ allocation_info_map_.find((uint64_t)buffer_resource.buffer) };
+		if (iter == allocation_info_map_.end() || !iter->second.allocation->mapped) {
+			logger::Error("Attempted to flush a buffer that isn't persistently mapped.\n");
+			return;
+		}
+
+		if (iter->second.allocation->host_coherent || size == 0) {
+			return;
+		}
+
+		// Flushed ranges must be aligned to the atom size, unless they reach the end of the allocation.
+		VkDeviceSize atom_size{ limits_.nonCoherentAtomSize };
+		VkDeviceSize start{ buffer_resource.offset + offset };
+		VkDeviceSize aligned_start{ start - start % atom_size };
+		VkDeviceSize aligned_end{ AlignUp(start + size, atom_size) };
+
+		VkMappedMemoryRange range{
+			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+			.memory = iter->second.allocation->memory,
+			.offset = aligned_start,
+			.size = aligned_end >= iter->second.allocation->blocks.GetSize() ? VK_WHOLE_SIZE : aligned_end - aligned_start,
+		};
+
+		VkResult result{ vkFlushMappedMemoryRanges(context_->device, 1, &range) };
+		CheckResult(result, "Failed to flush mapped buffer memory.");
+	}
+
 	ImageResource Allocator::CreateImageResource(
 		Extent extent,
 		VkImageUsageFlags usage,
@@ -301,36 +373,60 @@ namespace renderer
 		return false;
 	}
 
-	void Allocator::UpdateAllocationOffsets(uint64_t vulkan_handle)
+	void Allocator::FreeResourceMemory(uint64_t vulkan_handle)
 	{
 		auto iter{ allocation_info_map_.find(vulkan_handle) };
-
-		if (iter != allocation_info_map_.end())
+		if (iter == allocation_info_map_.end())
 		{
-			BufferAllocationInfo alloc_info{ iter->second };
-			alloc_info.allocation->buffer_offsets.erase(alloc_info.next_available_offset);
+			logger::Error("Failed to find resource of buffer attempting to be freed.");
+			return;
+		}
 
-			// If we destroy the highest address buffer, we must recalculate Allocation::available_offset.
-			if (alloc_info.next_available_offset == alloc_info.allocation->available_offset)
-			{
-				// The greatest offset such that all higher offsets in this allocation are free.
-				VkDeviceSize max_remaining_offset{ *alloc_info.allocation->buffer_offsets.rbegin() };
-				alloc_info.allocation->available_memory += alloc_info.allocation->available_offset - max_remaining_offset;
-				alloc_info.allocation->available_offset = max_remaining_offset;
+		Allocation* allocation{ iter->second.allocation };
+		allocation->blocks.Free(iter->second.block);
+		allocation_info_map_.erase(iter);
+
+		// Give empty allocations back to the driver, so memory doesn't climb after spikes in usage.
+		// One is kept per memory type for the next resource. Mapped allocations are dedicated, so they can't be that one.
+		if (allocation->blocks.IsEmpty())
+		{
+			const std::vector<Allocation*>& allocations{ allocation->owner->allocations };
+			if (std::count_if(allocations.begin(), allocations.end(), [](const Allocation* alloc) { return !alloc->mapped; }) > 1) {
+				FreeAllocation(allocation);
 			}
 		}
-		else {
-			logger::Error("Failed to find resource of buffer attempting to be freed.");
-		}
 	}
 
 	void Allocator::DestroyBufferResource(BufferResource* buffer_resource)
 	{
 		vkDestroyBuffer(context_->device, buffer_resource->buffer, nullptr);
 
-		if (buffer_resource->buffer) {
-			UpdateAllocationOffsets((uint64_t)buffer_resource->buffer);
+		if (!buffer_resource->buffer) {
+			return;
 		}
+
+		auto iter{ allocation_info_map_.find((uint64_t)buffer_resource->buffer) };
+		if (iter != allocation_info_map_.end() && iter->second.allocation->mapped)
+		{
+			FreeAllocation(iter->second.allocation);
+			allocation_info_map_.erase(iter);
+			return;
+		}
+
+		FreeResourceMemory((uint64_t)buffer_resource->buffer);
+	}
+
+	void Allocator::FreeAllocation(Allocation* allocation)
+	{
+		if (allocation->mapped) {
+			vkUnmapMemory(context_->device, allocation->memory);
+		}
+		vkFreeMemory(context_->device, allocation->memory, nullptr);
+		remaining_heap_memory_[allocation->owner->memory_type.heapIndex] += allocation->blocks.GetSize();
+
+		std::vector<Allocation*>& allocations{ allocation->owner->allocations };
+		allocations.erase(std::find(allocations.begin(), allocations.end(), allocation));
+		delete allocation;
 	}
 
 	void Allocator::DestroyImageResource(ImageResource* image_resource)
@@ -340,33 +436,64 @@ namespace renderer
 		vkDestroyImage(context_->device, image_resource->image, nullptr);
 
 		if (image_resource->image) {
-			UpdateAllocationOffsets((uint64_t)image_resource->image);
+			FreeResourceMemory((uint64_t)image_resource->image);
 		}
 	}
 
-	VkDeviceSize Allocator::ExistingAllocation(uint64_t vulkan_handle, VkDeviceSize alignment_offset, VkDeviceSize required_size, Allocation* alloc, VkDeviceMemory** out_memory)
+	std::vector<MemoryHeapStats> Allocator::GetHeapStats() const
 	{
-		*out_memory = &alloc->memory;
+		std::vector<MemoryHeapStats> heap_stats(remaining_heap_memory_.size());
+		std::vector<VkDeviceSize> free_bytes(remaining_heap_memory_.size());
+
+		for (const std::vector<MemoryTypeAllocations>* category : { &device_host_allocations_, &device_allocations_, &host_allocations_ })
+		{
+			for (const MemoryTypeAllocations& mem_type_allocations : *category)
+			{
+				uint32_t heap{ mem_type_allocations.memory_type.heapIndex };
+				for (const Allocation* alloc : mem_type_allocations.allocations)
+				{
+					TlsfStats block_stats{ alloc->blocks.GetStats() };
+					heap_stats[heap].allocated_bytes += alloc->blocks.GetSize();
+					heap_stats[heap].used_bytes += block_stats.used_bytes;
+					heap_stats[heap].largest_free_block = std::max(heap_stats[heap].largest_free_block, block_stats.largest_free_block);
+					heap_stats[heap].allocation_count += 1;
+					heap_stats[heap].resource_count += block_stats.allocation_count;
+					free_bytes[heap] += block_stats.free_bytes;
+				}
+			}
+		}
 
-		VkDeviceSize buffer_start_offset{ alloc->available_offset + alignment_offset };
+		for (uint32_t heap{ 0 }; heap < (uint32_t)heap_stats.size(); ++heap)
+		{
+			if (free_bytes[heap] > 0) {
+				heap_stats[heap].fragmentation = 1.0f - (float)heap_stats[heap].largest_free_block / free_bytes[heap];
+			}
+		}
 
-		alloc->available_offset += alignment_offset + required_size;
-		alloc->available_memory -= alignment_offset + required_size;
-		alloc->buffer_offsets.insert(alloc->available_offset);
+		return heap_stats;
+	}
+
+	VkDeviceSize Allocator::ExistingAllocation(uint64_t vulkan_handle, VkDeviceSize alignment, VkDeviceSize required_size, Allocation* alloc, VkDeviceMemory** out_memory)
+	{
+		uint32_t block{ alloc->blocks.Allocate(required_size, alignment) };
+		if (block == NULL_INDEX) {
+			return (VkDeviceSize)~0ull;
+		}
 
 		BufferAllocationInfo alloc_info{
 			.allocation = alloc,
-			.next_available_offset = alloc->available_offset,
+			.block = block,
 		};
 		allocation_info_map_[vulkan_handle] = alloc_info;
 
-		return buffer_start_offset;
+		*out_memory = &alloc->memory;
+		return alloc->blocks.GetOffset(block);
 	}
 
-	VkDeviceSize Allocator::NewAllocation(uint64_t vulkan_handle, VkDeviceSize required_size, MemoryTypeAllocations* mem_type_alloc, VkDeviceMemory** out_memory)
+	VkDeviceSize Allocator::NewAllocation(uint64_t vulkan_handle, VkDeviceSize alignment, VkDeviceSize required_size, MemoryTypeAllocations* mem_type_alloc, VkDeviceMemory** out_memory, bool dedicated)
 	{
 		VkDeviceSize alloc_size{ (VkDeviceSize)(ALLOCATION_RATIO * remaining_heap_memory_[mem_type_alloc->memory_type.heapIndex]) };
-		alloc_size = std::clamp(alloc_size, required_size, max_alloc_size_);
+		alloc_size = dedicated ? required_size : std::clamp(alloc_size, required_size, max_alloc_size_);
 
 		VkMemoryAllocateFlagsInfo flags_info{
 			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
@@ -386,24 +513,15 @@ namespace renderer
 		VkResult result{ vkAllocateMemory(context_->device, &allocate_info, nullptr, &allocation->memory) };
 		CheckResult(result, "Failed to allocate memory.");
 
-		// No need to worry about alignment since we are return buffer at offset 0.
-		allocation->available_memory = alloc_size - required_size;
-		allocation->available_offset = required_size;
-		allocation->buffer_offsets.insert(0); // Insert 0 too since this is initial allocation.
-		allocation->buffer_offsets.insert(allocation->available_offset);
+		allocation->blocks.Initialize(alloc_size);
+		allocation->owner = mem_type_alloc;
+		allocation->host_coherent = (bool)(mem_type_alloc->memory_type.propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		remaining_heap_memory_[mem_type_alloc->memory_type.heapIndex] -= std::min(alloc_size, remaining_heap_memory_[mem_type_alloc->memory_type.heapIndex]);
 
 		mem_type_alloc->allocations.push_back(allocation);
 
-		BufferAllocationInfo alloc_info{
-			.allocation = allocation,
-			.next_available_offset = allocation->available_offset,
-		};
-
-		// Need this association when we destroy the buffer.
-		allocation_info_map_[vulkan_handle] = alloc_info;
-
-		*out_memory = &allocation->memory;
-		return (VkDeviceSize)0; // Buffer will start at beginning of allocation.
+		// The resource starts at the beginning of the allocation, which meets any alignment.
+		return ExistingAllocation(vulkan_handle, alignment, required_size, allocation, out_memory);
 	}
 
 	VkDeviceSize Allocator::FindMemoryType(
@@ -412,7 +530,8 @@ namespace renderer
 		const VkMemoryRequirements& requirements,
 		VkMemoryPropertyFlags properties,
 		std::vector<MemoryTypeAllocations>& memory_type_allocations,
-		VkDeviceMemory** out_memory
+		VkDeviceMemory** out_memory,
+		bool dedicated
 	)
 	{
 		// Find the lowest alignment that both meets user alignment and Vulkan requirements.
@@ -430,18 +549,26 @@ namespace renderer
 
 			if (has_all_properties && meets_buffer_requirement && on_requested_device_or_host)
 			{
+				// A dedicated allocation never reuses existing memory, and leaves none over for other resources.
+				// Mapped allocations are dedicated, so they're skipped too.
 				for (Allocation* alloc : memory_type_alloc.allocations)
 				{
-					VkDeviceSize alignment_offset{ GetAlignmentOffset(alloc->available_offset, alignment) };
+					if (dedicated) {
+						break;
+					}
+					if (alloc->mapped) {
+						continue;
+					}
 
-					// Use existing allocation if there's enough memory left.
-					if (requirements.size + alignment_offset <= alloc->available_memory) {
-						return ExistingAllocation(vulkan_handle, alignment_offset, requirements.size, alloc, out_memory);
+					// Use existing allocation if it has a free range big enough.
+					VkDeviceSize offset{ ExistingAllocation(vulkan_handle, alignment, requirements.size, alloc, out_memory) };
+					if (offset != (VkDeviceSize)~0ull) {
+						return offset;
 					}
 				}
 
 				// Otherwise we need to allocate more memory of this type.
-				return NewAllocation(vulkan_handle, requirements.size, &memory_type_alloc, out_memory);
+				return NewAllocation(vulkan_handle, alignment, requirements.size, &memory_type_alloc, out_memory, dedicated);
 			}
 		}
 
@@ -454,7 +581,8 @@ namespace renderer
 		VkDeviceSize user_alignment,
 		const VkMemoryRequirements& requirements,
 		VkMemoryPropertyFlags properties,
-		VkDeviceMemory** out_memory
+		VkDeviceMemory** out_memory,
+		bool dedicated
 	)
 	{
 		bool device_local{ (bool)(properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) };
@@ -463,13 +591,13 @@ namespace renderer
 		VkDeviceSize offset = ~0ull;
 
 		if (device_local && host_visible) {
-			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, device_host_allocations_, out_memory);
+			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, device_host_allocations_, out_memory, dedicated);
 		}
 		else if (device_local) {
-			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, device_allocations_, out_memory);
+			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, device_allocations_, out_memory, dedicated);
 		}
 		else if (host_visible) {
-			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, host_allocations_, out_memory);
+			offset = FindMemoryType(vulkan_handle, user_alignment, requirements, properties, host_allocations_, out_memory, dedicated);
 		}
 		else {
 			logger::Error("Unsupported memory properties.");
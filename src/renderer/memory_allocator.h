@@ -2,10 +2,10 @@
 
 #include <vector>
 #include <unordered_map>
-#include <set>
 #include "volk.h"
 
 #include "context.h"
+#include "tlsf_allocator.h"
 
 namespace renderer
 {
@@ -32,6 +32,17 @@ namespace renderer
 		const ImageResource& operator=(const ImageResource& other);
 	};
 
+	// Usage of the memory allocated from one VkPhysicalDeviceMemoryProperties::memoryHeaps heap.
+	struct MemoryHeapStats
+	{
+		VkDeviceSize allocated_bytes;    // Device memory allocated from the heap, which resources are sub-allocated from.
+		VkDeviceSize used_bytes;         // Bytes bound to resources, including alignment.
+		VkDeviceSize largest_free_block; // Largest resource that fits without a new device memory allocation.
+		uint32_t allocation_count;       // Device memory allocations.
+		uint32_t resource_count;         // Buffers and images bound to the heap.
+		float fragmentation;             // 0 if all free memory is in one block, approaching 1 as it's split into small blocks.
+	};
+
 	class Allocator
 	{
 	public:
@@ -50,6 +61,17 @@ namespace renderer
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties);
 
+		// Create a host visible buffer with its own memory allocation, which stays mapped until the buffer is destroyed.
+		// Writes through out_mapped need FlushBufferResource() before the device reads them.
+		BufferResource CreateMappedBufferResource(
+			VkDeviceSize size,
+			VkBufferUsageFlags usage,
+			VkMemoryPropertyFlags properties,
+			void** out_mapped);
+
+		// Make host writes to a byte range of a mapped buffer visible to the device. Does nothing for host coherent memory.
+		void FlushBufferResource(const BufferResource& buffer_resource, VkDeviceSize offset, VkDeviceSize size);
+
 		ImageResource CreateImageResource(
 			Extent extent,
 			VkImageUsageFlags usage,
@@ -78,20 +100,26 @@ namespace renderer
 
 		void DestroyImageResource(ImageResource* image_resource);
 
+		// Indexed by heap.
+		std::vector<MemoryHeapStats> GetHeapStats() const;
+
 	private:
+		struct MemoryTypeAllocations;
+
 		struct Allocation
 		{
 			VkDeviceMemory memory;
-			VkDeviceSize available_offset;         // The byte offset where unbound allocated memory starts.
-			VkDeviceSize available_memory;         // How much allocated memory is left in this allocation?
-			std::set<VkDeviceSize> buffer_offsets; // Offsets of each buffer bound to this allocation.
+			TlsfAllocator blocks;         // Ranges of the memory bound to resources, and the free ranges between them.
+			MemoryTypeAllocations* owner; // Memory type this was allocated from. Categories aren't resized after initialization.
+			void* mapped;                 // Only set for allocations dedicated to one persistently mapped buffer.
+			bool host_coherent;
 		};
 
 		// Associated to each bound buffer via allocation_info_map_.
 		struct BufferAllocationInfo
 		{
 			Allocation* allocation;
-			VkDeviceSize next_available_offset; // The byte offset marking the end of the associated buffer, where other buffers could begin.
+			uint32_t block; // Handle of the range bound to the resource in Allocation::blocks.
 		};
 
 		struct MemoryTypeAllocations
@@ -101,25 +129,27 @@ namespace renderer
 			std::vector<Allocation*> allocations; // Vector of pointers so pointers to Allocations don't become invalidated when vector exands.
 		};
 
-		// Get info of an existing allocation for buffer to be bound to.
+		// Bind a resource to a free range of an existing allocation.
 		//
-		// Returns byte offset into device memory.
+		// Returns byte offset into device memory, or ~0 if the allocation has no free range big enough.
 		VkDeviceSize ExistingAllocation(
 			uint64_t vulkan_handle,
-			VkDeviceSize alignment_offset,
+			VkDeviceSize alignment,
 			VkDeviceSize required_size,
 			Allocation* alloc,
 			VkDeviceMemory** out_memory
 		);
 
-		// Make a new memory allocation.
+		// Make a new memory allocation. A dedicated allocation is sized to fit only this resource.
 		// 
 		// Returns byte offset into device memory.
 		VkDeviceSize NewAllocation(
 			uint64_t vulkan_handle,
+			VkDeviceSize alignment,
 			VkDeviceSize required_size,
 			MemoryTypeAllocations* alloc,
-			VkDeviceMemory** out_memory
+			VkDeviceMemory** out_memory,
+			bool dedicated = false
 		);
 
 		// Find an allocation of a specific memory type to bind a buffer to. If an allocation
@@ -132,7 +162,8 @@ namespace renderer
 			const VkMemoryRequirements& requirements,
 			VkMemoryPropertyFlags properties,
 			std::vector<MemoryTypeAllocations>& memory_type_allocations,
-			VkDeviceMemory** out_memory
+			VkDeviceMemory** out_memory,
+			bool dedicated
 		);
 
 		// Find an allocation to bind a buffer to. If an allocation cannot be found,
@@ -144,12 +175,16 @@ namespace renderer
 			VkDeviceSize user_alignment,
 			const VkMemoryRequirements& requirements,
 			VkMemoryPropertyFlags properties,
-			VkDeviceMemory** out_memory
+			VkDeviceMemory** out_memory,
+			bool dedicated = false
 		);
 
-		// Update the offsets associated with an allocation after a resource has been destroyed.
-		// This includes reclaiming memory that is no longer bound to a buffer/image.
-		void UpdateAllocationOffsets(uint64_t vulkan_handle);
+		// Unmap and free an allocation once no resources are bound to it.
+		void FreeAllocation(Allocation* allocation);
+
+		// Return the range bound to a destroyed resource to its allocation, where it merges with neighbouring free ranges.
+		// Allocations left empty are freed, except the last of each memory type, which is kept for reuse.
+		void FreeResourceMemory(uint64_t vulkan_handle);
 
 		Context* context_{};
 		VkPhysicalDeviceLimits limits_{};
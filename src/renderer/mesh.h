@@ -74,6 +74,9 @@ namespace renderer
 		std::vector<Vertex> vertices;
 		std::vector<uint32_t> indices;
 
+		// Only for procedural meshes, one box per primitive in place of vertices and indices. Kept in vertices_resource.
+		std::vector<VkAabbPositionsKHR> aabbs;
+
 		BufferResource vertices_resource;
 		BufferResource indices_resource;
 	};
@@ -82,6 +85,10 @@ namespace renderer
 	{
 		VkAccelerationStructureKHR acceleration_structure;
 		BufferResource buffer_resource;
+
+		// Only used by acceleration structures that are sized for a capacity and then built in place.
+		BufferResource scratch_resource;
+		uint32_t refits_since_build;
 	};
 
 	struct Mesh
@@ -99,10 +106,16 @@ namespace renderer
 		// If false, then each renderer::Geometry will correspond to a Vulkan geometry like normal, and build range offsets can be 0.
 		bool use_single_buffer;
 
+		// If true, geometries are made of aabbs instead of triangles. They're hit with an intersection shader and aren't rasterized.
+		bool procedural;
+
 		// If true, then this mesh data will be written to disk when the project is saved.
 		// This would be false for generated mesh data, like voxels..
 		bool write_to_disk;
 		std::vector<uint32_t> index_byte_offsets;  // Only used if use_single_buffer is true.
+
+		// Timeline value of the last transfer queue upload to the geometry buffers, which must finish before they're destroyed.
+		uint64_t upload_ticket;
 	};
 
 	// Extra info about a mesh needed for building a BLAS.
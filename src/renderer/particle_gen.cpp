@@ -1,6 +1,10 @@
 #include "particle_gen.h"
 
 #include <execution>
+#include <algorithm>
+#include <ranges>
+#include <atomic>
+#include <bit>
 #include "tracy/Tracy.hpp"
 
 #include "vulkan_renderer.h"
@@ -24,6 +28,32 @@ namespace renderer
 	constexpr uint32_t PARTICLE_MESH_OUT_VERTICES_BINDING{ 1 };
 	constexpr uint32_t PARTICLE_MESH_OUT_INDICES_BINDING{ 2 };
 	constexpr uint32_t PARTICLE_MESH_UBO_BINDING{ 3 };
+	constexpr uint32_t PARTICLE_MESH_IN_FACES_BINDING{ 4 };
+
+	// Normals and tangents of the faces of particle cubes, in VoxelSidesFlagBits order.
+	const std::array<glm::vec3, PARTICLE_FACE_COUNT> PARTICLE_FACE_NORMALS{
+		glm::vec3{ 1.0f, 0.0f, 0.0f },
+		glm::vec3{ -1.0f, 0.0f, 0.0f },
+		glm::vec3{ 0.0f, 1.0f, 0.0f },
+		glm::vec3{ 0.0f, -1.0f, 0.0f },
+		glm::vec3{ 0.0f, 0.0f, 1.0f },
+		glm::vec3{ 0.0f, 0.0f, -1.0f },
+	};
+	const std::array<glm::vec3, PARTICLE_FACE_COUNT> PARTICLE_FACE_TANGENTS{
+		glm::vec3{ 0.0f, 0.0f, -1.0f },
+		glm::vec3{ 0.0f, 0.0f, 1.0f },
+		glm::vec3{ 1.0f, 0.0f, 0.0f },
+		glm::vec3{ 1.0f, 0.0f, 0.0f },
+		glm::vec3{ 1.0f, 0.0f, 0.0f },
+		glm::vec3{ -1.0f, 0.0f, 0.0f },
+	};
+
+	// Horizontal and vertical axes of the slices perpendicular to the x, y and z axes.
+	const std::array<glm::uvec2, 3> PARTICLE_SLICE_AXES{
+		glm::uvec2{ 2, 1 },
+		glm::uvec2{ 0, 2 },
+		glm::uvec2{ 0, 1 },
+	};
 
 	static VoxelGeometricFeatureType GeometricFeaturesFromNeighbors(VoxelSidesFlagBits side_flags)
 	{
@@ -97,429 +127,12 @@ namespace renderer
 		return lut[(uint8_t)side_flags];
 	}
 
-	// Return value may need to be multiplied by -1 to keep consistent normal direction with neighbors.
-	static glm::vec3 NormalFromNeighbors(VoxelSidesFlagBits side_flags)
-	{
-		static glm::vec3 lut[64]{
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // No neighbors.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // X_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // X_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // Y_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, Y_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_NEGATIVE, Y_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_NEGATIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, Y_POSITIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, 1.0f }),   // X_POSITIVE, Y_POSITIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, -1.0f }), // X_NEGATIVE, Y_POSITIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, 1.0f }),  // X_POSITIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, -1.0f }),  // X_NEGATIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, -1.0f }),  // X_POSITIVE, X_NEGATIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 1.0f }),   // X_POSITIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, -1.0f }),  // X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, -1.0f }),  // X_POSITIVE, Y_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, 1.0f }),  // X_NEGATIVE, Y_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, -1.0f }),  // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, -1.0f }), // X_POSITIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, 1.0f }),   // X_NEGATIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, -1.0f }),  // X_POSITIVE, Y_POSITIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 1.0f }),   // X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 1.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, 0.0f }),   // X_POSITIVE, Y_POSITIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, 0.0f }),  // X_NEGATIVE, Y_POSITIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, -1.0f, 0.0f }),  // X_POSITIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 1.0f, 0.0f }),   // X_NEGATIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 1.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // X_POSITIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 1.0f, 0.0f, 0.0f }),   // X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-			glm::normalize(glm::vec3{ 0.0f, 0.0f, 0.0f }),   // X_POSITIVE, X_NEGATIVE, Y_POSITIVE, Y_NEGATIVE, Z_POSITIVE, Z_NEGATIVE.
-		};
-
-		return lut[(uint8_t)side_flags];
-	}
 
 	std::vector<MaterialRange> ParticleGenContext::GetMaterialRanges()
 	{
 		return mat_ranges_;
 	}
 
-	VoxelChunk::VoxelChunk()
-		: VoxelChunk{ 1, 1, 1 } // Dummy voxel chunk.
-	{
-	}
-
-	VoxelChunk::VoxelChunk(uint32_t width, uint32_t height, uint32_t depth)
-		: width_{ width }
-		, height_{ height }
-		, depth_{ depth }
-		, width_height_slice_{ width * height }
-	{
-		Voxel empty_voxel{
-			.physics_material_index = PHYSICS_MATERIAL_EMPTY_INDEX,
-		};
-
-		const uint64_t voxel_count{ (uint64_t)width_height_slice_ * depth_ };
-		voxels_.resize(voxel_count, empty_voxel);
-		side_flags_.resize(voxel_count);
-	}
-
-	VoxelChunk::VoxelChunk(uint32_t width, uint32_t height, uint32_t depth, std::vector<std::pair<Voxel, glm::uvec3>>&& voxel_pairs)
-		: VoxelChunk(width, height, depth)
-	{
-		// Convert the voxel pairs into voxels in the voxels_ vector.
-		std::for_each(
-			std::execution::par,
-			voxel_pairs.begin(),
-			voxel_pairs.end(),
-			[&](std::pair<Voxel, glm::uvec3>& pair)
-			{
-				Coordinate(pair.second.x, pair.second.y, pair.second.z) = pair.first;
-			});
-
-		// Create side flags.
-		std::for_each(
-			std::execution::par,
-			voxel_pairs.begin(),
-			voxel_pairs.end(),
-			[&](std::pair<Voxel, glm::uvec3>& pair)
-			{
-				glm::uvec3& coord{ pair.second };
-				uint8_t neighbors{};
-
-				// X-axis neighbors.
-				if (coord.x != width_ - 1 && NeighborOccupied(coord, glm::ivec3(1, 0, 0))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::X_POSITIVE;
-				}
-				if (coord.x != 0 && NeighborOccupied(coord, glm::ivec3(-1, 0, 0))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::X_NEGATIVE;
-				}
-				// Y-axis neighbors.
-				if (coord.y != height_ - 1 && NeighborOccupied(coord, glm::ivec3(0, 1, 0))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::Y_POSITIVE;
-				}
-				if (coord.y != 0 && NeighborOccupied(coord, glm::ivec3(0, -1, 0))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::Y_NEGATIVE;
-				}
-				// Y-axis neighbors.
-				if (coord.z != depth_ - 1 && NeighborOccupied(coord, glm::ivec3(0, 0, 1))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::Z_POSITIVE;
-				}
-				if (coord.z != 0 && NeighborOccupied(coord, glm::ivec3(0, 0, -1))) {
-					neighbors |= (uint8_t)VoxelSidesFlagBits::Z_NEGATIVE;
-				}
-
-				side_flags_[CoordinateToIndex(coord)] = neighbors;
-			});
-
-		// Create list of outer voxels, for collision detection.
-		std::vector<uint8_t> mask{};
-		mask.resize(voxels_.size());
-		for (uint32_t i{ 0 }; i < (uint32_t)voxels_.size(); ++i)
-		{
-			glm::uvec3 coord{ IndexToCoordinate(i) };
-			if (FloodFillInside(coord, mask))
-			{
-				OuterVoxel outer_voxel{
-					.coord = coord,
-					.normal = NormalFromNeighbors((VoxelSidesFlagBits)side_flags_[i]),
-				};
-
-				// We flood fill outer voxels to propogate consistent normal direction.
-				OuterVoxelFloodFill(std::move(outer_voxel), mask);
-			}
-		}
-	}
-
-	Voxel& VoxelChunk::Coordinate(uint32_t i, uint32_t j, uint32_t k)
-	{
-		return voxels_[CoordinateToIndex({ i, j, k })];
-	}
-
-	Voxel& VoxelChunk::Coordinate(const glm::uvec3& coord)
-	{
-		return Coordinate(coord.x, coord.y, coord.z);
-	}
-
-	const Voxel& VoxelChunk::Coordinate(uint32_t i, uint32_t j, uint32_t k) const
-	{
-		return voxels_[CoordinateToIndex({ i, j, k })];
-	}
-
-	const Voxel& VoxelChunk::Coordinate(const glm::uvec3& coord) const
-	{
-		return Coordinate(coord.x, coord.y, coord.z);
-	}
-
-	Voxel& VoxelChunk::Index(uint32_t idx)
-	{
-		return voxels_[idx];
-	}
-
-	const Voxel& VoxelChunk::Index(uint32_t idx) const
-	{
-		return voxels_[idx];
-	}
-
-	uint32_t VoxelChunk::VoxelCount() const
-	{
-		return (uint32_t)voxels_.size();
-	}
-
-	bool VoxelChunk::IsOccluded(uint32_t voxel_idx) const
-	{
-		return side_flags_[voxel_idx] == (uint8_t)VoxelSidesFlagBits::ALL_SIDES;
-	}
-
-	bool VoxelChunk::IsEmpty(uint32_t voxel_idx) const
-	{
-		return voxels_[voxel_idx].physics_material_index == PHYSICS_MATERIAL_EMPTY_INDEX;
-	}
-
-	bool VoxelChunk::IsEmpty(const glm::uvec3& voxel_coord) const
-	{
-		return IsEmpty(CoordinateToIndex(voxel_coord));
-	}
-
-	bool VoxelChunk::InBounds(const glm::uvec3& voxel_coord) const
-	{
-		return (voxel_coord.x < width_) && (voxel_coord.y < height_) && (voxel_coord.z < depth_);
-	}
-
-	glm::uvec3 VoxelChunk::IndexToCoordinate(uint32_t index) const
-	{
-		uint32_t z{ index / width_height_slice_ };
-		uint32_t y{ (index % width_height_slice_) / width_ };
-		uint32_t x{ index % width_ };
-
-		return glm::uvec3{ x, y, z };
-	}
-
-	uint32_t VoxelChunk::CoordinateToIndex(const glm::uvec3& coord) const
-	{
-		return coord.x + coord.y * width_ + coord.z * width_height_slice_;
-	}
-
-	std::vector<Voxel>& VoxelChunk::GetVoxels()
-	{
-		return voxels_;
-	}
-
-	std::vector<uint8_t>& VoxelChunk::GetSideFlags()
-	{
-		return side_flags_;
-	}
-
-	const std::vector<OuterVoxel>& VoxelChunk::GetOuterVoxels() const
-	{
-		return outer_voxels_;
-	}
-
-	std::array<glm::uvec3, 8> VoxelChunk::GetPotentialCollisions(const glm::vec3& coord_space, uint32_t* potential_collision_count) const
-	{
-		// TODO: Can probably use precalculated neighbor particles to skip all the iteration in this function.
-		glm::vec3 fract{ glm::fract(coord_space) };
-		glm::ivec3 coord{ glm::ivec3{glm::floor(coord_space + 0.5f)} };
-		int32_t x_offset{ fract.x < 0.5 ? 1 : -1 };
-		int32_t y_offset{ fract.y < 0.5 ? 1 : -1 };
-		int32_t z_offset{ fract.z < 0.5 ? 1 : -1 };
-
-		// Implicity cast each ivec3 to uvec3, intentionally underflowing all negative integers since they're out of bounds.
-		glm::uvec3 out_candidates[8]{
-			coord,
-			coord + glm::ivec3{0, 0, z_offset},
-			coord + glm::ivec3{0, y_offset, 0},
-			coord + glm::ivec3{0, y_offset, z_offset},
-			coord + glm::ivec3{x_offset, 0, 0},
-			coord + glm::ivec3{x_offset, 0, z_offset},
-			coord + glm::ivec3{x_offset, y_offset, 0},
-			coord + glm::ivec3{x_offset, y_offset, z_offset},
-		};
-
-		std::array<glm::uvec3, 8> out_coordinates{};
-		uint32_t i{ 0 };
-		for (const glm::uvec3& candidate : out_candidates)
-		{
-			if (InBounds(candidate) && !IsEmpty(candidate)) {
-				out_coordinates[i++] = candidate;
-			}
-		}
-
-		*potential_collision_count = i;
-		return out_coordinates;
-	}
-
-	uint32_t VoxelChunk::GetWidth() const
-	{
-		return width_;
-	}
-
-	uint32_t VoxelChunk::GetHeight() const
-	{
-		return height_;
-	}
-
-	uint32_t VoxelChunk::GetDepth() const
-	{
-		return depth_;
-	}
-
-	bool VoxelChunk::IsPointMass() const
-	{
-		return (width_ == 1) && (height_ == 1) && (depth_ == 1);
-	}
-
-	// Returns true when the given coordinate is inside the region that flood fill is filling.
-	bool VoxelChunk::FloodFillInside(const glm::uvec3& coord, const std::vector<uint8_t>& mask) const
-	{
-		// We only check upper condition since negative uints will overflow anyway.
-		bool x_out_bounds{ coord.x >= width_ };
-		bool y_out_bounds{ coord.y >= height_ };
-		bool z_out_bounds{ coord.z >= depth_ };
-
-		if (x_out_bounds || y_out_bounds || z_out_bounds) {
-			return false;
-		}
-
-		uint32_t idx{ CoordinateToIndex(coord) };
-		return !mask[idx] && !IsEmpty(idx) && !IsOccluded(idx); // Mask indicates if it's already been added to outer_voxels_.
-	}
-
-	OuterVoxel VoxelChunk::FloodFillSet(const glm::uvec3& coord, const glm::vec3& prev_normal, std::vector<uint8_t>& mask) const
-	{
-		uint32_t idx{ CoordinateToIndex(coord) };
-
-		glm::vec3 normal{ NormalFromNeighbors((VoxelSidesFlagBits)side_flags_[idx]) };
-		if (glm::dot(normal, prev_normal) < 0.0f) {
-			normal = -normal;
-		}
-
-		mask[idx] = true;
-
-		return OuterVoxel{
-			.coord = coord,
-			.normal = normal,
-		};
-	}
-
-	void VoxelChunk::FloodFillScan(
-		uint32_t lx,
-		const glm::uvec3& coord,
-		uint32_t original_x,
-		int32_t y_offset,
-		int32_t z_offset,
-		std::queue<OuterVoxel>& queue,
-		const std::vector<uint8_t>& mask)
-	{
-		uint32_t rx{ coord.x };
-		uint32_t y{ coord.y + y_offset };
-		uint32_t z{ coord.z + z_offset };
-		bool span_added{ false };
-
-		for (uint32_t x{ lx }; x < rx; ++x)
-		{
-			if (!FloodFillInside({ x, y, z }, mask)) {
-				span_added = false;
-			}
-			else if (!span_added)
-			{
-				uint32_t added_voxel_count{ rx - lx };
-				size_t start_idx{ outer_voxels_.size() - added_voxel_count };
-				uint32_t new_voxel_idx{ x - lx };
-
-				// Flip index since the left side outer voxels were added in reverse order.
-				if (x < original_x)
-				{
-					uint32_t left_size{ original_x - lx };
-					new_voxel_idx = left_size - new_voxel_idx - 1;
-				}
-
-				glm::vec3 adjacent_normal{ outer_voxels_[start_idx + new_voxel_idx].normal };
-				queue.push({ { x, y, z }, adjacent_normal });
-				span_added = true;
-			}
-		}
-	}
-
-	void VoxelChunk::OuterVoxelFloodFill(OuterVoxel&& outer_voxel, std::vector<uint8_t>& mask)
-	{
-		std::queue<OuterVoxel> queue{};
-		queue.push(std::move(outer_voxel));
-
-		while (!queue.empty())
-		{
-			OuterVoxel ov{ queue.front() };
-			queue.pop();
-			uint32_t lx{ ov.coord.x };
-			glm::vec3 prev_normal{ ov.normal };
-
-			glm::uvec3 next_coord{ lx - 1, ov.coord.y, ov.coord.z };
-			while (FloodFillInside(next_coord, mask))
-			{
-				OuterVoxel new_ov{ FloodFillSet(next_coord, prev_normal, mask) };
-				prev_normal = new_ov.normal;
-				outer_voxels_.push_back(std::move(new_ov));
-
-				--lx;
-				next_coord = { lx - 1, ov.coord.y, ov.coord.z };
-			}
-
-			uint32_t original_x{ ov.coord.x };
-			prev_normal = ov.normal;
-			while (FloodFillInside(ov.coord, mask))
-			{
-				OuterVoxel new_ov{ FloodFillSet(ov.coord, prev_normal, mask) };
-				prev_normal = new_ov.normal;
-				outer_voxels_.push_back(std::move(new_ov));
-
-				++ov.coord.x;
-			}
-
-			FloodFillScan(lx, ov.coord, original_x, 1, 0, queue, mask);
-			FloodFillScan(lx, ov.coord, original_x, -1, 0, queue, mask);
-			FloodFillScan(lx, ov.coord, original_x, 0, 1, queue, mask);
-			FloodFillScan(lx, ov.coord, original_x, 0, -1, queue, mask);
-		}
-	}
-
-
-	bool VoxelChunk::NeighborOccupied(glm::uvec3 coord, glm::ivec3 offset) const
-	{
-		glm::uvec3 neighbor_coord = glm::ivec3{ coord } + offset;
-		return !IsEmpty(neighbor_coord);
-	}
-
 	void ParticleGenContext::Initialize(Context* context, VulkanRenderer* renderer)
 	{
 		context_ = context;
@@ -556,6 +169,33 @@ namespace renderer
 	}
 
 	void ParticleGenContext::InvokeParticleGenShader(RenderObjectHandle ro_target, std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags)
+	{
+		ZoneScoped;
+
+		// Chunk coordinate is always the origin for now, so the built-in UBO matches DispatchParticleGenShader().
+		ParticleGenShaderResources::BuiltInUBO built_in_ubo{
+			.chunk_coordinate = {0, 0, 0},
+		};
+
+		const std::byte* built_in_ubo_bytes{ reinterpret_cast<const std::byte*>(&built_in_ubo) };
+		const ParticleGenCacheKey key{
+			.shader_hash = renderer_->user_compute_shader_hashes_[particle_gen_.shader_idx],
+			.built_in_ubo = { built_in_ubo_bytes, built_in_ubo_bytes + sizeof(built_in_ubo) },
+			.custom_ubo = particle_gen_.custom_ubo,
+		};
+
+		if (particle_gen_cache_.IsEnabled() && particle_gen_cache_.Load(key, out_voxels, out_side_flags)) {
+			return;
+		}
+
+		DispatchParticleGenShader(out_voxels, out_side_flags);
+
+		if (particle_gen_cache_.IsEnabled()) {
+			particle_gen_cache_.Store(key, *out_voxels);
+		}
+	}
+
+	void ParticleGenContext::DispatchParticleGenShader(std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags)
 	{
 		ComputePipeline* particle_gen_pipeline{ renderer_->user_compute_shaders_[particle_gen_.shader_idx] };
 
@@ -627,11 +267,22 @@ namespace renderer
 
 	void ParticleGenContext::UpdateParticleGenShaderCustomUBO(const std::vector<std::byte>& custom_ubo)
 	{
+		particle_gen_.custom_ubo = custom_ubo;
 		renderer_->vulkan_util_.Begin();
 		renderer_->vulkan_util_.TransferBufferToDevice(custom_ubo, particle_gen_.custom_ubo_buffer);
 		renderer_->vulkan_util_.Submit();
 	}
 
+	void ParticleGenContext::SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes)
+	{
+		particle_gen_cache_.Initialize(directory, max_size_bytes);
+	}
+
+	const ParticleGenCacheStats& ParticleGenContext::GetParticleGenCacheStats() const
+	{
+		return particle_gen_cache_.GetStats();
+	}
+
 	DescriptorSetLayoutResource& ParticleGenContext::GetParticleGenLayoutResource()
 	{
 		return particle_gen_.layout_resource;
@@ -788,11 +439,20 @@ namespace renderer
 			.pImmutableSamplers = nullptr,
 		};
 
+		VkDescriptorSetLayoutBinding faces_in_ssbo{
+			.binding = PARTICLE_MESH_IN_FACES_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.pImmutableSamplers = nullptr,
+		};
+
 		std::vector<VkDescriptorSetLayoutBinding> layout_bindings{
 			positions_in_ssbo,
 			vertices_out_ssbo,
 			indices_out_ssbo,
 			ubo,
+			faces_in_ssbo,
 		};
 
 		particle_mesh_.layout_resource = renderer_->descriptor_allocator_.CreateDescriptorSetLayoutResource(layout_bindings, 0);
@@ -813,7 +473,7 @@ namespace renderer
 			frame.particle_mesh.descriptor_set_resource.LinkBufferToBinding(PARTICLE_MESH_UBO_BINDING, frame.particle_mesh.ubo_buffer);
 		}
 
-		// Buffers for positions, vertices, and indices will need to be made dynamically later based on the number of particles.
+		// Buffers for positions, faces, vertices, and indices will need to be made dynamically later based on the number of particles.
 
 		// Make the compute pipeline.
 		std::vector<DescriptorSetLayoutResource> compute_layouts{
@@ -869,84 +529,200 @@ namespace renderer
 		return frame_resources_[current_frame_];
 	}
 
+	uint32_t ParticleGenContext::PackParticleFaces(
+		const std::byte* particles,
+		uint32_t particle_count,
+		uint32_t exposed_faces_offset,
+		uint32_t stride,
+		std::vector<uint32_t>* out_packed_faces)
+	{
+		ZoneScoped;
+		out_packed_faces->resize(particle_count);
+
+		uint32_t face_count{ 0 };
+		for (uint32_t p{ 0 }; p < particle_count; ++p)
+		{
+			uint8_t exposed_faces{ (uint8_t)(static_cast<uint8_t>(particles[p * stride + exposed_faces_offset]) & (uint8_t)VoxelSidesFlagBits::ALL_SIDES) };
+			(*out_packed_faces)[p] = (face_count << PARTICLE_FACE_COUNT) | exposed_faces;
+			face_count += std::popcount(exposed_faces);
+		}
+
+		dynamic_particle_mesh_stats_ = DynamicParticleMeshStats{
+			.particle_count = particle_count,
+			.face_count = face_count,
+			.culled_face_count = particle_count * PARTICLE_FACE_COUNT - face_count,
+		};
+		return face_count;
+	}
+
 	void ParticleGenContext::GenerateDynamicParticleMesh(
 		RenderObjectHandle ro_target,
 		const std::byte* positions,
 		uint32_t offset,
+		uint32_t exposed_faces_offset,
+		uint32_t stride,
+		const std::vector<MaterialRange>& mat_ranges)
+	{
+		ZoneScoped;
+		Mesh* mesh{ BuildDynamicParticleMesh(positions, offset, exposed_faces_offset, stride, mat_ranges) };
+		UpdateDynamicParticleMesh(ro_target, mesh, mat_ranges);
+	}
+
+	Mesh* ParticleGenContext::BuildDynamicParticleMesh(
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t exposed_faces_offset,
 		uint32_t stride,
 		const std::vector<MaterialRange>& mat_ranges)
 	{
 		ZoneScoped;
-		mat_ranges_ = mat_ranges;
 		Mesh* mesh{ new Mesh{} };
 		mesh->write_to_disk = false;
 		mesh->geometries.resize(std::max(mat_ranges.size(), (size_t)1));
 
+		uint32_t particle_count{ mat_ranges.empty() ? 0 : mat_ranges.back().offset + mat_ranges.back().count };
+		std::vector<uint32_t> packed_faces{};
+		uint32_t total_face_count{ PackParticleFaces(positions, particle_count, exposed_faces_offset, stride, &packed_faces) };
+
+		std::vector<Vertex> particle_vertices{ GetParticleVertices() };
+		std::vector<uint32_t> face_indices{ GetParticleIndices() };
+		auto first_face_of = [&](uint32_t p) {
+			return p < particle_count ? packed_faces[p] >> PARTICLE_FACE_COUNT : total_face_count;
+			};
+
+		// Cube indices point into the whole cube, so shift them to index only their own face's vertices.
+		for (uint32_t j{ 0 }; j < (uint32_t)face_indices.size(); ++j) {
+			face_indices[j] -= (j / PARTICLE_FACE_INDEX_COUNT) * PARTICLE_FACE_VERTEX_COUNT;
+		}
+
 		for (uint32_t i{ 0 }; i < (uint32_t)mat_ranges.size(); ++i)
 		{
 			const MaterialRange& mat_offset{ mat_ranges[i] };
+			uint32_t range_end{ mat_offset.offset + mat_offset.count };
+			uint32_t first_face{ first_face_of(mat_offset.offset) };
+			uint32_t end_face{ first_face_of(range_end) };
+			Geometry& geometry{ mesh->geometries[i] };
 
-			// Generate vertices.
-			uint32_t particle_vert_count{};
+			if (std::find(fluid_surface_materials_.begin(), fluid_surface_materials_.end(), mat_offset.physics_material_index) != fluid_surface_materials_.end())
 			{
-				ZoneScopedN("Generate vertices");
-				std::vector<Vertex> particle_vertices{ GetParticleVertices() };
-				particle_vert_count = (uint32_t)particle_vertices.size();
-				uint32_t vertex_count{ particle_vert_count * mat_offset.count };
-				mesh->geometries[i].vertices.resize(vertex_count);
-
-				for (uint32_t p{ 0 }; p < mat_offset.count; ++p)
-				{
-					for (uint32_t v{ 0 }; v < particle_vert_count; ++v)
-					{
-						const glm::vec3& position{ *reinterpret_cast<const glm::vec3*>(positions + (p + mat_offset.offset) * stride + offset) };
-						uint32_t vert_buffer_idx{ p * particle_vert_count + v };
-						mesh->geometries[i].vertices[vert_buffer_idx] = particle_vertices[v];
-						mesh->geometries[i].vertices[vert_buffer_idx].position += glm::vec4{ position, 0.0f };
-					}
-				}
+				ExtractFluidSurface(positions, offset, stride, mat_offset.offset, mat_offset.count, fluid_surface_settings_, &geometry);
+				dynamic_particle_mesh_stats_.face_count -= end_face - first_face;
+				dynamic_particle_mesh_stats_.fluid_triangle_count += (uint32_t)geometry.indices.size() / 3;
+				continue;
 			}
 
-			// Generate indices.
-			{
-				ZoneScopedN("Generate indices");
-				std::vector<uint32_t> particle_indices{ GetParticleIndices() };
-				uint32_t index_count{ (uint32_t)(particle_indices.size() * mat_offset.count) };
-				mesh->geometries[i].indices.resize(index_count);
+			ZoneScopedN("Generate faces");
+			geometry.vertices.resize((end_face - first_face) * PARTICLE_FACE_VERTEX_COUNT);
+			geometry.indices.resize((end_face - first_face) * PARTICLE_FACE_INDEX_COUNT);
 
-				for (uint32_t p{ 0 }; p < mat_offset.count; ++p)
-				{
-					for (uint32_t j{ 0 }; j < (uint32_t)particle_indices.size(); ++j)
+			// Every particle already knows where its faces go, so particles are written in parallel.
+			// Normals and tangents are constant per face and come straight from the cube vertices.
+			auto particles{ std::views::iota(mat_offset.offset, range_end) };
+			std::for_each(std::execution::par, particles.begin(), particles.end(),
+				[&](uint32_t p) {
+					const glm::vec4 position{ *reinterpret_cast<const glm::vec3*>(positions + p * stride + offset), 0.0f };
+					uint32_t face{ (packed_faces[p] >> PARTICLE_FACE_COUNT) - first_face };
+
+					for (uint32_t faces{ packed_faces[p] & (uint32_t)VoxelSidesFlagBits::ALL_SIDES }; faces != 0; faces &= faces - 1)
 					{
-						uint32_t idx_buffer_idx{ p * (uint32_t)particle_indices.size() + j };
-						mesh->geometries[i].indices[idx_buffer_idx] = p * particle_vert_count + particle_indices[j];
+						uint32_t f{ (uint32_t)std::countr_zero(faces) };
+						Vertex* out_vertices{ geometry.vertices.data() + face * PARTICLE_FACE_VERTEX_COUNT };
+						uint32_t* out_indices{ geometry.indices.data() + face * PARTICLE_FACE_INDEX_COUNT };
+
+						for (uint32_t v{ 0 }; v < PARTICLE_FACE_VERTEX_COUNT; ++v)
+						{
+							out_vertices[v] = particle_vertices[f * PARTICLE_FACE_VERTEX_COUNT + v];
+							out_vertices[v].position += position;
+						}
+
+						for (uint32_t j{ 0 }; j < PARTICLE_FACE_INDEX_COUNT; ++j) {
+							out_indices[j] = face * PARTICLE_FACE_VERTEX_COUNT + face_indices[f * PARTICLE_FACE_INDEX_COUNT + j];
+						}
+						++face;
 					}
-				}
-			}
+				});
 		}
 
+		return mesh;
+	}
+
+	Mesh* ParticleGenContext::BuildProceduralParticleMesh(
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t exposed_faces_offset,
+		uint32_t stride,
+		const std::vector<MaterialRange>& mat_ranges)
+	{
+		ZoneScoped;
+		Mesh* mesh{ new Mesh{} };
+		mesh->write_to_disk = false;
+		mesh->procedural = true;
+		mesh->geometries.resize(std::max(mat_ranges.size(), (size_t)1));
+
+		float particle_radius{ PARTICLE_WIDTH / 2.0f };
+		uint32_t box_count{ 0 };
+		for (uint32_t i{ 0 }; i < (uint32_t)mat_ranges.size(); ++i)
 		{
-			ZoneScopedN("Calculate tangents");
-			CalculateTangents(mesh);
+			const MaterialRange& mat_range{ mat_ranges[i] };
+			std::vector<VkAabbPositionsKHR>& aabbs{ mesh->geometries[i].aabbs };
+			aabbs.reserve(mat_range.count);
+
+			for (uint32_t p{ mat_range.offset }; p < mat_range.offset + mat_range.count; ++p)
+			{
+				const std::byte* particle{ positions + p * stride };
+				if (((uint8_t)particle[exposed_faces_offset] & (uint8_t)VoxelSidesFlagBits::ALL_SIDES) == 0) {
+					continue;
+				}
+
+				const glm::vec3& position{ *reinterpret_cast<const glm::vec3*>(particle + offset) };
+				aabbs.push_back(VkAabbPositionsKHR{
+					.minX = position.x - particle_radius,
+					.minY = position.y - particle_radius,
+					.minZ = position.z - particle_radius,
+					.maxX = position.x + particle_radius,
+					.maxY = position.y + particle_radius,
+					.maxZ = position.z + particle_radius,
+				});
+			}
+			box_count += (uint32_t)aabbs.size();
 		}
 
-		{
-			ZoneScopedN("Replace render object");
-			std::vector<int> render_mat_indices(mat_ranges_.size());
-			std::transform(mat_ranges_.begin(), mat_ranges_.end(), render_mat_indices.begin(),
-				[this](const MaterialRange& range)
-				{
+		dynamic_particle_mesh_stats_ = DynamicParticleMeshStats{
+			.particle_count = mat_ranges.empty() ? 0 : mat_ranges.back().offset + mat_ranges.back().count,
+			.box_count = box_count,
+		};
+		return mesh;
+	}
+
+	void ParticleGenContext::ReplaceParticleMesh(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<MaterialRange>& mat_ranges)
+	{
+		ZoneScopedN("Replace render object");
+		mat_ranges_ = mat_ranges;
+		renderer_->ReplaceRenderObjectAndBuildBlas(ro_target, mesh, GetRenderMaterialIndices(mat_ranges_));
+	}
+
+	void ParticleGenContext::UpdateDynamicParticleMesh(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<MaterialRange>& mat_ranges)
+	{
+		ZoneScopedN("Update render object");
+		mat_ranges_ = mat_ranges;
+		renderer_->UpdateDynamicRenderObject(ro_target, mesh, GetRenderMaterialIndices(mat_ranges_));
+	}
+
+	std::vector<int> ParticleGenContext::GetRenderMaterialIndices(const std::vector<MaterialRange>& mat_ranges) const
+	{
+		std::vector<int> render_mat_indices(mat_ranges.size());
+		std::transform(mat_ranges.begin(), mat_ranges.end(), render_mat_indices.begin(),
+			[this](const MaterialRange& range)
+			{
 #ifdef EDITOR_ENABLED
-					// For editor convenience we just use available physics material if enough haven't been created yet.
-					uint32_t idx{ std::min(range.physics_material_index, (uint8_t)(physics_to_render_mat_idx_.size() - 1)) };
+				// For editor convenience we just use available physics material if enough haven't been created yet.
+				uint32_t idx{ std::min(range.physics_material_index, (uint8_t)(physics_to_render_mat_idx_.size() - 1)) };
 #else
-					uint32_t idx{ range.physics_material_index };
+				uint32_t idx{ range.physics_material_index };
 #endif
-					return physics_to_render_mat_idx_[idx];
-				});
-
-			renderer_->ReplaceRenderObjectAndBuildBlas(ro_target, mesh, render_mat_indices);
-		}
+				return physics_to_render_mat_idx_[idx];
+			});
+		return render_mat_indices;
 	}
 
 	void ParticleGenContext::SetPhysicsToRenderMaterialMap(std::vector<int>&& physics_to_render_mat_idx)
@@ -954,6 +730,11 @@ namespace renderer
 		physics_to_render_mat_idx_ = std::move(physics_to_render_mat_idx);
 	}
 
+	void ParticleGenContext::SetFluidSurfaceMaterials(std::vector<uint8_t>&& physics_material_indices)
+	{
+		fluid_surface_materials_ = std::move(physics_material_indices);
+	}
+
 	void ParticleGenContext::UpdatePhysicsRenderMaterials(RenderObjectHandle ro_target)
 	{
 		// Assign render object's material indices based on physics materials.
@@ -999,6 +780,7 @@ namespace renderer
 		const std::byte* positions,
 		uint32_t position_count,
 		uint32_t offset,
+		uint32_t exposed_faces_offset,
 		uint32_t stride,
 		const std::vector<MaterialRange>& mat_ranges)
 	{
@@ -1007,8 +789,11 @@ namespace renderer
 		VkCommandBuffer& cmd{ GetCurrentFrame().command_buffer };
 		const uint32_t position_buffer_size{ stride * position_count };
 
-		constexpr uint32_t CUBE_VERTEX_COUNT{ 24 };
-		constexpr uint32_t CUBE_INDEX_COUNT{ 36 };
+		// Output buffers only hold exposed faces, so find where each particle's faces go first.
+		std::vector<uint32_t> packed_faces{};
+		const uint32_t face_count{ PackParticleFaces(positions, position_count, exposed_faces_offset, stride, &packed_faces) };
+		const uint32_t faces_buffer_size{ (uint32_t)(sizeof(uint32_t) * position_count) };
+		const uint32_t output_face_capacity{ std::max(face_count, 1u) }; // Avoid empty buffers when every face is covered.
 		bool buffer_expanded{};
 
 		// Create or resize particle in/out buffers if necessary.
@@ -1024,7 +809,18 @@ namespace renderer
 		}
 
 		buffer_expanded = renderer_->allocator_.ExpandOrReuseBuffer(
-			sizeof(Vertex) * position_count * CUBE_VERTEX_COUNT,
+			(uint64_t)faces_buffer_size,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			GetCurrentFrame().particle_mesh.faces_in);
+		if (buffer_expanded)
+		{
+			NameObject(context_->device, GetCurrentFrame().particle_mesh.faces_in.buffer, "Particle_Mesh_Faces_In");
+			GetCurrentFrame().particle_mesh.descriptor_set_resource.LinkBufferToBinding(PARTICLE_MESH_IN_FACES_BINDING, GetCurrentFrame().particle_mesh.faces_in);
+		}
+
+		buffer_expanded = renderer_->allocator_.ExpandOrReuseBuffer(
+			sizeof(Vertex) * output_face_capacity * PARTICLE_FACE_VERTEX_COUNT,
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			GetCurrentFrame().particle_mesh.vertices_out);
@@ -1035,7 +831,7 @@ namespace renderer
 		}
 
 		buffer_expanded = renderer_->allocator_.ExpandOrReuseBuffer(
-			sizeof(uint32_t) * position_count * CUBE_INDEX_COUNT,
+			sizeof(uint32_t) * output_face_capacity * PARTICLE_FACE_INDEX_COUNT,
 			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			GetCurrentFrame().particle_mesh.indices_out);
@@ -1073,6 +869,13 @@ namespace renderer
 			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
 
+		renderer_->vulkan_util_.TransferBufferToDeviceCmd(cmd, packed_faces.data(), faces_buffer_size, GetCurrentFrame().particle_mesh.faces_in);
+		PipelineBarrier(
+			cmd,
+			GetCurrentFrame().particle_mesh.faces_in.buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
 		PipelineBarrier(
 			cmd,
 			GetCurrentFrame().particle_mesh.ubo_buffer.buffer,
@@ -1112,12 +915,17 @@ namespace renderer
 			build_ranges.reserve(mat_ranges.size());
 			max_indices.reserve(mat_ranges.size());
 			index_byte_offsets.reserve(mat_ranges.size());
-			uint32_t pos_count_accumulator{ 0 };
+			auto first_face_of = [&](uint32_t p) {
+				return p < position_count ? packed_faces[p] >> PARTICLE_FACE_COUNT : face_count;
+				};
+
 			for (const MaterialRange& mat_range : mat_ranges)
 			{
-				uint32_t primitive_offset{ pos_count_accumulator * CUBE_INDEX_COUNT * sizeof(uint32_t) };
+				uint32_t first_face{ first_face_of(mat_range.offset) };
+				uint32_t end_face{ first_face_of(mat_range.offset + mat_range.count) };
+				uint32_t primitive_offset{ first_face * PARTICLE_FACE_INDEX_COUNT * sizeof(uint32_t) };
 				VkAccelerationStructureBuildRangeInfoKHR build_range{
-					.primitiveCount = (CUBE_INDEX_COUNT / 3) * mat_range.count,
+					.primitiveCount = (PARTICLE_FACE_INDEX_COUNT / 3) * (end_face - first_face),
 					.primitiveOffset = primitive_offset, // Byte offset into index buffer.
 					.firstVertex = 0, // Zero since index values already index into correct part of vertex buffer.
 					.transformOffset = 0,
@@ -1125,9 +933,7 @@ namespace renderer
 				build_ranges.push_back(std::move(build_range));
 				index_byte_offsets.push_back(primitive_offset);
 
-				pos_count_accumulator += mat_range.count;
-
-				max_indices.push_back(pos_count_accumulator * CUBE_INDEX_COUNT - 1);
+				max_indices.push_back(std::max(end_face * PARTICLE_FACE_VERTEX_COUNT, 1u) - 1);
 			}
 		}
 
@@ -1147,21 +953,13 @@ namespace renderer
 
 		renderer_->rt_context_.QueueBlas(mesh, mesh_info);
 
-		std::vector<int> render_mat_indices(mat_ranges_.size());
-		std::transform(mat_ranges_.begin(), mat_ranges_.end(), render_mat_indices.begin(),
-			[this](const MaterialRange& range)
-			{
-#ifdef EDITOR_ENABLED
-				// For editor convenience we just use available physics material if enough haven't been created yet.
-				uint32_t idx{ std::min(range.physics_material_index, (uint8_t)(physics_to_render_mat_idx_.size() - 1)) };
-#else
-				uint32_t idx{ range.physics_material_index };
-#endif
-				return physics_to_render_mat_idx_[idx];
-			});
-
 		// Do not replace render object yet since last frame's resources are still in use. We do it during VulkanRenderer::HostRenderWork().
-		renderer_->QueueReplaceRenderObject(ro_target, mesh, std::move(render_mat_indices));
+		renderer_->QueueReplaceRenderObject(ro_target, mesh, GetRenderMaterialIndices(mat_ranges_));
+	}
+
+	const DynamicParticleMeshStats& ParticleGenContext::GetDynamicParticleMeshStats() const
+	{
+		return dynamic_particle_mesh_stats_;
 	}
 
 	void ParticleGenContext::CmdSubmit()
@@ -1192,25 +990,36 @@ namespace renderer
 	std::vector<MaterialPosition> VoxelChunkToMaterialPositions(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin)
 	{
 		std::vector<MaterialPosition> mat_positions{};
-		for (uint32_t i{ 0 }; i < voxel_chunk.VoxelCount(); ++i)
-		{
-			if (voxel_chunk.IsEmpty(i) || voxel_chunk.IsOccluded(i)) {
-				continue;
+		voxel_chunk.ForEachOccupied([&](uint32_t idx, const glm::uvec3& coord, const Voxel& voxel) {
+			if (voxel_chunk.IsOccluded(idx)) {
+				return;
 			}
 
 			MaterialPosition mat_position{
-				.physics_material_index = voxel_chunk.Index(i).physics_material_index,
-				.position = PARTICLE_WIDTH * glm::vec3(voxel_chunk.IndexToCoordinate(i)) - object_origin,
+				.physics_material_index = voxel.physics_material_index,
+				.exposed_faces = (uint8_t)(~voxel_chunk.GetSideFlags(idx) & (uint8_t)VoxelSidesFlagBits::ALL_SIDES),
+				.position = PARTICLE_WIDTH * glm::vec3(coord) - object_origin,
 			};
 			mat_positions.push_back(mat_position);
-		}
+			});
 		return mat_positions;
 	}
 
+	float ExposedFaceDensity(const VoxelChunk& voxel_chunk)
+	{
+		uint32_t exposed_face_count{ 0 };
+		for (const OuterVoxel& outer_voxel : voxel_chunk.GetOuterVoxels())
+		{
+			uint8_t side_flags{ voxel_chunk.GetSideFlags(voxel_chunk.CoordinateToIndex(outer_voxel.coord)) };
+			exposed_face_count += (uint32_t)std::popcount((uint8_t)(~side_flags & (uint8_t)VoxelSidesFlagBits::ALL_SIDES));
+		}
+		return (float)exposed_face_count / voxel_chunk.VoxelCount();
+	}
+
 	void ParticleGenContext::GenerateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin)
 	{
-		// When true, forces to always generate dynamic particle meshes for debugging purposes.
-		if (DISABLE_STATIC_PARTICLE_MESH)
+		// Mesh each particle as a cube for debugging, or when few of the chunk's faces would merge.
+		if (DISABLE_STATIC_PARTICLE_MESH || ExposedFaceDensity(voxel_chunk) > STATIC_MESH_MAX_FACE_DENSITY)
 		{
 			std::vector<MaterialPosition> mat_positions{ VoxelChunkToMaterialPositions(voxel_chunk, object_origin) };
 			if (mat_positions.empty()) {
@@ -1221,78 +1030,67 @@ namespace renderer
 				[](const MaterialPosition& p0, const MaterialPosition& p1) { return p0.physics_material_index < p1.physics_material_index; });
 
 			mat_ranges_ = CreateMaterialRanges(mat_positions);
-			GenerateDynamicParticleMesh(ro_target, (const std::byte*)mat_positions.data(), offsetof(MaterialPosition, position), sizeof(MaterialPosition), mat_ranges_);
+			GenerateDynamicParticleMesh(ro_target, (const std::byte*)mat_positions.data(), offsetof(MaterialPosition, position), offsetof(MaterialPosition, exposed_faces), sizeof(MaterialPosition), mat_ranges_);
 			return;
 		}
 
-		// TODO: Experiment and measure speed with reinterpretting particles as uint64_t.
-		//constexpr uint64_t empty_particles{ 0 };
-		//constexpr uint64_t all_sides{ 0x3F3f3f3f3F3f3f3f };
+		// The mesh no longer matches any mesher state kept for the render object.
+		static_mesh_generators_.erase(ro_target);
 
-		//StaticParticleMeshGenerator gen{};
-		//Mesh* mesh{ gen.Generate(voxel_chunk) };
-		//renderer_->ReplaceRenderObject(ro_target, mesh);
+		StaticParticleMeshGenerator generator{};
+		std::vector<MaterialRange> mat_ranges{};
+		Mesh* mesh{ generator.Generate(voxel_chunk, object_origin, &mat_ranges) };
+		if (mesh) {
+			ReplaceParticleMesh(ro_target, mesh, mat_ranges);
+		}
+	}
+
+	void ParticleGenContext::UpdateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord)
+	{
+		if (DISABLE_STATIC_PARTICLE_MESH)
+		{
+			GenerateStaticParticleMesh(ro_target, voxel_chunk, object_origin);
+			return;
+		}
+
+		// The first update of a render object meshes the whole chunk, since its current mesh may not have come from a generator.
+		auto [it, inserted] { static_mesh_generators_.try_emplace(ro_target) };
+		std::vector<MaterialRange> mat_ranges{};
+		Mesh* mesh{ inserted ?
+			it->second.Generate(voxel_chunk, object_origin, &mat_ranges) :
+			it->second.Regenerate(voxel_chunk, object_origin, min_coord, max_coord, &mat_ranges) };
+		if (mesh) {
+			ReplaceParticleMesh(ro_target, mesh, mat_ranges);
+		}
+	}
+
+	void ParticleGenContext::ReleaseStaticParticleMesh(RenderObjectHandle ro_target)
+	{
+		static_mesh_generators_.erase(ro_target);
 	}
 
 	std::vector<Vertex> ParticleGenContext::GetParticleVertices() const
 	{
-		uint32_t vert_count{ 24 }; // Cube with 3 normals per corner so 8 * 3 vertices.
-		std::vector<Vertex> verts(vert_count);
-		float particle_radius{ PARTICLE_WIDTH / 2.0f };
+		// Cube with 4 vertices per face so each face has its own normal and tangent. Faces are in VoxelSidesFlagBits order,
+		// so the ith face can be skipped when the ith side is covered. Faces are axis aligned, so tangents are constant
+		// and meshes made from these vertices don't need CalculateTangents().
+		const std::array<glm::vec3, PARTICLE_FACE_VERTEX_COUNT * PARTICLE_FACE_COUNT> corners{
+			glm::vec3{ 1.0f, -1.0f, 1.0f }, glm::vec3{ 1.0f, -1.0f, -1.0f }, glm::vec3{ 1.0f, 1.0f, 1.0f }, glm::vec3{ 1.0f, 1.0f, -1.0f },         // X+ face.
+			glm::vec3{ -1.0f, -1.0f, 1.0f }, glm::vec3{ -1.0f, -1.0f, -1.0f }, glm::vec3{ -1.0f, 1.0f, 1.0f }, glm::vec3{ -1.0f, 1.0f, -1.0f }, // X- face.
+			glm::vec3{ -1.0f, 1.0f, 1.0f }, glm::vec3{ -1.0f, 1.0f, -1.0f }, glm::vec3{ 1.0f, 1.0f, 1.0f }, glm::vec3{ 1.0f, 1.0f, -1.0f },     // Y+ face.
+			glm::vec3{ -1.0f, -1.0f, 1.0f }, glm::vec3{ -1.0f, -1.0f, -1.0f }, glm::vec3{ 1.0f, -1.0f, 1.0f }, glm::vec3{ 1.0f, -1.0f, -1.0f }, // Y- face.
+			glm::vec3{ -1.0f, -1.0f, 1.0f }, glm::vec3{ -1.0f, 1.0f, 1.0f }, glm::vec3{ 1.0f, -1.0f, 1.0f }, glm::vec3{ 1.0f, 1.0f, 1.0f },     // Z+ face.
+			glm::vec3{ -1.0f, -1.0f, -1.0f }, glm::vec3{ -1.0f, 1.0f, -1.0f }, glm::vec3{ 1.0f, -1.0f, -1.0f }, glm::vec3{ 1.0f, 1.0f, -1.0f }, // Z- face.
+		};
 
-		// Position. Three of each since there are three different normals at each corner.
-		verts[0].position = glm::vec4{ -1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[1].position = glm::vec4{ -1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[2].position = glm::vec4{ -1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[3].position = glm::vec4{ -1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[4].position = glm::vec4{ -1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[5].position = glm::vec4{ -1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[6].position = glm::vec4{ -1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[7].position = glm::vec4{ -1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[8].position = glm::vec4{ -1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[9].position = glm::vec4{ -1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[10].position = glm::vec4{ -1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[11].position = glm::vec4{ -1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-
-		verts[12].position = glm::vec4{ 1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[13].position = glm::vec4{ 1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[14].position = glm::vec4{ 1.0f, -1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[15].position = glm::vec4{ 1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[16].position = glm::vec4{ 1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[17].position = glm::vec4{ 1.0f, -1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[18].position = glm::vec4{ 1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[19].position = glm::vec4{ 1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[20].position = glm::vec4{ 1.0f, 1.0f, 1.0f, 0.0f } *particle_radius;
-		verts[21].position = glm::vec4{ 1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[22].position = glm::vec4{ 1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-		verts[23].position = glm::vec4{ 1.0f, 1.0f, -1.0f, 0.0f } *particle_radius;
-
-		// Normals.
-		verts[0].normal = glm::vec4{ -1.0f, 0.0f, 0.0f, 0.0f };  // 0 vertex.
-		verts[1].normal = glm::vec4{ 0.0f, -1.0f, 0.0f, 0.0f };  // 0 vertex.
-		verts[2].normal = glm::vec4{ 0.0f, 0.0f, 1.0f, 0.0f };   // 0 vertex.
-		verts[3].normal = glm::vec4{ -1.0f, 0.0f, 0.0f, 0.0f };  // 1 vertex.
-		verts[4].normal = glm::vec4{ 0.0f, -1.0f, 0.0f, 0.0f };  // 1 vertex.
-		verts[5].normal = glm::vec4{ 0.0f, 0.0f, -1.0f, 0.0f };  // 1 vertex.
-		verts[6].normal = glm::vec4{ -1.0f, 0.0f, 0.0f, 0.0f };  // 2 vertex.
-		verts[7].normal = glm::vec4{ 0.0f, 1.0f, 0.0f, 0.0f };   // 2 vertex.
-		verts[8].normal = glm::vec4{ 0.0f, 0.0f, 1.0f, 0.0f };   // 2 vertex.
-		verts[9].normal = glm::vec4{ -1.0f, 0.0f, 0.0f, 0.0f };  // 3 vertex.
-		verts[10].normal = glm::vec4{ 0.0f, 1.0f, 0.0f, 0.0f };  // 3 vertex.
-		verts[11].normal = glm::vec4{ 0.0f, 0.0f, -1.0f, 0.0f }; // 3 vertex.
-
-		verts[12].normal = glm::vec4{ 1.0f, 0.0f, 0.0f, 0.0f };  // 4 vertex.
-		verts[13].normal = glm::vec4{ 0.0f, -1.0f, 0.0f, 0.0f }; // 4 vertex.
-		verts[14].normal = glm::vec4{ 0.0f, 0.0f, 1.0f, 0.0f };  // 4 vertex.
-		verts[15].normal = glm::vec4{ 1.0f, 0.0f, 0.0f, 0.0f };  // 5 vertex.
-		verts[16].normal = glm::vec4{ 0.0f, -1.0f, 0.0f, 0.0f }; // 5 vertex.
-		verts[17].normal = glm::vec4{ 0.0f, 0.0f, -1.0f, 0.0f }; // 5 vertex.
-		verts[18].normal = glm::vec4{ 1.0f, 0.0f, 0.0f, 0.0f };  // 6 vertex.
-		verts[19].normal = glm::vec4{ 0.0f, 1.0f, 0.0f, 0.0f };  // 6 vertex.
-		verts[20].normal = glm::vec4{ 0.0f, 0.0f, 1.0f, 0.0f };  // 6 vertex.
-		verts[21].normal = glm::vec4{ 1.0f, 0.0f, 0.0f, 0.0f };  // 7 vertex.
-		verts[22].normal = glm::vec4{ 0.0f, 1.0f, 0.0f, 0.0f };  // 7 vertex.
-		verts[23].normal = glm::vec4{ 0.0f, 0.0f, -1.0f, 0.0f }; // 7 vertex.
+		std::vector<Vertex> verts(corners.size());
+		float particle_radius{ PARTICLE_WIDTH / 2.0f };
+		for (uint32_t v{ 0 }; v < (uint32_t)verts.size(); ++v)
+		{
+			verts[v].position = glm::vec4{ corners[v] * particle_radius, 0.0f };
+			verts[v].normal = glm::vec4{ PARTICLE_FACE_NORMALS[v / PARTICLE_FACE_VERTEX_COUNT], 0.0f };
+			verts[v].tangent = glm::vec4{ PARTICLE_FACE_TANGENTS[v / PARTICLE_FACE_VERTEX_COUNT], 0.0f };
+		}
 
 		return verts;
 	}
@@ -1300,261 +1098,432 @@ namespace renderer
 	std::vector<uint32_t> ParticleGenContext::GetParticleIndices() const
 	{
 		// Seems that Vulkan RT API has counter clockwise hardcoded as front face.
+		// Each face only indexes its own 4 vertices, in VoxelSidesFlagBits order.
 		return {
-			8, 2, 20,   // Z- plane.
-			20, 2, 14,  // Z- plane.
-			3, 0, 6,    // X- plane.
-			9, 3, 6,    // X- plane.
-			23, 5, 11,  // Z+ plane.
-			17, 5, 23,  // Z+ plane.
-			18, 15, 21, // X+ plane.
-			12, 15, 18, // X+ plane.
-			7, 19, 10,  // Y+ plane.
-			10, 19, 22, // Y+ plane.
-			13, 1, 4,   // Y- plane.
-			16, 13, 4,  // Y- plane.
+			2, 1, 3,    // X+ plane.
+			0, 1, 2,    // X+ plane.
+			5, 4, 6,    // X- plane.
+			7, 5, 6,    // X- plane.
+			8, 10, 9,   // Y+ plane.
+			9, 10, 11,  // Y+ plane.
+			14, 12, 13, // Y- plane.
+			15, 14, 13, // Y- plane.
+			17, 16, 19, // Z+ plane.
+			19, 16, 18, // Z+ plane.
+			23, 20, 21, // Z- plane.
+			22, 20, 23, // Z- plane.
 		};
 	}
 
-	Mesh* StaticParticleMeshGenerator::Generate(const VoxelChunk& voxel_chunk)
+	// Slices of each side, enough for the widest chunk.
+	constexpr uint32_t MAX_SLICES{ 64 };
+
+	Mesh* StaticParticleMeshGenerator::Generate(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, std::vector<MaterialRange>* out_mat_ranges)
 	{
-		/*
-		mesh_ = new Mesh{};
-		mesh_->geometries.emplace_back();
-
-		GenerateSide(ParticleSidesFlagBits::X_POSITIVE, particles, side_flags);
-		GenerateSide(ParticleSidesFlagBits::Y_POSITIVE, particles, side_flags);
-		GenerateSide(ParticleSidesFlagBits::Z_POSITIVE, particles, side_flags);
-
-		CalculateTangents(mesh_);
-		return mesh_;
-		*/
-		return nullptr;
+		ZoneScoped;
+		out_mat_ranges->clear();
+		dimensions_ = glm::uvec3{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() };
+
+		// Dense physics materials, so rows can be built in order. Slabs of bricks write distinct voxels and count their own materials.
+		materials_.assign((size_t)dimensions_.x * dimensions_.y * dimensions_.z, PHYSICS_MATERIAL_EMPTY_INDEX);
+		std::vector<std::array<uint32_t, 256>> slab_voxel_counts(voxel_chunk.GetBrickDimensions().z);
+		{
+			ZoneScopedN("Gather materials");
+			auto slabs{ std::views::iota(0u, voxel_chunk.GetBrickDimensions().z) };
+			std::for_each(std::execution::par, slabs.begin(), slabs.end(),
+				[&](uint32_t bz) {
+					glm::uvec3 min_coord{ 0, 0, bz * VOXEL_BRICK_WIDTH };
+					glm::uvec3 max_coord{ dimensions_.x - 1, dimensions_.y - 1, std::min(min_coord.z + VOXEL_BRICK_WIDTH, dimensions_.z) - 1 };
+					slab_voxel_counts[bz] = {};
+					voxel_chunk.ForEachOccupied(min_coord, max_coord,
+						[&](uint32_t idx, const glm::uvec3& coord, const Voxel& voxel) {
+							materials_[idx] = voxel.physics_material_index;
+							++slab_voxel_counts[bz][voxel.physics_material_index];
+						});
+				});
+		}
+
+		voxel_counts_ = {};
+		for (const std::array<uint32_t, 256>& counts : slab_voxel_counts)
+		{
+			for (uint32_t m{ 0 }; m < 256; ++m) {
+				voxel_counts_[m] += counts[m];
+			}
+		}
+
+		geometry_indices_.fill(NULL_INDEX);
+		geometry_count_ = 0;
+		for (uint32_t m{ 0 }; m < PHYSICS_MATERIAL_EMPTY_INDEX; ++m)
+		{
+			if (voxel_counts_[m] != 0) {
+				geometry_indices_[m] = geometry_count_++;
+			}
+		}
+
+		slice_rectangles_.assign(PARTICLE_FACE_COUNT * MAX_SLICES, {});
+		if (geometry_count_ == 0) {
+			return nullptr;
+		}
+
+		BuildMasks();
+
+		// One task per slice of each side.
+		{
+			ZoneScopedN("Merge faces");
+			auto slices{ std::views::iota(0u, (uint32_t)slice_rectangles_.size()) };
+			std::for_each(std::execution::par, slices.begin(), slices.end(),
+				[&](uint32_t slice) {
+					uint32_t side_idx{ slice / MAX_SLICES };
+					uint32_t depth{ slice % MAX_SLICES };
+					if (depth < dimensions_[side_idx / 2]) {
+						MeshSlice(side_idx, depth, &slice_rectangles_[slice]);
+					}
+				});
+		}
+
+		BuildMaterialRanges(out_mat_ranges);
+		return Triangulate(object_origin);
 	}
 
-	void StaticParticleMeshGenerator::GenerateSide(VoxelSidesFlagBits side, const std::vector<Voxel>& particles, const std::vector<uint8_t>& side_flags)
+	Mesh* StaticParticleMeshGenerator::Regenerate(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord, std::vector<MaterialRange>* out_mat_ranges)
 	{
-		/*
-		rectangle_indices_.resize(CHUNK_ROW_VOXEL_COUNT, NULL_INDEX);
-		uint32_t rect_start{}; // Coordinate of start of current rectangle.
+		ZoneScoped;
 
-		// Abstract x_, y_, z_ coordinates so algorithm can be done for any sides of the voxels.
-		uint32_t& h{ GetHorizontalReference(side) };
-		uint32_t& v{ GetVerticalReference(side) };
-		uint32_t& d{ GetDepthReference(side) };
+		glm::uvec3 dimensions{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() };
+		if (dimensions != dimensions_ || materials_.empty()) {
+			return Generate(voxel_chunk, object_origin, out_mat_ranges);
+		}
 
-		for (d = 0; d < CHUNK_ROW_VOXEL_COUNT; ++d)
+		// Gather the materials of the edited region again, keeping the voxel counts up to date.
+		const glm::uvec3 region_max{ glm::min(max_coord, dimensions_ - 1u) };
+		for (uint32_t z{ min_coord.z }; z <= region_max.z; ++z)
 		{
-			for (v = 0; v < CHUNK_ROW_VOXEL_COUNT; ++v)
+			for (uint32_t y{ min_coord.y }; y <= region_max.y; ++y)
 			{
-				rect_start = NULL_INDEX;
-				for (h = 0; h < CHUNK_ROW_VOXEL_COUNT; ++h)
+				uint8_t* row_materials{ materials_.data() + (y + z * dimensions_.y) * dimensions_.x };
+				for (uint32_t x{ min_coord.x }; x <= region_max.x; ++x)
 				{
-					uint32_t i{ CoordinateToParticleIndex({x_, y_, z_}) };
-
-					uint32_t current_rect_idx = rectangle_indices_[h];
-					bool in_rectangle_domain{ current_rect_idx != NULL_INDEX };
-					bool solid_particle{ particles[i].physics_material_index != PHYSICS_MATERIAL_EMPTY_INDEX };
-					bool occluded{ (bool)(side_flags[i] & (uint8_t)side) };
-					bool part_of_shell{ solid_particle && !occluded }; // Each solid and non-occluded face will be part of a the triangle shell.
-					bool end_of_row{ h == CHUNK_ROW_VOXEL_COUNT - 1 };
-
-					if (in_rectangle_domain)
-					{
-						if (part_of_shell)
-						{
-							// If null then we just entered a rectangle, so we mark the start of it.
-							if (rect_start == NULL_INDEX) {
-								rect_start = h;
-							}
-							// Otherwise if we reached the end of the rectangle, then we clear the start marker.
-							else if (h == rectangles_[current_rect_idx].end_h) {
-								rect_start = NULL_INDEX;
-							}
-						}
-						else
-						{
-							// In checking to see if a rectangle can get another row, we found empty block so rectangle is done.
-							TriangulateRectangle(side, current_rect_idx, v, d);
-							ClearRectangleIndices(current_rect_idx);
-						}
-					}
-					else
-					{
-						// Just entered a part of shell, so mark start of it.
-						if (part_of_shell && (rect_start == NULL_INDEX)) {
-							rect_start = h;
-						}
-						// Otherwise we made it to the end of a streak of shell blocks, so create a new rectangle if it's not already a part of one.
-						else if ((!part_of_shell || end_of_row) && (rect_start != NULL_INDEX) && (rectangle_indices_[rect_start] == NULL_INDEX))
-						{
-							Rectangle rect{
-								.start_h = rect_start,
-								.end_h = end_of_row ? h : h - 1,
-								.start_v = v,
-							};
-							uint32_t rect_idx{ (uint32_t)rectangles_.size() };
-							rectangles_.push_back(rect);
-							SetRectangleIndices(rect_idx);
-							rect_start = NULL_INDEX;
-						}
+					if (row_materials[x] != PHYSICS_MATERIAL_EMPTY_INDEX) {
+						--voxel_counts_[row_materials[x]];
 					}
+					row_materials[x] = PHYSICS_MATERIAL_EMPTY_INDEX;
 				}
 			}
+		}
+		voxel_chunk.ForEachOccupied(min_coord, region_max,
+			[&](uint32_t idx, const glm::uvec3& coord, const Voxel& voxel) {
+				materials_[idx] = voxel.physics_material_index;
+				++voxel_counts_[voxel.physics_material_index];
+			});
 
-			// Just finished slice, so triangulate all of the remaining rectangles.
-			for (uint32_t rect_idx : rectangle_indices_)
-			{
-				if (rect_idx != NULL_INDEX) {
-					TriangulateRectangle(side, rect_idx, CHUNK_ROW_VOXEL_COUNT - 1, CHUNK_ROW_VOXEL_COUNT - 1);
-					ClearRectangleIndices(rect_idx);
-				}
+		// The masks are laid out by geometry, so they're all rebuilt when a geometry is added or removed.
+		for (uint32_t m{ 0 }; m < PHYSICS_MATERIAL_EMPTY_INDEX; ++m)
+		{
+			if ((voxel_counts_[m] != 0) != (geometry_indices_[m] != NULL_INDEX)) {
+				return Generate(voxel_chunk, object_origin, out_mat_ranges);
 			}
-			rectangles_.clear();
 		}
-		*/
+
+		out_mat_ranges->clear();
+		if (geometry_count_ == 0) {
+			return nullptr;
+		}
+
+		UpdateMasks(min_coord, region_max);
+
+		// A slice's faces depend on its own voxels and those of the slice in front of it, so the slices around the region merge again too.
+		std::vector<uint32_t> dirty_slices{};
+		for (uint32_t side_idx{ 0 }; side_idx < PARTICLE_FACE_COUNT; ++side_idx)
+		{
+			uint32_t axis{ side_idx / 2 };
+			uint32_t first_depth{ min_coord[axis] > 0 ? min_coord[axis] - 1 : 0 };
+			uint32_t last_depth{ std::min(region_max[axis] + 1, dimensions_[axis] - 1) };
+			for (uint32_t depth{ first_depth }; depth <= last_depth; ++depth) {
+				dirty_slices.push_back(side_idx * MAX_SLICES + depth);
+			}
+		}
+
+		{
+			ZoneScopedN("Merge faces");
+			std::for_each(std::execution::par, dirty_slices.begin(), dirty_slices.end(),
+				[&](uint32_t slice) {
+					slice_rectangles_[slice].clear();
+					MeshSlice(slice / MAX_SLICES, slice % MAX_SLICES, &slice_rectangles_[slice]);
+				});
+		}
+
+		BuildMaterialRanges(out_mat_ranges);
+		return Triangulate(object_origin);
 	}
 
-	void StaticParticleMeshGenerator::TriangulateRectangle(VoxelSidesFlagBits side, uint32_t rect_idx, uint32_t vertical, uint32_t depth)
+	void StaticParticleMeshGenerator::BuildMaterialRanges(std::vector<MaterialRange>* out_mat_ranges) const
 	{
-		float left{ (float)rectangles_[rect_idx].start_h };
-		float right{ (float)rectangles_[rect_idx].end_h + 1 }; // Add one since triangle ends at rightmost edge of the block.
-		float top{ (float)vertical };
-		float bottom{ (float)rectangles_[rect_idx].start_v };
-
-		Vertex top_left{};
-		Vertex top_right{};
-		Vertex bottom_right{};
-		Vertex bottom_left{};
-		bool switch_winding_order{}; // Need to switch winding order if z-coordinate is horizontal or vertical.
-		switch (side)
+		out_mat_ranges->clear();
+		for (uint32_t m{ 0 }; m < PHYSICS_MATERIAL_EMPTY_INDEX; ++m)
 		{
-		case VoxelSidesFlagBits::X_POSITIVE:
-			++depth;
-			[[fallthrough]];
-		case VoxelSidesFlagBits::X_NEGATIVE:
-			top_left = { {     (float)depth, top,    left,  0.0f}, {1.0f, 0.0f, 0.0f, 0.0f} };
-			top_right = { {    (float)depth, top,    right, 0.0f}, {1.0f, 0.0f, 0.0f, 0.0f} };
-			bottom_right = { { (float)depth, bottom, right, 0.0f}, {1.0f, 0.0f, 0.0f, 0.0f} };
-			bottom_left = { {  (float)depth, bottom, left,  0.0f}, {1.0f, 0.0f, 0.0f, 0.0f} };
-			switch_winding_order = true;
-			break;
-		case VoxelSidesFlagBits::Y_POSITIVE:
-			++depth;
-			[[fallthrough]];
-		case VoxelSidesFlagBits::Y_NEGATIVE:
-			top_left = { {     left,  (float)depth, top,    0.0f}, {0.0f, 1.0f, 0.0f, 0.0f} };
-			top_right = { {    right, (float)depth, top,    0.0f}, {0.0f, 1.0f, 0.0f, 0.0f} };
-			bottom_right = { { right, (float)depth, bottom, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f} };
-			bottom_left = { {  left,  (float)depth, bottom, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f} };
-			switch_winding_order = true;
-			break;
-		case VoxelSidesFlagBits::Z_POSITIVE:
-			++depth;
-			[[fallthrough]];
-		case VoxelSidesFlagBits::Z_NEGATIVE:
-			top_left = { {     left,  top,    (float)depth, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f} };
-			top_right = { {    right, top,    (float)depth, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f} };
-			bottom_right = { { right, bottom, (float)depth, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f} };
-			bottom_left = { {  left,  bottom, (float)depth, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f} };
-			switch_winding_order = false;
-			break;
+			if (geometry_indices_[m] == NULL_INDEX) {
+				continue;
+			}
+
+			out_mat_ranges->push_back(MaterialRange{
+				.physics_material_index = (uint8_t)m,
+				.offset = out_mat_ranges->empty() ? 0 : out_mat_ranges->back().offset + out_mat_ranges->back().count,
+				.count = voxel_counts_[m],
+				});
 		}
+	}
 
-		uint32_t start_index{ (uint32_t)mesh_->geometries[0].vertices.size() };
+	Mesh* StaticParticleMeshGenerator::Triangulate(const glm::vec3& object_origin) const
+	{
+		ZoneScoped;
 
-		mesh_->geometries[0].vertices.push_back(top_left);
-		mesh_->geometries[0].vertices.push_back(top_right);
-		mesh_->geometries[0].vertices.push_back(bottom_right);
-		mesh_->geometries[0].vertices.push_back(bottom_left);
+		// Slices write their rectangles after those of the previous slices in each geometry.
+		std::vector<uint32_t> first_rectangles(slice_rectangles_.size() * geometry_count_);
+		std::vector<uint32_t> rectangle_counts(geometry_count_);
+		for (uint32_t slice{ 0 }; slice < (uint32_t)slice_rectangles_.size(); ++slice)
+		{
+			for (uint32_t g{ 0 }; g < geometry_count_; ++g) {
+				first_rectangles[slice * geometry_count_ + g] = rectangle_counts[g];
+			}
+			for (const Rectangle& rect : slice_rectangles_[slice]) {
+				++rectangle_counts[rect.geometry_idx];
+			}
+		}
 
-		// Seems that Vulkan RT API has counter clockwise hardcoded as front face.
-		std::vector<uint32_t> indices = switch_winding_order ? std::vector<uint32_t>{ 0, 1, 3, 2, 3, 1 } : std::vector<uint32_t>{ 1, 0, 3, 3, 2, 1 };
-		for (uint32_t i : indices) {
-			mesh_->geometries[0].indices.push_back(start_index + i);
+		Mesh* mesh{ new Mesh{} };
+		mesh->write_to_disk = false;
+		mesh->geometries.resize(geometry_count_);
+		for (uint32_t g{ 0 }; g < geometry_count_; ++g)
+		{
+			mesh->geometries[g].vertices.resize(rectangle_counts[g] * PARTICLE_FACE_VERTEX_COUNT);
+			mesh->geometries[g].indices.resize(rectangle_counts[g] * PARTICLE_FACE_INDEX_COUNT);
 		}
+
+		auto slices{ std::views::iota(0u, (uint32_t)slice_rectangles_.size()) };
+		std::for_each(std::execution::par, slices.begin(), slices.end(),
+			[&](uint32_t slice) {
+				std::vector<uint32_t> next_rectangles(first_rectangles.begin() + slice * geometry_count_, first_rectangles.begin() + (slice + 1) * geometry_count_);
+				for (const Rectangle& rect : slice_rectangles_[slice])
+				{
+					Geometry& geometry{ mesh->geometries[rect.geometry_idx] };
+					uint32_t rect_idx{ next_rectangles[rect.geometry_idx]++ };
+					TriangulateRectangle(rect, object_origin, rect_idx * PARTICLE_FACE_VERTEX_COUNT,
+						geometry.vertices.data() + rect_idx * PARTICLE_FACE_VERTEX_COUNT,
+						geometry.indices.data() + rect_idx * PARTICLE_FACE_INDEX_COUNT);
+				}
+			});
+
+		return mesh;
 	}
 
-	void StaticParticleMeshGenerator::ClearRectangleIndices(uint32_t rect_idx)
+	// Transpose a 64x64 matrix of bits, so bit c of row r becomes bit r of row c. Swaps ever smaller blocks, from Hacker's Delight.
+	static void TransposeBits(std::array<uint64_t, 64>* rows)
 	{
-		for (uint32_t i{ rectangles_[rect_idx].start_h }; i <= rectangles_[rect_idx].end_h; ++i)
+		uint64_t mask{ 0x00000000FFFFFFFFull };
+		for (uint32_t j{ 32 }; j != 0; j >>= 1, mask ^= mask << j)
 		{
-			if (rectangle_indices_[i] == rect_idx) {
-				rectangle_indices_[i] = NULL_INDEX;
+			for (uint32_t k{ 0 }; k < 64; k = ((k | j) + 1) & ~j)
+			{
+				uint64_t t{ (((*rows)[k] >> j) ^ (*rows)[k | j]) & mask };
+				(*rows)[k] ^= t << j;
+				(*rows)[k | j] ^= t;
 			}
 		}
 	}
 
-	void StaticParticleMeshGenerator::SetRectangleIndices(uint32_t rect_idx)
+	void StaticParticleMeshGenerator::BuildMasks()
 	{
-		for (uint32_t i{ rectangles_[rect_idx].start_h }; i <= rectangles_[rect_idx].end_h; ++i) {
-			rectangle_indices_[i] = rect_idx;
+		ZoneScoped;
+
+		for (uint32_t axis{ 0 }; axis < 3; ++axis) {
+			masks_[axis].assign((size_t)(geometry_count_ + 1) * dimensions_[axis] * dimensions_[PARTICLE_SLICE_AXES[axis].y], 0);
 		}
+
+		// Slices along z have rows along x, the same as the voxels. Each slice only writes its own rows.
+		auto z_slices{ std::views::iota(0u, dimensions_.z) };
+		std::for_each(std::execution::par, z_slices.begin(), z_slices.end(),
+			[&](uint32_t z) {
+				for (uint32_t y{ 0 }; y < dimensions_.y; ++y)
+				{
+					const uint8_t* row_materials{ materials_.data() + (y + z * dimensions_.y) * dimensions_.x };
+					for (uint32_t x{ 0 }; x < dimensions_.x; ++x)
+					{
+						if (row_materials[x] == PHYSICS_MATERIAL_EMPTY_INDEX) {
+							continue;
+						}
+						masks_[2][MaskIndex(2, geometry_indices_[row_materials[x]], z, y)] |= 1ull << x;
+						masks_[2][MaskIndex(2, geometry_count_, z, y)] |= 1ull << x;
+					}
+				}
+			});
+
+		// Slices along y have the same rows in a different order, and slices along x have them transposed.
+		auto layers{ std::views::iota(0u, (geometry_count_ + 1) * dimensions_.y) };
+		std::for_each(std::execution::par, layers.begin(), layers.end(),
+			[&](uint32_t layer) {
+				uint32_t g{ layer / dimensions_.y };
+				uint32_t y{ layer % dimensions_.y };
+
+				std::array<uint64_t, 64> rows{};
+				for (uint32_t z{ 0 }; z < dimensions_.z; ++z)
+				{
+					rows[z] = masks_[2][MaskIndex(2, g, z, y)];
+					masks_[1][MaskIndex(1, g, y, z)] = rows[z];
+				}
+
+				TransposeBits(&rows);
+				for (uint32_t x{ 0 }; x < dimensions_.x; ++x) {
+					masks_[0][MaskIndex(0, g, x, y)] = rows[x];
+				}
+			});
 	}
 
-	uint32_t& StaticParticleMeshGenerator::GetHorizontalReference(VoxelSidesFlagBits side)
+	void StaticParticleMeshGenerator::UpdateMasks(const glm::uvec3& min_coord, const glm::uvec3& max_coord)
 	{
-		switch (side)
+		ZoneScoped;
+
+		// Rows along x of the slices along z and y, which are the same rows.
+		for (uint32_t z{ min_coord.z }; z <= max_coord.z; ++z)
 		{
-		case VoxelSidesFlagBits::X_POSITIVE:
-			return z_;
-		case VoxelSidesFlagBits::X_NEGATIVE:
-			return z_;
-		case VoxelSidesFlagBits::Y_POSITIVE:
-			return x_;
-		case VoxelSidesFlagBits::Y_NEGATIVE:
-			return x_;
-		case VoxelSidesFlagBits::Z_POSITIVE:
-			return x_;
-		case VoxelSidesFlagBits::Z_NEGATIVE:
-			return x_;
+			for (uint32_t y{ min_coord.y }; y <= max_coord.y; ++y)
+			{
+				for (uint32_t g{ 0 }; g <= geometry_count_; ++g) {
+					masks_[2][MaskIndex(2, g, z, y)] = 0;
+				}
+
+				const uint8_t* row_materials{ materials_.data() + (y + z * dimensions_.y) * dimensions_.x };
+				for (uint32_t x{ 0 }; x < dimensions_.x; ++x)
+				{
+					if (row_materials[x] == PHYSICS_MATERIAL_EMPTY_INDEX) {
+						continue;
+					}
+					masks_[2][MaskIndex(2, geometry_indices_[row_materials[x]], z, y)] |= 1ull << x;
+					masks_[2][MaskIndex(2, geometry_count_, z, y)] |= 1ull << x;
+				}
+
+				for (uint32_t g{ 0 }; g <= geometry_count_; ++g) {
+					masks_[1][MaskIndex(1, g, y, z)] = masks_[2][MaskIndex(2, g, z, y)];
+				}
+			}
 		}
 
-		logger::Error("Failed to get horizontal reference.\n");
-		return x_;
+		// Rows along z of the slices along x only change in the bits of the region.
+		const uint64_t region_bits{ (max_coord.z - min_coord.z == 63 ? ~0ull : (1ull << (max_coord.z - min_coord.z + 1)) - 1) << min_coord.z };
+		for (uint32_t x{ min_coord.x }; x <= max_coord.x; ++x)
+		{
+			for (uint32_t y{ min_coord.y }; y <= max_coord.y; ++y)
+			{
+				for (uint32_t g{ 0 }; g <= geometry_count_; ++g) {
+					masks_[0][MaskIndex(0, g, x, y)] &= ~region_bits;
+				}
+
+				for (uint32_t z{ min_coord.z }; z <= max_coord.z; ++z)
+				{
+					uint8_t material{ materials_[x + (y + z * dimensions_.y) * dimensions_.x] };
+					if (material == PHYSICS_MATERIAL_EMPTY_INDEX) {
+						continue;
+					}
+					masks_[0][MaskIndex(0, geometry_indices_[material], x, y)] |= 1ull << z;
+					masks_[0][MaskIndex(0, geometry_count_, x, y)] |= 1ull << z;
+				}
+			}
+		}
 	}
 
-	uint32_t& StaticParticleMeshGenerator::GetVerticalReference(VoxelSidesFlagBits side)
+	void StaticParticleMeshGenerator::MeshSlice(uint32_t side_idx, uint32_t depth, std::vector<Rectangle>* out_rectangles) const
 	{
-		switch (side)
+		const uint32_t axis{ side_idx / 2 };
+		const bool positive{ side_idx % 2 == 0 };
+		const uint32_t vertical_count{ dimensions_[PARTICLE_SLICE_AXES[axis].y] };
+
+		// Faces are exposed where the neighboring slice on this side is empty. Outside of the chunk is empty.
+		const bool has_neighbor{ positive ? depth + 1 < dimensions_[axis] : depth > 0 };
+		const uint32_t neighbor_depth{ positive ? depth + 1 : depth - 1 };
+
+		std::array<uint64_t, 64> rows{};
+		for (uint32_t g{ 0 }; g < geometry_count_; ++g)
 		{
-		case VoxelSidesFlagBits::X_POSITIVE:
-			return y_;
-		case VoxelSidesFlagBits::X_NEGATIVE:
-			return y_;
-		case VoxelSidesFlagBits::Y_POSITIVE:
-			return z_;
-		case VoxelSidesFlagBits::Y_NEGATIVE:
-			return z_;
-		case VoxelSidesFlagBits::Z_POSITIVE:
-			return y_;
-		case VoxelSidesFlagBits::Z_NEGATIVE:
-			return y_;
-		}
+			for (uint32_t v{ 0 }; v < vertical_count; ++v)
+			{
+				uint64_t covered{ has_neighbor ? masks_[axis][MaskIndex(axis, geometry_count_, neighbor_depth, v)] : 0 };
+				rows[v] = masks_[axis][MaskIndex(axis, g, depth, v)] & ~covered;
+			}
+
+			for (uint32_t v{ 0 }; v < vertical_count; ++v)
+			{
+				while (rows[v])
+				{
+					uint32_t start_h{ (uint32_t)std::countr_zero(rows[v]) };
+					uint32_t run{ (uint32_t)std::countr_one(rows[v] >> start_h) };
+					uint64_t run_mask{ (run == 64 ? ~0ull : (1ull << run) - 1) << start_h };
 
-		logger::Error("Failed to get vertical reference.\n");
-		return x_;
+					// Grow the rectangle over the following rows while they have the whole run.
+					uint32_t end_v{ v + 1 };
+					while (end_v < vertical_count && (rows[end_v] & run_mask) == run_mask)
+					{
+						rows[end_v] &= ~run_mask;
+						++end_v;
+					}
+					rows[v] &= ~run_mask;
+
+					out_rectangles->push_back(Rectangle{
+						.geometry_idx = g,
+						.side_idx = side_idx,
+						.depth = depth,
+						.start_h = start_h,
+						.end_h = start_h + run,
+						.start_v = v,
+						.end_v = end_v,
+						});
+				}
+			}
+		}
 	}
 
-	uint32_t& StaticParticleMeshGenerator::GetDepthReference(VoxelSidesFlagBits side)
+	void StaticParticleMeshGenerator::TriangulateRectangle(const Rectangle& rect, const glm::vec3& object_origin, uint32_t first_vertex, Vertex* out_vertices, uint32_t* out_indices) const
 	{
-		switch (side)
+		const uint32_t axis{ rect.side_idx / 2 };
+		const glm::uvec2 slice_axes{ PARTICLE_SLICE_AXES[axis] };
+		const float face_offset{ rect.side_idx % 2 == 0 ? 0.5f : -0.5f };
+
+		// Voxel centers are at their coordinates, so rectangle edges are half a voxel before their start and end.
+		const std::array<glm::vec2, PARTICLE_FACE_VERTEX_COUNT> corners{
+			glm::vec2{ rect.start_h, rect.start_v },
+			glm::vec2{ rect.end_h, rect.start_v },
+			glm::vec2{ rect.end_h, rect.end_v },
+			glm::vec2{ rect.start_h, rect.end_v },
+		};
+		for (uint32_t i{ 0 }; i < PARTICLE_FACE_VERTEX_COUNT; ++i)
 		{
-		case VoxelSidesFlagBits::X_POSITIVE:
-			return x_;
-		case VoxelSidesFlagBits::X_NEGATIVE:
-			return x_;
-		case VoxelSidesFlagBits::Y_POSITIVE:
-			return y_;
-		case VoxelSidesFlagBits::Y_NEGATIVE:
-			return y_;
-		case VoxelSidesFlagBits::Z_POSITIVE:
-			return z_;
-		case VoxelSidesFlagBits::Z_NEGATIVE:
-			return z_;
+			glm::vec3 coord{};
+			coord[axis] = (float)rect.depth + face_offset;
+			coord[slice_axes.x] = corners[i].x - 0.5f;
+			coord[slice_axes.y] = corners[i].y - 0.5f;
+
+			out_vertices[i] = Vertex{};
+			out_vertices[i].position = glm::vec4{ PARTICLE_WIDTH * coord - object_origin, 0.0f };
+			out_vertices[i].normal = glm::vec4{ PARTICLE_FACE_NORMALS[rect.side_idx], 0.0f };
+			out_vertices[i].tangent = glm::vec4{ PARTICLE_FACE_TANGENTS[rect.side_idx], 0.0f };
 		}
 
-		logger::Error("Failed to get depth reference.\n");
-		return x_;
+		// Seems that Vulkan RT API has counter clockwise hardcoded as front face.
+		// Corners go counter clockwise around the horizontal axis crossed with the vertical axis, so flip the winding when that's not the normal.
+		glm::vec3 horizontal{};
+		glm::vec3 vertical{};
+		horizontal[slice_axes.x] = 1.0f;
+		vertical[slice_axes.y] = 1.0f;
+		bool counter_clockwise{ glm::dot(glm::cross(horizontal, vertical), PARTICLE_FACE_NORMALS[rect.side_idx]) > 0.0f };
+		const std::array<uint32_t, PARTICLE_FACE_INDEX_COUNT> indices{ counter_clockwise ?
+			std::array<uint32_t, PARTICLE_FACE_INDEX_COUNT>{ 0, 1, 2, 0, 2, 3 } :
+			std::array<uint32_t, PARTICLE_FACE_INDEX_COUNT>{ 0, 2, 1, 0, 3, 2 } };
+		for (uint32_t i{ 0 }; i < PARTICLE_FACE_INDEX_COUNT; ++i) {
+			out_indices[i] = first_vertex + indices[i];
+		}
+	}
+
+	uint32_t StaticParticleMeshGenerator::MaskIndex(uint32_t axis, uint32_t geometry_idx, uint32_t depth, uint32_t vertical) const
+	{
+		const uint32_t vertical_count{ dimensions_[PARTICLE_SLICE_AXES[axis].y] };
+		return (geometry_idx * dimensions_[axis] + depth) * vertical_count + vertical;
 	}
 }
@@ -1,142 +1,43 @@
 #pragma once
 
 #include <queue>
+#include <array>
+#include <unordered_map>
+#include <bit>
 #include "glm/glm.hpp"
 
+#include "voxel_chunk.h"
 #include "descriptor_set.h"
 #include "memory_allocator.h"
 #include "mesh.h"
 #include "pipeline.h"
+#include "particle_gen_cache.h"
+#include "fluid_surface.h"
 
 namespace renderer
 {
 	class VulkanRenderer;
 
-	// Encodes whether each of the 6 voxel neighbors are occupied or not.
-	enum class VoxelSidesFlagBits : uint8_t
-	{
-		X_POSITIVE = 0x01,
-		X_NEGATIVE = 0x02,
-		Y_POSITIVE = 0x04,
-		Y_NEGATIVE = 0x08,
-		Z_POSITIVE = 0x10,
-		Z_NEGATIVE = 0x20,
-		ALL_SIDES = 0x3F,
-	};
-
-	// Each voxel in a rigid body can be labeled based on its neighbors which is useful for collision detection. 
-	enum class VoxelGeometricFeatureType : uint8_t
-	{
-		INTERIOR,
-		CORNER,
-		EDGE,
-		FACE,
-	};
-
-	// Defined in renderer instead of Pumpkin since it's used in particle_gen.cpp.
-	constexpr uint8_t PHYSICS_MATERIAL_EMPTY_INDEX{ 0xFF };
-
-	// Particles that are not being simulated.
-	struct Voxel
-	{
-		uint8_t physics_material_index;
-	};
-
-	struct OuterVoxel
-	{
-		glm::uvec3 coord;
-		glm::vec3 normal;
-	};
-
-	class VoxelChunk
-	{
-	public:
-		VoxelChunk();
-
-		VoxelChunk(uint32_t width, uint32_t height, uint32_t depth);
-
-		VoxelChunk(uint32_t width, uint32_t height, uint32_t depth, std::vector<std::pair<Voxel, glm::uvec3>>&& voxel_pairs);
-
-		Voxel& Coordinate(uint32_t i, uint32_t j, uint32_t k);
-
-		Voxel& Coordinate(const glm::uvec3& coord);
-
-		const Voxel& Coordinate(uint32_t i, uint32_t j, uint32_t k) const;
-
-		const Voxel& Coordinate(const glm::uvec3& coord) const;
-
-		Voxel& Index(uint32_t idx);
-
-		const Voxel& Index(uint32_t idx) const;
-
-		uint32_t VoxelCount() const;
-
-		bool IsOccluded(uint32_t voxel_idx) const;
-
-		bool IsEmpty(uint32_t voxel_idx) const;
-
-		bool IsEmpty(const glm::uvec3& voxel_coord) const;
-
-		bool InBounds(const glm::uvec3& voxel_coord) const;
-
-		glm::uvec3 IndexToCoordinate(uint32_t index) const;
-
-		uint32_t CoordinateToIndex(const glm::uvec3& coord) const;
-
-		std::vector<Voxel>& GetVoxels();
-
-		std::vector<uint8_t>& GetSideFlags();
-
-		const std::vector<OuterVoxel>& GetOuterVoxels() const;
-
-		// Given a voxel-sized particle in coordinate space (one unit is one voxel width) return all possible voxels in the chunk that could collide with it.
-		// This means the voxels that are a close enough distance and not empty.
-		std::array<glm::uvec3, 8> GetPotentialCollisions(const glm::vec3& coord_space, uint32_t* potential_collision_count) const;
-
-		uint32_t GetWidth() const;
-
-		uint32_t GetHeight() const;
-
-		uint32_t GetDepth() const;
-
-		bool IsPointMass() const;
-
-	private:
-		bool FloodFillInside(const glm::uvec3& coord, const std::vector<uint8_t>& mask) const;
-
-		OuterVoxel FloodFillSet(const glm::uvec3& coord, const glm::vec3& prev_normal, std::vector<uint8_t>& mask) const;
-
-		void FloodFillScan(
-			uint32_t lx,
-			const glm::uvec3& coord,
-			uint32_t original_x,
-			int32_t y_offset,
-			int32_t z_offset,
-			std::queue<OuterVoxel>& queue,
-			const std::vector<uint8_t>& mask);
-
-		// Flood fill for gathering outer voxels and calculating their normals.
-		void OuterVoxelFloodFill(OuterVoxel&& outer_voxel, std::vector<uint8_t>& mask);
-
-		// Helper function for calculating side flags.
-		bool NeighborOccupied(glm::uvec3 coord, glm::ivec3 offset) const;
-
-		uint32_t width_{};
-		uint32_t height_{};
-		uint32_t depth_{};
-		uint32_t width_height_slice_{};
-		std::vector<Voxel> voxels_{};
-		std::vector<uint8_t> side_flags_{};
-		std::vector<OuterVoxel> outer_voxels_{}; // A list of the non-occluded voxels and their normals.
-	};
+	// Particle cubes are meshed face by face so covered faces can be skipped.
+	constexpr uint32_t PARTICLE_FACE_COUNT{ 6 };
+	constexpr uint32_t PARTICLE_FACE_VERTEX_COUNT{ 4 };
+	constexpr uint32_t PARTICLE_FACE_INDEX_COUNT{ 6 };
 
 	// Can convert static particles to this as a simplified stand-in for material point.
 	struct MaterialPosition
 	{
 		uint8_t physics_material_index;
+		uint8_t exposed_faces; // VoxelSidesFlagBits of the faces to mesh.
 		glm::vec3 position;
 	};
 
+	// Positions and exposed faces of the voxels that aren't occluded, to mesh each as a cube.
+	std::vector<MaterialPosition> VoxelChunkToMaterialPositions(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin);
+
+	// Exposed faces of the outer voxels per voxel of the chunk. The greedy mesher's time grows with the chunk's volume while few faces merge
+	// when this is high, like in noise or small chunks that are nearly all surface. Those are meshed faster as cubes, for slightly more triangles.
+	float ExposedFaceDensity(const VoxelChunk& voxel_chunk);
+
 	// Each MaterialOffset specifies a material type and range in the particle buffer.
 	struct MaterialRange
 	{
@@ -145,47 +46,70 @@ namespace renderer
 		uint32_t count;  // Count of particles with this physics material.
 	};
 
+	struct DynamicParticleMeshStats
+	{
+		uint32_t particle_count;
+		uint32_t face_count;        // Faces in the last dynamic particle mesh.
+		uint32_t culled_face_count; // Faces skipped because an adjacent particle covers them.
+		uint32_t fluid_triangle_count; // Triangles of the surfaces reconstructed for fluid materials instead of faces.
+		uint32_t box_count;         // Boxes in the last procedural particle mesh, one for each particle with an exposed face.
+	};
+
+	// Meshes the shell of a voxel chunk with as few rectangles as possible, merging exposed faces of the same physics material.
+	// Exposed faces of each slice are 64 bit masks per row. Trailing zero counts find runs of faces along a row,
+	// and runs are extended over the following rows while ANDing with them keeps the whole run. Slices are meshed in parallel.
 	class StaticParticleMeshGenerator
 	{
 	public:
-		Mesh* Generate(const VoxelChunk& voxel_chunk);
+		// One geometry per physics material, in the order of out_mat_ranges, whose counts are of voxels.
+		// Covers exactly the exposed faces that meshing every voxel as a cube would. Returns nullptr for an empty chunk.
+		Mesh* Generate(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, std::vector<MaterialRange>* out_mat_ranges);
+
+		// Same as Generate() after the voxels between min_coord and max_coord inclusive were edited since the last Generate() or Regenerate().
+		// Only the slices through the edited region and next to it are merged again, the others keep their rectangles. Every rectangle is
+		// still triangulated since the mesh is replaced whole. Falls back to Generate() if the chunk was resized or a material appeared or disappeared.
+		Mesh* Regenerate(const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord, std::vector<MaterialRange>* out_mat_ranges);
 
 	private:
 		struct Rectangle
 		{
+			uint32_t geometry_idx;
+			uint32_t side_idx;  // Bit index of the side in VoxelSidesFlagBits.
+			uint32_t depth;
 			uint32_t start_h;   // Inclusive. Horizontal start.
-			uint32_t end_h;     // Inclusive. Horizontal end.
+			uint32_t end_h;     // Exclusive. Horizontal end.
 			uint32_t start_v;   // Inclusive. Vertical start.
+			uint32_t end_v;     // Exclusive. Vertical end.
 		};
 
-		// Generate a single side of all the voxels. Will need to be called 6 times for full mesh generation.
-		void GenerateSide(VoxelSidesFlagBits side, const std::vector<Voxel>& particles, const std::vector<uint8_t>& side_flags);
+		// Build the face masks of each axis from the dense physics materials of the chunk.
+		void BuildMasks();
 
-		void TriangulateRectangle(VoxelSidesFlagBits side, uint32_t rect_idx, uint32_t vertical, uint32_t depth);
+		// Rebuild the face masks of the rows through the voxels between min_coord and max_coord inclusive.
+		void UpdateMasks(const glm::uvec3& min_coord, const glm::uvec3& max_coord);
 
-		// Clear indices to a rectangle in rectangles_ between rectangle's start and end.
-		void ClearRectangleIndices(uint32_t rect_idx);
+		void BuildMaterialRanges(std::vector<MaterialRange>* out_mat_ranges) const;
 
-		// Set indices to a rectangle in rectangles_ between rectangle's start and end.
-		void SetRectangleIndices(uint32_t rect_idx);
+		// Mesh the rectangles of every slice.
+		Mesh* Triangulate(const glm::vec3& object_origin) const;
 
-		// Get reference to chunk coordinate currently acting as the horizontal access.
-		uint32_t& GetHorizontalReference(VoxelSidesFlagBits side);
+		// Merge the exposed faces of one side of one slice into rectangles, for each geometry.
+		void MeshSlice(uint32_t side_idx, uint32_t depth, std::vector<Rectangle>* out_rectangles) const;
 
-		// Get reference to chunk coordinate currently acting as the vertical access.
-		uint32_t& GetVerticalReference(VoxelSidesFlagBits side);
+		void TriangulateRectangle(const Rectangle& rect, const glm::vec3& object_origin, uint32_t first_vertex, Vertex* out_vertices, uint32_t* out_indices) const;
 
-		// Get reference to chunk coordinate currently acting as the depth access.
-		uint32_t& GetDepthReference(VoxelSidesFlagBits side);
+		// Index of the masks of a row of a slice. The geometry after the last is the occupancy of all materials.
+		uint32_t MaskIndex(uint32_t axis, uint32_t geometry_idx, uint32_t depth, uint32_t vertical) const;
 
-		std::vector<uint32_t> rectangle_indices_{};  // rectangle_indices[j] contains the index into x_positive_partial_rectangles which contains this coordinate in its range. Otherwise contains null index.
-		std::vector<Rectangle> rectangles_{};        // The WIP rectangles that have not been triangulated yet.
-		Mesh* mesh_{};                               // The output mesh.
+		glm::uvec3 dimensions_{};
+		uint32_t geometry_count_{};
+		std::array<std::vector<uint64_t>, 3> masks_{}; // For each axis, bit h of a row is set for each occupied voxel.
 
-		// These coordinates will not be accessed directly, but instead will be reference by horizontal/vertical/depth variables.
-		uint32_t x_{};
-		uint32_t y_{};
-		uint32_t z_{};
+		// Kept between calls so Regenerate() only redoes the edited region.
+		std::vector<uint8_t> materials_{};                       // Dense physics materials of the chunk.
+		std::array<uint32_t, 256> voxel_counts_{};               // Voxels of each physics material.
+		std::array<uint32_t, 256> geometry_indices_{};           // Geometry of each physics material, NULL_INDEX if it has no voxels.
+		std::vector<std::vector<Rectangle>> slice_rectangles_{}; // Rectangles of each slice of each side.
 	};
 
 	class ParticleGenContext
@@ -238,8 +162,17 @@ namespace renderer
 
 		void CleanUp();
 
+		// Outputs come from the particle gen cache when the shader, built-in UBO and custom UBO are unchanged.
 		void InvokeParticleGenShader(RenderObjectHandle ro_target, std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags);
 
+		// Dispatch the particle gen and neighbor shaders and read the results back, bypassing the cache.
+		void DispatchParticleGenShader(std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags);
+
+		// An empty directory disables the cache.
+		void SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes);
+
+		const ParticleGenCacheStats& GetParticleGenCacheStats() const;
+
 		void SetParticleGenShader(uint32_t shader_idx, uint32_t custom_ubo_size);
 
 		void UpdateParticleGenShaderCustomUBO(const std::vector<std::byte>& custom_ubo);
@@ -252,31 +185,65 @@ namespace renderer
 		// Get the index data for a single particle, eg a cube.
 		std::vector<uint32_t> GetParticleIndices() const;
 
-		// Generates triangles for each individual particle as a cube.
+		// Generates triangles for the exposed faces of each individual particle as a cube.
 		// Positions should be an array of glm::vec3 with arbitrary stride between each. Stride is in bytes.
+		// Each particle also has a uint8_t of VoxelSidesFlagBits at exposed_faces_offset with the faces to mesh.
 		void GenerateDynamicParticleMesh(
 			RenderObjectHandle ro_target,
 			const std::byte* positions,
 			uint32_t offset,
+			uint32_t exposed_faces_offset,
+			uint32_t stride,
+			const std::vector<MaterialRange>& mat_ranges);
+
+		// Same as GenerateDynamicParticleMesh() without replacing the render object, so the particles can change after.
+		// Ranges of fluid surface materials get a reconstructed surface instead of cubes.
+		Mesh* BuildDynamicParticleMesh(
+			const std::byte* positions,
+			uint32_t offset,
+			uint32_t exposed_faces_offset,
 			uint32_t stride,
 			const std::vector<MaterialRange>& mat_ranges);
-		
+
+		// Build a procedural mesh with a box for each particle instead of triangles, which is ray traced with an intersection shader
+		// and isn't rasterized. There is a geometry for each of mat_ranges so materials come from the geometry index like other particle meshes.
+		// Particles without an exposed face in the uint8_t of VoxelSidesFlagBits at exposed_faces_offset can't be seen, so they're skipped.
+		Mesh* BuildProceduralParticleMesh(
+			const std::byte* positions,
+			uint32_t offset,
+			uint32_t exposed_faces_offset,
+			uint32_t stride,
+			const std::vector<MaterialRange>& mat_ranges);
+
+		// Replace the render object with a particle mesh that has a geometry for each of mat_ranges.
+		void ReplaceParticleMesh(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<MaterialRange>& mat_ranges);
+
+		// Same as ReplaceParticleMesh() for meshes replaced every frame. Updates the render object's buffers and BLAS in place when the mesh fits.
+		void UpdateDynamicParticleMesh(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<MaterialRange>& mat_ranges);
+
 		void SetPhysicsToRenderMaterialMap(std::vector<int>&& physics_to_render_mat_idx);
 
+		// Physics materials whose particles are meshed as a smooth surface by the CPU mesh builder, see ExtractFluidSurface().
+		void SetFluidSurfaceMaterials(std::vector<uint8_t>&& physics_material_indices);
+
 		void UpdatePhysicsRenderMaterials(RenderObjectHandle ro_target);
 
 		void CmdBegin();
 
 		// Offset and stride must be multiples of 4.
 		// Particle positions must be grouped, and correspond to mat_ranges.
+		// Only faces set in the uint8_t at exposed_faces_offset of each particle are meshed, packed without gaps.
 		void CmdGenerateDynamicParticleMesh(
 			RenderObjectHandle ro_target,
 			const std::byte* positions,
 			uint32_t position_count,
 			uint32_t offset,
+			uint32_t exposed_faces_offset,
 			uint32_t stride,
 			const std::vector<MaterialRange>& mat_ranges);
 
+		const DynamicParticleMeshStats& GetDynamicParticleMeshStats() const;
+
 		void CmdSubmit();
 
 		bool CommandsRecordedThisFrame();
@@ -284,6 +251,13 @@ namespace renderer
 		// Genereates fewest triangles possible as a shell around particle mass. Good for particles not currently being simulated.
 		void GenerateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin);
 
+		// Same as GenerateStaticParticleMesh() after the voxels between min_coord and max_coord inclusive were edited, such as by breaking a rigid body.
+		// Keeps the mesher's state for the render object, so later edits only merge the faces around them again.
+		void UpdateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord);
+
+		// Drop the mesher state kept by UpdateStaticParticleMesh(), when the render object is destroyed.
+		void ReleaseStaticParticleMesh(RenderObjectHandle ro_target);
+
 		void NextFrame();
 
 	private:
@@ -299,6 +273,18 @@ namespace renderer
 
 		FrameResources& GetCurrentFrame();
 
+		// Map the physics material of each range to its render material.
+		std::vector<int> GetRenderMaterialIndices(const std::vector<MaterialRange>& mat_ranges) const;
+
+		// Pack the index of each particle's first output face with its exposed faces, (first_face << 6) | exposed_faces,
+		// so the mesh shader knows where to write. Returns the total face count and updates the mesh stats.
+		uint32_t PackParticleFaces(
+			const std::byte* particles,
+			uint32_t particle_count,
+			uint32_t exposed_faces_offset,
+			uint32_t stride,
+			std::vector<uint32_t>* out_packed_faces);
+
 		struct ParticleGenShaderResources
 		{
 			struct BuiltInUBO
@@ -312,8 +298,11 @@ namespace renderer
 			BufferResource custom_ubo_buffer;              // User-defined ubo buffer for the particle gen shader.
 			BufferResource particle_out_buffer;            // Shader outputs particles to this buffer.
 			uint32_t shader_idx;                           // Index into user_compute_shaders_.
+			std::vector<std::byte> custom_ubo;             // Host copy of the custom UBO for cache keys.
 		}particle_gen_{};
 
+		ParticleGenCache particle_gen_cache_{};
+
 		struct ParticleNeighborShaderResources
 		{
 			DescriptorSetLayoutResource layout_resource;
@@ -342,6 +331,7 @@ namespace renderer
 
 			DescriptorSetResource descriptor_set_resource; // Descriptor set resource for user-defined particle gen shader.
 			BufferResource positions_in;                   // Non-packed position data of dynamic particles.
+			BufferResource faces_in;                       // First output face and exposed faces of each particle.
 			BufferResource vertices_out;                   // Out vertex data for particle mesh.
 			BufferResource indices_out;                    // Out index data for particle mesh.
 			BufferResource ubo_buffer;                     // UBO containing cube vertex data and position data.
@@ -364,5 +354,9 @@ namespace renderer
 
 		std::vector<int> physics_to_render_mat_idx_{}; // Convert a physics material index into a render material index. ith index is render material of ith physics material.
 		std::vector<MaterialRange> mat_ranges_{};      // Particle ranges of each physics material.
+		DynamicParticleMeshStats dynamic_particle_mesh_stats_{};
+		std::unordered_map<RenderObjectHandle, StaticParticleMeshGenerator> static_mesh_generators_{}; // Of render objects remeshed by UpdateStaticParticleMesh().
+		std::vector<uint8_t> fluid_surface_materials_{}; // Physics material indices.
+		FluidSurfaceSettings fluid_surface_settings_{};
 	};
 }
@@ -0,0 +1,234 @@
+#include "particle_gen_cache.h"
+
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include "tracy/Tracy.hpp"
+#include "logger.h"
+#include "common_constants.h"
+#include "hash_util.h"
+#include "voxel_codec.h"
+#include "particle_gen_cpu.h"
+
+namespace renderer
+{
+	const std::string PARTICLE_GEN_CACHE_EXTENSION{ ".pgc" };
+	constexpr uint32_t PARTICLE_GEN_CACHE_MAGIC{ 0x31434750 }; // "PGC1".
+
+	// Start of each entry file, followed by the built-in UBO, the custom UBO, and the compressed voxels.
+	struct ParticleGenCacheEntryHeader
+	{
+		uint32_t magic;
+		uint32_t built_in_ubo_size;
+		uint32_t custom_ubo_size;
+		uint32_t padding;
+		uint64_t shader_hash;
+	};
+
+	uint64_t ParticleGenCacheKey::Hash() const
+	{
+		uint64_t hash{ shader_hash };
+		hash = pmkutil::HashBytes(built_in_ubo.data(), built_in_ubo.size(), hash);
+		hash = pmkutil::HashBytes(custom_ubo.data(), custom_ubo.size(), hash);
+		return hash;
+	}
+
+	// Returns false if the data doesn't start with an entry header followed by the key it was stored with.
+	static bool ReadEntryHeader(const std::vector<uint8_t>& data, ParticleGenCacheEntryHeader* out_header)
+	{
+		if (data.size() < sizeof(ParticleGenCacheEntryHeader)) {
+			return false;
+		}
+		std::memcpy(out_header, data.data(), sizeof(ParticleGenCacheEntryHeader));
+
+		return out_header->magic == PARTICLE_GEN_CACHE_MAGIC &&
+			data.size() >= sizeof(ParticleGenCacheEntryHeader) + (size_t)out_header->built_in_ubo_size + out_header->custom_ubo_size;
+	}
+
+	static bool MatchesKey(const ParticleGenCacheEntryHeader& header, const std::vector<uint8_t>& data, const ParticleGenCacheKey& key)
+	{
+		if (header.shader_hash != key.shader_hash || header.built_in_ubo_size != key.built_in_ubo.size() || header.custom_ubo_size != key.custom_ubo.size()) {
+			return false;
+		}
+
+		const uint8_t* src{ data.data() + sizeof(header) };
+		return std::memcmp(src, key.built_in_ubo.data(), key.built_in_ubo.size()) == 0 &&
+			std::memcmp(src + key.built_in_ubo.size(), key.custom_ubo.data(), key.custom_ubo.size()) == 0;
+	}
+
+	void ParticleGenCache::Initialize(const std::filesystem::path& directory, uint64_t max_size_bytes)
+	{
+		directory_ = directory;
+		max_size_bytes_ = max_size_bytes;
+		recency_.clear();
+		entries_.clear();
+		stats_ = {};
+
+		if (directory_.empty()) {
+			return;
+		}
+		std::filesystem::create_directories(directory_); // Make the directory if it doesn't exist.
+
+		// Order existing entries by their last write time, which Load() refreshes, so recency carries over between sessions.
+		std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> existing{};
+		for (const auto& dir_entry : std::filesystem::directory_iterator{ directory_ })
+		{
+			if (!dir_entry.is_regular_file() || dir_entry.path().extension() != PARTICLE_GEN_CACHE_EXTENSION) {
+				continue;
+			}
+
+			uint64_t hash{};
+			std::istringstream{ dir_entry.path().stem().string() } >> std::hex >> hash;
+			entries_[hash] = Entry{ .size_bytes = dir_entry.file_size() };
+			existing.emplace_back(dir_entry.last_write_time(), hash);
+			stats_.size_bytes += dir_entry.file_size();
+		}
+
+		std::sort(existing.begin(), existing.end());
+		for (const auto& [time, hash] : existing) {
+			entries_[hash].recency = recency_.insert(recency_.end(), hash);
+		}
+		stats_.entry_count = (uint32_t)entries_.size();
+
+		EvictLeastRecentlyUsed();
+	}
+
+	bool ParticleGenCache::Load(const ParticleGenCacheKey& key, std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags)
+	{
+		ZoneScoped;
+
+		const uint64_t hash{ key.Hash() };
+		auto it{ entries_.find(hash) };
+		if (it == entries_.end())
+		{
+			++stats_.miss_count;
+			return false;
+		}
+
+		std::filesystem::path path{ EntryPath(hash) };
+		std::ifstream file{ path, std::ios::ate | std::ios::binary };
+		std::vector<uint8_t> data(file.is_open() ? (size_t)file.tellg() : 0);
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		const bool read{ file.good() };
+		file.close();
+
+		// A different key with the same hash is a miss, and its entry is replaced if this key is stored.
+		ParticleGenCacheEntryHeader header{};
+		const bool valid_header{ read && ReadEntryHeader(data, &header) };
+		if (valid_header && !MatchesKey(header, data, key))
+		{
+			++stats_.miss_count;
+			return false;
+		}
+
+		glm::uvec3 dimensions{};
+		const size_t voxels_offset{ sizeof(header) + (size_t)header.built_in_ubo_size + header.custom_ubo_size };
+		if (!valid_header ||
+			!DecodeDenseVoxels(std::vector<uint8_t>(data.begin() + voxels_offset, data.end()), &dimensions, out_voxels) ||
+			dimensions != glm::uvec3{ CHUNK_ROW_VOXEL_COUNT })
+		{
+			// Treat unreadable entries as misses and drop them.
+			logger::Error("Invalid particle gen cache entry %s.\n", path.string().c_str());
+			Remove(hash);
+			++stats_.miss_count;
+			return false;
+		}
+
+		ComputeDenseSideFlags(*out_voxels, out_side_flags);
+
+		std::error_code error{};
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+		Touch(it->second);
+		++stats_.hit_count;
+		return true;
+	}
+
+	void ParticleGenCache::Store(const ParticleGenCacheKey& key, const std::vector<Voxel>& voxels)
+	{
+		ZoneScoped;
+
+		const ParticleGenCacheEntryHeader header{
+			.magic = PARTICLE_GEN_CACHE_MAGIC,
+			.built_in_ubo_size = (uint32_t)key.built_in_ubo.size(),
+			.custom_ubo_size = (uint32_t)key.custom_ubo.size(),
+			.padding = 0,
+			.shader_hash = key.shader_hash,
+		};
+		std::vector<uint8_t> voxel_data{ EncodeDenseVoxels(glm::uvec3{ CHUNK_ROW_VOXEL_COUNT }, voxels) };
+
+		const uint64_t hash{ key.Hash() };
+		std::filesystem::path path{ EntryPath(hash) };
+		std::ofstream file{ path, std::ios::out | std::ios::binary };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(key.built_in_ubo.data()), key.built_in_ubo.size());
+		file.write(reinterpret_cast<const char*>(key.custom_ubo.data()), key.custom_ubo.size());
+		file.write(reinterpret_cast<const char*>(voxel_data.data()), voxel_data.size());
+		if (!file.good())
+		{
+			logger::Error("Failed to write particle gen cache entry %s.\n", path.string().c_str());
+			return;
+		}
+
+		const uint64_t size_bytes{ sizeof(header) + key.built_in_ubo.size() + key.custom_ubo.size() + voxel_data.size() };
+		auto [it, inserted] { entries_.try_emplace(hash) };
+		if (inserted) {
+			it->second.recency = recency_.insert(recency_.end(), hash);
+		}
+		else
+		{
+			stats_.size_bytes -= it->second.size_bytes;
+			Touch(it->second);
+		}
+		it->second.size_bytes = size_bytes;
+		stats_.size_bytes += size_bytes;
+		stats_.entry_count = (uint32_t)entries_.size();
+
+		EvictLeastRecentlyUsed();
+	}
+
+	bool ParticleGenCache::IsEnabled() const
+	{
+		return !directory_.empty();
+	}
+
+	const ParticleGenCacheStats& ParticleGenCache::GetStats() const
+	{
+		return stats_;
+	}
+
+	std::filesystem::path ParticleGenCache::EntryPath(uint64_t hash) const
+	{
+		std::ostringstream name{};
+		name << std::hex << hash << PARTICLE_GEN_CACHE_EXTENSION;
+		return directory_ / name.str();
+	}
+
+	void ParticleGenCache::Touch(Entry& entry)
+	{
+		recency_.splice(recency_.end(), recency_, entry.recency);
+	}
+
+	void ParticleGenCache::Remove(uint64_t hash)
+	{
+		auto it{ entries_.find(hash) };
+		if (it == entries_.end()) {
+			return;
+		}
+
+		std::error_code error{};
+		std::filesystem::remove(EntryPath(hash), error);
+		stats_.size_bytes -= it->second.size_bytes;
+		recency_.erase(it->second.recency);
+		entries_.erase(it);
+		stats_.entry_count = (uint32_t)entries_.size();
+	}
+
+	void ParticleGenCache::EvictLeastRecentlyUsed()
+	{
+		while (stats_.size_bytes > max_size_bytes_ && !recency_.empty()) {
+			Remove(recency_.front());
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <filesystem>
+#include <cstddef>
+#include <cstdint>
+
+namespace renderer
+{
+	struct Voxel;
+
+	struct ParticleGenCacheStats
+	{
+		uint32_t hit_count;
+		uint32_t miss_count;
+		uint32_t entry_count;
+		uint64_t size_bytes;
+	};
+
+	// Everything a particle gen shader output depends on.
+	struct ParticleGenCacheKey
+	{
+		uint64_t shader_hash;                // Hash of the shader SPIR-V.
+		std::vector<std::byte> built_in_ubo; // Includes the chunk coordinate.
+		std::vector<std::byte> custom_ubo;
+
+		// Names the entry file. Entries store the whole key, so a hash collision is a miss rather than the wrong output.
+		uint64_t Hash() const;
+	};
+
+	// Disk cache of particle gen shader outputs, one file per key.
+	// Voxels are stored compressed and side flags are recomputed on load, since they only depend on the voxels.
+	// The least recently used entries are removed once the cache grows past its size cap.
+	class ParticleGenCache
+	{
+	public:
+		// Index the entries already in the directory. An empty directory disables the cache.
+		void Initialize(const std::filesystem::path& directory, uint64_t max_size_bytes);
+
+		// Returns false on a miss.
+		bool Load(const ParticleGenCacheKey& key, std::vector<Voxel>* out_voxels, std::vector<uint8_t>* out_side_flags);
+
+		void Store(const ParticleGenCacheKey& key, const std::vector<Voxel>& voxels);
+
+		bool IsEnabled() const;
+
+		const ParticleGenCacheStats& GetStats() const;
+
+	private:
+		struct Entry
+		{
+			uint64_t size_bytes;
+			std::list<uint64_t>::iterator recency; // Position in recency_.
+		};
+
+		std::filesystem::path EntryPath(uint64_t hash) const;
+
+		// Mark the entry as the most recently used.
+		void Touch(Entry& entry);
+
+		void Remove(uint64_t hash);
+
+		void EvictLeastRecentlyUsed();
+
+		std::filesystem::path directory_{};
+		uint64_t max_size_bytes_{};
+		std::list<uint64_t> recency_{}; // Entry hashes from least to most recently used.
+		std::unordered_map<uint64_t, Entry> entries_{};
+		ParticleGenCacheStats stats_{};
+	};
+}
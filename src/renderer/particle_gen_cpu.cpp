@@ -0,0 +1,127 @@
+#include "particle_gen_cpu.h"
+
+#include <execution>
+#include <algorithm>
+#include <ranges>
+#include <cstring>
+#include "tracy/Tracy.hpp"
+#include "common_constants.h"
+
+namespace renderer
+{
+	constexpr uint8_t PHYSICS_MATERIAL_BOUNCY_INDEX{ 0 };
+	constexpr uint8_t PHYSICS_MATERIAL_LIQUID_INDEX{ 1 };
+	constexpr uint8_t PHYSICS_MATERIAL_STONE_INDEX{ 1 };
+	constexpr uint8_t BOX_FILL_OUTSIDE_INDEX{ 0 }; // particle_gen_cube.comp writes 0 outside the box, which is a material and not empty.
+
+	// Copy the custom UBO into its parameter struct. Missing bytes are left zero.
+	template<typename T>
+	static T ReadCustomUBO(const std::vector<std::byte>& custom_ubo)
+	{
+		T parameters{};
+		std::memcpy(&parameters, custom_ubo.data(), std::min(sizeof(T), custom_ubo.size()));
+		return parameters;
+	}
+
+	// Like rb.comp, doesn't depend on the chunk coordinate.
+	void SphereProductKernel(uint32_t y, uint32_t z, const ParticleGenBuiltIns&, const std::vector<std::byte>& custom_ubo, Voxel* out_row)
+	{
+		const SphereProductParameters parameters{ ReadCustomUBO<SphereProductParameters>(custom_ubo) };
+		const glm::vec3 sphere_center{ 32.0f, 16.0f, 32.0f };
+		const uint8_t outside{ y == 0 ? PHYSICS_MATERIAL_BOUNCY_INDEX : PHYSICS_MATERIAL_EMPTY_INDEX };
+
+		// Selects instead of branches so the row vectorizes.
+		for (uint32_t x{ 0 }; x < CHUNK_ROW_VOXEL_COUNT; ++x)
+		{
+			glm::vec3 coord{ (float)x, (float)y, (float)z };
+			float d0{ glm::distance(coord, sphere_center) };
+			float d1{ glm::distance(coord, parameters.center) };
+			uint8_t inside{ d0 < d1 ? PHYSICS_MATERIAL_LIQUID_INDEX : PHYSICS_MATERIAL_BOUNCY_INDEX };
+			out_row[x].physics_material_index = (d0 * d1 < parameters.radius) ? inside : outside;
+		}
+	}
+
+	// Like particle_gen_cube.comp, doesn't depend on the chunk coordinate.
+	void BoxFillKernel(uint32_t y, uint32_t z, const ParticleGenBuiltIns&, const std::vector<std::byte>& custom_ubo, Voxel* out_row)
+	{
+		const BoxFillParameters parameters{ ReadCustomUBO<BoxFillParameters>(custom_ubo) };
+		const glm::vec3 box_min{ parameters.center - parameters.radius };
+		const glm::vec3 box_max{ parameters.center + parameters.radius };
+		const bool row_inside{ (float)y > box_min.y && (float)y < box_max.y && (float)z > box_min.z && (float)z < box_max.z };
+
+		for (uint32_t x{ 0 }; x < CHUNK_ROW_VOXEL_COUNT; ++x)
+		{
+			bool inside{ row_inside && (float)x > box_min.x && (float)x < box_max.x };
+			out_row[x].physics_material_index = inside ? PHYSICS_MATERIAL_STONE_INDEX : BOX_FILL_OUTSIDE_INDEX;
+		}
+	}
+
+	void ComputeDenseSideFlags(const std::vector<Voxel>& voxels, std::vector<uint8_t>* out_side_flags)
+	{
+		ZoneScoped;
+
+		constexpr uint32_t n{ CHUNK_ROW_VOXEL_COUNT };
+		out_side_flags->clear();
+		out_side_flags->resize(CHUNK_TOTAL_VOXEL_COUNT);
+
+		// Neighbors outside of the chunk are empty.
+		auto occupied = [&](uint32_t idx) {
+			return voxels[idx].physics_material_index != PHYSICS_MATERIAL_EMPTY_INDEX;
+			};
+
+		auto rows{ std::views::iota(0u, n * n) };
+		std::for_each(std::execution::par, rows.begin(), rows.end(),
+			[&](uint32_t row) {
+				uint32_t y{ row % n };
+				uint32_t z{ row / n };
+				for (uint32_t x{ 0 }; x < n; ++x)
+				{
+					uint32_t idx{ row * n + x };
+					uint8_t flags{ 0 };
+					flags |= (x != n - 1 && occupied(idx + 1)) ? (uint8_t)VoxelSidesFlagBits::X_POSITIVE : 0;
+					flags |= (x != 0 && occupied(idx - 1)) ? (uint8_t)VoxelSidesFlagBits::X_NEGATIVE : 0;
+					flags |= (y != n - 1 && occupied(idx + n)) ? (uint8_t)VoxelSidesFlagBits::Y_POSITIVE : 0;
+					flags |= (y != 0 && occupied(idx - n)) ? (uint8_t)VoxelSidesFlagBits::Y_NEGATIVE : 0;
+					flags |= (z != n - 1 && occupied(idx + n * n)) ? (uint8_t)VoxelSidesFlagBits::Z_POSITIVE : 0;
+					flags |= (z != 0 && occupied(idx - n * n)) ? (uint8_t)VoxelSidesFlagBits::Z_NEGATIVE : 0;
+					(*out_side_flags)[idx] = flags;
+				}
+			});
+	}
+
+	void InvokeParticleGenKernel(
+		ParticleGenKernel kernel,
+		const ParticleGenBuiltIns& built_ins,
+		const std::vector<std::byte>& custom_ubo,
+		std::vector<Voxel>* out_voxels,
+		std::vector<uint8_t>* out_side_flags)
+	{
+		ZoneScoped;
+
+		constexpr uint32_t n{ CHUNK_ROW_VOXEL_COUNT };
+		out_voxels->clear();
+		out_voxels->resize(CHUNK_TOTAL_VOXEL_COUNT);
+
+		auto rows{ std::views::iota(0u, n * n) };
+		std::for_each(std::execution::par, rows.begin(), rows.end(),
+			[&](uint32_t row) {
+				kernel(row % n, row / n, built_ins, custom_ubo, out_voxels->data() + row * n);
+			});
+
+		ComputeDenseSideFlags(*out_voxels, out_side_flags);
+	}
+
+	VoxelChunk GenerateKernelChunk(ParticleGenKernel kernel, const glm::ivec3& chunk_coord, const std::vector<std::byte>& custom_ubo)
+	{
+		ZoneScoped;
+
+		std::vector<Voxel> voxels{};
+		std::vector<uint8_t> side_flags{};
+		InvokeParticleGenKernel(kernel, ParticleGenBuiltIns{ .chunk_coordinate = chunk_coord }, custom_ubo, &voxels, &side_flags);
+
+		VoxelChunk chunk{ CHUNK_ROW_VOXEL_COUNT, CHUNK_ROW_VOXEL_COUNT, CHUNK_ROW_VOXEL_COUNT };
+		chunk.AssignDense(voxels, side_flags);
+		chunk.RebuildOuterVoxels();
+		return chunk;
+	}
+}
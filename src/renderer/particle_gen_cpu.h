@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "voxel_chunk.h"
+
+namespace renderer
+{
+	// Same data as the BuiltInUBO of particle gen shaders.
+	struct ParticleGenBuiltIns
+	{
+		glm::ivec3 chunk_coordinate;
+	};
+
+	// Fills one row of voxels along x at the given y and z, like one row of invocations of a particle gen shader.
+	// custom_ubo has the same layout as the CustomUBO of the equivalent shader.
+	using ParticleGenKernel = void(*)(uint32_t y, uint32_t z, const ParticleGenBuiltIns& built_ins, const std::vector<std::byte>& custom_ubo, Voxel* out_row);
+
+	// Custom UBO of SphereProductKernel, matching rb.comp.
+	struct SphereProductParameters
+	{
+		float radius;
+		glm::vec3 center;
+	};
+
+	// Custom UBO of BoxFillKernel, matching particle_gen_cube.comp.
+	struct BoxFillParameters
+	{
+		float radius;     // Half width of the box.
+		glm::vec3 center;
+	};
+
+	// Voxels where the product of the distances to a fixed sphere center and to the custom center is below the radius,
+	// liquid when nearer the fixed center and bouncy otherwise, with a bouncy floor. Same rules as rb.comp.
+	void SphereProductKernel(uint32_t y, uint32_t z, const ParticleGenBuiltIns& built_ins, const std::vector<std::byte>& custom_ubo, Voxel* out_row);
+
+	// Fill an axis-aligned box with stone, and the rest of the chunk with material 0. Same rules as particle_gen_cube.comp.
+	void BoxFillKernel(uint32_t y, uint32_t z, const ParticleGenBuiltIns& built_ins, const std::vector<std::byte>& custom_ubo, Voxel* out_row);
+
+	// Side flags of a dense chunk of CHUNK_ROW_VOXEL_COUNT voxels per dimension, the same as particle_neighbors.comp.
+	void ComputeDenseSideFlags(const std::vector<Voxel>& voxels, std::vector<uint8_t>* out_side_flags);
+
+	// CPU equivalent of ParticleGenContext::InvokeParticleGenShader() that needs no Vulkan device.
+	// Rows are generated in parallel, then side flags are computed with ComputeDenseSideFlags().
+	void InvokeParticleGenKernel(
+		ParticleGenKernel kernel,
+		const ParticleGenBuiltIns& built_ins,
+		const std::vector<std::byte>& custom_ubo,
+		std::vector<Voxel>* out_voxels,
+		std::vector<uint8_t>* out_side_flags);
+
+	// Chunk of CHUNK_ROW_VOXEL_COUNT voxels per dimension filled by the kernel, such as for a ChunkStreamer generator.
+	VoxelChunk GenerateKernelChunk(ParticleGenKernel kernel, const glm::ivec3& chunk_coord, const std::vector<std::byte>& custom_ubo);
+}
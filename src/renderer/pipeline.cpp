@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <execution>
 #include "volk.h"
 
 #include "logger.h"
@@ -11,6 +12,13 @@
 
 namespace renderer
 {
+	void CreatePipelinesInParallel(const std::vector<std::function<void()>>& create_pipelines)
+	{
+		std::for_each(std::execution::par, create_pipelines.begin(), create_pipelines.end(), [](const std::function<void()>& create_pipeline) {
+			create_pipeline();
+			});
+	}
+
 	void CreatePipelineLayout(
 		VkDevice device,
 		const std::vector<DescriptorSetLayoutResource>& set_layouts,
@@ -274,7 +282,7 @@ namespace renderer
 			.basePipelineIndex = 0,
 		};
 
-		VkResult result{ vkCreateGraphicsPipelines(context_->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) };
+		VkResult result{ vkCreateGraphicsPipelines(context_->device, context_->pipeline_cache, 1, &pipeline_info, nullptr, &pipeline) };
 		CheckResult(result, "Failed to create graphics pipeline.");
 
 		vkDestroyShaderModule(context_->device, vertex_shader, nullptr);
@@ -313,7 +321,7 @@ namespace renderer
 			.basePipelineIndex = -1,
 		};
 
-		VkResult result{ vkCreateComputePipelines(context_->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline) };
+		VkResult result{ vkCreateComputePipelines(context_->device, context_->pipeline_cache, 1, &pipeline_info, nullptr, &pipeline) };
 		CheckResult(result, "Failed to create compute pipeline.");
 
 		vkDestroyShaderModule(context_->device, shader, nullptr);
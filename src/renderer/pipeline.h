@@ -2,6 +2,7 @@
 
 #include <string>
 #include <filesystem>
+#include <functional>
 #include "volk.h"
 
 #include "context.h"
@@ -10,6 +11,10 @@
 
 namespace renderer
 {
+	// Run functions that each create independent pipelines on worker threads, returning once all are done.
+	// Pipeline creation and the shared pipeline cache are thread safe, but the functions mustn't record or submit commands.
+	void CreatePipelinesInParallel(const std::vector<std::function<void()>>& create_pipelines);
+
 	class GraphicsPipeline
 	{
 	public:
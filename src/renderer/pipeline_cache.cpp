@@ -0,0 +1,135 @@
+#include "pipeline_cache.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include "tracy/Tracy.hpp"
+
+#include "logger.h"
+#include "vulkan_util.h"
+#include "hash_util.h"
+
+namespace renderer
+{
+	const std::string PIPELINE_CACHE_EXTENSION{ ".bin" };
+
+	void PipelineCache::Initialize(Context* context, const std::filesystem::path& directory)
+	{
+		ZoneScoped;
+
+		context_ = context;
+		stats_ = {};
+		vkGetPhysicalDeviceProperties(context_->physical_device, &device_properties_);
+
+		std::ostringstream name{};
+		name << std::hex << std::setfill('0');
+		for (uint8_t byte : device_properties_.pipelineCacheUUID) {
+			name << std::setw(2) << (uint32_t)byte;
+		}
+		name << "_" << std::setw(8) << device_properties_.driverVersion << PIPELINE_CACHE_EXTENSION;
+		path_ = directory / name.str();
+
+		std::error_code error{};
+		std::filesystem::create_directories(directory, error); // Make the directory if it doesn't exist.
+
+		std::ifstream file{ path_, std::ios::ate | std::ios::binary };
+		std::vector<uint8_t> data(file.is_open() ? (size_t)file.tellg() : 0);
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+		if (!data.empty() && (!file.good() || !IsCompatible(data)))
+		{
+			logger::Error("Ignoring invalid pipeline cache %s.\n", path_.string().c_str());
+			data.clear();
+		}
+
+		VkPipelineCacheCreateInfo cache_info{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.flags = 0, // Pipelines are created on several threads, so the driver synchronizes access.
+			.initialDataSize = data.size(),
+			.pInitialData = data.data(),
+		};
+
+		VkResult result{ vkCreatePipelineCache(context_->device, &cache_info, nullptr, &context_->pipeline_cache) };
+		CheckResult(result, "Failed to create pipeline cache.");
+		NameObject(context_->device, context_->pipeline_cache, "Pipeline_Cache");
+
+		stats_.warm = !data.empty();
+		stats_.loaded_bytes = data.size();
+		saved_hash_ = pmkutil::HashBytes(data.data(), data.size());
+	}
+
+	void PipelineCache::CleanUp()
+	{
+		Save();
+		vkDestroyPipelineCache(context_->device, context_->pipeline_cache, nullptr);
+		context_->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	void PipelineCache::Save()
+	{
+		ZoneScoped;
+
+		size_t size{};
+		VkResult result{ vkGetPipelineCacheData(context_->device, context_->pipeline_cache, &size, nullptr) };
+		CheckResult(result, "Failed to get pipeline cache size.");
+
+		std::vector<uint8_t> data(size);
+		result = vkGetPipelineCacheData(context_->device, context_->pipeline_cache, &size, data.data());
+		CheckResult(result, "Failed to get pipeline cache data.");
+		data.resize(size);
+
+		uint64_t hash{ pmkutil::HashBytes(data.data(), data.size()) };
+		if (hash == saved_hash_) {
+			return;
+		}
+
+		// Write a temporary file then replace the cache, so a crash mid write doesn't leave a truncated cache.
+		std::filesystem::path temp_path{ path_ };
+		temp_path += ".tmp";
+		std::ofstream file{ temp_path, std::ios::out | std::ios::binary };
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		file.close();
+
+		std::error_code error{};
+		if (!file.fail()) {
+			std::filesystem::rename(temp_path, path_, error);
+		}
+		if (file.fail() || error)
+		{
+			logger::Error("Failed to write pipeline cache %s.\n", path_.string().c_str());
+			std::filesystem::remove(temp_path, error);
+			return;
+		}
+
+		saved_hash_ = hash;
+		stats_.saved_bytes = data.size();
+	}
+
+	void PipelineCache::SetStartupTime(float milliseconds)
+	{
+		stats_.startup_ms = milliseconds;
+		logger::Print("Renderer initialized in %.1f ms with a %s pipeline cache.\n\n", milliseconds, stats_.warm ? "warm" : "cold");
+	}
+
+	const PipelineCacheStats& PipelineCache::GetStats() const
+	{
+		return stats_;
+	}
+
+	bool PipelineCache::IsCompatible(const std::vector<uint8_t>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header{};
+		if (data.size() < sizeof(header)) {
+			return false;
+		}
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header) &&
+			header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.vendorID == device_properties_.vendorID &&
+			header.deviceID == device_properties_.deviceID &&
+			std::memcmp(header.pipelineCacheUUID, device_properties_.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
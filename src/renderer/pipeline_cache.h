@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include "volk.h"
+
+#include "context.h"
+
+namespace renderer
+{
+	struct PipelineCacheStats
+	{
+		bool warm;             // Cache data for this device and driver was loaded from disk.
+		uint64_t loaded_bytes;
+		uint64_t saved_bytes;
+		float startup_ms;      // Time the renderer took to initialize, which is mostly pipeline creation.
+	};
+
+	// VkPipelineCache shared by all pipeline creation through Context::pipeline_cache, and saved to disk between sessions.
+	// The file is named after the device's pipeline cache UUID and driver version, so a driver update starts a new cache
+	// instead of handing the driver data it can't use.
+	class PipelineCache
+	{
+	public:
+		// Load the cache for this device from the directory, or start empty if there isn't one.
+		void Initialize(Context* context, const std::filesystem::path& directory);
+
+		// Save then destroy the cache. Must be called before the device is destroyed.
+		void CleanUp();
+
+		// Write the cache to disk if pipelines were added since it was loaded or last saved.
+		void Save();
+
+		void SetStartupTime(float milliseconds);
+
+		const PipelineCacheStats& GetStats() const;
+
+	private:
+		// Check the header against this device, since some drivers don't validate data passed to vkCreatePipelineCache.
+		bool IsCompatible(const std::vector<uint8_t>& data) const;
+
+		Context* context_{};
+		VkPhysicalDeviceProperties device_properties_{};
+		std::filesystem::path path_{};
+		uint64_t saved_hash_{}; // Hash of the data last loaded or saved, to skip writing an unchanged cache.
+		PipelineCacheStats stats_{};
+	};
+}
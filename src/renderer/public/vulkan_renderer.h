@@ -11,6 +11,7 @@
 #include "context.h"
 #include "swapchain.h"
 #include "pipeline.h"
+#include "pipeline_cache.h"
 #include "memory_allocator.h"
 #include "mesh.h"
 #include "vulkan_util.h"
@@ -21,6 +22,7 @@
 #include "render_object.h"
 #include "renderer_constants.h"
 #include "particle_gen.h"
+#include "particle_gen_cpu.h"
 
 namespace renderer
 {
@@ -58,24 +60,81 @@ namespace renderer
 
 		void UpdateParticleGenShaderCustomUBO(const std::vector<std::byte>& custom_ubo);
 
-		// Generates triangles for each individual particle as a cube.
+		// Run the current particle gen shader and the CPU kernel with the same custom UBO, and return the number of voxels whose
+		// material or side flags differ. The custom UBO of the shader is left set to custom_ubo.
+		uint32_t ValidateParticleGenKernel(ParticleGenKernel kernel, const std::vector<std::byte>& custom_ubo);
+
+		// Cache particle gen shader outputs in the directory, up to max_size_bytes. An empty directory disables the cache.
+		void SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes);
+
+		const ParticleGenCacheStats& GetParticleGenCacheStats() const;
+
+		// Face counts of the last dynamic particle mesh, including faces culled because they are covered by other particles.
+		const DynamicParticleMeshStats& GetDynamicParticleMeshStats() const;
+
+		// Instance counts of the last TLAS, whether it was refit or rebuilt, and how long its build took on the GPU.
+		const TlasBuildStats& GetTlasBuildStats() const;
+
+		// How many times dynamic render object BLASes were refit, rebuilt in place, or outgrew their buffers.
+		const DynamicBlasStats& GetDynamicBlasStats() const;
+
+		// Bytes and batches uploaded on the transfer queue, and how often the host waited for staging space.
+		const UploaderStats& GetUploaderStats() const;
+
+		// Indexed by VkPhysicalDeviceMemoryProperties::memoryHeaps.
+		std::vector<MemoryHeapStats> GetMemoryHeapStats() const;
+
+		const PipelineCacheStats& GetPipelineCacheStats() const;
+
+		const RasterPassStats& GetRasterPassStats() const;
+
+		// Generates triangles for the exposed faces of each individual particle as a cube on the CPU,
+		// or a smooth surface for fluid surface materials. The mesh is built immediately, so the particles can change after,
+		// and the render object is replaced at the next HostRenderWork().
 		// Positions should be an array of glm::vec3 with arbitrary stride between each. Stride is in bytes.
-		void GenerateDynamicParticleMesh(RenderObjectHandle ro_target, const std::byte* positions, uint32_t position_count, uint32_t offset, uint32_t stride);
+		// exposed_faces_offset is the byte offset of a uint8_t of VoxelSidesFlagBits with the faces to mesh.
+		// Particle positions must be grouped, and correspond to mat_ranges.
+		void GenerateDynamicParticleMesh(
+			RenderObjectHandle ro_target,
+			const std::byte* positions,
+			uint32_t offset,
+			uint32_t exposed_faces_offset,
+			uint32_t stride,
+			const std::vector<MaterialRange>& mat_ranges);
+
+		// Same as GenerateDynamicParticleMesh() with a box per particle for an intersection shader instead of triangles,
+		// so only 24 bytes per particle are uploaded and refit. The render object is ray traced but not rasterized.
+		void GenerateProceduralParticleMesh(
+			RenderObjectHandle ro_target,
+			const std::byte* positions,
+			uint32_t offset,
+			uint32_t exposed_faces_offset,
+			uint32_t stride,
+			const std::vector<MaterialRange>& mat_ranges);
 
 		// Record commands to generate dynamic particle mesh in graphics queue, and replace the target render object.
+		// Only the exposed faces of each particle are meshed, see GenerateDynamicParticleMesh().
 		void CmdGenerateDynamicParticleMesh(
 			RenderObjectHandle ro_target,
 			const std::byte* positions,
 			uint32_t position_count,
 			uint32_t offset,
+			uint32_t exposed_faces_offset,
 			uint32_t stride,
 			const std::vector<MaterialRange>& mat_ranges);
 
 		// Genereates fewest triangles possible as a shell around particle mass. Good for particles not currently being simulated.
 		void GenerateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin = {});
 
+		// Same as GenerateStaticParticleMesh() after the voxels between min_coord and max_coord inclusive were edited.
+		// Only the faces of the slices around the edit are merged again.
+		void UpdateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord);
+
 		void ImportShader(const std::filesystem::path& spirv_path);
 
+		// Create the pipelines of several user shaders in parallel, in the order of spirv_paths.
+		void ImportShaders(const std::vector<std::filesystem::path>& spirv_paths);
+
 		// Queue work to be done at the next HostRenderWork() invocation.
 		void QueueHostRenderWork(std::function<void()> func);
 
@@ -96,8 +155,16 @@ namespace renderer
 		// Get a blank render object to be used as a render object target when generating a mesh later.
 		RenderObjectHandle CreateBlankRenderObject();
 
+		// The mesh is uploaded on the transfer queue, and its BLAS is built in the next frame's command buffer.
 		void ReplaceRenderObjectAndBuildBlas(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices);
 
+		// For meshes replaced every frame. Takes ownership of a mesh with only CPU side geometry. If it fits in the buffers of the
+		// render object's last dynamic mesh, its geometry is copied into them and their BLAS is refit or rebuilt in place.
+		// Otherwise the render object is replaced by the mesh, with buffers and a BLAS that have room to grow.
+		// The copies and BLAS build are recorded into the current frame's command buffer. Meshes may be procedural.
+		// Call only during HostRenderWork(), after the current frame's last submission has finished.
+		void UpdateDynamicRenderObject(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices);
+
 		// Will replace the render object during the next HostRenderWork() invocation.
 		void QueueReplaceRenderObject(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices);
 
@@ -146,6 +213,9 @@ namespace renderer
 
 		void SetPhysicsToRenderMaterialMap(std::vector<int>&& physics_to_render_mat_idx);
 
+		// Physics materials meshed as a smooth fluid surface by GenerateDynamicParticleMesh().
+		void SetFluidSurfaceMaterials(std::vector<uint8_t>&& physics_material_indices);
+
 		void UpdatePhysicsRenderMaterials(RenderObjectHandle ro_target);
 
 		void SetMaterialIndex(RenderObjectHandle render_object_handle, uint32_t geometry_index, int material_index);
@@ -246,7 +316,15 @@ namespace renderer
 
 		void InitializeDescriptorSetLayouts();
 
-		void UploadMeshToDevice(VulkanUtil& vulkan_util, Mesh& mesh);
+		// Create the mesh's geometry buffers and upload them on the transfer queue.
+		// Its BLAS should be queued, so it's built by the next frame after the upload.
+		void UploadMeshToDevice(Mesh& mesh);
+
+		// Write data to the current frame's dynamic mesh staging buffer, and queue a copy from there to the start of dst.
+		void QueueDynamicMeshCopy(const void* data, VkDeviceSize size, VkBuffer dst);
+
+		// Record the current frame's queued dynamic mesh copies, with barriers for the BLAS builds and draws that read them.
+		void CmdCopyDynamicMeshes(VkCommandBuffer cmd);
 
 		// Pass last_resource as true if all the other frame resources corresponding render objects have already been destroyed.
 		void DestroyRenderObject(RenderObject* ro_ptr, bool last_resource);
@@ -257,10 +335,62 @@ namespace renderer
 
 		void ReplaceRenderObject(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices);
 
+		// Queue a render object's data to be written to every frame's object data buffer once that frame is no longer in use.
+		void QueueObjectDataWrite(RenderObjectHandle render_object_handle);
+
+		// Grow the current frame's object data buffer to fit every render object, write queued object data and flush every write this frame.
+		// Call only after the current frame's last submission has finished.
+		void UpdateObjectDataBuffer();
+
+		// Copy objects into the mapped buffer. They are flushed together by UpdateObjectDataBuffer().
+		void WriteObjectData(FrameResources& frame, uint32_t first, uint32_t count);
+
+		// Rebuild every frame's indirect draws before its next raster pass.
+		void MarkRasterDrawsDirty();
+
+		// Rebuild the current frame's indirect draws and shared index buffer copies if render objects changed since they were built.
+		// Call only after the current frame's last submission has finished.
+		void UpdateRasterDraws();
+
+		// Copy geometry indices into the current frame's shared raster index buffer. Record after the dynamic mesh copies.
+		void CmdCopyRasterIndices(VkCommandBuffer cmd);
+
 		struct FrameResources
 		{
 			std::vector<RenderObject*> render_objects;
 
+			// Array of RenderObject::ObjectData indexed by render object handle, bound once per pass.
+			// Stays mapped, and only objects whose data changed are written.
+			BufferResource object_data_buffer;
+			RenderObject::ObjectData* object_data_mapped;
+			DescriptorSetResource object_data_descriptor_set_resource;
+			uint32_t object_data_capacity;
+			std::vector<uint32_t> queued_object_data_writes;
+			uint32_t dirty_object_data_begin; // Range of objects written since the last flush.
+			uint32_t dirty_object_data_end;
+
+			// One indirect draw for each geometry of each render object, so the raster pass is a single bind and draw call.
+			BufferResource raster_draw_buffer; // Array of RasterDraw.
+			RasterDraw* raster_draws_mapped;
+			BufferResource raster_indirect_buffer; // Array of VkDrawIndexedIndirectCommand.
+			VkDrawIndexedIndirectCommand* raster_indirect_mapped;
+			uint32_t raster_draw_capacity;
+			uint32_t raster_draw_count;
+			bool raster_draws_dirty;
+
+			// Indices of every rasterized geometry copied into one buffer, so the draws can be indexed from a single bound index buffer.
+			// A geometry drawn by many render objects is copied once. Dynamic geometries change in place, so they are copied every frame.
+			BufferResource raster_index_buffer;
+			uint32_t raster_index_capacity;
+			std::vector<std::pair<VkBuffer, VkBufferCopy>> raster_index_copies;         // Copies to record this frame.
+			std::vector<std::pair<VkBuffer, VkBufferCopy>> dynamic_raster_index_copies; // Copies of dynamic geometries, repeated each frame.
+
+			// Dynamic meshes are updated in place by copies recorded into this frame's command buffer, since earlier frames may still read them.
+			BufferResource dynamic_mesh_staging_buffer;
+			std::byte* dynamic_mesh_staging_mapped;
+			VkDeviceSize dynamic_mesh_staging_size; // Bytes written since the last copies were recorded.
+			std::vector<std::pair<VkBuffer, VkBufferCopy>> queued_dynamic_mesh_copies;
+
 			struct RasterizationCameraUBO
 			{
 				glm::mat4 projection_view;
@@ -275,8 +405,6 @@ namespace renderer
 			VkSemaphore image_acquired_semaphore;
 			VkSemaphore render_done_semaphore;
 
-			AccelerationStructure* tlas;
-
 #ifndef EDITOR_ENABLED
 			// Only used when EDITOR_ENABLED is not defined, since ImguiBackend has ownership over these otherwise.
 			// This is not in the Swapchain class since we only need frame-in-flight number depth images.
@@ -293,12 +421,14 @@ namespace renderer
 #endif
 
 		Context context_{};
+		PipelineCache pipeline_cache_{};
 		Swapchain swapchain_{};
 		GraphicsPipeline raster_pipeline_{};
 		GraphicsPipeline composite_pipeline_{};
 		VkCommandPool command_pool_{};
 		Allocator allocator_{};
 		DescriptorAllocator descriptor_allocator_{};
+		Uploader uploader_{};
 		VulkanUtil vulkan_util_{};
 		RayTracingContext rt_context_{};
 		ParticleGenContext particle_gen_context_{};
@@ -307,6 +437,7 @@ namespace renderer
 		std::vector<Material*> materials_{};                   // All materials referenced by geometries. Buffer resource for materials is in RayTracingContext.
 		std::vector<ImageResource*> textures_{};               // All textures referenced by materials.
 		std::vector<ComputePipeline*> user_compute_shaders_{}; // All user-defined compute shaders.
+		std::vector<uint64_t> user_compute_shader_hashes_{};   // Hash of the SPIR-V of each user-defined compute shader.
 		std::unordered_map<uint64_t, std::pair<uint64_t, uint32_t>> mesh_hash_map_{}; // To prevent duplicating vertex data when loading same file multiple times. (vertex_hash, (index_hash, mesh_idx)).
 		DescriptorSetLayoutResource camera_layout_resource_{};
 		DescriptorSetLayoutResource render_object_layout_resource_{};
@@ -316,6 +447,9 @@ namespace renderer
 		RenderObjectDestroyer render_object_destroyer_{};               // Render objects can't be destroyed while they're in use rendering in previous frame, so use special destroyer class.
 		bool should_update_materials_{};
 		bool should_update_object_buffers_{};
+		uint32_t max_draw_indirect_count_{}; // Most draws a single indirect draw call can issue.
+		DynamicBlasStats dynamic_blas_stats_{};
+		RasterPassStats raster_pass_stats_{};
 
 		uint32_t current_frame_{};
 		std::array<FrameResources, FRAMES_IN_FLIGHT> frame_resources_{};
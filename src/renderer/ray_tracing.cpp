@@ -13,6 +13,7 @@ namespace renderer
 	constexpr uint32_t TLAS_BINDING{ 0 };
 	constexpr uint32_t IMAGE_BUFFER_BINDING{ 1 };
 	constexpr uint32_t CAMERA_UBO_BINDING{ 2 };
+	constexpr uint32_t INSTANCE_HANDLES_BINDING{ 3 };
 
 	// Set 1 of rt pipeline. Persistent set.
 	constexpr uint32_t OBJECT_BUFFERS_BINDING{ 0 };
@@ -24,15 +25,21 @@ namespace renderer
 	constexpr uint32_t RAYCAST_TLAS_BINDING{ 0 };
 	constexpr uint32_t RAYCASTS_BUFFER_BINDING{ 1 };
 	constexpr uint32_t RAYHITS_BUFFER_BINDING{ 2 };
+	constexpr uint32_t RAYCAST_INSTANCE_HANDLES_BINDING{ 3 };
+	constexpr uint32_t RAYCAST_OBJECT_BUFFERS_BINDING{ 4 };
+
+	// Hit groups of both pipelines, picked by the SBT record offset of each instance.
+	constexpr uint32_t TRIANGLE_HIT_GROUP{ 0 };
+	constexpr uint32_t PARTICLE_HIT_GROUP{ 1 };
 
 	std::vector<VkAccelerationStructureBuildRangeInfoKHR> GetGeometryBuildRanges(const std::vector<Geometry>& geometries)
 	{
-		// Get number of triangles in each geometry.
+		// Get number of triangles, or boxes of procedural geometries, in each geometry.
 		std::vector<VkAccelerationStructureBuildRangeInfoKHR> build_ranges(geometries.size());
 		std::transform(geometries.begin(), geometries.end(), build_ranges.begin(),
 			[](const Geometry& x) {
 				VkAccelerationStructureBuildRangeInfoKHR build_range{
-					.primitiveCount = (uint32_t)x.indices.size() / 3,
+					.primitiveCount = x.aabbs.empty() ? (uint32_t)x.indices.size() / 3 : (uint32_t)x.aabbs.size(),
 					.primitiveOffset = 0,
 					.firstVertex = 0,
 					.transformOffset = 0,
@@ -42,6 +49,16 @@ namespace renderer
 		return build_ranges;
 	}
 
+	// Whether b can be written over a in an acceleration structure update, which may only change transforms.
+	bool CanRefitInstance(const VkAccelerationStructureInstanceKHR& a, const VkAccelerationStructureInstanceKHR& b)
+	{
+		return a.instanceCustomIndex == b.instanceCustomIndex &&
+			a.mask == b.mask &&
+			a.instanceShaderBindingTableRecordOffset == b.instanceShaderBindingTableRecordOffset &&
+			a.flags == b.flags &&
+			a.accelerationStructureReference == b.accelerationStructureReference;
+	}
+
 	void RayTracingContext::Initialize(Context* context,
 		VulkanRenderer* renderer,
 		Allocator* allocator,
@@ -65,10 +82,34 @@ namespace renderer
 
 		// Get acceleration structure properties to reference throughout lifetime of RT context.
 		vkGetPhysicalDeviceProperties2(context->physical_device, &physical_device_properties);
+		timestamp_period_ = physical_device_properties.properties.limits.timestampPeriod;
+
+		VkQueryPoolCreateInfo query_pool_info{
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = 2,
+		};
+
+		for (FrameResources& frame : frame_resources_)
+		{
+			VkResult result{ vkCreateQueryPool(context_->device, &query_pool_info, nullptr, &frame.timestamp_query_pool_) };
+			CheckResult(result, "Failed to create TLAS timestamp query pool.");
+		}
 
 		CreateDescriptorSets();
-		CreateRtPipelineAndShaderBindingTable();
-		CreateRaycastPipelineAndShaderBindingTable();
+
+		// The pipelines compile in parallel. Their SBTs are built afterwards, since building submits an upload.
+		ShaderBindingTableBuilder rt_sbt_builder{};
+		ShaderBindingTableBuilder raycast_sbt_builder{};
+		CreatePipelinesInParallel({
+			[&]() { CreateRtPipeline(&rt_sbt_builder); },
+			[&]() { CreateRaycastPipeline(&raycast_sbt_builder); },
+		});
+
+		rt_shader_binding_table_ = rt_sbt_builder.Build(rt_pipeline_);
+		rt_sbt_builder.CleanUp();
+		raycast_shader_binding_table_ = raycast_sbt_builder.Build(raycast_pipeline_);
+		raycast_sbt_builder.CleanUp();
 	}
 
 	void RayTracingContext::CleanUp()
@@ -132,30 +173,81 @@ namespace renderer
 		QueueBlas(&mesh->blas, std::move(vk_geometries), std::move(mesh_info.build_ranges));
 	}
 
-	AccelerationStructure* RayTracingContext::QueueTlas(const std::vector<RenderObject*>& render_objects)
+	void RayTracingContext::CreateDynamicBlas(Mesh* mesh)
 	{
-		QueuedTlasBuildInfo build_info{
-			.tlas = new AccelerationStructure{}, // This TLAS will be populated later when build command is called.
-			.instances = {},                     // Populated below.
-		};
-
-		build_info.instances.reserve(render_objects.size());
-		for (const RenderObject* render_object : render_objects)
+		std::vector<uint32_t> max_vertices{};
+		std::vector<uint32_t> max_primitive_counts{};
+		for (const Geometry& geometry : mesh->geometries)
 		{
-			if (render_object && render_object->visible) {
-				build_info.instances.push_back(RenderObjectToVulkanInstance(*render_object));
+			if (mesh->procedural) {
+				max_primitive_counts.push_back((uint32_t)(geometry.vertices_resource.size / sizeof(VkAabbPositionsKHR)));
 			}
 			else
 			{
-				// Inactive instance according to Vulkan spec since acceleration structure reference is 0.
-				// We include this so indices don't get messed up for rt instances.
-				build_info.instances.push_back(VkAccelerationStructureInstanceKHR{});
+				max_vertices.push_back((uint32_t)(geometry.vertices_resource.size / sizeof(Vertex)) - 1);
+				max_primitive_counts.push_back((uint32_t)(geometry.indices_resource.size / sizeof(decltype(Geometry::indices)::value_type)) / 3);
 			}
 		}
+		std::vector<VkAccelerationStructureGeometryKHR> vk_geometries{ mesh->procedural ?
+			PumpkinAabbGeometriesToVulkanGeometries(mesh->geometries) : PumpkinTriGeometriesToVulkanGeometries(mesh->geometries, max_vertices) };
+
+		// Flags must match the builds in CmdBuildBlases(...).
+		VkAccelerationStructureBuildGeometryInfoKHR blas_build_info{
+			.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+			.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+			.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+			.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+			.geometryCount = (uint32_t)vk_geometries.size(),
+			.pGeometries = vk_geometries.data(),
+		};
+
+		VkAccelerationStructureBuildSizesInfoKHR build_sizes{ GetAccelerationStructureBuildSizes(blas_build_info, max_primitive_counts) };
 
-		queued_tlas_build_infos_.push_back(build_info);
+		CreateAccelerationStructure(build_sizes.accelerationStructureSize, false, &mesh->blas);
+		NameObject(context_->device, mesh->blas.acceleration_structure, "Dynamic_Blas");
+		NameObject(context_->device, mesh->blas.buffer_resource.buffer, "Dynamic_Blas_Buffer");
 
-		return build_info.tlas;
+		mesh->blas.scratch_resource = allocator_->CreateAlignedBufferResource(
+			std::max(build_sizes.buildScratchSize, build_sizes.updateScratchSize),
+			acceleration_structure_properties_.minAccelerationStructureScratchOffsetAlignment,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		NameObject(context_->device, mesh->blas.scratch_resource.buffer, "Dynamic_Blas_Scratch_Buffer");
+		mesh->blas.refits_since_build = 0;
+	}
+
+	bool RayTracingContext::QueueDynamicBlasUpdate(Mesh* mesh, bool can_refit)
+	{
+		// Only the latest update of a BLAS is built. It can only be a refit if the one it replaces was too.
+		auto queued{ std::find_if(queued_blas_build_infos_.begin(), queued_blas_build_infos_.end(),
+			[mesh](const QueuedBlasBuildInfo& build_info) { return build_info.blas == &mesh->blas; }) };
+		if (queued != queued_blas_build_infos_.end())
+		{
+			can_refit = can_refit && queued->refit;
+			queued_blas_build_infos_.erase(queued);
+		}
+
+		bool refit{ can_refit && mesh->blas.refits_since_build < BLAS_REBUILD_INTERVAL };
+		mesh->blas.refits_since_build = refit ? mesh->blas.refits_since_build + 1 : 0;
+
+		if (mesh->procedural) {
+			QueueBlas(&mesh->blas, PumpkinAabbGeometriesToVulkanGeometries(mesh->geometries), GetGeometryBuildRanges(mesh->geometries));
+		}
+		else
+		{
+			std::vector<uint32_t> max_vertices{};
+			for (const Geometry& geometry : mesh->geometries) {
+				max_vertices.push_back(std::max((uint32_t)geometry.vertices.size(), 1u) - 1);
+			}
+			QueueBlas(&mesh->blas, PumpkinTriGeometriesToVulkanGeometries(mesh->geometries, max_vertices), GetGeometryBuildRanges(mesh->geometries));
+		}
+		queued_blas_build_infos_.back().refit = refit;
+		return refit;
+	}
+
+	void RayTracingContext::DequeueBlas(const AccelerationStructure* blas)
+	{
+		std::erase_if(queued_blas_build_infos_, [blas](const QueuedBlasBuildInfo& build_info) { return build_info.blas == blas; });
 	}
 
 	void RayTracingContext::CmdBuildQueuedBlases(VkCommandBuffer cmd)
@@ -175,96 +267,120 @@ namespace renderer
 		CmdBuildBlases(cmd, build_infos);
 	}
 
-	void RayTracingContext::CmdBuildQueuedTlases(VkCommandBuffer cmd)
+	void RayTracingContext::CmdUpdateTlas(VkCommandBuffer cmd, const std::vector<RenderObject*>& render_objects)
 	{
-		// Since each TLAS only has 1 geometry, we don't need a vector of vectors for build range infos.
-		std::vector<VkAccelerationStructureBuildRangeInfoKHR*> build_range_infos{};
-		std::vector<VkAccelerationStructureBuildGeometryInfoKHR> tlas_build_infos{};
+		FrameResources& frame{ GetCurrentFrame() };
+		ReadTlasBuildTime();
 
-		for (const QueuedTlasBuildInfo& build_info : queued_tlas_build_infos_)
-		{
-			VkDeviceAddress instance_buffer_address{};
+		// Compact out render objects without an instance, keeping the handle each instance belongs to.
+		std::vector<VkAccelerationStructureInstanceKHR> instances{};
+		std::vector<uint32_t> instance_handles{};
+		instances.reserve(render_objects.size());
+		instance_handles.reserve(render_objects.size());
 
-			// We still build TLAS if there are no instances so we can trace rays and execute the miss shader.
-			if (!build_info.instances.empty())
-			{
-				UploadInstancesToDevice(cmd, build_info.instances);
-				instance_buffer_address = DeviceAddress(context_->device, GetCurrentFrame().instance_buffer_.buffer);
-			}
-			else
+		for (uint32_t handle{ 0 }; handle < (uint32_t)render_objects.size(); ++handle)
+		{
+			const RenderObject* render_object{ render_objects[handle] };
+			if (render_object && render_object->visible)
 			{
-				// We cannot pass null handle buffer address to build an empty TLAS so we must create a dummy buffer.
-				UploadInstancesToDevice(cmd, { VkAccelerationStructureInstanceKHR{} });
-				instance_buffer_address = DeviceAddress(context_->device, GetCurrentFrame().instance_buffer_.buffer);
+				instances.push_back(RenderObjectToVulkanInstance(*render_object));
+				instance_handles.push_back(handle);
 			}
+		}
 
-			VkAccelerationStructureGeometryKHR vk_geometry{
-				.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
-				.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
-				.geometry = {
-					.instances = {
-						.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
-						.arrayOfPointers = VK_FALSE,
-						.data = instance_buffer_address,
-					},
-				},
-				.flags = 0,
-			};
-
-			VkAccelerationStructureBuildRangeInfoKHR* range_info{ new VkAccelerationStructureBuildRangeInfoKHR{
-				.primitiveCount = (uint32_t)build_info.instances.size(),
-				.primitiveOffset = 0,
-				.firstVertex = 0,
-				.transformOffset = 0,
-			} };
-
-			build_range_infos.push_back(range_info);
+		uint32_t instance_count{ (uint32_t)instances.size() };
+		ReserveTlasInstances(instance_count);
 
-			VkAccelerationStructureBuildGeometryInfoKHR tlas_build_info{
-				.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
-				.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
-				.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR,
-				.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
-				.srcAccelerationStructure = VK_NULL_HANDLE,
-				.dstAccelerationStructure = VK_NULL_HANDLE, // Populate this after getting acceleration structure size.
-				.geometryCount = 1,
-				.pGeometries = &vk_geometry,
-				.scratchData = {}, // Populate this after getting scratch buffer size.
-			};
-
-			VkAccelerationStructureBuildSizesInfoKHR build_sizes{ GetAccelerationStructureBuildSizes(tlas_build_info, (uint32_t)build_info.instances.size()) };
+		// Write only the instances that differ from what the buffers already hold.
+		bool refit{ frame.tlas_built_ && instance_count == (uint32_t)frame.instances_.size() && frame.refits_since_build_ < TLAS_REBUILD_INTERVAL };
+		uint32_t dirty_begin{ instance_count };
+		uint32_t dirty_end{ 0 };
+		for (uint32_t i{ 0 }; i < instance_count; ++i)
+		{
+			if (i < (uint32_t)frame.instances_.size())
+			{
+				if (std::memcmp(&frame.instances_[i], &instances[i], sizeof(VkAccelerationStructureInstanceKHR)) == 0 &&
+					frame.instance_handles_[i] == instance_handles[i])
+				{
+					continue;
+				}
+				refit = refit && CanRefitInstance(frame.instances_[i], instances[i]);
+			}
 
-			BufferResource scratch_buffer{ allocator_->CreateAlignedBufferResource(
-				build_sizes.buildScratchSize, acceleration_structure_properties_.minAccelerationStructureScratchOffsetAlignment,
-				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) };
-			GetCurrentFrame().scratch_buffers_.push_back(scratch_buffer);
-			NameObject(context_->device, scratch_buffer.buffer, "Tlas_Scratch_Buffer");
+			frame.instances_mapped_[i] = instances[i];
+			frame.instance_handles_mapped_[i] = instance_handles[i];
+			dirty_begin = std::min(dirty_begin, i);
+			dirty_end = i + 1;
+		}
 
-			// We must create the TLAS before we can build it.
-			CreateAccelerationStructure(build_sizes.accelerationStructureSize, true, build_info.tlas);
-			NameObject(context_->device, build_info.tlas->acceleration_structure, "Tlas");
-			NameObject(context_->device, build_info.tlas->buffer_resource.buffer, "Tlas_Buffer");
+		if (dirty_begin < dirty_end)
+		{
+			allocator_->FlushBufferResource(frame.instance_buffer_,
+				dirty_begin * sizeof(VkAccelerationStructureInstanceKHR), (dirty_end - dirty_begin) * sizeof(VkAccelerationStructureInstanceKHR));
+			allocator_->FlushBufferResource(frame.instance_handle_buffer_,
+				dirty_begin * sizeof(uint32_t), (dirty_end - dirty_begin) * sizeof(uint32_t));
+		}
 
-			tlas_build_info.dstAccelerationStructure = build_info.tlas->acceleration_structure;
-			tlas_build_info.scratchData.deviceAddress = DeviceAddress(context_->device, scratch_buffer.buffer);
+		tlas_build_stats_.instance_count = instance_count;
+		tlas_build_stats_.written_instance_count = dirty_end > dirty_begin ? dirty_end - dirty_begin : 0;
+		tlas_build_stats_.refit = refit;
 
-			tlas_build_infos.push_back(tlas_build_info);
-		}
+		frame.instances_ = std::move(instances);
+		frame.instance_handles_ = std::move(instance_handles);
+		frame.refits_since_build_ = refit ? frame.refits_since_build_ + 1 : 0;
+		frame.tlas_built_ = true;
 
-		vkCmdBuildAccelerationStructuresKHR(cmd, (uint32_t)tlas_build_infos.size(), tlas_build_infos.data(), build_range_infos.data());
+		VkAccelerationStructureGeometryKHR vk_geometry{
+			.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+			.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
+			.geometry = {
+				.instances = {
+					.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
+					.arrayOfPointers = VK_FALSE,
+					.data = DeviceAddress(context_->device, frame.instance_buffer_.buffer),
+				},
+			},
+			.flags = 0,
+		};
 
-		for (const QueuedTlasBuildInfo& build_info : queued_tlas_build_infos_)
-		{
-			PipelineBarrier(cmd, build_info.tlas->buffer_resource.buffer,
-				VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-				VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
-		}
-		queued_tlas_build_infos_.clear();
+		// An update reads the TLAS it refits from src, so src and dst are the same TLAS.
+		VkAccelerationStructureBuildGeometryInfoKHR tlas_build_info{
+			.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+			.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+			.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+			.mode = refit ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+			.srcAccelerationStructure = refit ? frame.tlas_.acceleration_structure : VK_NULL_HANDLE,
+			.dstAccelerationStructure = frame.tlas_.acceleration_structure,
+			.geometryCount = 1,
+			.pGeometries = &vk_geometry,
+			.scratchData = {
+				.deviceAddress = DeviceAddress(context_->device, frame.tlas_scratch_buffer_.buffer),
+			},
+		};
 
-		for (VkAccelerationStructureBuildRangeInfoKHR* range_info : build_range_infos) {
-			delete range_info;
-		}
+		// We still build TLAS if there are no instances so we can trace rays and execute the miss shader.
+		VkAccelerationStructureBuildRangeInfoKHR range_info{
+			.primitiveCount = instance_count,
+			.primitiveOffset = 0,
+			.firstVertex = 0,
+			.transformOffset = 0,
+		};
+		const VkAccelerationStructureBuildRangeInfoKHR* range_infos{ &range_info };
+
+		// Both timestamps are at the build stage, so the first is written once the BLAS builds before the TLAS are done.
+		vkCmdResetQueryPool(cmd, frame.timestamp_query_pool_, 0, 2);
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, frame.timestamp_query_pool_, 0);
+		vkCmdBuildAccelerationStructuresKHR(cmd, 1, &tlas_build_info, &range_infos);
+		vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, frame.timestamp_query_pool_, 1);
+		frame.timestamps_written_ = true;
+
+		PipelineBarrier(cmd, frame.tlas_.buffer_resource.buffer,
+			VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+			VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+
+		// The raycast set is shared between frames, so point it at this frame's TLAS.
+		raycast_descriptor_set_resource_.LinkAccelerationStructureToBinding(RAYCAST_TLAS_BINDING, frame.tlas_.acceleration_structure);
+		raycast_descriptor_set_resource_.LinkBufferToBinding(RAYCAST_INSTANCE_HANDLES_BINDING, frame.instance_handle_buffer_);
 	}
 
 	VkAccelerationStructureInstanceKHR RayTracingContext::RenderObjectToVulkanInstance(const RenderObject& render_object) const
@@ -277,10 +393,10 @@ namespace renderer
 		};
 
 		return VkAccelerationStructureInstanceKHR{
-			.transform = ToVulkanTransformMatrix(render_object.uniform_buffer.transform),
+			.transform = ToVulkanTransformMatrix(render_object.object_data.transform),
 			.instanceCustomIndex = custom_index_map_.at(&mesh->blas), // Can't use operator[] since this function is const.
 			.mask = 0xFF,
-			.instanceShaderBindingTableRecordOffset = 0,
+			.instanceShaderBindingTableRecordOffset = mesh->procedural ? PARTICLE_HIT_GROUP : TRIANGLE_HIT_GROUP,
 			.flags = 0,
 			.accelerationStructureReference = vkGetAccelerationStructureDeviceAddressKHR(context_->device, &device_address_info),
 		};
@@ -325,10 +441,6 @@ namespace renderer
 		}
 		GetCurrentFrame().scratch_buffers_.clear();
 
-		for (BufferResource buffer_resource : GetCurrentFrame().staging_buffers_) {
-			allocator_->DestroyBufferResource(&buffer_resource);
-		}
-		GetCurrentFrame().staging_buffers_.clear();
 	}
 
 	void RayTracingContext::SetCameraMatrices(const glm::mat4& view, const glm::mat4& projection)
@@ -344,12 +456,6 @@ namespace renderer
 		vkUnmapMemory(context_->device, *GetCurrentFrame().camera_ubo_buffer.memory);
 	}
 
-	void RayTracingContext::SetTlas(VkAccelerationStructureKHR tlas)
-	{
-		GetCurrentFrame().frame_descriptor_set_resource_.LinkAccelerationStructureToBinding(TLAS_BINDING, tlas);
-		raycast_descriptor_set_resource_.LinkAccelerationStructureToBinding(RAYCAST_TLAS_BINDING, tlas);
-	}
-
 	void RayTracingContext::SetRenderImages(const Extent& render_extent, const std::array<ImageResource, FRAMES_IN_FLIGHT>& render_images)
 	{
 		uint32_t i{ 0 };
@@ -392,9 +498,10 @@ namespace renderer
 			{
 				for (Geometry& geometry : mesh->geometries)
 				{
+					// Procedural geometries have no index buffer.
 					ObjectBuffers& obj_buffers{ object_buffers_vec.emplace_back() };
 					obj_buffers.vertices = (uint64_t)DeviceAddress(context_->device, geometry.vertices_resource.buffer);
-					obj_buffers.indices = (uint64_t)DeviceAddress(context_->device, geometry.indices_resource.buffer);
+					obj_buffers.indices = geometry.indices_resource.buffer ? (uint64_t)DeviceAddress(context_->device, geometry.indices_resource.buffer) : 0;
 					++custom_index;
 				}
 			}
@@ -416,6 +523,7 @@ namespace renderer
 		vulkan_util_->Submit();
 
 		persistent_descriptor_set_resource_.LinkBufferToBinding(OBJECT_BUFFERS_BINDING, object_buffers_buffer_);
+		raycast_descriptor_set_resource_.LinkBufferToBinding(RAYCAST_OBJECT_BUFFERS_BINDING, object_buffers_buffer_);
 	}
 
 	void RayTracingContext::UpdateMaterialBuffers(const std::vector<Material*>& materials, const std::vector<const std::vector<int>*>& indices)
@@ -486,7 +594,7 @@ namespace renderer
 		for (const std::vector<int>* geometry_mat_indices : *indices_ptr)
 		{
 			index_addresses.push_back(current_address);
-			// If a rt instance is disabled it will have null geometry_mat_indices, but we still must push back an address so gl_InstanceID indexes correctly.
+			// If a render object is disabled it will have null geometry_mat_indices, but we still must push back an address so handles index correctly.
 			if (geometry_mat_indices) {
 				current_address += geometry_mat_indices->size() * sizeof(decltype(indices_vec)::value_type);
 			}
@@ -559,6 +667,11 @@ namespace renderer
 		return rayhits;
 	}
 
+	const TlasBuildStats& RayTracingContext::GetTlasBuildStats() const
+	{
+		return tlas_build_stats_;
+	}
+
 	VkAccelerationStructureGeometryKHR RayTracingContext::PumpkinTriGeometryToVulkanGeometry(const Geometry& pmk_geometry, uint32_t max_vertex) const
 	{
 		VkAccelerationStructureGeometryKHR vk_geometry{
@@ -598,6 +711,28 @@ namespace renderer
 		return vk_geometries;
 	}
 
+	std::vector<VkAccelerationStructureGeometryKHR> RayTracingContext::PumpkinAabbGeometriesToVulkanGeometries(const std::vector<Geometry>& pmk_geometries) const
+	{
+		std::vector<VkAccelerationStructureGeometryKHR> vk_geometries{};
+		vk_geometries.reserve(pmk_geometries.size());
+		for (const Geometry& pmk_geometry : pmk_geometries)
+		{
+			vk_geometries.push_back(VkAccelerationStructureGeometryKHR{
+				.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+				.geometryType = VK_GEOMETRY_TYPE_AABBS_KHR,
+				.geometry = {
+					.aabbs = {
+						.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR,
+						.data = DeviceAddress(context_->device, pmk_geometry.vertices_resource.buffer),
+						.stride = sizeof(VkAabbPositionsKHR),
+					},
+				},
+				.flags = VK_GEOMETRY_OPAQUE_BIT_KHR, // No any-hit shader, so the intersection shader's hits are final.
+			});
+		}
+		return vk_geometries;
+	}
+
 	std::vector<VkAccelerationStructureGeometryKHR> RayTracingContext::PumpkinSingleGeometryToVulkanGeometries(const Geometry& pmk_geometry, const std::vector<uint32_t>& max_vertices) const
 	{
 		VkAccelerationStructureGeometryKHR vk_geometry{
@@ -688,58 +823,117 @@ namespace renderer
 		return build_sizes_info;
 	}
 
-	void RayTracingContext::UploadInstancesToDevice(VkCommandBuffer cmd, const std::vector<VkAccelerationStructureInstanceKHR>& instances)
+	void RayTracingContext::ReserveTlasInstances(uint32_t instance_count)
 	{
-		allocator_->ExpandOrReuseAlignedBuffer(
-			instances.size() * sizeof(VkAccelerationStructureInstanceKHR),
-			16,
-			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			GetCurrentFrame().instance_buffer_);
-		NameObject(context_->device, GetCurrentFrame().instance_buffer_.buffer, "Ray_Tracing_Instance_Buffer");
+		FrameResources& frame{ GetCurrentFrame() };
+		if (frame.tlas_.acceleration_structure && instance_count <= frame.instance_capacity_) {
+			return;
+		}
 
-		BufferResource staging{ allocator_->CreateBufferResource(GetCurrentFrame().instance_buffer_.size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) };
-		NameObject(context_->device, staging.buffer, "Ray_Tracing_Staging_Instance_Buffer");
-		GetCurrentFrame().staging_buffers_.push_back(staging);
+		frame.instance_capacity_ = std::max(frame.instance_capacity_, MIN_TLAS_INSTANCE_CAPACITY);
+		while (frame.instance_capacity_ < instance_count) {
+			frame.instance_capacity_ *= 2;
+		}
+		std::string frame_number{ std::to_string(renderer_->GetCurrentFrameNumber()) };
 
-		// Copy data to staging buffer.
-		void* data{};
-		vkMapMemory(context_->device, *staging.memory, staging.offset, staging.size, 0, &data);
-		memcpy(data, instances.data(), staging.size);
-		vkUnmapMemory(context_->device, *staging.memory);
-
-		// Transfer from staging to device.
-		VkBufferCopy buffer_copy{
-			.srcOffset = 0,
-			.dstOffset = 0,
-			.size = staging.size,
+		// Instances must be 16 byte aligned, which a dedicated allocation is.
+		allocator_->DestroyBufferResource(&frame.instance_buffer_);
+		frame.instance_buffer_ = allocator_->CreateMappedBufferResource(frame.instance_capacity_ * sizeof(VkAccelerationStructureInstanceKHR),
+			VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.instances_mapped_);
+		NameObject(context_->device, frame.instance_buffer_.buffer, "Ray_Tracing_Instance_Buffer_" + frame_number);
+
+		allocator_->DestroyBufferResource(&frame.instance_handle_buffer_);
+		frame.instance_handle_buffer_ = allocator_->CreateMappedBufferResource(frame.instance_capacity_ * sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.instance_handles_mapped_);
+		NameObject(context_->device, frame.instance_handle_buffer_.buffer, "Ray_Tracing_Instance_Handle_Buffer_" + frame_number);
+
+		// Size the TLAS for the whole capacity so it is only recreated when the instance buffer grows.
+		VkAccelerationStructureGeometryKHR vk_geometry{
+			.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
+			.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR,
+			.geometry = {
+				.instances = {
+					.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR,
+					.arrayOfPointers = VK_FALSE,
+					.data = {}, // Unused when getting build sizes.
+				},
+			},
+			.flags = 0,
+		};
+
+		VkAccelerationStructureBuildGeometryInfoKHR tlas_build_info{
+			.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+			.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+			.flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+			.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
+			.geometryCount = 1,
+			.pGeometries = &vk_geometry,
 		};
 
-		vkCmdCopyBuffer(cmd, staging.buffer, GetCurrentFrame().instance_buffer_.buffer, 1, &buffer_copy);
+		VkAccelerationStructureBuildSizesInfoKHR build_sizes{ GetAccelerationStructureBuildSizes(tlas_build_info, frame.instance_capacity_) };
 
-		PipelineBarrier(cmd, GetCurrentFrame().instance_buffer_.buffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT);
+		if (frame.tlas_.acceleration_structure)
+		{
+			vkDestroyAccelerationStructureKHR(context_->device, frame.tlas_.acceleration_structure, nullptr);
+			allocator_->DestroyBufferResource(&frame.tlas_.buffer_resource);
+		}
+		CreateAccelerationStructure(build_sizes.accelerationStructureSize, true, &frame.tlas_);
+		NameObject(context_->device, frame.tlas_.acceleration_structure, "Tlas_" + frame_number);
+		NameObject(context_->device, frame.tlas_.buffer_resource.buffer, "Tlas_Buffer_" + frame_number);
+
+		allocator_->DestroyBufferResource(&frame.tlas_scratch_buffer_);
+		frame.tlas_scratch_buffer_ = allocator_->CreateAlignedBufferResource(
+			std::max(build_sizes.buildScratchSize, build_sizes.updateScratchSize),
+			acceleration_structure_properties_.minAccelerationStructureScratchOffsetAlignment,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		NameObject(context_->device, frame.tlas_scratch_buffer_.buffer, "Tlas_Scratch_Buffer_" + frame_number);
+
+		frame.frame_descriptor_set_resource_.LinkAccelerationStructureToBinding(TLAS_BINDING, frame.tlas_.acceleration_structure);
+		frame.frame_descriptor_set_resource_.LinkBufferToBinding(INSTANCE_HANDLES_BINDING, frame.instance_handle_buffer_);
+
+		// The new buffers and TLAS are empty, so every instance is written and the TLAS is rebuilt.
+		frame.instances_.clear();
+		frame.instance_handles_.clear();
+		frame.tlas_built_ = false;
 	}
 
-	void RayTracingContext::CreateRtPipelineAndShaderBindingTable()
+	void RayTracingContext::ReadTlasBuildTime()
 	{
-		ShaderBindingTableBuilder sbt_builder{};
-		sbt_builder.Initialize(context_, allocator_, vulkan_util_, &rt_pipeline_properties_);
-		sbt_builder.SetRaygenShader(SPIRV_PREFIX / "pbr.rgen.spv");
-		sbt_builder.AddMissShader(SPIRV_PREFIX / "pbr.rmiss.spv");
-		sbt_builder.AddHitGroup(SPIRV_PREFIX / "pbr.rchit.spv", SHADER_UNUSED_PATH, SHADER_UNUSED_PATH);
+		FrameResources& frame{ GetCurrentFrame() };
+		if (!frame.timestamps_written_) {
+			return;
+		}
+		frame.timestamps_written_ = false;
+
+		uint64_t timestamps[2]{};
+		VkResult result{ vkGetQueryPoolResults(context_->device, frame.timestamp_query_pool_, 0, 2, sizeof(timestamps), timestamps,
+			sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) };
+		if (result == VK_SUCCESS) {
+			tlas_build_stats_.build_time_ms = (float)(timestamps[1] - timestamps[0]) * timestamp_period_ / 1000000.0f;
+		}
+	}
+
+	void RayTracingContext::CreateRtPipeline(ShaderBindingTableBuilder* sbt_builder)
+	{
+		sbt_builder->Initialize(context_, allocator_, vulkan_util_, &rt_pipeline_properties_);
+		sbt_builder->SetRaygenShader(SPIRV_PREFIX / "pbr.rgen.spv");
+		sbt_builder->AddMissShader(SPIRV_PREFIX / "pbr.rmiss.spv");
+		// Hit groups in the order of TRIANGLE_HIT_GROUP and PARTICLE_HIT_GROUP.
+		sbt_builder->AddHitGroup(SPIRV_PREFIX / "pbr.rchit.spv", SHADER_UNUSED_PATH, SHADER_UNUSED_PATH);
+		sbt_builder->AddHitGroup(SPIRV_PREFIX / "pbr.rchit.spv", SHADER_UNUSED_PATH, SPIRV_PREFIX / "particle.rint.spv");
 
 		CreateRtPipelineLayout();
 
 		VkRayTracingPipelineCreateInfoKHR rt_pipeline_info{
 			.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
 			.flags = 0,
-			.stageCount = (uint32_t)sbt_builder.GetShaderStages().size(),
-			.pStages = sbt_builder.GetShaderStages().data(),
-			.groupCount = (uint32_t)sbt_builder.GetGroups().size(),
-			.pGroups = sbt_builder.GetGroups().data(),
+			.stageCount = (uint32_t)sbt_builder->GetShaderStages().size(),
+			.pStages = sbt_builder->GetShaderStages().data(),
+			.groupCount = (uint32_t)sbt_builder->GetGroups().size(),
+			.pGroups = sbt_builder->GetGroups().data(),
 			.maxPipelineRayRecursionDepth = 1,
 			.pLibraryInfo = nullptr,
 			.pLibraryInterface = nullptr,
@@ -749,12 +943,9 @@ namespace renderer
 			.basePipelineIndex = {},
 		};
 
-		VkResult result{ vkCreateRayTracingPipelinesKHR(context_->device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &rt_pipeline_info, nullptr, &rt_pipeline_) };
+		VkResult result{ vkCreateRayTracingPipelinesKHR(context_->device, VK_NULL_HANDLE, context_->pipeline_cache, 1, &rt_pipeline_info, nullptr, &rt_pipeline_) };
 		CheckResult(result, "Failed to create ray tracing pipeline.");
 		NameObject(context_->device, rt_pipeline_, "Ray_Trace_Pipeline");
-
-		rt_shader_binding_table_ = sbt_builder.Build(rt_pipeline_);
-		sbt_builder.CleanUp();
 	}
 
 	void RayTracingContext::CreateRtPipelineLayout()
@@ -778,23 +969,24 @@ namespace renderer
 		NameObject(context_->device, rt_pipeline_layout_, "Ray_Trace_Pipeline_Layout");
 	}
 
-	void RayTracingContext::CreateRaycastPipelineAndShaderBindingTable()
+	void RayTracingContext::CreateRaycastPipeline(ShaderBindingTableBuilder* sbt_builder)
 	{
-		ShaderBindingTableBuilder sbt_builder{};
-		sbt_builder.Initialize(context_, allocator_, vulkan_util_, &rt_pipeline_properties_);
-		sbt_builder.SetRaygenShader(SPIRV_PREFIX / "raycast.rgen.spv");
-		sbt_builder.AddMissShader(SPIRV_PREFIX / "raycast.rmiss.spv");
-		sbt_builder.AddHitGroup(SPIRV_PREFIX / "raycast.rchit.spv", SHADER_UNUSED_PATH, SHADER_UNUSED_PATH);
+		sbt_builder->Initialize(context_, allocator_, vulkan_util_, &rt_pipeline_properties_);
+		sbt_builder->SetRaygenShader(SPIRV_PREFIX / "raycast.rgen.spv");
+		sbt_builder->AddMissShader(SPIRV_PREFIX / "raycast.rmiss.spv");
+		// Hit groups in the order of TRIANGLE_HIT_GROUP and PARTICLE_HIT_GROUP.
+		sbt_builder->AddHitGroup(SPIRV_PREFIX / "raycast.rchit.spv", SHADER_UNUSED_PATH, SHADER_UNUSED_PATH);
+		sbt_builder->AddHitGroup(SPIRV_PREFIX / "raycast.rchit.spv", SHADER_UNUSED_PATH, SPIRV_PREFIX / "raycast_particle.rint.spv");
 
 		CreateRaycastPipelineLayout();
 
 		VkRayTracingPipelineCreateInfoKHR raycast_pipeline_info{
 			.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
 			.flags = 0,
-			.stageCount = (uint32_t)sbt_builder.GetShaderStages().size(),
-			.pStages = sbt_builder.GetShaderStages().data(),
-			.groupCount = (uint32_t)sbt_builder.GetGroups().size(),
-			.pGroups = sbt_builder.GetGroups().data(),
+			.stageCount = (uint32_t)sbt_builder->GetShaderStages().size(),
+			.pStages = sbt_builder->GetShaderStages().data(),
+			.groupCount = (uint32_t)sbt_builder->GetGroups().size(),
+			.pGroups = sbt_builder->GetGroups().data(),
 			.maxPipelineRayRecursionDepth = 1,
 			.pLibraryInfo = nullptr,
 			.pLibraryInterface = nullptr,
@@ -804,12 +996,9 @@ namespace renderer
 			.basePipelineIndex = {},
 		};
 
-		VkResult result{ vkCreateRayTracingPipelinesKHR(context_->device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &raycast_pipeline_info, nullptr, &raycast_pipeline_) };
+		VkResult result{ vkCreateRayTracingPipelinesKHR(context_->device, VK_NULL_HANDLE, context_->pipeline_cache, 1, &raycast_pipeline_info, nullptr, &raycast_pipeline_) };
 		CheckResult(result, "Failed to create raycast pipeline.");
 		NameObject(context_->device, raycast_pipeline_, "Raycast_Pipeline");
-
-		raycast_shader_binding_table_ = sbt_builder.Build(raycast_pipeline_);
-		sbt_builder.CleanUp();
 	}
 
 	void RayTracingContext::CreateRaycastPipelineLayout()
@@ -860,12 +1049,20 @@ namespace renderer
 			.pImmutableSamplers = nullptr,
 		};
 
+		VkDescriptorSetLayoutBinding instance_handles_binding{
+			.binding = INSTANCE_HANDLES_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
+			.pImmutableSamplers = nullptr,
+		};
+
 		// Set 1 of rt pipline.
 		VkDescriptorSetLayoutBinding object_buffers_binding{
 			.binding = OBJECT_BUFFERS_BINDING,
 			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 			.descriptorCount = 1,
-			.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
+			.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR,
 			.pImmutableSamplers = nullptr,
 		};
 
@@ -926,10 +1123,27 @@ namespace renderer
 			.pImmutableSamplers = nullptr,
 		};
 
+		VkDescriptorSetLayoutBinding raycast_instance_handles_binding{
+			.binding = RAYCAST_INSTANCE_HANDLES_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR,
+			.pImmutableSamplers = nullptr,
+		};
+
+		VkDescriptorSetLayoutBinding raycast_object_buffers_binding{
+			.binding = RAYCAST_OBJECT_BUFFERS_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_INTERSECTION_BIT_KHR,
+			.pImmutableSamplers = nullptr,
+		};
+
 		std::vector<VkDescriptorSetLayoutBinding> bindings_rt_set_0{
 			tlas_binding,
 			image_buffer_binding,
 			camera_ubo_binding,
+			instance_handles_binding,
 		};
 
 		std::vector<VkDescriptorSetLayoutBinding> bindings_rt_set_1{
@@ -943,6 +1157,8 @@ namespace renderer
 			raycast_tlas_binding,
 			raycasts_buffer_binding,
 			rayhits_buffer_binding,
+			raycast_instance_handles_binding,
+			raycast_object_buffers_binding,
 		};
 
 		frame_descriptor_set_layout_resource_ = descriptor_allocator_->CreateDescriptorSetLayoutResource(bindings_rt_set_0, 0);
@@ -966,7 +1182,7 @@ namespace renderer
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 			NameObject(context_->device, frame.camera_ubo_buffer.buffer, "Ray_Trace_Camera_Ubo_Buffer_" + std::to_string(i));
 
-			// We don't link TLAS yet since that will be done each frame since new TLASes will be created.
+			// We don't link TLAS or instance handles yet since they are created with the first CmdUpdateTlas(...).
 			// We don't link render images yet since that is done each time the viewport changes size.
 			frame.frame_descriptor_set_resource_.LinkBufferToBinding(CAMERA_UBO_BINDING, frame.camera_ubo_buffer);
 			++i;
@@ -997,9 +1213,14 @@ namespace renderer
 		{
 			allocator_->DestroyBufferResource(&frame.camera_ubo_buffer);
 			allocator_->DestroyBufferResource(&frame.instance_buffer_);
+			allocator_->DestroyBufferResource(&frame.instance_handle_buffer_);
+			allocator_->DestroyBufferResource(&frame.tlas_scratch_buffer_);
+			vkDestroyQueryPool(context_->device, frame.timestamp_query_pool_, nullptr);
 
-			for (BufferResource& buffer : frame.staging_buffers_) {
-				allocator_->DestroyBufferResource(&buffer);
+			if (frame.tlas_.acceleration_structure)
+			{
+				vkDestroyAccelerationStructureKHR(context_->device, frame.tlas_.acceleration_structure, nullptr);
+				allocator_->DestroyBufferResource(&frame.tlas_.buffer_resource);
 			}
 
 			for (BufferResource& buffer : frame.scratch_buffers_) {
@@ -1056,6 +1277,18 @@ namespace renderer
 				.scratchData = {}, // Populate this after getting scratch buffer size.
 			};
 
+			if (build_info.blas->scratch_resource.buffer)
+			{
+				// Dynamic BLASes are already sized for this build, so build or refit them in place.
+				blas_build_info.flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+				blas_build_info.mode = build_info.refit ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+				blas_build_info.srcAccelerationStructure = build_info.refit ? build_info.blas->acceleration_structure : VK_NULL_HANDLE;
+				blas_build_info.dstAccelerationStructure = build_info.blas->acceleration_structure;
+				blas_build_info.scratchData.deviceAddress = DeviceAddress(context_->device, build_info.blas->scratch_resource.buffer);
+				blas_build_infos.push_back(blas_build_info);
+				continue;
+			}
+
 			// Extract primitive counts from build ranges.
 			std::vector<uint32_t> primitive_counts{};
 			primitive_counts.resize(build_info.build_ranges.size());
@@ -50,6 +50,22 @@ namespace renderer
 		glm::vec3 position;
 	};
 
+	struct TlasBuildStats
+	{
+		uint32_t instance_count;         // Visible render objects in the last TLAS.
+		uint32_t written_instance_count; // Instances whose data changed and were written to the instance buffer.
+		bool refit;                      // Whether the last TLAS was updated in place instead of rebuilt.
+		float build_time_ms;             // GPU time of the latest TLAS build that has finished, which lags a frame in flight behind the others.
+	};
+
+	// Counts of how dynamic BLASes were updated since the renderer started.
+	struct DynamicBlasStats
+	{
+		uint32_t refit_count;   // Same vertex and triangle counts, so the BLAS was refit in place.
+		uint32_t rebuild_count; // Counts changed within capacity, or refits were due a rebuild, so the BLAS was rebuilt in place.
+		uint32_t grow_count;    // The mesh outgrew its buffers, so new buffers and a new BLAS were created.
+	};
+
 	std::vector<VkAccelerationStructureBuildRangeInfoKHR> GetGeometryBuidRanges(const std::vector<Geometry>& geometries);
 
 	// Utility for building the shader binding table.
@@ -129,10 +145,6 @@ namespace renderer
 		// Will mutate mesh_info, so will be invalid after this function is called.
 		void QueueBlas(Mesh* mesh, MeshBlasInfo& mesh_info);
 
-		// Returns empty TLAS without build data that will be populated after CmdBuildQueuedTlases(...) is called.
-		// The build data will not be present in the TLAS buffer until after CmdBuildQueuedTlases(...) is called and the queue is submitted.
-		AccelerationStructure* QueueTlas(const std::vector<RenderObject*>& render_objects);
-
 		// Creates the BLAS objects populating the empty BLASes saved from QueueBlas(...) and writes the build
 		// commands into the command buffer.
 		// Includes pipeline barriers for BLAS buffers.
@@ -141,10 +153,23 @@ namespace renderer
 		// Build BLAS immediately, without adding it to the queue.
 		void CmdBuildBlas(VkCommandBuffer cmd, Mesh* mesh);
 
-		// Creates the TLAS objects populating the empty TLASes returned from QueueTlas(...) and writes the build
-		// commands into the command buffer.
-		// Includes pipeline barriers for TLAS buffers.
-		void CmdBuildQueuedTlases(VkCommandBuffer cmd);
+		// Creates a BLAS and scratch buffer sized for the capacity of the mesh's geometry buffers, so the BLAS can be updated in place
+		// with QueueDynamicBlasUpdate(...) while the geometries fit. Nothing is built until an update is queued.
+		void CreateDynamicBlas(Mesh* mesh);
+
+		// Queue an update of a BLAS from CreateDynamicBlas(...) using the mesh's current CPU side geometry.
+		// Pass can_refit only if the vertex and triangle counts are the same as the last update. Refits are still replaced by a rebuild
+		// every BLAS_REBUILD_INTERVAL updates, since they degrade the BLAS. Returns whether the update is a refit.
+		bool QueueDynamicBlasUpdate(Mesh* mesh, bool can_refit);
+
+		// Remove a queued BLAS that hasn't been built yet, eg if its mesh is replaced before it is built.
+		void DequeueBlas(const AccelerationStructure* blas);
+
+		// Writes the instances of visible render objects that changed into the current frame's instance buffer,
+		// then refits the current frame's TLAS in place, or rebuilds it if instances were added, removed or reference a different BLAS.
+		// The TLAS is also rebuilt every TLAS_REBUILD_INTERVAL builds, since refits degrade its quality.
+		// Includes pipeline barriers for the TLAS buffer. Call only after the current frame's last submission has finished.
+		void CmdUpdateTlas(VkCommandBuffer cmd, const std::vector<RenderObject*>& render_objects);
 
 		VkAccelerationStructureInstanceKHR RenderObjectToVulkanInstance(const RenderObject& render_object) const;
 
@@ -154,8 +179,6 @@ namespace renderer
 
 		void SetCameraMatrices(const glm::mat4& view, const glm::mat4& projection);
 
-		void SetTlas(VkAccelerationStructureKHR tlas);
-
 		void SetRenderImages(const Extent& render_extent, const std::array<ImageResource, FRAMES_IN_FLIGHT>& render_images);
 
 		// Updates the buffers containing vertex data to be accessed in closest-hit shaders. This could maybe be handled automatically
@@ -174,6 +197,8 @@ namespace renderer
 		// Returns vector of Rayhits of same size as input raycasts.
 		std::vector<Rayhit> CastRays(const std::vector<Raycast>& raycasts);
 
+		const TlasBuildStats& GetTlasBuildStats() const;
+
 	private:
 		struct FrameResources;
 
@@ -183,6 +208,9 @@ namespace renderer
 
 		std::vector<VkAccelerationStructureGeometryKHR> PumpkinTriGeometriesToVulkanGeometries(const std::vector<Geometry>& pmk_geometries, const std::vector<uint32_t>& max_vertices) const;
 
+		// The boxes of procedural geometries are read from their vertex buffers.
+		std::vector<VkAccelerationStructureGeometryKHR> PumpkinAabbGeometriesToVulkanGeometries(const std::vector<Geometry>& pmk_geometries) const;
+
 		std::vector<VkAccelerationStructureGeometryKHR> PumpkinSingleGeometryToVulkanGeometries(const Geometry& pmk_geometry, const std::vector<uint32_t>& max_vertices) const;
 
 		std::vector<VkAccelerationStructureGeometryKHR> PumpkinTriGeometriesToVulkanGeometries(const std::vector<Geometry>& pmk_geometries) const;
@@ -197,13 +225,18 @@ namespace renderer
 			const VkAccelerationStructureBuildGeometryInfoKHR& build_info,
 			uint32_t instance_count) const;
 
-		void UploadInstancesToDevice(VkCommandBuffer cmd, const std::vector<VkAccelerationStructureInstanceKHR>& instances);
+		// Grows the current frame's instance buffers, TLAS and scratch buffer to hold at least instance_count instances.
+		void ReserveTlasInstances(uint32_t instance_count);
 
-		void CreateRtPipelineAndShaderBindingTable();
+		// Reads the TLAS build time of the current frame's last submission.
+		void ReadTlasBuildTime();
+
+		// Create the pipeline from shaders added to sbt_builder, which then builds the SBT from it.
+		void CreateRtPipeline(ShaderBindingTableBuilder* sbt_builder);
 
 		void CreateRtPipelineLayout();
 
-		void CreateRaycastPipelineAndShaderBindingTable();
+		void CreateRaycastPipeline(ShaderBindingTableBuilder* sbt_builder);
 
 		void CreateRaycastPipelineLayout();
 
@@ -226,14 +259,8 @@ namespace renderer
 			// The actual geometry data needed for the BLAS.
 			const std::vector<VkAccelerationStructureGeometryKHR> vk_geometries;
 			std::vector<VkAccelerationStructureBuildRangeInfoKHR> build_ranges;
-		};
-
-		struct QueuedTlasBuildInfo
-		{
-			// Allocate TLAS when it's added to queue so we can return that to caller to associate with the mesh, even though it won't yet be built.
-			AccelerationStructure* tlas;
-			// The acceleration structure instances needed for the TLAS.
-			std::vector<VkAccelerationStructureInstanceKHR> instances;
+			// Only for BLASes from CreateDynamicBlas(...), which are built in place with their own scratch buffer.
+			bool refit{ false };
 		};
 
 		struct RayTraceCameraUBO
@@ -246,13 +273,27 @@ namespace renderer
 		{
 			BufferResource camera_ubo_buffer;
 			DescriptorSetResource frame_descriptor_set_resource_{};
-			BufferResource instance_buffer_{};              // Store so we can delete it after the TLAS is built.
+
+			// The TLAS and its inputs persist between frames, so unchanged instances aren't written and an unchanged topology is only refit.
+			// Only visible render objects get an instance, so instance_handles_ maps each instance back to its render object handle.
+			AccelerationStructure tlas_{};
+			BufferResource tlas_scratch_buffer_{};
+			BufferResource instance_buffer_{};
+			VkAccelerationStructureInstanceKHR* instances_mapped_{};
+			BufferResource instance_handle_buffer_{};
+			uint32_t* instance_handles_mapped_{};
+			uint32_t instance_capacity_{};
+			std::vector<VkAccelerationStructureInstanceKHR> instances_{}; // Instances as last written to instance_buffer_.
+			std::vector<uint32_t> instance_handles_{};
+			uint32_t refits_since_build_{};
+			bool tlas_built_{ false };
+			VkQueryPool timestamp_query_pool_{};                           // Timestamps before and after the TLAS build.
+			bool timestamps_written_{ false };
+
 			std::vector<BufferResource> scratch_buffers_{}; // Store these so we can delete them after the acceleration structures are built.
-			std::vector<BufferResource> staging_buffers_{}; // Store these so we can delete them after the acceleration structures are built.
 		};
 
 		std::vector<QueuedBlasBuildInfo> queued_blas_build_infos_{};              // Info needed to build the BLASes when CmdBuildQueuedBlases(...) is called.
-		std::vector<QueuedTlasBuildInfo> queued_tlas_build_infos_{};              // Info needed to build the TLASes when CmdBuildQueuedTlases(...) is called.
 		BufferResource object_buffers_buffer_{};                                  // Buffer containing device addresses to mesh data for each object in the scene. Not in FrameResources since it's rarely updated.
 		BufferResource materials_resource_{};                                     // Buffer containing all ray tracing material data.
 		BufferResource material_indices_resource_{};                              // Buffer containing concatenated ray tracing material indices for all geometries for all render objects.
@@ -275,6 +316,9 @@ namespace renderer
 		BufferResource rayhits_buffer_{};
 		ShaderBindingTable raycast_shader_binding_table_{};
 
+		TlasBuildStats tlas_build_stats_{};
+		float timestamp_period_{}; // Nanoseconds per timestamp tick.
+
 		VkPhysicalDeviceAccelerationStructurePropertiesKHR acceleration_structure_properties_{};
 		VkPhysicalDeviceRayTracingPipelinePropertiesKHR rt_pipeline_properties_{};
 		Context* context_{};
@@ -11,14 +11,34 @@ namespace renderer
 		std::vector<int> material_indices; // The ith index is the material index for the ith geometry. Store it here to decouple material and mesh.
 		bool visible;
 
-		// TODO: Maybe put all the render object transforms into a single buffer and store index here.
-		//       Instead of having lots of tiny buffers.
-		struct UniformBuffer
+		// Host copy of this object's element in the frame's object data buffer, which is indexed by render object handle.
+		struct ObjectData
 		{
 			glm::mat4 transform;
-		} uniform_buffer;
+		} object_data;
+	};
+
+	// Pushed before each draw to index the frame's object data buffer, so the buffer's descriptor set is bound once per pass.
+	struct RenderObjectPushConstant
+	{
+		uint32_t object_index;
+	};
 
-		BufferResource ubo_buffer_resource;
-		DescriptorSetResource ubo_descriptor_set_resource;
+	// One geometry drawn by the raster pass's indirect draw, indexed in the vertex shader by the draw's first instance.
+	// Indices come from the frame's shared raster index buffer, but geometries don't share vertex buffers,
+	// so the vertex shader pulls the indexed vertex through its geometry's device address.
+	struct RasterDraw
+	{
+		uint64_t vertices;
+		uint32_t object_index;
+		uint32_t padding;
+	};
+
+	// Commands recorded by the last raster pass. Binds stay the same however many render objects there are.
+	struct RasterPassStats
+	{
+		uint32_t draw_count;      // Geometries drawn.
+		uint32_t draw_call_count; // Indexed indirect draw calls the geometries were issued in.
+		uint32_t bind_count;      // Pipeline, descriptor set and index buffer bind calls.
 	};
 }
@@ -7,14 +7,26 @@
 namespace renderer
 {
 	const std::filesystem::path SPIRV_PREFIX{ "../shaders/" };
+	const std::filesystem::path PIPELINE_CACHE_DIRECTORY{ "../pipeline_cache/" };
 
 	// Path for a shader to signify that it's unused, eg. for hit groups.
 	const std::filesystem::path SHADER_UNUSED_PATH{ "" };
 
 	constexpr uint64_t NULL_HANDLE{ std::numeric_limits<uint64_t>().max() }; // Handle specifying null or invalid.
 	constexpr uint32_t MAX_BINDLESS_TEXTURES{ 512 };                         // Maximum number of texture descriptors in the bindless array.
+	constexpr uint32_t MIN_OBJECT_DATA_CAPACITY{ 1024 };                     // Initial number of render objects in each frame's object data buffer. Doubles when exceeded.
+	constexpr uint32_t MIN_RASTER_DRAW_CAPACITY{ 1024 };                     // Initial number of geometries in each frame's indirect draw buffer. Doubles when exceeded.
+	constexpr uint32_t MIN_RASTER_INDEX_CAPACITY{ 1 << 16 };                 // Initial number of indices in each frame's shared raster index buffer. Doubles when exceeded.
+	constexpr uint32_t MIN_TLAS_INSTANCE_CAPACITY{ 1024 };                   // Initial number of instances in each frame's TLAS. Doubles when exceeded.
+	constexpr uint32_t TLAS_REBUILD_INTERVAL{ 60 };                          // Consecutive refits of a frame's TLAS before it is rebuilt to restore its quality.
+	constexpr uint32_t BLAS_REBUILD_INTERVAL{ 30 };                          // Consecutive refits of a dynamic BLAS before it is rebuilt to restore its quality.
+	constexpr uint32_t MIN_DYNAMIC_GEOMETRY_CAPACITY{ 1024 };                // Minimum vertices and indices a dynamic geometry's buffers hold. Rounded up to a power of two.
+	constexpr uint64_t MIN_DYNAMIC_MESH_STAGING_SIZE{ 1 << 20 };             // Initial byte size of each frame's staging buffer for dynamic meshes. Doubles when exceeded.
+	constexpr uint64_t UPLOAD_RING_SIZE{ 64 << 20 };                         // Byte size of the persistently mapped staging ring for transfer queue uploads.
+	constexpr uint64_t UPLOAD_RING_ALIGNMENT{ 16 };                          // Alignment of each upload in the staging ring, enough for buffer to image copies of any texel size.
+	constexpr float STATIC_MESH_MAX_FACE_DENSITY{ 0.5f };                    // Exposed faces per chunk voxel above which static particles are meshed as cubes, see ExposedFaceDensity().
 
 	// Flags to change renderer functionality.
 	constexpr bool DYNAMIC_PARTICLE_MESH_CPU_BUILD{ true }; // Build dynamic particle meshes on CPU instead of GPU.
-	constexpr bool DISABLE_STATIC_PARTICLE_MESH{ true };    // For debugging. Draws static particles as individual cubes, not a shell.
+	constexpr bool DISABLE_STATIC_PARTICLE_MESH{ false };   // For debugging. Draws static particles as individual cubes, not a shell. Chunks over STATIC_MESH_MAX_FACE_DENSITY are always cubes.
 }
@@ -21,6 +21,9 @@ struct HitPayload
 
 const float pi = 3.14159265359;
 
+// Hit kind reported by the particle intersection shaders. Triangle hits use the built in front and back facing kinds.
+const uint PARTICLE_HIT_KIND = 0;
+
 // A single iteration of Bob Jenkins' One-At-A-Time hashing algorithm.
 uint Hash(uint x)
 {
@@ -1,7 +1,10 @@
 #version 460
+#extension GL_EXT_scalar_block_layout : enable
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_buffer_reference2 : require
+#extension GL_GOOGLE_include_directive : enable
 
-layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
+#include "common.glsl"
 
 layout (location = 0) out vec3 out_normal;
 
@@ -9,15 +12,38 @@ layout (set = 0, binding = 0) uniform CameraUBO {
     mat4 projection_view;
 } camera_ubo;
 
-layout (set = 1, binding = 0) uniform RenderObjectUBO {
+struct ObjectData {
     mat4 transform;
-} render_object_ubo;
+};
+
+// Every render object's data, indexed by render object handle.
+layout (std430, set = 1, binding = 0) readonly buffer ObjectDataBuffer {
+    ObjectData objects[];
+};
+
+// Vertex address of the geometry each indexed indirect draw renders.
+struct RasterDraw {
+    uint64_t vertices;
+    uint object_index;
+};
+
+// Indexed by the draw's first instance.
+layout (std430, set = 1, binding = 1) readonly buffer RasterDrawBuffer {
+    RasterDraw draws[];
+};
+
+layout (buffer_reference, scalar) readonly buffer Vertices { Vertex v[]; };
 
 void main()
 {
+    // Draws are indexed from the shared index buffer, so gl_VertexIndex is already the geometry's vertex index.
+    RasterDraw draw = draws[gl_InstanceIndex];
+    Vertex vertex = Vertices(draw.vertices).v[gl_VertexIndex];
+    mat4 transform = objects[draw.object_index].transform;
+
     // Ignore translation component of transform when transforming normal.
-    vec3 normal_transformed = mat3(render_object_ubo.transform) * normal;
+    vec3 normal_transformed = mat3(transform) * vertex.normal.xyz;
     out_normal = normalize(normal_transformed.xyz);
 
-    gl_Position = camera_ubo.projection_view * render_object_ubo.transform * vec4(position, 1.0);
+    gl_Position = camera_ubo.projection_view * transform * vec4(vertex.position.xyz, 1.0);
 }
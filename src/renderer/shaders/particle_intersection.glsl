@@ -0,0 +1,42 @@
+// Particles are ray traced as axis aligned boxes, laid out like VkAabbPositionsKHR, instead of triangles.
+struct Aabb
+{
+	vec3 min;
+	vec3 max;
+};
+
+struct ObjectBuffers
+{
+	uint64_t vertices; // The boxes of procedural geometries.
+	uint64_t indices;
+};
+
+layout(buffer_reference, scalar) readonly buffer Aabbs { Aabb a[]; };
+
+// Object space normal of the face the ray entered through. Must match the hit attribute of the closest-hit shader.
+hitAttributeEXT vec3 hit_normal;
+
+// Report where the ray enters the box of the primitive it's testing. Rays starting inside a box don't hit it,
+// so rays bouncing off a particle's surface don't hit that particle again.
+void IntersectParticle(Aabbs aabbs)
+{
+	Aabb aabb = aabbs.a[gl_PrimitiveID];
+
+	vec3 inverse_direction = 1.0 / gl_ObjectRayDirectionEXT;
+	vec3 t0 = (aabb.min - gl_ObjectRayOriginEXT) * inverse_direction;
+	vec3 t1 = (aabb.max - gl_ObjectRayOriginEXT) * inverse_direction;
+	vec3 t_near = min(t0, t1);
+	vec3 t_far = max(t0, t1);
+
+	float t_enter = max(max(t_near.x, t_near.y), t_near.z);
+	float t_exit = min(min(t_far.x, t_far.y), t_far.z);
+
+	if (t_enter > t_exit || t_enter < gl_RayTminEXT || t_enter > gl_RayTmaxEXT) {
+		return;
+	}
+
+	// The ray enters through a face of the axis whose slab it enters last.
+	vec3 axis = t_enter == t_near.x ? vec3(1.0, 0.0, 0.0) : (t_enter == t_near.y ? vec3(0.0, 1.0, 0.0) : vec3(0.0, 0.0, 1.0));
+	hit_normal = -sign(gl_ObjectRayDirectionEXT) * axis;
+	reportIntersectionEXT(t_enter, PARTICLE_HIT_KIND);
+}
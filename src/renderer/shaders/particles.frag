@@ -7,8 +7,9 @@ layout (location = 3) in float in_mass;
 
 layout (location = 0) out vec4 out_color;
 
+// Offset past the render object index used by the vertex stage.
 layout (push_constant) uniform PushConstant {
-    uint particle_color_mode;
+    layout (offset = 4) uint particle_color_mode;
     float max_value;
 } constants;
 
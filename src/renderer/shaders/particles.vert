@@ -18,9 +18,18 @@ layout (set = 0, binding = 0) uniform CameraUBO {
     mat4 projection_view;
 } camera_ubo;
 
-layout (set = 1, binding = 0) uniform RenderObjectUBO {
+struct ObjectData {
     mat4 transform;
-} render_object_ubo;
+};
+
+// Every render object's data, indexed by render object handle.
+layout (std430, set = 1, binding = 0) readonly buffer ObjectDataBuffer {
+    ObjectData objects[];
+};
+
+layout (push_constant) uniform RenderObjectPushConstant {
+    uint object_index;
+} render_object;
 
 void main()
 {
@@ -29,5 +38,5 @@ void main()
     out_velocity = velocity;
     out_debug_color = debug_color;
     out_mass = 1.0 / inverse_mass;
-    gl_Position = camera_ubo.projection_view * render_object_ubo.transform * vec4(final_position, 1.0);
+    gl_Position = camera_ubo.projection_view * objects[render_object.object_index].transform * vec4(final_position, 1.0);
 }
@@ -0,0 +1,292 @@
+#include "tlsf_allocator.h"
+
+#include <bit>
+#include <algorithm>
+
+#include "logger.h"
+
+namespace renderer
+{
+	void TlsfAllocator::Initialize(uint64_t size)
+	{
+		size_ = size;
+		used_bytes_ = 0;
+		allocation_count_ = 0;
+		blocks_.clear();
+		unused_blocks_.clear();
+		fl_bitmap_ = 0;
+		sl_bitmaps_.fill(0);
+		for (auto& heads : free_heads_) {
+			heads.fill(NULL_INDEX);
+		}
+
+		// The whole range starts as one free block.
+		uint32_t block{ NewBlock() };
+		blocks_[block].size = size;
+		InsertFree(block);
+	}
+
+	uint32_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		size = std::max<uint64_t>(size, 1);
+		alignment = std::max<uint64_t>(alignment, 1);
+
+		// Any block this big can fit the allocation wherever it's aligned to.
+		uint32_t block{ FindFreeBlock(size + alignment - 1) };
+		if (block == NULL_INDEX) {
+			return NULL_INDEX;
+		}
+		RemoveFree(block);
+
+		// Free the padding before the aligned offset. The block before it is in use, otherwise they'd have been merged.
+		uint64_t padding{ (alignment - blocks_[block].offset % alignment) % alignment };
+		if (padding > 0)
+		{
+			uint32_t front{ block };
+			block = Split(front, padding);
+			InsertFree(front);
+		}
+
+		if (blocks_[block].size > size) {
+			InsertFree(Split(block, size));
+		}
+
+		blocks_[block].state = BlockState::ALLOCATED;
+		used_bytes_ += blocks_[block].size;
+		++allocation_count_;
+		return block;
+	}
+
+	void TlsfAllocator::Free(uint32_t block)
+	{
+		// Also catches a block freed again after it was merged into a neighbour, since its handle is then unused.
+		if (block >= blocks_.size() || blocks_[block].state != BlockState::ALLOCATED)
+		{
+			logger::Error("Attempted to free a block that isn't allocated.\n");
+			return;
+		}
+
+		blocks_[block].state = BlockState::FREE;
+		used_bytes_ -= blocks_[block].size;
+		--allocation_count_;
+
+		uint32_t next{ blocks_[block].next_physical };
+		if (next != NULL_INDEX && blocks_[next].state == BlockState::FREE)
+		{
+			RemoveFree(next);
+			Merge(block, next);
+		}
+
+		uint32_t prev{ blocks_[block].prev_physical };
+		if (prev != NULL_INDEX && blocks_[prev].state == BlockState::FREE)
+		{
+			RemoveFree(prev);
+			Merge(prev, block);
+			block = prev;
+		}
+
+		InsertFree(block);
+	}
+
+	uint64_t TlsfAllocator::GetOffset(uint32_t block) const
+	{
+		return blocks_[block].offset;
+	}
+
+	uint64_t TlsfAllocator::GetSize() const
+	{
+		return size_;
+	}
+
+	bool TlsfAllocator::IsEmpty() const
+	{
+		return allocation_count_ == 0;
+	}
+
+	TlsfStats TlsfAllocator::GetStats() const
+	{
+		TlsfStats stats{
+			.used_bytes = used_bytes_,
+			.free_bytes = size_ - used_bytes_,
+			.largest_free_block = 0,
+			.allocation_count = allocation_count_,
+			.free_block_count = 0,
+		};
+
+		for (uint32_t fl{ 0 }; fl < FL_COUNT; ++fl)
+		{
+			for (uint32_t sl{ 0 }; sl < SL_COUNT; ++sl)
+			{
+				for (uint32_t block{ free_heads_[fl][sl] }; block != NULL_INDEX; block = blocks_[block].next_free)
+				{
+					stats.largest_free_block = std::max(stats.largest_free_block, blocks_[block].size);
+					++stats.free_block_count;
+				}
+			}
+		}
+
+		return stats;
+	}
+
+	void TlsfAllocator::MappingInsert(uint64_t size, uint32_t* out_fl, uint32_t* out_sl)
+	{
+		if (size < SL_COUNT)
+		{
+			// Small sizes get a linear class each.
+			*out_fl = 0;
+			*out_sl = (uint32_t)size;
+		}
+		else
+		{
+			uint32_t msb{ (uint32_t)std::bit_width(size) - 1 };
+			*out_fl = msb - SL_BITS + 1;
+			*out_sl = (uint32_t)(size >> (msb - SL_BITS)) ^ SL_COUNT;
+		}
+	}
+
+	void TlsfAllocator::MappingSearch(uint64_t size, uint32_t* out_fl, uint32_t* out_sl)
+	{
+		if (size >= SL_COUNT) {
+			size += (1ull << (std::bit_width(size) - 1 - SL_BITS)) - 1;
+		}
+		MappingInsert(size, out_fl, out_sl);
+	}
+
+	uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const
+	{
+		uint32_t fl{}, sl{};
+		MappingSearch(size, &fl, &sl);
+
+		if (fl < FL_COUNT)
+		{
+			uint32_t sl_map{ sl_bitmaps_[fl] & (~0u << sl) };
+			if (sl_map == 0)
+			{
+				uint64_t fl_map{ fl + 1 < 64 ? fl_bitmap_ & (~0ull << (fl + 1)) : 0 };
+				if (fl_map != 0)
+				{
+					fl = (uint32_t)std::countr_zero(fl_map);
+					sl_map = sl_bitmaps_[fl];
+				}
+			}
+
+			if (sl_map != 0) {
+				return free_heads_[fl][std::countr_zero(sl_map)];
+			}
+		}
+
+		// Rounding up the size class skips blocks in the requested size's own class, which may still fit. Such as the whole range.
+		MappingInsert(size, &fl, &sl);
+		for (uint32_t block{ free_heads_[fl][sl] }; block != NULL_INDEX; block = blocks_[block].next_free)
+		{
+			if (blocks_[block].size >= size) {
+				return block;
+			}
+		}
+
+		return NULL_INDEX;
+	}
+
+	void TlsfAllocator::InsertFree(uint32_t block)
+	{
+		uint32_t fl{}, sl{};
+		MappingInsert(blocks_[block].size, &fl, &sl);
+
+		uint32_t head{ free_heads_[fl][sl] };
+		blocks_[block].state = BlockState::FREE;
+		blocks_[block].prev_free = NULL_INDEX;
+		blocks_[block].next_free = head;
+		if (head != NULL_INDEX) {
+			blocks_[head].prev_free = block;
+		}
+
+		free_heads_[fl][sl] = block;
+		fl_bitmap_ |= 1ull << fl;
+		sl_bitmaps_[fl] |= 1u << sl;
+	}
+
+	void TlsfAllocator::RemoveFree(uint32_t block)
+	{
+		uint32_t fl{}, sl{};
+		MappingInsert(blocks_[block].size, &fl, &sl);
+
+		uint32_t prev{ blocks_[block].prev_free };
+		uint32_t next{ blocks_[block].next_free };
+		if (prev != NULL_INDEX) {
+			blocks_[prev].next_free = next;
+		}
+		else {
+			free_heads_[fl][sl] = next;
+		}
+		if (next != NULL_INDEX) {
+			blocks_[next].prev_free = prev;
+		}
+
+		if (free_heads_[fl][sl] == NULL_INDEX)
+		{
+			sl_bitmaps_[fl] &= ~(1u << sl);
+			if (sl_bitmaps_[fl] == 0) {
+				fl_bitmap_ &= ~(1ull << fl);
+			}
+		}
+		blocks_[block].state = BlockState::ALLOCATED;
+	}
+
+	uint32_t TlsfAllocator::Split(uint32_t block, uint64_t first_size)
+	{
+		uint32_t tail{ NewBlock() }; // May reallocate blocks_, so index it after.
+		Block& first{ blocks_[block] };
+		Block& second{ blocks_[tail] };
+
+		second.offset = first.offset + first_size;
+		second.size = first.size - first_size;
+		second.prev_physical = block;
+		second.next_physical = first.next_physical;
+		if (first.next_physical != NULL_INDEX) {
+			blocks_[first.next_physical].prev_physical = tail;
+		}
+
+		first.size = first_size;
+		first.next_physical = tail;
+		return tail;
+	}
+
+	void TlsfAllocator::Merge(uint32_t block, uint32_t next)
+	{
+		Block& first{ blocks_[block] };
+		first.size += blocks_[next].size;
+		first.next_physical = blocks_[next].next_physical;
+		if (first.next_physical != NULL_INDEX) {
+			blocks_[first.next_physical].prev_physical = block;
+		}
+
+		blocks_[next].state = BlockState::UNUSED;
+		unused_blocks_.push_back(next);
+	}
+
+	uint32_t TlsfAllocator::NewBlock()
+	{
+		uint32_t block{};
+		if (unused_blocks_.empty())
+		{
+			block = (uint32_t)blocks_.size();
+			blocks_.emplace_back();
+		}
+		else
+		{
+			block = unused_blocks_.back();
+			unused_blocks_.pop_back();
+		}
+
+		blocks_[block] = Block{
+			.offset = 0,
+			.size = 0,
+			.prev_physical = NULL_INDEX,
+			.next_physical = NULL_INDEX,
+			.prev_free = NULL_INDEX,
+			.next_free = NULL_INDEX,
+			.state = BlockState::ALLOCATED,
+		};
+		return block;
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+#include "common_constants.h"
+
+namespace renderer
+{
+	struct TlsfStats
+	{
+		uint64_t used_bytes;         // Bytes in allocated blocks, including splits too small to be worth keeping free.
+		uint64_t free_bytes;
+		uint64_t largest_free_block; // The largest allocation that is sure to succeed, ignoring alignment.
+		uint32_t allocation_count;
+		uint32_t free_block_count;
+	};
+
+	// Two level segregated fit sub-allocator over a range of offsets, such as a VkDeviceMemory allocation.
+	// Free blocks are kept in size classes, so allocating and freeing are constant time,
+	// and a freed block is merged with free neighbours so the range doesn't fragment over time.
+	// Only tracks offsets, and doesn't touch any memory itself.
+	class TlsfAllocator
+	{
+	public:
+		void Initialize(uint64_t size);
+
+		// Returns a handle to the allocated block, or NULL_INDEX if there isn't a free block big enough.
+		uint32_t Allocate(uint64_t size, uint64_t alignment);
+
+		void Free(uint32_t block);
+
+		uint64_t GetOffset(uint32_t block) const;
+
+		uint64_t GetSize() const;
+
+		bool IsEmpty() const;
+
+		TlsfStats GetStats() const;
+
+	private:
+		static constexpr uint32_t SL_BITS{ 4 };             // Each power of two size class is split into 2^SL_BITS linear classes.
+		static constexpr uint32_t SL_COUNT{ 1 << SL_BITS };
+		static constexpr uint32_t FL_COUNT{ 64 - SL_BITS + 1 };
+
+		enum class BlockState : uint8_t
+		{
+			ALLOCATED,
+			FREE,
+			UNUSED, // Merged into a neighbour, and its handle is waiting to be reused.
+		};
+
+		struct Block
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t prev_physical; // Neighbouring blocks in offset order.
+			uint32_t next_physical;
+			uint32_t prev_free;     // Neighbouring blocks in the same size class. Only used while free.
+			uint32_t next_free;
+			BlockState state;
+		};
+
+		// Size class that a block of this size is kept in.
+		static void MappingInsert(uint64_t size, uint32_t* out_fl, uint32_t* out_sl);
+
+		// Lowest size class whose blocks are all at least this size.
+		static void MappingSearch(uint64_t size, uint32_t* out_fl, uint32_t* out_sl);
+
+		uint32_t FindFreeBlock(uint64_t size) const;
+
+		void InsertFree(uint32_t block);
+
+		void RemoveFree(uint32_t block);
+
+		// Split the tail of block past first_size into a new block, which is returned.
+		uint32_t Split(uint32_t block, uint64_t first_size);
+
+		// Merge next into block, where next directly follows it. next's handle is recycled.
+		void Merge(uint32_t block, uint32_t next);
+
+		uint32_t NewBlock();
+
+		uint64_t size_{};
+		uint64_t used_bytes_{};
+		uint32_t allocation_count_{};
+		std::vector<Block> blocks_{};
+		std::vector<uint32_t> unused_blocks_{}; // Handles of merged blocks ready to be reused.
+		uint64_t fl_bitmap_{};                  // Bit per first level class with any free blocks.
+		std::array<uint32_t, FL_COUNT> sl_bitmaps_{};
+		std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> free_heads_{};
+	};
+}
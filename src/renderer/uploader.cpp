@@ -0,0 +1,411 @@
+#include "uploader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "tracy/Tracy.hpp"
+
+#include "vulkan_util.h"
+#include "renderer_constants.h"
+
+namespace renderer
+{
+	void Uploader::Initialize(Context* context, Allocator* alloc)
+	{
+		context_ = context;
+		alloc_ = alloc;
+		ownership_transfer_ = context_->GetTransferQueueFamilyIndex() != context_->GetGraphicsQueueFamilyIndex();
+		stats_ = UploaderStats{ .dedicated_transfer_queue = ownership_transfer_ };
+
+		VkCommandPoolCreateInfo command_pool_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = context_->GetTransferQueueFamilyIndex(),
+		};
+
+		VkResult result{ vkCreateCommandPool(context_->device, &command_pool_info, nullptr, &command_pool_) };
+		CheckResult(result, "Failed to create uploader command pool.");
+		NameObject(context_->device, command_pool_, "Uploader_Command_Pool");
+
+		VkSemaphoreTypeCreateInfo semaphore_type_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		VkSemaphoreCreateInfo semaphore_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &semaphore_type_info,
+		};
+
+		result = vkCreateSemaphore(context_->device, &semaphore_info, nullptr, &timeline_);
+		CheckResult(result, "Failed to create uploader timeline semaphore.");
+		NameObject(context_->device, timeline_, "Uploader_Timeline_Semaphore");
+
+		ring_ = alloc_->CreateMappedBufferResource(UPLOAD_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&ring_mapped_);
+		NameObject(context_->device, ring_.buffer, "Uploader_Staging_Ring");
+	}
+
+	void Uploader::CleanUp()
+	{
+		WaitIdle();
+
+		alloc_->DestroyBufferResource(&ring_);
+		vkDestroySemaphore(context_->device, timeline_, nullptr);
+
+		// Destroying command pool frees all command buffers allocated from it.
+		vkDestroyCommandPool(context_->device, command_pool_, nullptr);
+	}
+
+	UploadTicket Uploader::UploadBuffer(const void* data, VkDeviceSize size, const BufferResource& dst, VkDeviceSize dst_offset)
+	{
+		if (size == 0) {
+			return submitted_ticket_;
+		}
+
+		auto [staging, staging_offset] { Stage(data, size) };
+		VkCommandBuffer cmd{ RecordingCmd() };
+
+		VkBufferCopy region{
+			.srcOffset = staging_offset,
+			.dstOffset = dst_offset,
+			.size = size,
+		};
+		vkCmdCopyBuffer(cmd, staging, dst.buffer, 1, &region);
+
+		if (ownership_transfer_)
+		{
+			buffer_releases_.push_back(VkBufferMemoryBarrier{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = 0,
+				.srcQueueFamilyIndex = context_->GetTransferQueueFamilyIndex(),
+				.dstQueueFamilyIndex = context_->GetGraphicsQueueFamilyIndex(),
+				.buffer = dst.buffer,
+				.offset = dst_offset,
+				.size = size,
+			});
+		}
+
+		return submitted_ticket_ + 1;
+	}
+
+	UploadTicket Uploader::UploadImage(const void* data, VkDeviceSize size, const ImageResource& image, VkImageLayout final_layout)
+	{
+		auto [staging, staging_offset] { Stage(data, size) };
+		VkCommandBuffer cmd{ RecordingCmd() };
+
+		PipelineBarrier(
+			cmd, image.image,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+		VkBufferImageCopy image_copy{
+			.bufferOffset = staging_offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.imageOffset = {0, 0, 0},
+			.imageExtent = {
+				.width = image.extent.width,
+				.height = image.extent.height,
+				.depth = 1,
+			},
+		};
+		vkCmdCopyBufferToImage(cmd, staging, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_copy);
+
+		// The layout transition is recorded with the batch's releases. Without a family change, it's an ordinary barrier.
+		image_releases_.push_back(VkImageMemoryBarrier{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = 0,
+			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.newLayout = final_layout,
+			.srcQueueFamilyIndex = ownership_transfer_ ? context_->GetTransferQueueFamilyIndex() : VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = ownership_transfer_ ? context_->GetGraphicsQueueFamilyIndex() : VK_QUEUE_FAMILY_IGNORED,
+			.image = image.image,
+			.subresourceRange = {
+				.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+		});
+
+		return submitted_ticket_ + 1;
+	}
+
+	UploadTicket Uploader::Submit()
+	{
+		ZoneScoped;
+		ReclaimCompleted();
+
+		if (!recording_.cmd) {
+			return submitted_ticket_;
+		}
+
+		// Release everything uploaded this batch in one barrier. The graphics queue acquires it after waiting on the timeline.
+		if (!buffer_releases_.empty() || !image_releases_.empty())
+		{
+			vkCmdPipelineBarrier(
+				recording_.cmd,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0,
+				0, nullptr,
+				(uint32_t)buffer_releases_.size(), buffer_releases_.data(),
+				(uint32_t)image_releases_.size(), image_releases_.data());
+		}
+
+		VkResult result{ vkEndCommandBuffer(recording_.cmd) };
+		CheckResult(result, "Failed to end uploader command buffer.");
+
+		recording_.ticket = submitted_ticket_ + 1;
+		recording_.ring_end = ring_head_;
+
+		VkTimelineSemaphoreSubmitInfo timeline_info{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.signalSemaphoreValueCount = 1,
+			.pSignalSemaphoreValues = &recording_.ticket,
+		};
+
+		VkSubmitInfo submit_info{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.pNext = &timeline_info,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &recording_.cmd,
+			.signalSemaphoreCount = 1,
+			.pSignalSemaphores = &timeline_,
+		};
+
+		result = vkQueueSubmit(context_->transfer_queue, 1, &submit_info, VK_NULL_HANDLE);
+		CheckResult(result, "Error submitting uploader batch.");
+
+		submitted_ticket_ = recording_.ticket;
+		in_flight_.push_back(std::move(recording_));
+		recording_ = {};
+		++stats_.batch_count;
+
+		// Only acquire what has been released by a submitted batch.
+		if (ownership_transfer_)
+		{
+			for (VkBufferMemoryBarrier& barrier : buffer_releases_)
+			{
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				buffer_acquires_.push_back(barrier);
+			}
+			for (VkImageMemoryBarrier& barrier : image_releases_)
+			{
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+				image_acquires_.push_back(barrier);
+			}
+		}
+		buffer_releases_.clear();
+		image_releases_.clear();
+
+		return submitted_ticket_;
+	}
+
+	bool Uploader::IsComplete(UploadTicket ticket)
+	{
+		uint64_t completed{};
+		VkResult result{ vkGetSemaphoreCounterValue(context_->device, timeline_, &completed) };
+		CheckResult(result, "Error getting uploader timeline semaphore value.");
+		return completed >= ticket;
+	}
+
+	void Uploader::Wait(UploadTicket ticket)
+	{
+		if (IsComplete(ticket)) {
+			return;
+		}
+
+		ZoneScoped;
+		if (ticket > submitted_ticket_) {
+			Submit();
+		}
+
+		VkSemaphoreWaitInfo wait_info{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.semaphoreCount = 1,
+			.pSemaphores = &timeline_,
+			.pValues = &ticket,
+		};
+
+		VkResult result{ vkWaitSemaphores(context_->device, &wait_info, std::numeric_limits<uint64_t>::max()) };
+		CheckResult(result, "Error waiting for uploader timeline semaphore.");
+		ReclaimCompleted();
+	}
+
+	void Uploader::WaitIdle()
+	{
+		Wait(recording_.cmd ? submitted_ticket_ + 1 : submitted_ticket_);
+	}
+
+	void Uploader::CmdAcquire(VkCommandBuffer cmd)
+	{
+		if (buffer_acquires_.empty() && image_acquires_.empty()) {
+			return;
+		}
+
+		vkCmdPipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			0, nullptr,
+			(uint32_t)buffer_acquires_.size(), buffer_acquires_.data(),
+			(uint32_t)image_acquires_.size(), image_acquires_.data());
+
+		buffer_acquires_.clear();
+		image_acquires_.clear();
+	}
+
+	void Uploader::Forget(VkBuffer buffer)
+	{
+		auto same_buffer = [buffer](const VkBufferMemoryBarrier& barrier) { return barrier.buffer == buffer; };
+		std::erase_if(buffer_releases_, same_buffer);
+		std::erase_if(buffer_acquires_, same_buffer);
+	}
+
+	VkSemaphore Uploader::GetSemaphore() const
+	{
+		return timeline_;
+	}
+
+	UploadTicket Uploader::GetSubmittedTicket() const
+	{
+		return submitted_ticket_;
+	}
+
+	const UploaderStats& Uploader::GetStats() const
+	{
+		return stats_;
+	}
+
+	VkCommandBuffer Uploader::RecordingCmd()
+	{
+		if (recording_.cmd) {
+			return recording_.cmd;
+		}
+
+		if (free_cmds_.empty())
+		{
+			VkCommandBufferAllocateInfo alloc_info{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.commandPool = command_pool_,
+				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1,
+			};
+
+			VkCommandBuffer cmd{};
+			VkResult result{ vkAllocateCommandBuffers(context_->device, &alloc_info, &cmd) };
+			CheckResult(result, "Failed to allocate uploader command buffer.");
+			free_cmds_.push_back(cmd);
+		}
+
+		recording_.cmd = free_cmds_.back();
+		free_cmds_.pop_back();
+
+		VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+
+		VkResult result{ vkBeginCommandBuffer(recording_.cmd, &begin_info) };
+		CheckResult(result, "Failed to begin uploader command buffer.");
+
+		return recording_.cmd;
+	}
+
+	uint64_t Uploader::AllocateRing(VkDeviceSize size)
+	{
+		while (true)
+		{
+			ReclaimCompleted();
+
+			// Start again from the beginning of the ring when none of it is in use.
+			if (ring_tail_ == ring_head_) {
+				ring_head_ = ring_tail_ = AlignUp(ring_head_, UPLOAD_RING_SIZE);
+			}
+
+			// Each upload is contiguous, so skip to the start of the ring rather than wrapping around its end.
+			uint64_t position{ AlignUp(ring_head_, UPLOAD_RING_ALIGNMENT) };
+			if (position % UPLOAD_RING_SIZE + size > UPLOAD_RING_SIZE) {
+				position = AlignUp(position, UPLOAD_RING_SIZE);
+			}
+
+			if (position + size - ring_tail_ <= UPLOAD_RING_SIZE)
+			{
+				ring_head_ = position + size;
+				return position;
+			}
+
+			// The ring is full of staging data the transfer queue hasn't read yet, so wait for the oldest batch.
+			ZoneScopedN("Upload ring stall");
+			if (in_flight_.empty()) {
+				Submit();
+			}
+			++stats_.ring_stall_count;
+			Wait(in_flight_.front().ticket);
+		}
+	}
+
+	std::pair<VkBuffer, VkDeviceSize> Uploader::Stage(const void* data, VkDeviceSize size)
+	{
+		stats_.uploaded_bytes += size;
+
+		if (size > UPLOAD_RING_SIZE)
+		{
+			++stats_.oversized_count;
+			void* mapped{};
+			BufferResource staging{ alloc_->CreateMappedBufferResource(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &mapped) };
+			NameObject(context_->device, staging.buffer, "Uploader_Oversized_Staging_Buffer");
+
+			std::memcpy(mapped, data, size);
+			alloc_->FlushBufferResource(staging, 0, size);
+			recording_.oversized.push_back(staging);
+			return { staging.buffer, 0 };
+		}
+
+		VkDeviceSize offset{ AllocateRing(size) % UPLOAD_RING_SIZE };
+		std::memcpy(ring_mapped_ + offset, data, size);
+		alloc_->FlushBufferResource(ring_, offset, size);
+		return { ring_.buffer, offset };
+	}
+
+	void Uploader::ReclaimCompleted()
+	{
+		if (in_flight_.empty()) {
+			return;
+		}
+
+		uint64_t completed{};
+		VkResult result{ vkGetSemaphoreCounterValue(context_->device, timeline_, &completed) };
+		CheckResult(result, "Error getting uploader timeline semaphore value.");
+
+		while (!in_flight_.empty() && in_flight_.front().ticket <= completed)
+		{
+			Batch& batch{ in_flight_.front() };
+			ring_tail_ = batch.ring_end;
+
+			for (BufferResource& staging : batch.oversized) {
+				alloc_->DestroyBufferResource(&staging);
+			}
+
+			result = vkResetCommandBuffer(batch.cmd, 0);
+			CheckResult(result, "Error resetting uploader command buffer.");
+			free_cmds_.push_back(batch.cmd);
+
+			in_flight_.pop_front();
+		}
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <utility>
+#include "volk.h"
+
+#include "context.h"
+#include "memory_allocator.h"
+
+namespace renderer
+{
+	// Timeline semaphore value that signals once an upload has finished on the transfer queue.
+	using UploadTicket = uint64_t;
+
+	// Counts since the renderer started.
+	struct UploaderStats
+	{
+		uint64_t uploaded_bytes;       // Bytes copied from the host to buffers and images.
+		uint32_t batch_count;          // Transfer queue submissions, usually one per frame with uploads.
+		uint32_t ring_stall_count;     // Times the host waited for a batch to finish to free staging ring space.
+		uint32_t oversized_count;      // Uploads larger than the staging ring, which used a staging buffer of their own.
+		bool dedicated_transfer_queue; // False if uploads share the graphics queue.
+	};
+
+	// Uploads host data to device local buffers and images on the transfer queue without the host waiting per upload.
+	// Data is staged in a persistently mapped ring buffer, and uploads are batched into one submission per Submit(),
+	// which signals a timeline semaphore with the batch's ticket.
+	//
+	// Graphics submissions that read uploaded resources must wait on GetSemaphore() at GetSubmittedTicket(),
+	// and record CmdAcquire() first to take queue family ownership of resources uploaded since the last acquire.
+	// Only upload to resources that nothing in flight is using, such as ones just created.
+	class Uploader
+	{
+	public:
+		void Initialize(Context* context, Allocator* alloc);
+
+		void CleanUp();
+
+		// Copy size bytes of data to dst at dst_offset.
+		UploadTicket UploadBuffer(const void* data, VkDeviceSize size, const BufferResource& dst, VkDeviceSize dst_offset = 0);
+
+		template <typename T>
+		UploadTicket UploadBuffer(const std::vector<T>& data, const BufferResource& dst)
+		{
+			return UploadBuffer(data.data(), data.size() * sizeof(T), dst);
+		}
+
+		// Copy data to the whole first mip level and layer of image, discarding its contents, and leave it in final_layout.
+		UploadTicket UploadImage(const void* data, VkDeviceSize size, const ImageResource& image, VkImageLayout final_layout);
+
+		// Submit the uploads recorded since the last submission, if any.
+		// Returns the ticket of the last submitted batch.
+		UploadTicket Submit();
+
+		bool IsComplete(UploadTicket ticket);
+
+		// Block until the upload has finished, submitting its batch first if it hasn't been.
+		void Wait(UploadTicket ticket);
+
+		// Block until all recorded uploads have finished.
+		void WaitIdle();
+
+		// Record the acquiring half of queue family ownership transfers for everything uploaded since the last call.
+		// Does nothing if uploads share the graphics queue family.
+		void CmdAcquire(VkCommandBuffer cmd);
+
+		// Drop pending ownership transfers of a buffer, so a destroyed buffer isn't acquired later.
+		void Forget(VkBuffer buffer);
+
+		VkSemaphore GetSemaphore() const;
+
+		UploadTicket GetSubmittedTicket() const;
+
+		const UploaderStats& GetStats() const;
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer cmd;
+			UploadTicket ticket;
+			uint64_t ring_end;                       // Ring position past this batch's staging data.
+			std::vector<BufferResource> oversized{}; // Staging buffers of uploads too large for the ring.
+		};
+
+		// Start recording a batch if one isn't already.
+		VkCommandBuffer RecordingCmd();
+
+		// Reserve size bytes of the staging ring, waiting for batches to finish if it's full.
+		// Returns the ring position, which wraps around modulo UPLOAD_RING_SIZE.
+		uint64_t AllocateRing(VkDeviceSize size);
+
+		// Stage data, either in the ring or in an oversized buffer. Returns the staging buffer and its offset.
+		std::pair<VkBuffer, VkDeviceSize> Stage(const void* data, VkDeviceSize size);
+
+		// Recycle the command buffers and staging space of batches that have finished.
+		void ReclaimCompleted();
+
+		Context* context_{};
+		Allocator* alloc_{};
+		bool ownership_transfer_{}; // Transfer and graphics queues are in different families.
+
+		VkCommandPool command_pool_{};
+		VkSemaphore timeline_{};
+		BufferResource ring_{};
+		std::byte* ring_mapped_{};
+		uint64_t ring_head_{}; // Total bytes ever allocated from the ring. The write position is this modulo UPLOAD_RING_SIZE.
+		uint64_t ring_tail_{}; // Ring position of the oldest staging data still in use.
+
+		Batch recording_{};             // Batch being recorded, whose cmd is null if nothing has been recorded.
+		std::deque<Batch> in_flight_{}; // Submitted batches, oldest first.
+		std::vector<VkCommandBuffer> free_cmds_{};
+		UploadTicket submitted_ticket_{};
+
+		std::vector<VkBufferMemoryBarrier> buffer_releases_{}; // Recorded when the batch is submitted.
+		std::vector<VkImageMemoryBarrier> image_releases_{};
+		std::vector<VkBufferMemoryBarrier> buffer_acquires_{}; // Released by a submitted batch, waiting for CmdAcquire().
+		std::vector<VkImageMemoryBarrier> image_acquires_{};
+
+		UploaderStats stats_{};
+	};
+}
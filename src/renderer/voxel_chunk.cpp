@@ -0,0 +1,673 @@
+#include "voxel_chunk.h"
+
+#include <execution>
+#include <atomic>
+#include <algorithm>
+#include <ranges>
+#include "tracy/Tracy.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+
+namespace renderer
+{
+	// Index of a voxel within its brick.
+	static uint32_t LocalBrickIndex(const glm::uvec3& coord)
+	{
+		glm::uvec3 local{ coord % VOXEL_BRICK_WIDTH };
+		return local.x + local.y * VOXEL_BRICK_WIDTH + local.z * VOXEL_BRICK_WIDTH * VOXEL_BRICK_WIDTH;
+	}
+
+	VoxelChunk::VoxelChunk()
+		: VoxelChunk{ 1, 1, 1 } // Dummy voxel chunk.
+	{
+	}
+
+	// Dimensions of the chunk to make, or those of a dummy chunk if they are invalid.
+	static glm::uvec3 CheckedDimensions(const glm::uvec3& dimensions)
+	{
+		if (!VoxelChunk::ValidDimensions(dimensions))
+		{
+			logger::Error("Voxel chunk dimensions %u x %u x %u must be between 1 and %u, making an empty 1 x 1 x 1 chunk instead.\n",
+				dimensions.x, dimensions.y, dimensions.z, CHUNK_ROW_VOXEL_COUNT);
+			return glm::uvec3{ 1 };
+		}
+		return dimensions;
+	}
+
+	VoxelChunk::VoxelChunk(uint32_t width, uint32_t height, uint32_t depth)
+		: VoxelChunk{ CheckedDimensions(glm::uvec3{ width, height, depth }) }
+	{
+	}
+
+	VoxelChunk::VoxelChunk(const glm::uvec3& dimensions)
+		: width_{ dimensions.x }
+		, height_{ dimensions.y }
+		, depth_{ dimensions.z }
+		, width_height_slice_{ dimensions.x * dimensions.y }
+		, brick_dimensions_{ (dimensions + VOXEL_BRICK_WIDTH - 1u) / VOXEL_BRICK_WIDTH }
+	{
+		brick_map_.resize((size_t)brick_dimensions_.x * brick_dimensions_.y * brick_dimensions_.z, EMPTY_BRICK);
+	}
+
+	VoxelChunk::VoxelChunk(uint32_t width, uint32_t height, uint32_t depth, std::vector<std::pair<Voxel, glm::uvec3>>&& voxel_pairs)
+		: VoxelChunk(width, height, depth)
+	{
+		// Insert voxels serially since bricks are allocated on demand and share occupancy words.
+		for (const auto& [voxel, coord] : voxel_pairs)
+		{
+			if (voxel.physics_material_index == PHYSICS_MATERIAL_EMPTY_INDEX || !InBounds(coord)) {
+				continue;
+			}
+
+			uint32_t& brick_idx{ brick_map_[BrickMapIndex(coord)] };
+			if (brick_idx == EMPTY_BRICK) {
+				brick_idx = AllocateBrick();
+			}
+
+			uint32_t local{ LocalBrickIndex(coord) };
+			bricks_[brick_idx].voxels[local] = voxel;
+			bricks_[brick_idx].occupancy[local / 64] |= 1ull << (local % 64);
+		}
+
+		std::vector<uint64_t> rows{ OccupancyRows() };
+		RebuildSideFlags(rows);
+		RebuildOuterVoxels(rows);
+	}
+
+	void VoxelChunk::AssignDense(const std::vector<Voxel>& voxels, const std::vector<uint8_t>& side_flags)
+	{
+		ZoneScoped;
+
+		std::fill(brick_map_.begin(), brick_map_.end(), EMPTY_BRICK);
+		bricks_.clear();
+		vacant_bricks_.clear();
+		outer_voxels_.clear();
+
+		// Find occupied bricks in parallel, then allocate them in order and fill them in parallel.
+		std::vector<uint8_t> brick_occupied(brick_map_.size());
+		auto brick_indices{ std::views::iota(0u, (uint32_t)brick_map_.size()) };
+		auto brick_origin = [&](uint32_t brick) {
+			return glm::uvec3{
+				brick % brick_dimensions_.x,
+				(brick / brick_dimensions_.x) % brick_dimensions_.y,
+				brick / (brick_dimensions_.x * brick_dimensions_.y) } * VOXEL_BRICK_WIDTH;
+			};
+		auto for_each_brick_voxel = [&](uint32_t brick, auto&& func) {
+			glm::uvec3 origin{ brick_origin(brick) };
+			glm::uvec3 end{ glm::min(origin + VOXEL_BRICK_WIDTH, glm::uvec3{ width_, height_, depth_ }) };
+			for (uint32_t k{ origin.z }; k < end.z; ++k) {
+				for (uint32_t j{ origin.y }; j < end.y; ++j) {
+					for (uint32_t i{ origin.x }; i < end.x; ++i) {
+						func(glm::uvec3{ i, j, k });
+					}
+				}
+			}
+			};
+
+		std::for_each(std::execution::par, brick_indices.begin(), brick_indices.end(),
+			[&](uint32_t brick) {
+				for_each_brick_voxel(brick, [&](const glm::uvec3& coord) {
+					if (voxels[CoordinateToIndex(coord)].physics_material_index != PHYSICS_MATERIAL_EMPTY_INDEX) {
+						brick_occupied[brick] = 1;
+					}
+					});
+			});
+
+		for (uint32_t brick{ 0 }; brick < (uint32_t)brick_map_.size(); ++brick)
+		{
+			if (brick_occupied[brick]) {
+				brick_map_[brick] = AllocateBrick();
+			}
+		}
+
+		std::for_each(std::execution::par, brick_indices.begin(), brick_indices.end(),
+			[&](uint32_t brick) {
+				if (!brick_occupied[brick]) {
+					return;
+				}
+
+				VoxelBrick& voxel_brick{ bricks_[brick_map_[brick]] };
+				for_each_brick_voxel(brick, [&](const glm::uvec3& coord) {
+					uint32_t idx{ CoordinateToIndex(coord) };
+					if (voxels[idx].physics_material_index == PHYSICS_MATERIAL_EMPTY_INDEX) {
+						return;
+					}
+
+					uint32_t local{ LocalBrickIndex(coord) };
+					voxel_brick.voxels[local] = voxels[idx];
+					if (!side_flags.empty()) {
+						voxel_brick.side_flags[local] = side_flags[idx];
+					}
+					voxel_brick.occupancy[local / 64] |= 1ull << (local % 64);
+					});
+			});
+	}
+
+	void VoxelChunk::AssignDense(const std::vector<Voxel>& voxels)
+	{
+		AssignDense(voxels, {});
+
+		std::vector<uint64_t> rows{ OccupancyRows() };
+		RebuildSideFlags(rows);
+		RebuildOuterVoxels(rows);
+	}
+
+	void VoxelChunk::AssignRuns(const std::vector<std::pair<Voxel, uint32_t>>& runs)
+	{
+		ZoneScoped;
+
+		std::fill(brick_map_.begin(), brick_map_.end(), EMPTY_BRICK);
+		bricks_.clear();
+		vacant_bricks_.clear();
+		outer_voxels_.clear();
+
+		size_t run_total{ 0 };
+		for (const auto& [voxel, length] : runs) {
+			run_total += length;
+		}
+		if (run_total != VoxelCount())
+		{
+			logger::Error("Voxel runs cover %zu voxels of a chunk with %u.\n", run_total, VoxelCount());
+			return;
+		}
+
+		uint32_t idx{ 0 };
+		for (const auto& [voxel, length] : runs)
+		{
+			const uint32_t run_end{ idx + length };
+			if (voxel.physics_material_index == PHYSICS_MATERIAL_EMPTY_INDEX)
+			{
+				idx = run_end;
+				continue;
+			}
+
+			// Split the run into pieces that stay within a row of a brick, which are contiguous in the brick.
+			while (idx < run_end)
+			{
+				glm::uvec3 coord{ IndexToCoordinate(idx) };
+				uint32_t count{ std::min({ run_end - idx, width_ - coord.x, VOXEL_BRICK_WIDTH - coord.x % VOXEL_BRICK_WIDTH }) };
+
+				uint32_t& brick_idx{ brick_map_[BrickMapIndex(coord)] };
+				if (brick_idx == EMPTY_BRICK) {
+					brick_idx = AllocateBrick();
+				}
+
+				VoxelBrick& brick{ bricks_[brick_idx] };
+				uint32_t local{ LocalBrickIndex(coord) };
+				std::fill_n(brick.voxels.begin() + local, count, voxel);
+				brick.occupancy[local / 64] |= ((1ull << count) - 1) << (local % 64);
+				idx += count;
+			}
+		}
+
+		std::vector<uint64_t> rows{ OccupancyRows() };
+		RebuildSideFlags(rows);
+		RebuildOuterVoxels(rows);
+	}
+
+	void VoxelChunk::SetVoxel(const glm::uvec3& coord, const Voxel& voxel)
+	{
+		const bool empty{ voxel.physics_material_index == PHYSICS_MATERIAL_EMPTY_INDEX };
+		uint32_t& brick_idx{ brick_map_[BrickMapIndex(coord)] };
+		if (brick_idx == EMPTY_BRICK)
+		{
+			if (empty) {
+				return;
+			}
+			brick_idx = AllocateBrick();
+		}
+
+		VoxelBrick& brick{ bricks_[brick_idx] };
+		uint32_t local{ LocalBrickIndex(coord) };
+		uint64_t bit{ 1ull << (local % 64) };
+		brick.voxels[local] = voxel;
+		if (empty) {
+			brick.occupancy[local / 64] &= ~bit;
+		}
+		else {
+			brick.occupancy[local / 64] |= bit;
+		}
+		brick.side_flags[local] = empty ? 0 : ComputeSideFlags(coord);
+
+		// The side flags of the neighbors that face this voxel have changed too.
+		constexpr glm::ivec3 offsets[6]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		for (const glm::ivec3& offset : offsets)
+		{
+			glm::uvec3 neighbor_coord{ glm::ivec3{ coord } + offset };
+			if (InBounds(neighbor_coord) && !IsEmpty(neighbor_coord)) {
+				bricks_[brick_map_[BrickMapIndex(neighbor_coord)]].side_flags[LocalBrickIndex(neighbor_coord)] = ComputeSideFlags(neighbor_coord);
+			}
+		}
+
+		// Free the brick once its last voxel is removed.
+		if (empty && std::all_of(brick.occupancy.begin(), brick.occupancy.end(), [](uint64_t word) { return word == 0; }))
+		{
+			vacant_bricks_.push_back(brick_idx);
+			brick_idx = EMPTY_BRICK;
+		}
+	}
+
+	void VoxelChunk::RebuildOuterVoxels()
+	{
+		RebuildOuterVoxels(OccupancyRows());
+	}
+
+	std::vector<uint64_t> VoxelChunk::OccupancyRows() const
+	{
+		std::vector<uint64_t> rows((size_t)height_ * depth_);
+
+		// Slabs of bricks along z write to distinct rows, so they are gathered in parallel.
+		auto slabs{ std::views::iota(0u, brick_dimensions_.z) };
+		std::for_each(std::execution::par, slabs.begin(), slabs.end(),
+			[&](uint32_t bz) {
+				for (uint32_t by{ 0 }; by < brick_dimensions_.y; ++by)
+				{
+					for (uint32_t bx{ 0 }; bx < brick_dimensions_.x; ++bx)
+					{
+						uint32_t brick_idx{ brick_map_[bx + by * brick_dimensions_.x + bz * brick_dimensions_.x * brick_dimensions_.y] };
+						if (brick_idx == EMPTY_BRICK) {
+							continue;
+						}
+
+						const VoxelBrick& brick{ bricks_[brick_idx] };
+						uint32_t z_end{ std::min(VOXEL_BRICK_WIDTH, depth_ - bz * VOXEL_BRICK_WIDTH) };
+						uint32_t y_end{ std::min(VOXEL_BRICK_WIDTH, height_ - by * VOXEL_BRICK_WIDTH) };
+						for (uint32_t z{ 0 }; z < z_end; ++z)
+						{
+							for (uint32_t y{ 0 }; y < y_end; ++y)
+							{
+								// Each byte of an occupancy word is one row of the brick.
+								uint64_t bits{ (brick.occupancy[z] >> (y * VOXEL_BRICK_WIDTH)) & 0xFF };
+								uint32_t row{ (by * VOXEL_BRICK_WIDTH + y) + (bz * VOXEL_BRICK_WIDTH + z) * height_ };
+								rows[row] |= bits << (bx * VOXEL_BRICK_WIDTH);
+							}
+						}
+					}
+				}
+			});
+
+		return rows;
+	}
+
+	// Grow set bits through contiguous free bits in both directions along a row, with Kogge-Stone occluded fills.
+	static uint64_t FillRow(uint64_t seeds, uint64_t free)
+	{
+		uint64_t up{ seeds };
+		uint64_t up_free{ free };
+		uint64_t down{ seeds };
+		uint64_t down_free{ free };
+		for (uint32_t shift{ 1 }; shift < 64; shift *= 2)
+		{
+			up |= up_free & (up << shift);
+			up_free &= up_free << shift;
+			down |= down_free & (down >> shift);
+			down_free &= down_free >> shift;
+		}
+		return up | down;
+	}
+
+	std::vector<uint64_t> VoxelChunk::ExteriorRows(const std::vector<uint64_t>& rows) const
+	{
+		ZoneScoped;
+
+		const uint64_t row_mask{ width_ == 64 ? ~0ull : (1ull << width_) - 1 };
+		const uint64_t boundary_bits{ 1ull | (1ull << (width_ - 1)) };
+
+		// Seed with the empty voxels on the boundary of the chunk.
+		std::vector<uint64_t> exterior(rows.size());
+		for (uint32_t z{ 0 }; z < depth_; ++z)
+		{
+			for (uint32_t y{ 0 }; y < height_; ++y)
+			{
+				uint32_t row{ y + z * height_ };
+				uint64_t free{ ~rows[row] & row_mask };
+				bool boundary_row{ y == 0 || y == height_ - 1 || z == 0 || z == depth_ - 1 };
+				exterior[row] = FillRow(boundary_row ? free : free & boundary_bits, free);
+			}
+		}
+
+		// Dilate until nothing changes. Each slab sweeps its rows up and down, reading neighboring slabs from the previous pass.
+		std::vector<uint64_t> previous{};
+		auto slabs{ std::views::iota(0u, depth_) };
+		std::atomic_bool changed{ true };
+		while (changed.load(std::memory_order_relaxed))
+		{
+			changed.store(false, std::memory_order_relaxed);
+			previous = exterior;
+
+			std::for_each(std::execution::par, slabs.begin(), slabs.end(),
+				[&](uint32_t z) {
+					bool slab_changed{ false };
+					auto dilate = [&](uint32_t y) {
+						uint32_t row{ y + z * height_ };
+						uint64_t free{ ~rows[row] & row_mask };
+						uint64_t seeds{ exterior[row] };
+						if (y > 0) {
+							seeds |= exterior[row - 1];
+						}
+						if (y < height_ - 1) {
+							seeds |= exterior[row + 1];
+						}
+						if (z > 0) {
+							seeds |= previous[row - height_];
+						}
+						if (z < depth_ - 1) {
+							seeds |= previous[row + height_];
+						}
+
+						uint64_t filled{ FillRow(seeds & free, free) };
+						if (filled != exterior[row])
+						{
+							exterior[row] = filled;
+							slab_changed = true;
+						}
+						};
+
+					for (uint32_t y{ 0 }; y < height_; ++y) {
+						dilate(y);
+					}
+					for (uint32_t y{ height_ }; y-- > 0;) {
+						dilate(y);
+					}
+
+					if (slab_changed) {
+						changed.store(true, std::memory_order_relaxed);
+					}
+				});
+		}
+
+		return exterior;
+	}
+
+	void VoxelChunk::RebuildSideFlags(const std::vector<uint64_t>& rows)
+	{
+		auto row_at = [&](uint32_t y, uint32_t z) {
+			// Unsigned underflow makes y - 1 and z - 1 out of bounds as well.
+			return (y < height_ && z < depth_) ? rows[y + z * height_] : 0ull;
+			};
+
+		// Neighbor occupancy of a whole row is the neighboring row, or the row shifted by one along x.
+		auto slices{ std::views::iota(0u, depth_) };
+		std::for_each(std::execution::par, slices.begin(), slices.end(),
+			[&](uint32_t z) {
+				for (uint32_t y{ 0 }; y < height_; ++y)
+				{
+					uint64_t occupied{ rows[y + z * height_] };
+					uint64_t x_positive{ occupied >> 1 };
+					uint64_t x_negative{ occupied << 1 };
+					uint64_t y_positive{ row_at(y + 1, z) };
+					uint64_t y_negative{ row_at(y - 1, z) };
+					uint64_t z_positive{ row_at(y, z + 1) };
+					uint64_t z_negative{ row_at(y, z - 1) };
+
+					while (occupied)
+					{
+						uint32_t x{ (uint32_t)std::countr_zero(occupied) };
+						occupied &= occupied - 1;
+
+						uint8_t flags{ (uint8_t)(
+							((x_positive >> x) & 1) * (uint8_t)VoxelSidesFlagBits::X_POSITIVE |
+							((x_negative >> x) & 1) * (uint8_t)VoxelSidesFlagBits::X_NEGATIVE |
+							((y_positive >> x) & 1) * (uint8_t)VoxelSidesFlagBits::Y_POSITIVE |
+							((y_negative >> x) & 1) * (uint8_t)VoxelSidesFlagBits::Y_NEGATIVE |
+							((z_positive >> x) & 1) * (uint8_t)VoxelSidesFlagBits::Z_POSITIVE |
+							((z_negative >> x) & 1) * (uint8_t)VoxelSidesFlagBits::Z_NEGATIVE) };
+
+						glm::uvec3 coord{ x, y, z };
+						bricks_[brick_map_[BrickMapIndex(coord)]].side_flags[LocalBrickIndex(coord)] = flags;
+					}
+				}
+			});
+	}
+
+	void VoxelChunk::RebuildOuterVoxels(const std::vector<uint64_t>& rows)
+	{
+		ZoneScoped;
+
+		const std::vector<uint64_t> exterior{ ExteriorRows(rows) };
+		const uint64_t high_bit{ 1ull << (width_ - 1) };
+
+		// Outside of the chunk is exterior.
+		auto exterior_at = [&](uint32_t y, uint32_t z) {
+			return (y < height_ && z < depth_) ? exterior[y + z * height_] : ~0ull;
+			};
+
+		// Outer voxels are occupied voxels with a face exposed to the exterior, gathered per slice in parallel.
+		std::vector<std::vector<OuterVoxel>> slice_outer_voxels(depth_);
+		auto slices{ std::views::iota(0u, depth_) };
+		std::for_each(std::execution::par, slices.begin(), slices.end(),
+			[&](uint32_t z) {
+				for (uint32_t y{ 0 }; y < height_; ++y)
+				{
+					uint64_t row_exterior{ exterior[y + z * height_] };
+					uint64_t x_positive{ (row_exterior >> 1) | high_bit };
+					uint64_t x_negative{ (row_exterior << 1) | 1ull };
+					uint64_t y_positive{ exterior_at(y + 1, z) };
+					uint64_t y_negative{ exterior_at(y - 1, z) };
+					uint64_t z_positive{ exterior_at(y, z + 1) };
+					uint64_t z_negative{ exterior_at(y, z - 1) };
+
+					uint64_t outer{ rows[y + z * height_] & (x_positive | x_negative | y_positive | y_negative | z_positive | z_negative) };
+					while (outer)
+					{
+						uint32_t x{ (uint32_t)std::countr_zero(outer) };
+						outer &= outer - 1;
+
+						// Sum of the exposed face directions. Opposite exposed faces cancel out, such as on a one voxel thick wall.
+						glm::vec3 normal{
+							(float)((x_positive >> x) & 1) - (float)((x_negative >> x) & 1),
+							(float)((y_positive >> x) & 1) - (float)((y_negative >> x) & 1),
+							(float)((z_positive >> x) & 1) - (float)((z_negative >> x) & 1),
+						};
+						if (glm::dot(normal, normal) > 0.0f) {
+							normal = glm::normalize(normal);
+						}
+
+						slice_outer_voxels[z].push_back(OuterVoxel{ .coord = { x, y, z }, .normal = normal });
+					}
+				}
+			});
+
+		outer_voxels_.clear();
+		for (const std::vector<OuterVoxel>& slice : slice_outer_voxels) {
+			outer_voxels_.insert(outer_voxels_.end(), slice.begin(), slice.end());
+		}
+	}
+
+	const Voxel& VoxelChunk::Coordinate(uint32_t i, uint32_t j, uint32_t k) const
+	{
+		static constexpr Voxel empty_voxel{ .physics_material_index = PHYSICS_MATERIAL_EMPTY_INDEX };
+
+		glm::uvec3 coord{ i, j, k };
+		uint32_t brick_idx{ brick_map_[BrickMapIndex(coord)] };
+		if (brick_idx == EMPTY_BRICK) {
+			return empty_voxel;
+		}
+		return bricks_[brick_idx].voxels[LocalBrickIndex(coord)];
+	}
+
+	const Voxel& VoxelChunk::Coordinate(const glm::uvec3& coord) const
+	{
+		return Coordinate(coord.x, coord.y, coord.z);
+	}
+
+	const Voxel& VoxelChunk::Index(uint32_t idx) const
+	{
+		return Coordinate(IndexToCoordinate(idx));
+	}
+
+	uint32_t VoxelChunk::VoxelCount() const
+	{
+		return width_height_slice_ * depth_;
+	}
+
+	uint32_t VoxelChunk::OccupiedVoxelCount() const
+	{
+		// Vacant bricks have no occupancy bits set, so they don't need to be skipped.
+		uint32_t count{ 0 };
+		for (const VoxelBrick& brick : bricks_)
+		{
+			for (uint64_t word : brick.occupancy) {
+				count += (uint32_t)std::popcount(word);
+			}
+		}
+		return count;
+	}
+
+	size_t VoxelChunk::MemoryUsage() const
+	{
+		return brick_map_.capacity() * sizeof(uint32_t) +
+			bricks_.capacity() * sizeof(VoxelBrick) +
+			vacant_bricks_.capacity() * sizeof(uint32_t) +
+			outer_voxels_.capacity() * sizeof(OuterVoxel);
+	}
+
+	bool VoxelChunk::IsOccluded(uint32_t voxel_idx) const
+	{
+		return GetSideFlags(voxel_idx) == (uint8_t)VoxelSidesFlagBits::ALL_SIDES;
+	}
+
+	bool VoxelChunk::IsEmpty(uint32_t voxel_idx) const
+	{
+		return IsEmpty(IndexToCoordinate(voxel_idx));
+	}
+
+	bool VoxelChunk::IsEmpty(const glm::uvec3& voxel_coord) const
+	{
+		uint32_t brick_idx{ brick_map_[BrickMapIndex(voxel_coord)] };
+		if (brick_idx == EMPTY_BRICK) {
+			return true;
+		}
+
+		uint32_t local{ LocalBrickIndex(voxel_coord) };
+		return !(bricks_[brick_idx].occupancy[local / 64] & (1ull << (local % 64)));
+	}
+
+	bool VoxelChunk::InBounds(const glm::uvec3& voxel_coord) const
+	{
+		return (voxel_coord.x < width_) && (voxel_coord.y < height_) && (voxel_coord.z < depth_);
+	}
+
+	glm::uvec3 VoxelChunk::IndexToCoordinate(uint32_t index) const
+	{
+		uint32_t z{ index / width_height_slice_ };
+		uint32_t y{ (index % width_height_slice_) / width_ };
+		uint32_t x{ index % width_ };
+
+		return glm::uvec3{ x, y, z };
+	}
+
+	uint32_t VoxelChunk::CoordinateToIndex(const glm::uvec3& coord) const
+	{
+		return coord.x + coord.y * width_ + coord.z * width_height_slice_;
+	}
+
+	uint8_t VoxelChunk::GetSideFlags(uint32_t voxel_idx) const
+	{
+		glm::uvec3 coord{ IndexToCoordinate(voxel_idx) };
+		uint32_t brick_idx{ brick_map_[BrickMapIndex(coord)] };
+		if (brick_idx == EMPTY_BRICK) {
+			return 0;
+		}
+		return bricks_[brick_idx].side_flags[LocalBrickIndex(coord)];
+	}
+
+	glm::uvec3 VoxelChunk::GetBrickDimensions() const
+	{
+		return brick_dimensions_;
+	}
+
+	bool VoxelChunk::IsBrickEmpty(const glm::uvec3& brick_coord) const
+	{
+		return brick_map_[brick_coord.x + brick_coord.y * brick_dimensions_.x + brick_coord.z * brick_dimensions_.x * brick_dimensions_.y] == EMPTY_BRICK;
+	}
+
+	const std::vector<OuterVoxel>& VoxelChunk::GetOuterVoxels() const
+	{
+		return outer_voxels_;
+	}
+
+	uint32_t VoxelChunk::GetWidth() const
+	{
+		return width_;
+	}
+
+	uint32_t VoxelChunk::GetHeight() const
+	{
+		return height_;
+	}
+
+	uint32_t VoxelChunk::GetDepth() const
+	{
+		return depth_;
+	}
+
+	bool VoxelChunk::IsPointMass() const
+	{
+		return (width_ == 1) && (height_ == 1) && (depth_ == 1);
+	}
+
+	bool VoxelChunk::ValidDimensions(const glm::uvec3& dimensions)
+	{
+		return glm::all(glm::greaterThan(dimensions, glm::uvec3{ 0 })) && glm::all(glm::lessThanEqual(dimensions, glm::uvec3{ CHUNK_ROW_VOXEL_COUNT }));
+	}
+
+	uint8_t VoxelChunk::ComputeSideFlags(const glm::uvec3& coord) const
+	{
+		uint8_t neighbors{};
+
+		// X-axis neighbors.
+		if (coord.x != width_ - 1 && NeighborOccupied(coord, glm::ivec3(1, 0, 0))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::X_POSITIVE;
+		}
+		if (coord.x != 0 && NeighborOccupied(coord, glm::ivec3(-1, 0, 0))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::X_NEGATIVE;
+		}
+		// Y-axis neighbors.
+		if (coord.y != height_ - 1 && NeighborOccupied(coord, glm::ivec3(0, 1, 0))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::Y_POSITIVE;
+		}
+		if (coord.y != 0 && NeighborOccupied(coord, glm::ivec3(0, -1, 0))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::Y_NEGATIVE;
+		}
+		// Z-axis neighbors.
+		if (coord.z != depth_ - 1 && NeighborOccupied(coord, glm::ivec3(0, 0, 1))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::Z_POSITIVE;
+		}
+		if (coord.z != 0 && NeighborOccupied(coord, glm::ivec3(0, 0, -1))) {
+			neighbors |= (uint8_t)VoxelSidesFlagBits::Z_NEGATIVE;
+		}
+
+		return neighbors;
+	}
+
+	uint32_t VoxelChunk::BrickMapIndex(const glm::uvec3& coord) const
+	{
+		glm::uvec3 brick{ coord / VOXEL_BRICK_WIDTH };
+		return brick.x + brick.y * brick_dimensions_.x + brick.z * brick_dimensions_.x * brick_dimensions_.y;
+	}
+
+	uint32_t VoxelChunk::AllocateBrick()
+	{
+		VoxelBrick empty_brick{};
+		empty_brick.voxels.fill(Voxel{ .physics_material_index = PHYSICS_MATERIAL_EMPTY_INDEX });
+
+		if (!vacant_bricks_.empty())
+		{
+			uint32_t brick_idx{ vacant_bricks_.back() };
+			vacant_bricks_.pop_back();
+			bricks_[brick_idx] = empty_brick;
+			return brick_idx;
+		}
+
+		bricks_.push_back(empty_brick);
+		return (uint32_t)bricks_.size() - 1;
+	}
+
+	bool VoxelChunk::NeighborOccupied(glm::uvec3 coord, glm::ivec3 offset) const
+	{
+		glm::uvec3 neighbor_coord = glm::ivec3{ coord } + offset;
+		return !IsEmpty(neighbor_coord);
+	}
+}
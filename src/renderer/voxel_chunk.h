@@ -0,0 +1,228 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <bit>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+namespace renderer
+{
+	// Encodes whether each of the 6 voxel neighbors are occupied or not.
+	enum class VoxelSidesFlagBits : uint8_t
+	{
+		X_POSITIVE = 0x01,
+		X_NEGATIVE = 0x02,
+		Y_POSITIVE = 0x04,
+		Y_NEGATIVE = 0x08,
+		Z_POSITIVE = 0x10,
+		Z_NEGATIVE = 0x20,
+		ALL_SIDES = 0x3F,
+	};
+
+	// Each voxel in a rigid body can be labeled based on its neighbors which is useful for collision detection. 
+	enum class VoxelGeometricFeatureType : uint8_t
+	{
+		INTERIOR,
+		CORNER,
+		EDGE,
+		FACE,
+	};
+
+	// Defined in renderer instead of Pumpkin since it's used in particle_gen.cpp.
+	constexpr uint8_t PHYSICS_MATERIAL_EMPTY_INDEX{ 0xFF };
+
+	// Particles that are not being simulated.
+	struct Voxel
+	{
+		uint8_t physics_material_index;
+	};
+
+	struct OuterVoxel
+	{
+		glm::uvec3 coord;
+		glm::vec3 normal;
+	};
+
+	constexpr uint32_t VOXEL_BRICK_WIDTH{ 8 }; // Voxels along each dimension of a brick.
+	constexpr uint32_t VOXEL_BRICK_VOXEL_COUNT{ VOXEL_BRICK_WIDTH * VOXEL_BRICK_WIDTH * VOXEL_BRICK_WIDTH };
+
+	// Voxels of an 8x8x8 region of a chunk, indexed by x + 8 * y + 64 * z.
+	struct VoxelBrick
+	{
+		std::array<uint64_t, VOXEL_BRICK_WIDTH> occupancy; // Bit x + 8 * y of occupancy[z] is set for each occupied voxel.
+		std::array<Voxel, VOXEL_BRICK_VOXEL_COUNT> voxels;
+		std::array<uint8_t, VOXEL_BRICK_VOXEL_COUNT> side_flags;
+	};
+
+	// Voxels stored sparsely as a map of bricks, where only bricks with occupied voxels are allocated.
+	// Voxel indices and coordinates are still those of a dense width * height * depth grid.
+	// Chunks are at most 64 voxels wide so a row of voxels along x fits in a 64 bit word.
+	class VoxelChunk
+	{
+	public:
+		VoxelChunk();
+
+		// Dimensions that fail ValidDimensions() are refused with an error, leaving a 1x1x1 empty chunk.
+		VoxelChunk(uint32_t width, uint32_t height, uint32_t depth);
+
+		VoxelChunk(uint32_t width, uint32_t height, uint32_t depth, std::vector<std::pair<Voxel, glm::uvec3>>&& voxel_pairs);
+
+		const Voxel& Coordinate(uint32_t i, uint32_t j, uint32_t k) const;
+
+		const Voxel& Coordinate(const glm::uvec3& coord) const;
+
+		const Voxel& Index(uint32_t idx) const;
+
+		// Number of voxels in the dense grid, including empty voxels.
+		uint32_t VoxelCount() const;
+
+		uint32_t OccupiedVoxelCount() const;
+
+		// Bytes of heap memory held by the chunk, including vacant bricks.
+		size_t MemoryUsage() const;
+
+		bool IsOccluded(uint32_t voxel_idx) const;
+
+		bool IsEmpty(uint32_t voxel_idx) const;
+
+		bool IsEmpty(const glm::uvec3& voxel_coord) const;
+
+		bool InBounds(const glm::uvec3& voxel_coord) const;
+
+		glm::uvec3 IndexToCoordinate(uint32_t index) const;
+
+		uint32_t CoordinateToIndex(const glm::uvec3& coord) const;
+
+		uint8_t GetSideFlags(uint32_t voxel_idx) const;
+
+		const std::vector<OuterVoxel>& GetOuterVoxels() const;
+
+		// Replace every voxel from dense arrays with one element per voxel, such as the particle gen shader output.
+		void AssignDense(const std::vector<Voxel>& voxels, const std::vector<uint8_t>& side_flags);
+
+		// Replace every voxel from a dense array, computing side flags and outer voxels.
+		void AssignDense(const std::vector<Voxel>& voxels);
+
+		// Replace every voxel from runs of identical voxels in voxel index order, computing side flags and outer voxels.
+		// Runs are written straight into bricks and empty runs are skipped, so no dense array is needed.
+		// The run lengths must add up to VoxelCount(), otherwise the chunk is left empty.
+		void AssignRuns(const std::vector<std::pair<Voxel, uint32_t>>& runs);
+
+		// Set a voxel and update the side flags of it and its neighbors.
+		// Outer voxels are not updated, so call RebuildOuterVoxels() after a batch of edits.
+		void SetVoxel(const glm::uvec3& coord, const Voxel& voxel);
+
+		// Gather the occupied voxels with a face exposed to the exterior of the chunk, meaning empty space connected to outside the chunk.
+		// Voxels only exposed to enclosed cavities are not outer voxels.
+		void RebuildOuterVoxels();
+
+		// Occupancy as one 64 bit row per y and z, indexed by y + z * height, with bit x set for each occupied voxel.
+		std::vector<uint64_t> OccupancyRows() const;
+
+		// Empty voxels connected to outside of the chunk, in the same layout as OccupancyRows().
+		// Computed with a bit-parallel dilation of the empty voxels on the chunk boundary.
+		std::vector<uint64_t> ExteriorRows(const std::vector<uint64_t>& rows) const;
+
+		glm::uvec3 GetBrickDimensions() const;
+
+		bool IsBrickEmpty(const glm::uvec3& brick_coord) const;
+
+		// Call func(voxel_idx, coord, voxel) for every occupied voxel, skipping bricks with no occupied voxels.
+		template<typename Func>
+		void ForEachOccupied(Func&& func) const;
+
+		// Call func(voxel_idx, coord, voxel) for every occupied voxel between min_coord and max_coord inclusive.
+		template<typename Func>
+		void ForEachOccupied(const glm::uvec3& min_coord, const glm::uvec3& max_coord, Func&& func) const;
+
+		uint32_t GetWidth() const;
+
+		uint32_t GetHeight() const;
+
+		uint32_t GetDepth() const;
+
+		bool IsPointMass() const;
+
+		// Every dimension is between 1 and CHUNK_ROW_VOXEL_COUNT.
+		static bool ValidDimensions(const glm::uvec3& dimensions);
+
+	private:
+		explicit VoxelChunk(const glm::uvec3& dimensions);
+
+		// Recompute the side flags of every occupied voxel from occupancy rows.
+		void RebuildSideFlags(const std::vector<uint64_t>& rows);
+
+		void RebuildOuterVoxels(const std::vector<uint64_t>& rows);
+
+		uint8_t ComputeSideFlags(const glm::uvec3& coord) const;
+
+		uint32_t BrickMapIndex(const glm::uvec3& coord) const;
+
+		// Take a vacant brick or append a new one, with every voxel empty.
+		uint32_t AllocateBrick();
+
+		// Helper function for calculating side flags.
+		bool NeighborOccupied(glm::uvec3 coord, glm::ivec3 offset) const;
+
+		uint32_t width_{};
+		uint32_t height_{};
+		uint32_t depth_{};
+		uint32_t width_height_slice_{};
+		glm::uvec3 brick_dimensions_{};
+		std::vector<uint32_t> brick_map_{};      // Index into bricks_ of each brick, or EMPTY_BRICK.
+		std::vector<VoxelBrick> bricks_{};
+		std::vector<uint32_t> vacant_bricks_{};  // Bricks freed when their last voxel was removed.
+		std::vector<OuterVoxel> outer_voxels_{}; // A list of the non-occluded voxels and their normals.
+
+		static constexpr uint32_t EMPTY_BRICK{ UINT32_MAX };
+	};
+
+	template<typename Func>
+	void VoxelChunk::ForEachOccupied(Func&& func) const
+	{
+		ForEachOccupied(glm::uvec3{ 0 }, glm::uvec3{ width_ - 1, height_ - 1, depth_ - 1 }, std::forward<Func>(func));
+	}
+
+	template<typename Func>
+	void VoxelChunk::ForEachOccupied(const glm::uvec3& min_coord, const glm::uvec3& max_coord, Func&& func) const
+	{
+		const glm::uvec3 brick_min{ min_coord / VOXEL_BRICK_WIDTH };
+		const glm::uvec3 brick_max{ max_coord / VOXEL_BRICK_WIDTH };
+
+		for (uint32_t bz{ brick_min.z }; bz <= brick_max.z; ++bz)
+		{
+			for (uint32_t by{ brick_min.y }; by <= brick_max.y; ++by)
+			{
+				for (uint32_t bx{ brick_min.x }; bx <= brick_max.x; ++bx)
+				{
+					uint32_t brick_idx{ brick_map_[bx + by * brick_dimensions_.x + bz * brick_dimensions_.x * brick_dimensions_.y] };
+					if (brick_idx == EMPTY_BRICK) {
+						continue;
+					}
+
+					const VoxelBrick& brick{ bricks_[brick_idx] };
+					const glm::uvec3 origin{ glm::uvec3{ bx, by, bz } * VOXEL_BRICK_WIDTH };
+					for (uint32_t z{ 0 }; z < VOXEL_BRICK_WIDTH; ++z)
+					{
+						uint64_t bits{ brick.occupancy[z] };
+						while (bits)
+						{
+							uint32_t bit{ (uint32_t)std::countr_zero(bits) };
+							bits &= bits - 1;
+
+							glm::uvec3 coord{ origin + glm::uvec3{ bit % VOXEL_BRICK_WIDTH, bit / VOXEL_BRICK_WIDTH, z } };
+							if (glm::any(glm::lessThan(coord, min_coord)) || glm::any(glm::greaterThan(coord, max_coord))) {
+								continue;
+							}
+
+							func(CoordinateToIndex(coord), coord, brick.voxels[bit + z * VOXEL_BRICK_WIDTH * VOXEL_BRICK_WIDTH]);
+						}
+					}
+				}
+			}
+		}
+	}
+}
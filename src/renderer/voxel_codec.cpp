@@ -0,0 +1,192 @@
+#include "voxel_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "tracy/Tracy.hpp"
+
+namespace renderer
+{
+	constexpr uint32_t MAX_RUN_LENGTH{ UINT16_MAX };
+
+	std::vector<uint8_t> EncodeVoxelChunk(const VoxelChunk& voxel_chunk)
+	{
+		ZoneScoped;
+
+		std::vector<Voxel> voxels(voxel_chunk.VoxelCount(), Voxel{ PHYSICS_MATERIAL_EMPTY_INDEX });
+		voxel_chunk.ForEachOccupied([&](uint32_t idx, const glm::uvec3&, const Voxel& voxel) {
+			voxels[idx] = voxel;
+			});
+
+		return EncodeDenseVoxels({ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() }, voxels);
+	}
+
+	// Validate the compressed chunk and unpack its runs, in voxel index order. Returns false if the data is not valid.
+	static bool DecodeRuns(const std::vector<uint8_t>& data, glm::uvec3* out_dimensions, std::vector<std::pair<Voxel, uint32_t>>* out_runs)
+	{
+		VoxelCodecHeader header{};
+		if (data.size() < sizeof(header)) {
+			return false;
+		}
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		size_t palette_bytes{ (size_t)header.palette_size * sizeof(Voxel) };
+		size_t run_length_bytes{ (size_t)header.run_count * sizeof(uint16_t) };
+		size_t index_bytes{ ((size_t)header.run_count * header.index_bits + 63) / 64 * sizeof(uint64_t) };
+		if (header.magic != VOXEL_CODEC_MAGIC ||
+			header.index_bits > 8 ||
+			data.size() != sizeof(header) + palette_bytes + run_length_bytes + index_bytes)
+		{
+			return false;
+		}
+
+		// Reject bad dimensions and run lengths before allocating the voxels, so corrupt data can't request a huge allocation.
+		const glm::uvec3 dimensions{ header.width, header.height, header.depth };
+		if (!VoxelChunk::ValidDimensions(dimensions)) {
+			return false;
+		}
+
+		const uint8_t* src{ data.data() + sizeof(header) };
+		std::vector<Voxel> palette(header.palette_size);
+		std::memcpy(palette.data(), src, palette_bytes);
+		src += palette_bytes;
+		std::vector<uint16_t> run_lengths(header.run_count);
+		std::memcpy(run_lengths.data(), src, run_length_bytes);
+		src += run_length_bytes;
+		std::vector<uint64_t> packed_indices(index_bytes / sizeof(uint64_t));
+		std::memcpy(packed_indices.data(), src, index_bytes);
+
+		const size_t voxel_count{ (size_t)dimensions.x * dimensions.y * dimensions.z };
+		size_t run_total{ 0 };
+		for (uint16_t run_length : run_lengths) {
+			run_total += run_length;
+		}
+		if (run_total != voxel_count) {
+			return false;
+		}
+
+		const uint64_t index_mask{ (1ull << header.index_bits) - 1 };
+		std::vector<std::pair<Voxel, uint32_t>>& runs{ *out_runs };
+		runs.resize(header.run_count);
+		for (uint32_t run{ 0 }; run < header.run_count; ++run)
+		{
+			size_t bit{ (size_t)run * header.index_bits };
+			size_t word{ bit / 64 };
+			uint64_t low{ packed_indices.empty() ? 0 : packed_indices[word] >> (bit % 64) };
+			uint64_t high{ (bit % 64 + header.index_bits > 64) ? packed_indices[word + 1] << (64 - bit % 64) : 0 };
+			uint32_t palette_idx{ (uint32_t)((low | high) & index_mask) };
+
+			if (palette_idx >= header.palette_size) {
+				return false;
+			}
+			runs[run] = { palette[palette_idx], run_lengths[run] };
+		}
+
+		*out_dimensions = dimensions;
+		return true;
+	}
+
+	bool DecodeVoxelChunk(const std::vector<uint8_t>& data, VoxelChunk* out_voxel_chunk)
+	{
+		ZoneScoped;
+
+		// Runs go straight into the bricks, so empty space costs nothing and there's no dense array in between.
+		glm::uvec3 dimensions{};
+		std::vector<std::pair<Voxel, uint32_t>> runs{};
+		if (!DecodeRuns(data, &dimensions, &runs)) {
+			return false;
+		}
+
+		*out_voxel_chunk = VoxelChunk{ dimensions.x, dimensions.y, dimensions.z };
+		out_voxel_chunk->AssignRuns(runs);
+		return true;
+	}
+
+	std::vector<uint8_t> EncodeDenseVoxels(const glm::uvec3& dimensions, const std::vector<Voxel>& voxels)
+	{
+		// Palette index of each material, in order of first appearance.
+		std::array<uint16_t, 256> palette_lookup{};
+		palette_lookup.fill(UINT16_MAX);
+		std::vector<Voxel> palette{};
+		std::vector<uint16_t> run_lengths{};
+		std::vector<uint8_t> run_indices{};
+
+		for (uint32_t i{ 0 }; i < (uint32_t)voxels.size();)
+		{
+			uint8_t material{ voxels[i].physics_material_index };
+			uint32_t run_end{ i + 1 };
+			while (run_end < (uint32_t)voxels.size() && run_end - i < MAX_RUN_LENGTH && voxels[run_end].physics_material_index == material) {
+				++run_end;
+			}
+
+			if (palette_lookup[material] == UINT16_MAX)
+			{
+				palette_lookup[material] = (uint16_t)palette.size();
+				palette.push_back(voxels[i]);
+			}
+
+			run_lengths.push_back((uint16_t)(run_end - i));
+			run_indices.push_back((uint8_t)palette_lookup[material]);
+			i = run_end;
+		}
+
+		VoxelCodecHeader header{
+			.magic = VOXEL_CODEC_MAGIC,
+			.width = dimensions.x,
+			.height = dimensions.y,
+			.depth = dimensions.z,
+			.run_count = (uint32_t)run_lengths.size(),
+			.palette_size = (uint16_t)palette.size(),
+			.index_bits = (uint8_t)std::bit_width(palette.size() - 1),
+			.padding = 0,
+		};
+
+		std::vector<uint64_t> packed_indices(((size_t)header.run_count * header.index_bits + 63) / 64);
+		for (uint32_t run{ 0 }; run < header.run_count && header.index_bits > 0; ++run)
+		{
+			size_t bit{ (size_t)run * header.index_bits };
+			packed_indices[bit / 64] |= (uint64_t)run_indices[run] << (bit % 64);
+			if (bit % 64 + header.index_bits > 64) {
+				packed_indices[bit / 64 + 1] |= (uint64_t)run_indices[run] >> (64 - bit % 64);
+			}
+		}
+
+		size_t palette_bytes{ palette.size() * sizeof(Voxel) };
+		size_t run_length_bytes{ run_lengths.size() * sizeof(uint16_t) };
+		size_t index_bytes{ packed_indices.size() * sizeof(uint64_t) };
+		std::vector<uint8_t> data(sizeof(header) + palette_bytes + run_length_bytes + index_bytes);
+
+		uint8_t* dst{ data.data() };
+		std::memcpy(dst, &header, sizeof(header));
+		dst += sizeof(header);
+		std::memcpy(dst, palette.data(), palette_bytes);
+		dst += palette_bytes;
+		std::memcpy(dst, run_lengths.data(), run_length_bytes);
+		dst += run_length_bytes;
+		std::memcpy(dst, packed_indices.data(), index_bytes);
+
+		return data;
+	}
+
+	bool DecodeDenseVoxels(const std::vector<uint8_t>& data, glm::uvec3* out_dimensions, std::vector<Voxel>* out_voxels)
+	{
+		glm::uvec3 dimensions{};
+		std::vector<std::pair<Voxel, uint32_t>> runs{};
+		if (!DecodeRuns(data, &dimensions, &runs)) {
+			return false;
+		}
+
+		// Runs are expanded with fills, which compile to vectorized stores.
+		std::vector<Voxel>& voxels{ *out_voxels };
+		voxels.resize((size_t)dimensions.x * dimensions.y * dimensions.z);
+		size_t voxel_idx{ 0 };
+		for (const auto& [voxel, length] : runs)
+		{
+			std::fill_n(voxels.begin() + voxel_idx, length, voxel);
+			voxel_idx += length;
+		}
+
+		*out_dimensions = dimensions;
+		return true;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "voxel_chunk.h"
+
+namespace renderer
+{
+	// Compressed voxel chunk layout, in order:
+	//
+	// VoxelCodecHeader.
+	// Palette of the distinct voxels in the chunk, palette_size voxels.
+	// Run lengths as uint16_t, run_count of them. Runs are along voxel index order and longer runs are split.
+	// Palette index of each run, bit-packed into uint64_t words with index_bits bits per run.
+	struct VoxelCodecHeader
+	{
+		uint32_t magic;
+		uint32_t width;
+		uint32_t height;
+		uint32_t depth;
+		uint32_t run_count;
+		uint16_t palette_size;
+		uint8_t index_bits;
+		uint8_t padding;
+	};
+
+	constexpr uint32_t VOXEL_CODEC_MAGIC{ 0x31435650 }; // "PVC1".
+
+	std::vector<uint8_t> EncodeVoxelChunk(const VoxelChunk& voxel_chunk);
+
+	// Decodes runs straight into the chunk's bricks. Returns false if the data is not a valid compressed chunk.
+	bool DecodeVoxelChunk(const std::vector<uint8_t>& data, VoxelChunk* out_voxel_chunk);
+
+	// Encode a dense width * height * depth array of voxels, such as the particle gen shader output.
+	std::vector<uint8_t> EncodeDenseVoxels(const glm::uvec3& dimensions, const std::vector<Voxel>& voxels);
+
+	// Returns false if the data is not a valid compressed chunk.
+	bool DecodeDenseVoxels(const std::vector<uint8_t>& data, glm::uvec3* out_dimensions, std::vector<Voxel>* out_voxels);
+}
@@ -1,6 +1,9 @@
 #include "vulkan_renderer.h"
 
 #include <fstream>
+#include <algorithm>
+#include <bit>
+#include <chrono>
 
 #define VOLK_IMPLEMENTATION
 #include "volk.h"
@@ -19,6 +22,7 @@
 #include "mesh.h"
 #include "descriptor_set.h"
 #include "common_constants.h"
+#include "hash_util.h"
 
 namespace jsonkey
 {
@@ -95,9 +99,10 @@ namespace renderer
 	// Camera descriptor set.
 	constexpr uint32_t CAMERA_UBO_SET{ 0 };
 	constexpr uint32_t CAMERA_UBO_BINDING{ 0 };
-	// Render object descriptor set.
-	constexpr uint32_t RENDER_OBJECT_UBO_SET{ 1 };
-	constexpr uint32_t RENDER_OBJECT_UBO_BINDING{ 0 };
+	// Render object data descriptor set.
+	constexpr uint32_t RENDER_OBJECT_DATA_SET{ 1 };
+	constexpr uint32_t RENDER_OBJECT_DATA_BINDING{ 0 };
+	constexpr uint32_t RENDER_OBJECT_DRAW_BINDING{ 1 };
 	// Composite pass descriptor set.
 	constexpr uint32_t COMPOSITE_DESCRIPTOR_SET{ 0 };
 	constexpr uint32_t COMPOSITE_RASTER_BINDING{ 0 };
@@ -128,6 +133,8 @@ namespace renderer
 
 	void VulkanRenderer::Initialize(GLFWwindow* window)
 	{
+		std::chrono::steady_clock::time_point start_time{ std::chrono::steady_clock::now() };
+
 		VkResult result{ volkInitialize() };
 		CheckResult(result, "Failed to initialize volk.");
 
@@ -135,12 +142,19 @@ namespace renderer
 		glfwSetFramebufferSizeCallback(window, WindowResizedCallback);
 
 		context_.Initialize(window);
+		pipeline_cache_.Initialize(&context_, PIPELINE_CACHE_DIRECTORY);
+
+		VkPhysicalDeviceProperties physical_device_properties{};
+		vkGetPhysicalDeviceProperties(context_.physical_device, &physical_device_properties);
+		max_draw_indirect_count_ = physical_device_properties.limits.maxDrawIndirectCount;
+
 		swapchain_.Initialize(&context_);
 		descriptor_allocator_.Initialize(&context_);
 		InitializeDescriptorSetLayouts();
 		InitializePipelines();
 		allocator_.Initialize(&context_);
-		vulkan_util_.Initialize(&context_, &allocator_);
+		uploader_.Initialize(&context_, &allocator_);
+		vulkan_util_.Initialize(&context_, &allocator_, &uploader_);
 		InitializeFrameResources();
 		particle_gen_context_.Initialize(&context_, this);
 		InitializeRayTracing();
@@ -160,6 +174,11 @@ namespace renderer
 			particle_gen_context_.GetParticleIndices(),
 			&context_, this);
 #endif
+
+		// Save now so pipelines created at startup are cached even if the session doesn't end cleanly.
+		pipeline_cache_.Save();
+		std::chrono::steady_clock::time_point end_time{ std::chrono::steady_clock::now() };
+		pipeline_cache_.SetStartupTime(std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0f);
 	}
 
 #ifdef EDITOR_ENABLED
@@ -242,21 +261,15 @@ namespace renderer
 			vkDestroySemaphore(context_.device, frame.image_acquired_semaphore, nullptr);
 			vkDestroySemaphore(context_.device, frame.render_done_semaphore, nullptr);
 
-			for (RenderObject* render_object : frame.render_objects)
-			{
-				if (render_object)
-				{
-					allocator_.DestroyBufferResource(&render_object->ubo_buffer_resource);
-					delete render_object;
-				}
+			for (RenderObject* render_object : frame.render_objects) {
+				delete render_object;
 			}
+			allocator_.DestroyBufferResource(&frame.object_data_buffer);
+			allocator_.DestroyBufferResource(&frame.raster_draw_buffer);
+			allocator_.DestroyBufferResource(&frame.raster_indirect_buffer);
+			allocator_.DestroyBufferResource(&frame.raster_index_buffer);
+			allocator_.DestroyBufferResource(&frame.dynamic_mesh_staging_buffer);
 			allocator_.DestroyBufferResource(&frame.camera_ubo_buffer);
-
-			if (frame.tlas)
-			{
-				vkDestroyAccelerationStructureKHR(context_.device, frame.tlas->acceleration_structure, nullptr);
-				allocator_.DestroyBufferResource(&frame.tlas->buffer_resource);
-			}
 		}
 
 		for (ImageResource* texture : textures_) {
@@ -282,6 +295,7 @@ namespace renderer
 
 		particle_gen_context_.CleanUp();
 		vulkan_util_.CleanUp();
+		uploader_.CleanUp();
 		allocator_.CleanUp();
 		raster_pipeline_.CleanUp();
 		composite_pipeline_.CleanUp();
@@ -292,7 +306,9 @@ namespace renderer
 			delete compute_shader;
 		}
 		user_compute_shaders_.clear();
+		user_compute_shader_hashes_.clear();
 
+		pipeline_cache_.CleanUp();
 		descriptor_allocator_.CleanUp();
 		swapchain_.CleanUp();
 		context_.CleanUp();
@@ -322,35 +338,41 @@ namespace renderer
 			render_object_layout_resource_,
 		};
 
-		raster_pipeline_.Initialize(
-			&context_,
-			raster_layouts,
-			{},
-			VK_FORMAT_R8G8B8A8_UNORM,
-			GetDepthImageFormat(),
-			VertexAttributes::POSITION_NORMAL,
-			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-			SPIRV_PREFIX / "default.vert.spv",
-			SPIRV_PREFIX / "default.frag.spv");
-		NameObject(context_.device, raster_pipeline_.pipeline, "Raster_Pipeline");
-		NameObject(context_.device, raster_pipeline_.layout, "Raster_Pipeline_Layout");
-
 		std::vector<DescriptorSetLayoutResource> composite_layouts{
 			composite_layout_resource_,
 		};
 
-		composite_pipeline_.Initialize(
-			&context_,
-			composite_layouts,
-			{},
-			GetViewportImageFormat(),
-			VK_FORMAT_UNDEFINED,
-			VertexAttributes::NONE,
-			VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-			SPIRV_PREFIX / "fullscreen_triangle.vert.spv",
-			SPIRV_PREFIX / "composite.frag.spv");
-		NameObject(context_.device, composite_pipeline_.pipeline, "Composite_Pipeline");
-		NameObject(context_.device, composite_pipeline_.layout, "Composite_Pipeline_Layout");
+		CreatePipelinesInParallel({
+			[&]() {
+				// No vertex attributes since the vertex shader pulls vertices from each draw's geometry buffers.
+				raster_pipeline_.Initialize(
+					&context_,
+					raster_layouts,
+					{},
+					VK_FORMAT_R8G8B8A8_UNORM,
+					GetDepthImageFormat(),
+					VertexAttributes::NONE,
+					VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+					SPIRV_PREFIX / "default.vert.spv",
+					SPIRV_PREFIX / "default.frag.spv");
+				NameObject(context_.device, raster_pipeline_.pipeline, "Raster_Pipeline");
+				NameObject(context_.device, raster_pipeline_.layout, "Raster_Pipeline_Layout");
+			},
+			[&]() {
+				composite_pipeline_.Initialize(
+					&context_,
+					composite_layouts,
+					{},
+					GetViewportImageFormat(),
+					VK_FORMAT_UNDEFINED,
+					VertexAttributes::NONE,
+					VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+					SPIRV_PREFIX / "fullscreen_triangle.vert.spv",
+					SPIRV_PREFIX / "composite.frag.spv");
+				NameObject(context_.device, composite_pipeline_.pipeline, "Composite_Pipeline");
+				NameObject(context_.device, composite_pipeline_.layout, "Composite_Pipeline_Layout");
+			},
+		});
 	}
 
 	void VulkanRenderer::InitializeRayTracing()
@@ -389,18 +411,34 @@ namespace renderer
 		editor_backend_.GetImGuiBackend().DrawGui();
 #endif
 
+		// Objects may have been created since host render work, eg. by the editor GUI, so update right before recording.
+		UpdateObjectDataBuffer();
+		UpdateRasterDraws();
+
+		// Submit this frame's uploads, so the command buffer can acquire them.
+		uploader_.Submit();
+
 		// Drawing commands happen here.
 		RecordCommandBuffer(GetCurrentFrame().command_buffer, image_index);
 
-		VkPipelineStageFlags wait_stage{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		// We can't start rendering until image_acquired_semaphore is signaled, meaning the image is ready to be used.
+		// Anything reading uploads also waits for the transfer queue, which is usually done already.
+		std::array<VkSemaphore, 2> wait_semaphores{ GetCurrentFrame().image_acquired_semaphore, uploader_.GetSemaphore() };
+		std::array<VkPipelineStageFlags, 2> wait_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+		std::array<uint64_t, 2> wait_values{ 0, uploader_.GetSubmittedTicket() }; // Binary semaphores ignore their value.
+
+		VkTimelineSemaphoreSubmitInfo timeline_info{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.waitSemaphoreValueCount = (uint32_t)wait_values.size(),
+			.pWaitSemaphoreValues = wait_values.data(),
+		};
 
-		// We can't start rendering until image_acquired_semaphore is signaled,
-		// meaning the image is ready to be used.
 		VkSubmitInfo submit_info{
 			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &GetCurrentFrame().image_acquired_semaphore,
-			.pWaitDstStageMask = &wait_stage,
+			.pNext = &timeline_info,
+			.waitSemaphoreCount = (uint32_t)wait_semaphores.size(),
+			.pWaitSemaphores = wait_semaphores.data(),
+			.pWaitDstStageMask = wait_stages.data(),
 			.commandBufferCount = 1,
 			.pCommandBuffers = &GetCurrentFrame().command_buffer,
 			.signalSemaphoreCount = 1,
@@ -443,9 +481,7 @@ namespace renderer
 		if (!GetViewportMinimized())
 		{
 			// Ray tracing render pass.
-			if (GetCurrentFrame().tlas) {
-				rt_context_.Render(cmd);
-			}
+			rt_context_.Render(cmd);
 
 			// First raster render pass. Render 3D Viewport.
 			RasterRenderPass(cmd);
@@ -535,34 +571,31 @@ namespace renderer
 
 		vkCmdBeginRendering(cmd, &rendering_info);
 
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, raster_pipeline_.layout, CAMERA_UBO_SET, 1, &GetCurrentFrame().camera_descriptor_set_resource.descriptor_set, 0, nullptr);
-
-		VkDeviceSize zero_offset{ 0 };
+		// Every draw pulls its object data and vertices through these sets, so they're bound once for the whole pass.
+		std::array<VkDescriptorSet, 2> descriptor_sets{
+			GetCurrentFrame().camera_descriptor_set_resource.descriptor_set,
+			GetCurrentFrame().object_data_descriptor_set_resource.descriptor_set,
+		};
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, raster_pipeline_.pipeline);
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, raster_pipeline_.layout, CAMERA_UBO_SET, (uint32_t)descriptor_sets.size(), descriptor_sets.data(), 0, nullptr);
+		vkCmdBindIndexBuffer(cmd, GetCurrentFrame().raster_index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+		uint32_t draw_count{ GetCurrentFrame().raster_draw_count };
+		raster_pass_stats_ = RasterPassStats{
+			.draw_count = draw_count,
+			.bind_count = 3, // The pipeline, both descriptor sets in one call, and the shared index buffer.
+		};
 
-		for (RenderObject* render_obj : GetCurrentFrame().render_objects)
+		// Only split into multiple calls if there are more draws than the device allows in one.
+		for (uint32_t first_draw{ 0 }; first_draw < draw_count; first_draw += max_draw_indirect_count_)
 		{
-			if (!render_obj) {
-				continue;
-			}
-
-			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, raster_pipeline_.pipeline);
-			vkCmdBindDescriptorSets(
+			vkCmdDrawIndexedIndirect(
 				cmd,
-				VK_PIPELINE_BIND_POINT_GRAPHICS,
-				raster_pipeline_.layout,
-				RENDER_OBJECT_UBO_SET,
-				1,
-				&render_obj->ubo_descriptor_set_resource.descriptor_set,
-				0,
-				nullptr);
-
-			for (auto& geometry : meshes_[render_obj->mesh_idx]->geometries)
-			{
-				VkIndexType index_type{ std::is_same<uint32_t, decltype(Geometry::indices)::value_type>::value ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16 };
-				vkCmdBindVertexBuffers(cmd, 0, 1, &geometry.vertices_resource.buffer, &zero_offset);
-				vkCmdBindIndexBuffer(cmd, geometry.indices_resource.buffer, 0, index_type);
-				vkCmdDrawIndexed(cmd, (uint32_t)geometry.indices.size(), 1, 0, 0, 0);
-			}
+				GetCurrentFrame().raster_indirect_buffer.buffer,
+				first_draw * sizeof(VkDrawIndexedIndirectCommand),
+				std::min(draw_count - first_draw, max_draw_indirect_count_),
+				sizeof(VkDrawIndexedIndirectCommand));
+			++raster_pass_stats_.draw_call_count;
 		}
 
 		vkCmdEndRendering(cmd);
@@ -666,7 +699,9 @@ namespace renderer
 		VkResult result{ vkBeginCommandBuffer(cmd, &command_buffer_begin_info) };
 		CheckResult(result, "Failed to begin command buffer.");
 
+		uploader_.CmdAcquire(cmd);
 		BuildTlasAndUpdateBlases(cmd);
+		CmdCopyRasterIndices(cmd);
 
 		TransitionImagesForRender(cmd, image_index);
 		Draw(cmd, image_index);
@@ -896,8 +931,6 @@ namespace renderer
 			delete[] texture_data;
 		}
 
-		VkCommandBuffer cmd{ vulkan_util_.Begin() };
-
 		// Load meshes.
 		uint32_t mesh_idx{ 0 };
 		std::vector<uint32_t> vacant_mesh_indices{};
@@ -930,8 +963,8 @@ namespace renderer
 				index_file.read(reinterpret_cast<char*>(geometry.indices.data()), json_geometry[jsonkey::INDEX_BYTE_SIZE]);
 			}
 
-			UploadMeshToDevice(vulkan_util_, *mesh);
-			rt_context_.QueueBlas(mesh);
+			UploadMeshToDevice(*mesh);
+			rt_context_.QueueBlas(mesh); // Built by the next frame, once the mesh is uploaded.
 		}
 		render_object_destroyer_.SetVacantMeshIndices(std::move(vacant_mesh_indices));
 
@@ -954,16 +987,6 @@ namespace renderer
 			materials_.push_back(material);
 		}
 
-		// Use less fine-grained memory barrier (instead of buffer memory barrier) since there's a buffer for each geometry,
-		// and that would be a lot of pipeline barriers.
-		PipelineBarrier(
-			cmd,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
-
-		rt_context_.CmdBuildQueuedBlases(cmd);
-		vulkan_util_.Submit();
-
 		// Load render objects.
 		for (auto& json_ro : j[jsonkey::RENDER_OBJECTS])
 		{
@@ -994,19 +1017,11 @@ namespace renderer
 	void VulkanRenderer::BuildTlasAndUpdateBlases(VkCommandBuffer cmd)
 	{
 		// Delete the temporary buffers from the last frame.
-		if (GetCurrentFrame().tlas)
-		{
-			vkDestroyAccelerationStructureKHR(context_.device, GetCurrentFrame().tlas->acceleration_structure, nullptr);
-			allocator_.DestroyBufferResource(&GetCurrentFrame().tlas->buffer_resource);
-		}
 		rt_context_.DeleteTemporaryBuffers();
 
-		// TODO: Update any BLASes that need to be updated here.
-
+		CmdCopyDynamicMeshes(cmd);
 		rt_context_.CmdBuildQueuedBlases(cmd);
-		GetCurrentFrame().tlas = rt_context_.QueueTlas(GetCurrentFrame().render_objects);
-		rt_context_.CmdBuildQueuedTlases(cmd);
-		rt_context_.SetTlas(GetCurrentFrame().tlas->acceleration_structure);
+		rt_context_.CmdUpdateTlas(cmd, GetCurrentFrame().render_objects);
 	}
 
 	Mesh* VulkanRenderer::GetMesh(uint32_t mesh_index)
@@ -1080,6 +1095,11 @@ namespace renderer
 		particle_gen_context_.SetPhysicsToRenderMaterialMap(std::move(physics_to_render_mat_idx));
 	}
 
+	void VulkanRenderer::SetFluidSurfaceMaterials(std::vector<uint8_t>&& physics_material_indices)
+	{
+		particle_gen_context_.SetFluidSurfaceMaterials(std::move(physics_material_indices));
+	}
+
 	void VulkanRenderer::UpdatePhysicsRenderMaterials(RenderObjectHandle ro_target)
 	{
 		particle_gen_context_.UpdatePhysicsRenderMaterials(ro_target);
@@ -1152,25 +1172,8 @@ namespace renderer
 		NameObject(context_.device, texture_image->image, "Texture_Image");
 		NameObject(context_.device, texture_image->image_view, "Texture_Image_View");
 
-		vulkan_util_.Begin();
-
-		// Transition image to transfer dst layout.
-		vulkan_util_.PipelineBarrier(
-			texture_image->image,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			0, VK_ACCESS_TRANSFER_WRITE_BIT);
-
-		vulkan_util_.TransferImageToDevice(data, width * height * channels, *texture_image, width, height);
-
-		// Transition image to shader read only, so the texture can be read in shaders.
-		vulkan_util_.PipelineBarrier(
-			texture_image->image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
-
-		vulkan_util_.Submit();
+		// Left shader read only, so the texture can be read in shaders once the frame acquires it.
+		uploader_.UploadImage(data, width * height * channels, *texture_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		textures_.push_back(texture_image);
 
 		rt_context_.UpdateTextureBuffers(textures_);
@@ -1232,36 +1235,25 @@ namespace renderer
 				.mesh_idx = mesh_index,
 				.material_indices = material_indices,
 				.visible = true,
-				.uniform_buffer = {
+				.object_data = {
 					.transform = glm::mat4(1.0f),
 				},
-				.ubo_buffer_resource = allocator_.CreateBufferResource(sizeof(RenderObject::UniformBuffer),
-					VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
-				.ubo_descriptor_set_resource = descriptor_allocator_.CreateDescriptorSetResource(render_object_layout_resource_),
 			} };
-			NameObject(context_.device, render_object->ubo_descriptor_set_resource.descriptor_set, std::string{ "Render_Object_Descriptor_Set_" + std::to_string(render_object->mesh_idx) });
-			NameObject(context_.device, render_object->ubo_buffer_resource.buffer, std::string{ "Render_Object_Buffer_" + std::to_string(render_object->mesh_idx) });
-
-			render_object->ubo_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_UBO_BINDING, render_object->ubo_buffer_resource);
 			frame.render_objects.push_back(render_object);
 		}
 
-		return (RenderObjectHandle)(frame_resources_[0].render_objects.size() - 1);
+		RenderObjectHandle render_object_handle{ (RenderObjectHandle)(frame_resources_[0].render_objects.size() - 1) };
+		QueueObjectDataWrite(render_object_handle);
+		MarkRasterDrawsDirty();
+		return render_object_handle;
 	}
 
 	RenderObjectHandle VulkanRenderer::CreateRenderObjectFromMesh(Mesh* mesh, const std::vector<int>& material_indices)
 	{
 		uint32_t mesh_index{ (uint32_t)meshes_.size() };
 
-		VkCommandBuffer cmd{ vulkan_util_.Begin() };
-		UploadMeshToDevice(vulkan_util_, *mesh);
-		PipelineBarrier(
-			cmd,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+		UploadMeshToDevice(*mesh);
 		rt_context_.QueueBlas(mesh);
-		rt_context_.CmdBuildQueuedBlases(cmd);
-		vulkan_util_.Submit();
 
 		meshes_.push_back(mesh);
 		rt_context_.UpdateObjectBuffers(meshes_);
@@ -1281,20 +1273,111 @@ namespace renderer
 	{
 		ZoneScopedN("Replace render object");
 
-		// Upload mesh and build BLAS.
-		VkCommandBuffer cmd{ vulkan_util_.Begin() };
-		UploadMeshToDevice(vulkan_util_, *mesh);
-		PipelineBarrier(
-			cmd,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
-
-		rt_context_.CmdBuildBlas(cmd, mesh);
-		vulkan_util_.Submit();
+		// Upload mesh, and build its BLAS in the next frame's command buffer.
+		UploadMeshToDevice(*mesh);
+		rt_context_.QueueBlas(mesh);
 
 		ReplaceRenderObject(ro_target, mesh, material_indices);
 	}
 
+	void VulkanRenderer::UpdateDynamicRenderObject(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices)
+	{
+		ZoneScoped;
+		const RenderObject* render_object{ GetCurrentFrame().render_objects[ro_target] };
+		Mesh* target{ render_object ? meshes_[render_object->mesh_idx] : nullptr };
+
+		// Procedural geometries keep their boxes in the vertex buffer, and have no indices.
+		bool procedural{ mesh->procedural };
+		auto vertex_data = [procedural](const Geometry& geometry) -> const void* {
+			return procedural ? (const void*)geometry.aabbs.data() : (const void*)geometry.vertices.data();
+			};
+		auto vertex_bytes = [procedural](const Geometry& geometry) {
+			return procedural ? geometry.aabbs.size() * sizeof(VkAabbPositionsKHR) : geometry.vertices.size() * sizeof(Vertex);
+			};
+
+		// Only meshes from here have a scratch buffer with their BLAS, so anything else is replaced.
+		bool fits{ target && target->blas.scratch_resource.buffer && target->procedural == procedural &&
+			target->geometries.size() == mesh->geometries.size() &&
+			render_object->material_indices == (material_indices.empty() ? std::vector<int>{ 0 } : material_indices) };
+		bool can_refit{ fits };
+		for (uint32_t i{ 0 }; fits && i < (uint32_t)mesh->geometries.size(); ++i)
+		{
+			const Geometry& old_geometry{ target->geometries[i] };
+			const Geometry& new_geometry{ mesh->geometries[i] };
+			fits = vertex_bytes(new_geometry) <= old_geometry.vertices_resource.size &&
+				new_geometry.indices.size() * sizeof(decltype(Geometry::indices)::value_type) <= old_geometry.indices_resource.size;
+			can_refit = can_refit && vertex_bytes(new_geometry) == vertex_bytes(old_geometry) && new_geometry.indices.size() == old_geometry.indices.size();
+		}
+
+		if (fits)
+		{
+			for (uint32_t i{ 0 }; i < (uint32_t)mesh->geometries.size(); ++i)
+			{
+				target->geometries[i].vertices = std::move(mesh->geometries[i].vertices);
+				target->geometries[i].indices = std::move(mesh->geometries[i].indices);
+				target->geometries[i].aabbs = std::move(mesh->geometries[i].aabbs);
+			}
+			delete mesh;
+
+			// Draws use the index counts, which only change if the BLAS can't be refit.
+			if (!can_refit) {
+				MarkRasterDrawsDirty();
+			}
+		}
+		else
+		{
+			// The replaced mesh is only kept alive for the frame still in flight, so drop updates of it queued earlier this frame.
+			if (target && target->blas.scratch_resource.buffer)
+			{
+				rt_context_.DequeueBlas(&target->blas);
+				std::erase_if(GetCurrentFrame().queued_dynamic_mesh_copies, [target](const std::pair<VkBuffer, VkBufferCopy>& copy) {
+					return std::any_of(target->geometries.begin(), target->geometries.end(), [&copy](const Geometry& geometry) {
+						return copy.first == geometry.vertices_resource.buffer || copy.first == geometry.indices_resource.buffer;
+						});
+					});
+			}
+
+			// Round capacities up to a power of two so a growing mesh is only reallocated a few times.
+			std::string mesh_name{ NameMesh(mesh->geometries) };
+			for (Geometry& geometry : mesh->geometries)
+			{
+				VkDeviceSize vertex_size{ procedural ? sizeof(VkAabbPositionsKHR) : sizeof(Vertex) };
+				uint32_t vertex_capacity{ std::bit_ceil(std::max((uint32_t)(vertex_bytes(geometry) / vertex_size), MIN_DYNAMIC_GEOMETRY_CAPACITY)) };
+				geometry.vertices_resource = allocator_.CreateBufferResource(vertex_capacity * vertex_size,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+					VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				NameObject(context_.device, geometry.vertices_resource.buffer, std::string{ mesh_name + "_Dynamic_Vertex_Buffer" });
+
+				if (procedural) {
+					continue;
+				}
+
+				uint32_t index_capacity{ std::bit_ceil(std::max((uint32_t)geometry.indices.size(), MIN_DYNAMIC_GEOMETRY_CAPACITY)) };
+				geometry.indices_resource = allocator_.CreateBufferResource(index_capacity * sizeof(decltype(Geometry::indices)::value_type),
+					VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+					VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+				NameObject(context_.device, geometry.indices_resource.buffer, std::string{ mesh_name + "_Dynamic_Index_Buffer" });
+			}
+
+			rt_context_.CreateDynamicBlas(mesh);
+			ReplaceRenderObject(ro_target, mesh, material_indices);
+			target = mesh;
+			can_refit = false;
+			++dynamic_blas_stats_.grow_count;
+		}
+
+		for (const Geometry& geometry : target->geometries)
+		{
+			QueueDynamicMeshCopy(vertex_data(geometry), vertex_bytes(geometry), geometry.vertices_resource.buffer);
+			QueueDynamicMeshCopy(geometry.indices.data(), geometry.indices.size() * sizeof(decltype(Geometry::indices)::value_type), geometry.indices_resource.buffer);
+		}
+
+		bool refit{ rt_context_.QueueDynamicBlasUpdate(target, can_refit) };
+		if (fits) {
+			++(refit ? dynamic_blas_stats_.refit_count : dynamic_blas_stats_.rebuild_count);
+		}
+	}
+
 	void VulkanRenderer::QueueReplaceRenderObject(RenderObjectHandle ro_target, Mesh* mesh, const std::vector<int>& material_indices)
 	{
 		QueueHostRenderWork([=]()
@@ -1308,6 +1391,7 @@ namespace renderer
 		QueueHostRenderWork([=]()
 			{
 				render_object_destroyer_.DestroyElement((uint32_t)ro_target);
+				particle_gen_context_.ReleaseStaticParticleMesh(ro_target);
 			});
 	}
 
@@ -1319,12 +1403,15 @@ namespace renderer
 			return;
 		}
 
-		render_object->uniform_buffer.transform = transform;
+		if (render_object->object_data.transform == transform) {
+			return;
+		}
+		render_object->object_data.transform = transform;
 
-		void* data{};
-		vkMapMemory(context_.device, *render_object->ubo_buffer_resource.memory, render_object->ubo_buffer_resource.offset, render_object->ubo_buffer_resource.size, 0, &data);
-		memcpy(data, &render_object->uniform_buffer, sizeof(RenderObject::UniformBuffer));
-		vkUnmapMemory(context_.device, *render_object->ubo_buffer_resource.memory);
+		// Objects past the end of the buffer are written when it grows.
+		if (render_object_handle < GetCurrentFrame().object_data_capacity) {
+			WriteObjectData(GetCurrentFrame(), (uint32_t)render_object_handle, 1);
+		}
 	}
 
 	void VulkanRenderer::SetRenderObjectVisible(RenderObjectHandle render_object_handle, bool visible)
@@ -1355,7 +1442,7 @@ namespace renderer
 	void VulkanRenderer::InitializeDescriptorSetLayouts()
 	{
 		VkDescriptorSetLayoutBinding ubo_binding{
-			.binding = RENDER_OBJECT_UBO_BINDING,
+			.binding = CAMERA_UBO_BINDING,
 			.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 			.descriptorCount = 1,
 			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
@@ -1369,8 +1456,25 @@ namespace renderer
 		camera_layout_resource_ = descriptor_allocator_.CreateDescriptorSetLayoutResource(camera_bindings, 0);
 		NameObject(context_.device, camera_layout_resource_.layout, "Camera_Descriptor_Set_Layout");
 
+		VkDescriptorSetLayoutBinding object_data_binding{
+			.binding = RENDER_OBJECT_DATA_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+			.pImmutableSamplers = nullptr,
+		};
+
+		VkDescriptorSetLayoutBinding raster_draw_binding{
+			.binding = RENDER_OBJECT_DRAW_BINDING,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1,
+			.stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+			.pImmutableSamplers = nullptr,
+		};
+
 		std::vector<VkDescriptorSetLayoutBinding> render_object_bindings{
-			ubo_binding,
+			object_data_binding,
+			raster_draw_binding,
 		};
 
 		render_object_layout_resource_ = descriptor_allocator_.CreateDescriptorSetLayoutResource(render_object_bindings, 0);
@@ -1484,6 +1588,32 @@ namespace renderer
 			NameObject(context_.device, resource.camera_descriptor_set_resource.descriptor_set, std::string{ "Camera_Descriptor_Set_" + std::to_string(i) });
 			resource.camera_descriptor_set_resource.LinkBufferToBinding(CAMERA_UBO_BINDING, resource.camera_ubo_buffer);
 
+			// Render object data resources. The buffer is recreated when it runs out of space.
+			resource.object_data_capacity = MIN_OBJECT_DATA_CAPACITY;
+			resource.object_data_buffer = allocator_.CreateMappedBufferResource(resource.object_data_capacity * sizeof(RenderObject::ObjectData),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&resource.object_data_mapped);
+			resource.dirty_object_data_begin = resource.object_data_capacity;
+			resource.dirty_object_data_end = 0;
+			NameObject(context_.device, resource.object_data_buffer.buffer, std::string{ "Object_Data_Buffer_" + std::to_string(i) });
+
+			resource.object_data_descriptor_set_resource = descriptor_allocator_.CreateDescriptorSetResource(render_object_layout_resource_);
+			NameObject(context_.device, resource.object_data_descriptor_set_resource.descriptor_set, std::string{ "Object_Data_Descriptor_Set_" + std::to_string(i) });
+			resource.object_data_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_DATA_BINDING, resource.object_data_buffer);
+
+			// Raster indirect draw resources. Also recreated when they run out of space.
+			resource.raster_draw_capacity = MIN_RASTER_DRAW_CAPACITY;
+			resource.raster_draw_buffer = allocator_.CreateMappedBufferResource(resource.raster_draw_capacity * sizeof(RasterDraw),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&resource.raster_draws_mapped);
+			resource.raster_indirect_buffer = allocator_.CreateMappedBufferResource(resource.raster_draw_capacity * sizeof(VkDrawIndexedIndirectCommand),
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&resource.raster_indirect_mapped);
+			resource.raster_index_capacity = MIN_RASTER_INDEX_CAPACITY;
+			resource.raster_index_buffer = allocator_.CreateBufferResource(resource.raster_index_capacity * sizeof(decltype(Geometry::indices)::value_type),
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			NameObject(context_.device, resource.raster_draw_buffer.buffer, std::string{ "Raster_Draw_Buffer_" + std::to_string(i) });
+			NameObject(context_.device, resource.raster_indirect_buffer.buffer, std::string{ "Raster_Indirect_Buffer_" + std::to_string(i) });
+			NameObject(context_.device, resource.raster_index_buffer.buffer, std::string{ "Raster_Index_Buffer_" + std::to_string(i) });
+			resource.object_data_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_DRAW_BINDING, resource.raster_draw_buffer);
+
 			// Composite image resource. Don't link to binding yet, since we do this when window is resized.
 			resource.composite_descriptor_set_resource = descriptor_allocator_.CreateDescriptorSetResource(composite_layout_resource_);
 			NameObject(context_.device, resource.composite_descriptor_set_resource.descriptor_set, std::string{ "Composite_Descriptor_Set_" + std::to_string(i) });
@@ -1552,8 +1682,6 @@ namespace renderer
 		std::vector<int> duplicate_indices{};
 		duplicate_indices.reserve(model.meshes.size());
 
-		VkCommandBuffer cmd{ vulkan_util_.Begin() };
-
 		// Load meshes.
 		for (tinygltf::Mesh& tinygltf_mesh : model.meshes)
 		{
@@ -1575,7 +1703,7 @@ namespace renderer
 			else
 			{
 				mesh_hash_map_[vertex_hash] = std::pair<uint64_t, uint32_t>{ index_hash, (uint32_t)meshes_.size() };
-				UploadMeshToDevice(vulkan_util_, *mesh);
+				UploadMeshToDevice(*mesh);
 				rt_context_.QueueBlas(mesh);
 				duplicate_indices.push_back(-1); // -1 indicates this mesh has not been loaded before.
 				meshes_.push_back(mesh);
@@ -1602,14 +1730,6 @@ namespace renderer
 			materials_.push_back(new Material{ default_material });
 		}
 
-		PipelineBarrier(
-			cmd,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
-
-		rt_context_.CmdBuildQueuedBlases(cmd);
-		vulkan_util_.Submit();
-
 		rt_context_.UpdateObjectBuffers(meshes_);
 		// We won't update the material buffers until after we've created render objects since we need material indices.
 
@@ -1631,15 +1751,101 @@ namespace renderer
 		particle_gen_context_.UpdateParticleGenShaderCustomUBO(custom_ubo);
 	}
 
-	void VulkanRenderer::GenerateDynamicParticleMesh(RenderObjectHandle ro_target, const std::byte* positions, uint32_t position_count, uint32_t offset, uint32_t stride)
+	uint32_t VulkanRenderer::ValidateParticleGenKernel(ParticleGenKernel kernel, const std::vector<std::byte>& custom_ubo)
 	{
-		// TODO: Properly implement this. Though I don't think this function is ever used actually?
-		MaterialRange tmp{
-			.physics_material_index = 0,
-			.offset = 0,
-			.count = position_count,
-		};
-		particle_gen_context_.GenerateDynamicParticleMesh(ro_target, positions, offset, stride, { tmp });
+		std::vector<Voxel> gpu_voxels{};
+		std::vector<uint8_t> gpu_side_flags{};
+		particle_gen_context_.UpdateParticleGenShaderCustomUBO(custom_ubo);
+		particle_gen_context_.DispatchParticleGenShader(&gpu_voxels, &gpu_side_flags);
+
+		// The particle gen shader is always invoked with the chunk coordinate at the origin.
+		std::vector<Voxel> cpu_voxels{};
+		std::vector<uint8_t> cpu_side_flags{};
+		InvokeParticleGenKernel(kernel, ParticleGenBuiltIns{ .chunk_coordinate = { 0, 0, 0 } }, custom_ubo, &cpu_voxels, &cpu_side_flags);
+
+		uint32_t mismatch_count{ 0 };
+		for (uint32_t i{ 0 }; i < CHUNK_TOTAL_VOXEL_COUNT; ++i)
+		{
+			if (gpu_voxels[i].physics_material_index != cpu_voxels[i].physics_material_index || gpu_side_flags[i] != cpu_side_flags[i]) {
+				++mismatch_count;
+			}
+		}
+		return mismatch_count;
+	}
+
+	void VulkanRenderer::SetParticleGenCacheDirectory(const std::filesystem::path& directory, uint64_t max_size_bytes)
+	{
+		particle_gen_context_.SetParticleGenCacheDirectory(directory, max_size_bytes);
+	}
+
+	const ParticleGenCacheStats& VulkanRenderer::GetParticleGenCacheStats() const
+	{
+		return particle_gen_context_.GetParticleGenCacheStats();
+	}
+
+	const DynamicParticleMeshStats& VulkanRenderer::GetDynamicParticleMeshStats() const
+	{
+		return particle_gen_context_.GetDynamicParticleMeshStats();
+	}
+
+	const TlasBuildStats& VulkanRenderer::GetTlasBuildStats() const
+	{
+		return rt_context_.GetTlasBuildStats();
+	}
+
+	const DynamicBlasStats& VulkanRenderer::GetDynamicBlasStats() const
+	{
+		return dynamic_blas_stats_;
+	}
+
+	const UploaderStats& VulkanRenderer::GetUploaderStats() const
+	{
+		return uploader_.GetStats();
+	}
+
+	std::vector<MemoryHeapStats> VulkanRenderer::GetMemoryHeapStats() const
+	{
+		return allocator_.GetHeapStats();
+	}
+
+	const PipelineCacheStats& VulkanRenderer::GetPipelineCacheStats() const
+	{
+		return pipeline_cache_.GetStats();
+	}
+
+	const RasterPassStats& VulkanRenderer::GetRasterPassStats() const
+	{
+		return raster_pass_stats_;
+	}
+
+	void VulkanRenderer::GenerateDynamicParticleMesh(
+		RenderObjectHandle ro_target,
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t exposed_faces_offset,
+		uint32_t stride,
+		const std::vector<MaterialRange>& mat_ranges)
+	{
+		Mesh* mesh{ particle_gen_context_.BuildDynamicParticleMesh(positions, offset, exposed_faces_offset, stride, mat_ranges) };
+		QueueHostRenderWork([this, ro_target, mesh, mat_ranges]()
+			{
+				particle_gen_context_.UpdateDynamicParticleMesh(ro_target, mesh, mat_ranges);
+			});
+	}
+
+	void VulkanRenderer::GenerateProceduralParticleMesh(
+		RenderObjectHandle ro_target,
+		const std::byte* positions,
+		uint32_t offset,
+		uint32_t exposed_faces_offset,
+		uint32_t stride,
+		const std::vector<MaterialRange>& mat_ranges)
+	{
+		Mesh* mesh{ particle_gen_context_.BuildProceduralParticleMesh(positions, offset, exposed_faces_offset, stride, mat_ranges) };
+		QueueHostRenderWork([this, ro_target, mesh, mat_ranges]()
+			{
+				particle_gen_context_.UpdateDynamicParticleMesh(ro_target, mesh, mat_ranges);
+			});
 	}
 
 	void VulkanRenderer::CmdGenerateDynamicParticleMesh(
@@ -1647,10 +1853,11 @@ namespace renderer
 		const std::byte* positions,
 		uint32_t position_count,
 		uint32_t offset,
+		uint32_t exposed_faces_offset,
 		uint32_t stride,
 		const std::vector<MaterialRange>& mat_ranges)
 	{
-		particle_gen_context_.CmdGenerateDynamicParticleMesh(ro_target, positions, position_count, offset, stride, mat_ranges);
+		particle_gen_context_.CmdGenerateDynamicParticleMesh(ro_target, positions, position_count, offset, exposed_faces_offset, stride, mat_ranges);
 	}
 
 	void VulkanRenderer::GenerateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin)
@@ -1661,19 +1868,45 @@ namespace renderer
 			});
 	}
 
+	void VulkanRenderer::UpdateStaticParticleMesh(RenderObjectHandle ro_target, const VoxelChunk& voxel_chunk, const glm::vec3& object_origin, const glm::uvec3& min_coord, const glm::uvec3& max_coord)
+	{
+		QueueHostRenderWork([this, ro_target, voxel_chunk, object_origin, min_coord, max_coord]()
+			{
+				particle_gen_context_.UpdateStaticParticleMesh(ro_target, voxel_chunk, object_origin, min_coord, max_coord);
+			});
+	}
+
 	void VulkanRenderer::ImportShader(const std::filesystem::path& spirv_path)
 	{
-		ComputePipeline* compute_pipeline{ new ComputePipeline{} };
+		ImportShaders({ spirv_path });
+	}
 
+	void VulkanRenderer::ImportShaders(const std::vector<std::filesystem::path>& spirv_paths)
+	{
 		std::vector<DescriptorSetLayoutResource> compute_layouts{
 			particle_gen_context_.GetParticleGenLayoutResource(),
 		};
 
-		compute_pipeline->Initialize(&context_, compute_layouts, {}, spirv_path);
-		NameObject(context_.device, compute_pipeline->pipeline, "Compute_Pipeline");
-		NameObject(context_.device, compute_pipeline->layout, "Compute_Pipeline_Layout");
+		std::vector<std::function<void()>> create_pipelines{};
+		for (const std::filesystem::path& spirv_path : spirv_paths)
+		{
+			ComputePipeline* compute_pipeline{ new ComputePipeline{} };
+			user_compute_shaders_.push_back(compute_pipeline);
+
+			create_pipelines.push_back([this, compute_pipeline, &compute_layouts, &spirv_path]() {
+				compute_pipeline->Initialize(&context_, compute_layouts, {}, spirv_path);
+				NameObject(context_.device, compute_pipeline->pipeline, "Compute_Pipeline");
+				NameObject(context_.device, compute_pipeline->layout, "Compute_Pipeline_Layout");
+				});
+
+			std::ifstream file{ spirv_path, std::ios::ate | std::ios::binary };
+			std::vector<char> spirv(file.is_open() ? (size_t)file.tellg() : 0);
+			file.seekg(0);
+			file.read(spirv.data(), spirv.size());
+			user_compute_shader_hashes_.push_back(pmkutil::HashBytes(spirv.data(), spirv.size()));
+		}
 
-		user_compute_shaders_.push_back(compute_pipeline);
+		CreatePipelinesInParallel(create_pipelines);
 	}
 
 	void VulkanRenderer::QueueHostRenderWork(std::function<void()> func)
@@ -1711,7 +1944,7 @@ namespace renderer
 		}
 	}
 
-	void VulkanRenderer::UploadMeshToDevice(VulkanUtil& vulkan_util, Mesh& mesh)
+	void VulkanRenderer::UploadMeshToDevice(Mesh& mesh)
 	{
 		for (Geometry& geometry : mesh.geometries)
 		{
@@ -1720,17 +1953,79 @@ namespace renderer
 			geometry.vertices_resource = allocator_.CreateBufferResource(geometry.vertices.size() * sizeof(Vertex),
 				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
 				VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-			vulkan_util.TransferBufferToDevice(geometry.vertices, geometry.vertices_resource);
+			mesh.upload_ticket = uploader_.UploadBuffer(geometry.vertices, geometry.vertices_resource);
 			NameObject(context_.device, geometry.vertices_resource.buffer, std::string{ mesh_name + "_Vertex_Buffer" });
 
 			geometry.indices_resource = allocator_.CreateBufferResource(geometry.indices.size() * sizeof(decltype(Geometry::indices)::value_type),
 				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
-				VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-			vulkan_util.TransferBufferToDevice(geometry.indices, geometry.indices_resource);
+				VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			mesh.upload_ticket = uploader_.UploadBuffer(geometry.indices, geometry.indices_resource);
 			NameObject(context_.device, geometry.indices_resource.buffer, std::string{ mesh_name + "_Index_Buffer" });
 		}
 	}
 
+	void VulkanRenderer::QueueDynamicMeshCopy(const void* data, VkDeviceSize size, VkBuffer dst)
+	{
+		if (size == 0) {
+			return;
+		}
+
+		FrameResources& frame{ GetCurrentFrame() };
+		VkDeviceSize offset{ frame.dynamic_mesh_staging_size };
+		if (offset + size > frame.dynamic_mesh_staging_buffer.size)
+		{
+			// Keep what was already written this frame, since its copies are recorded from the new buffer.
+			BufferResource old_buffer{ frame.dynamic_mesh_staging_buffer };
+			std::byte* old_mapped{ frame.dynamic_mesh_staging_mapped };
+			VkDeviceSize capacity{ std::bit_ceil(std::max(offset + size, MIN_DYNAMIC_MESH_STAGING_SIZE)) };
+
+			frame.dynamic_mesh_staging_buffer = allocator_.CreateMappedBufferResource(capacity,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.dynamic_mesh_staging_mapped);
+			NameObject(context_.device, frame.dynamic_mesh_staging_buffer.buffer, std::string{ "Dynamic_Mesh_Staging_Buffer_" + std::to_string(current_frame_) });
+
+			if (old_mapped) {
+				std::memcpy(frame.dynamic_mesh_staging_mapped, old_mapped, offset);
+			}
+			allocator_.DestroyBufferResource(&old_buffer);
+		}
+
+		std::memcpy(frame.dynamic_mesh_staging_mapped + offset, data, size);
+		frame.queued_dynamic_mesh_copies.emplace_back(dst, VkBufferCopy{
+			.srcOffset = offset,
+			.dstOffset = 0,
+			.size = size,
+		});
+		frame.dynamic_mesh_staging_size = offset + size;
+	}
+
+	void VulkanRenderer::CmdCopyDynamicMeshes(VkCommandBuffer cmd)
+	{
+		FrameResources& frame{ GetCurrentFrame() };
+		if (frame.queued_dynamic_mesh_copies.empty()) {
+			return;
+		}
+
+		allocator_.FlushBufferResource(frame.dynamic_mesh_staging_buffer, 0, frame.dynamic_mesh_staging_size);
+
+		// The other frame in flight may still draw these meshes or build their BLASes, which share scratch buffers, so wait for it first.
+		PipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+			VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+			VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+
+		for (const auto& [dst, region] : frame.queued_dynamic_mesh_copies) {
+			vkCmdCopyBuffer(cmd, frame.dynamic_mesh_staging_buffer.buffer, dst, 1, &region);
+		}
+		frame.queued_dynamic_mesh_copies.clear();
+		frame.dynamic_mesh_staging_size = 0;
+
+		PipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT);
+	}
+
 	void VulkanRenderer::DestroyRenderObject(RenderObject* ro_ptr, bool last_resource)
 	{
 		if (!ro_ptr) {
@@ -1746,9 +2041,8 @@ namespace renderer
 		}
 
 		// Delete this frame's render object.
-		allocator_.DestroyBufferResource(&ro_ptr->ubo_buffer_resource);
-		descriptor_allocator_.FreeDescriptorSet(&ro_ptr->ubo_descriptor_set_resource.descriptor_set);
 		delete ro_ptr;
+		MarkRasterDrawsDirty();
 	}
 
 	void VulkanRenderer::DestroyMesh(uint32_t mesh_idx)
@@ -1758,13 +2052,20 @@ namespace renderer
 			return;
 		}
 
+		// The mesh may be destroyed before its queued BLAS is built, or even before its upload finishes.
+		rt_context_.DequeueBlas(&mesh->blas);
+		uploader_.Wait(mesh->upload_ticket);
+
 		vkDestroyAccelerationStructureKHR(context_.device, mesh->blas.acceleration_structure, nullptr);
 		allocator_.DestroyBufferResource(&mesh->blas.buffer_resource);
+		allocator_.DestroyBufferResource(&mesh->blas.scratch_resource);
 
 		if (!mesh->preserve_geometry_buffers)
 		{
 			for (Geometry& geometry : mesh->geometries)
 			{
+				uploader_.Forget(geometry.vertices_resource.buffer);
+				uploader_.Forget(geometry.indices_resource.buffer);
 				allocator_.DestroyBufferResource(&geometry.vertices_resource);
 				allocator_.DestroyBufferResource(&geometry.indices_resource);
 			}
@@ -1821,16 +2122,10 @@ namespace renderer
 					.mesh_idx = mesh_index,
 					.material_indices = material_indices.empty() ? std::vector<int>{0} : material_indices,
 					.visible = visible,
-					.uniform_buffer = {
+					.object_data = {
 						.transform = glm::mat4(1.0f),
 					},
-					.ubo_buffer_resource = allocator_.CreateBufferResource(sizeof(RenderObject::UniformBuffer),
-						VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT),
-					.ubo_descriptor_set_resource = descriptor_allocator_.CreateDescriptorSetResource(render_object_layout_resource_),
 				} };
-				NameObject(context_.device, render_object->ubo_buffer_resource.buffer, std::string{ "Replaced_Render_Object_Buffer_" + std::to_string(render_object->mesh_idx) });
-				NameObject(context_.device, render_object->ubo_descriptor_set_resource.descriptor_set, std::string{ "Replaced_Descriptor_Set_" + std::to_string(render_object->mesh_idx) });
-				render_object->ubo_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_UBO_BINDING, render_object->ubo_buffer_resource);
 				frame.render_objects[(size_t)ro_target] = render_object;
 			}
 			else {
@@ -1838,9 +2133,225 @@ namespace renderer
 			}
 		}
 
+		if (mesh) {
+			QueueObjectDataWrite(ro_target);
+		}
+		MarkRasterDrawsDirty();
+
 		UpdateMaterials();
 	}
 
+	void VulkanRenderer::QueueObjectDataWrite(RenderObjectHandle render_object_handle)
+	{
+		// Frames still in flight read the old data at this index, so wait until each frame is current to write it.
+		for (auto& frame : frame_resources_) {
+			frame.queued_object_data_writes.push_back((uint32_t)render_object_handle);
+		}
+	}
+
+	void VulkanRenderer::UpdateObjectDataBuffer()
+	{
+		ZoneScoped;
+		FrameResources& frame{ GetCurrentFrame() };
+		uint32_t object_count{ (uint32_t)frame.render_objects.size() };
+
+		if (object_count > frame.object_data_capacity)
+		{
+			while (frame.object_data_capacity < object_count) {
+				frame.object_data_capacity *= 2;
+			}
+
+			allocator_.DestroyBufferResource(&frame.object_data_buffer);
+			frame.object_data_buffer = allocator_.CreateMappedBufferResource(frame.object_data_capacity * sizeof(RenderObject::ObjectData),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.object_data_mapped);
+			NameObject(context_.device, frame.object_data_buffer.buffer, std::string{ "Object_Data_Buffer_" + std::to_string(current_frame_) });
+			frame.object_data_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_DATA_BINDING, frame.object_data_buffer);
+
+			// The new buffer is empty, so write every object instead of only the queued ones.
+			frame.queued_object_data_writes.clear();
+			WriteObjectData(frame, 0, object_count);
+		}
+
+		for (uint32_t object_index : frame.queued_object_data_writes) {
+			WriteObjectData(frame, object_index, 1);
+		}
+		frame.queued_object_data_writes.clear();
+
+		// Flush every object written this frame as one range.
+		if (frame.dirty_object_data_begin < frame.dirty_object_data_end)
+		{
+			allocator_.FlushBufferResource(
+				frame.object_data_buffer,
+				frame.dirty_object_data_begin * sizeof(RenderObject::ObjectData),
+				(frame.dirty_object_data_end - frame.dirty_object_data_begin) * sizeof(RenderObject::ObjectData));
+		}
+		frame.dirty_object_data_begin = frame.object_data_capacity;
+		frame.dirty_object_data_end = 0;
+	}
+
+	void VulkanRenderer::WriteObjectData(FrameResources& frame, uint32_t first, uint32_t count)
+	{
+		if (count == 0) {
+			return;
+		}
+
+		for (uint32_t i{ first }; i < first + count; ++i)
+		{
+			const RenderObject* render_object{ frame.render_objects[i] };
+			frame.object_data_mapped[i] = render_object ? render_object->object_data : RenderObject::ObjectData{ glm::mat4(1.0f) };
+		}
+
+		frame.dirty_object_data_begin = std::min(frame.dirty_object_data_begin, first);
+		frame.dirty_object_data_end = std::max(frame.dirty_object_data_end, first + count);
+	}
+
+	void VulkanRenderer::MarkRasterDrawsDirty()
+	{
+		for (auto& frame : frame_resources_) {
+			frame.raster_draws_dirty = true;
+		}
+	}
+
+	void VulkanRenderer::UpdateRasterDraws()
+	{
+		ZoneScoped;
+		FrameResources& frame{ GetCurrentFrame() };
+		if (!frame.raster_draws_dirty)
+		{
+			// Dynamic geometries were updated in place, so their indices are copied again.
+			frame.raster_index_copies = frame.dynamic_raster_index_copies;
+			return;
+		}
+		frame.raster_draws_dirty = false;
+		frame.raster_index_copies.clear();
+		frame.dynamic_raster_index_copies.clear();
+
+		// Geometries without CPU indices were built on the GPU or are procedural, and aren't rasterized.
+		// Each geometry's indices are copied into the shared index buffer once, however many render objects draw it.
+		uint32_t draw_count{ 0 };
+		uint32_t index_count{ 0 };
+		std::unordered_map<VkBuffer, uint32_t> first_indices{};
+		for (const RenderObject* render_object : frame.render_objects)
+		{
+			if (!render_object) {
+				continue;
+			}
+
+			// Only dynamic meshes have a scratch buffer with their BLAS, see UpdateDynamicRenderObject().
+			const Mesh* mesh{ meshes_[render_object->mesh_idx] };
+			bool dynamic{ mesh->blas.scratch_resource.buffer != VK_NULL_HANDLE };
+			for (const Geometry& geometry : mesh->geometries)
+			{
+				if (geometry.indices.empty()) {
+					continue;
+				}
+
+				++draw_count;
+				if (!first_indices.try_emplace(geometry.indices_resource.buffer, index_count).second) {
+					continue;
+				}
+
+				VkBufferCopy region{
+					.srcOffset = 0,
+					.dstOffset = index_count * sizeof(decltype(Geometry::indices)::value_type),
+					.size = geometry.indices.size() * sizeof(decltype(Geometry::indices)::value_type),
+				};
+				frame.raster_index_copies.emplace_back(geometry.indices_resource.buffer, region);
+				if (dynamic) {
+					frame.dynamic_raster_index_copies.emplace_back(geometry.indices_resource.buffer, region);
+				}
+				index_count += (uint32_t)geometry.indices.size();
+			}
+		}
+
+		if (draw_count > frame.raster_draw_capacity)
+		{
+			while (frame.raster_draw_capacity < draw_count) {
+				frame.raster_draw_capacity *= 2;
+			}
+
+			allocator_.DestroyBufferResource(&frame.raster_draw_buffer);
+			allocator_.DestroyBufferResource(&frame.raster_indirect_buffer);
+			frame.raster_draw_buffer = allocator_.CreateMappedBufferResource(frame.raster_draw_capacity * sizeof(RasterDraw),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.raster_draws_mapped);
+			frame.raster_indirect_buffer = allocator_.CreateMappedBufferResource(frame.raster_draw_capacity * sizeof(VkDrawIndexedIndirectCommand),
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, (void**)&frame.raster_indirect_mapped);
+			NameObject(context_.device, frame.raster_draw_buffer.buffer, std::string{ "Raster_Draw_Buffer_" + std::to_string(current_frame_) });
+			NameObject(context_.device, frame.raster_indirect_buffer.buffer, std::string{ "Raster_Indirect_Buffer_" + std::to_string(current_frame_) });
+			frame.object_data_descriptor_set_resource.LinkBufferToBinding(RENDER_OBJECT_DRAW_BINDING, frame.raster_draw_buffer);
+		}
+
+		if (index_count > frame.raster_index_capacity)
+		{
+			while (frame.raster_index_capacity < index_count) {
+				frame.raster_index_capacity *= 2;
+			}
+
+			allocator_.DestroyBufferResource(&frame.raster_index_buffer);
+			frame.raster_index_buffer = allocator_.CreateBufferResource(frame.raster_index_capacity * sizeof(decltype(Geometry::indices)::value_type),
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			NameObject(context_.device, frame.raster_index_buffer.buffer, std::string{ "Raster_Index_Buffer_" + std::to_string(current_frame_) });
+		}
+
+		// The first instance of each draw is its index, so the vertex shader can find its RasterDraw from gl_InstanceIndex.
+		uint32_t draw_index{ 0 };
+		for (uint32_t i{ 0 }; i < (uint32_t)frame.render_objects.size(); ++i)
+		{
+			const RenderObject* render_object{ frame.render_objects[i] };
+			if (!render_object) {
+				continue;
+			}
+
+			for (const Geometry& geometry : meshes_[render_object->mesh_idx]->geometries)
+			{
+				if (geometry.indices.empty()) {
+					continue;
+				}
+
+				frame.raster_draws_mapped[draw_index] = RasterDraw{
+					.vertices = (uint64_t)DeviceAddress(context_.device, geometry.vertices_resource.buffer),
+					.object_index = i,
+				};
+				frame.raster_indirect_mapped[draw_index] = VkDrawIndexedIndirectCommand{
+					.indexCount = (uint32_t)geometry.indices.size(),
+					.instanceCount = 1,
+					.firstIndex = first_indices.at(geometry.indices_resource.buffer),
+					.vertexOffset = 0,
+					.firstInstance = draw_index,
+				};
+				++draw_index;
+			}
+		}
+		frame.raster_draw_count = draw_count;
+
+		allocator_.FlushBufferResource(frame.raster_draw_buffer, 0, draw_count * sizeof(RasterDraw));
+		allocator_.FlushBufferResource(frame.raster_indirect_buffer, 0, draw_count * sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	void VulkanRenderer::CmdCopyRasterIndices(VkCommandBuffer cmd)
+	{
+		FrameResources& frame{ GetCurrentFrame() };
+		if (frame.raster_index_copies.empty()) {
+			return;
+		}
+
+		// Dynamic index buffers were just written by CmdCopyDynamicMeshes().
+		PipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+		for (const auto& [src, region] : frame.raster_index_copies) {
+			vkCmdCopyBuffer(cmd, src, frame.raster_index_buffer.buffer, 1, &region);
+		}
+		frame.raster_index_copies.clear();
+
+		PipelineBarrier(
+			cmd,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_INDEX_READ_BIT);
+	}
+
 	uint32_t VulkanRenderer::MeshCount() const
 	{
 		return (uint32_t)meshes_.size();
@@ -279,10 +279,11 @@ namespace renderer
 
 	// Stateful ----------------------------------------------------------------------------------------------
 
-	void VulkanUtil::Initialize(Context* context, Allocator* alloc)
+	void VulkanUtil::Initialize(Context* context, Allocator* alloc, Uploader* uploader)
 	{
 		context_ = context;
 		alloc_ = alloc;
+		uploader_ = uploader;
 
 		VkCommandPoolCreateInfo command_pool_info{
 			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
@@ -446,6 +447,10 @@ namespace renderer
 
 		vkBeginCommandBuffer(cmd_, &begin_info);
 
+		// Take ownership of uploaded resources, which Submit() waits on.
+		uploader_->Submit();
+		uploader_->CmdAcquire(cmd_);
+
 		return cmd_;
 	}
 
@@ -453,11 +458,22 @@ namespace renderer
 	{
 		vkEndCommandBuffer(cmd_);
 
+		VkSemaphore upload_semaphore{ uploader_->GetSemaphore() };
+		UploadTicket upload_ticket{ uploader_->GetSubmittedTicket() };
+		VkPipelineStageFlags upload_wait_stage{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+
+		VkTimelineSemaphoreSubmitInfo timeline_info{
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.waitSemaphoreValueCount = 1,
+			.pWaitSemaphoreValues = &upload_ticket,
+		};
+
 		VkSubmitInfo submit_info{
 			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-			.waitSemaphoreCount = 0,
-			.pWaitSemaphores = nullptr,
-			.pWaitDstStageMask = nullptr,
+			.pNext = &timeline_info,
+			.waitSemaphoreCount = 1,
+			.pWaitSemaphores = &upload_semaphore,
+			.pWaitDstStageMask = &upload_wait_stage,
 			.commandBufferCount = 1,
 			.pCommandBuffers = &cmd_,
 			.signalSemaphoreCount = 0,
@@ -11,6 +11,7 @@
 
 #include "logger.h"
 #include "memory_allocator.h"
+#include "uploader.h"
 #include "renderer_types.h"
 #include "renderer_constants.h"
 #include "render_object.h"	
@@ -224,6 +225,7 @@ namespace renderer
 	void PipelineBarrierBigHammer(VkCommandBuffer cmd);
 
 	// Utility object to help with common Vulkan tasks that need a command buffer.
+	// Commands are ordered after everything uploaded by the uploader before Begin().
 	class VulkanUtil
 	{
 	private:
@@ -231,7 +233,7 @@ namespace renderer
 
 	public:
 
-		void Initialize(Context* context, Allocator* alloc);
+		void Initialize(Context* context, Allocator* alloc, Uploader* uploader);
 
 		void TransferBufferToDevice(const void* host_buffer, uint32_t size, BufferResource& device_buffer);
 
@@ -307,6 +309,7 @@ namespace renderer
 
 		Context* context_{};
 		Allocator* alloc_{};
+		Uploader* uploader_{};
 		VkCommandPool command_pool_{};
 		VkCommandBuffer cmd_{};
 		std::vector<BufferResource> destroy_queue_{};   // Staging buffers are destroyed after each submit.
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "chunk_streaming.h"
+
+/*
+* Moves a camera out along a straight path and back again while a ChunkStreamer keeps the chunks around it resident,
+* then reports the worst main thread stall of Update() and the resident memory. Runs without a window or Vulkan device.
+*
+* Fails if a chunk around the final camera position is not resident after the streamer settles, or if a chunk that was
+* evicted to disk and read back differs from the generator output.
+*/
+
+constexpr uint32_t FRAME_COUNT{ 600 };
+constexpr std::chrono::milliseconds FRAME_TIME{ 4 };
+constexpr float CAMERA_SPEED{ 0.5f * CHUNK_WIDTH }; // World units per frame.
+constexpr uint32_t SETTLE_FRAME_LIMIT{ 2000 };
+constexpr uint8_t TERRAIN_MATERIAL_INDEX{ 0 };
+
+// Rolling terrain, so chunks range from full through partially filled to empty.
+static renderer::VoxelChunk GenerateTerrainChunk(const glm::ivec3& chunk_coord)
+{
+	constexpr uint32_t n{ CHUNK_ROW_VOXEL_COUNT };
+	std::vector<renderer::Voxel> voxels(CHUNK_TOTAL_VOXEL_COUNT);
+	for (uint32_t z{ 0 }; z < n; ++z)
+	{
+		for (uint32_t x{ 0 }; x < n; ++x)
+		{
+			glm::vec2 world{ glm::vec2{ chunk_coord.x, chunk_coord.z } * (float)n + glm::vec2{ x, z } };
+			float height{ 24.0f * std::sin(world.x * 0.02f) + 24.0f * std::cos(world.y * 0.015f) };
+			for (uint32_t y{ 0 }; y < n; ++y)
+			{
+				float world_y{ (float)(chunk_coord.y * (int32_t)n + (int32_t)y) };
+				voxels[x + y * n + z * n * n].physics_material_index = (world_y < height) ? TERRAIN_MATERIAL_INDEX : renderer::PHYSICS_MATERIAL_EMPTY_INDEX;
+			}
+		}
+	}
+
+	renderer::VoxelChunk chunk{ n, n, n };
+	chunk.AssignDense(voxels);
+	return chunk;
+}
+
+static bool ChunksEqual(const renderer::VoxelChunk& a, const renderer::VoxelChunk& b)
+{
+	if (a.VoxelCount() != b.VoxelCount()) {
+		return false;
+	}
+
+	for (uint32_t i{ 0 }; i < a.VoxelCount(); ++i)
+	{
+		if (a.Index(i).physics_material_index != b.Index(i).physics_material_index) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	const std::filesystem::path cache_directory{ std::filesystem::temp_directory_path() / "pumpkin_chunk_streaming_benchmark" };
+	std::filesystem::remove_all(cache_directory);
+
+	const pmk::ChunkStreamingSettings settings{
+		.load_radius = 3.0f,
+		.unload_radius = 4.0f,
+		.memory_budget = 256ull * 1024 * 1024,
+		.worker_count = std::max(std::thread::hardware_concurrency() / 2, 1u),
+		.max_integrations_per_update = 4,
+		.cache_directory = cache_directory,
+	};
+
+	pmk::ChunkStreamer streamer{};
+	streamer.Initialize(settings, GenerateTerrainChunk);
+
+	// Out along x for half of the frames, then back to the start so evicted chunks are read from disk.
+	float total_update_time{ 0.0f };
+	size_t peak_resident_bytes{ 0 };
+	glm::vec3 camera_position{ 0.0f };
+	for (uint32_t frame{ 0 }; frame < FRAME_COUNT; ++frame)
+	{
+		camera_position.x += (frame < FRAME_COUNT / 2) ? CAMERA_SPEED : -CAMERA_SPEED;
+		streamer.Update(camera_position);
+
+		total_update_time += streamer.GetStats().last_update_time;
+		peak_resident_bytes = std::max(peak_resident_bytes, streamer.GetStats().resident_bytes);
+		std::this_thread::sleep_for(FRAME_TIME);
+	}
+	const pmk::ChunkStreamingStats path_stats{ streamer.GetStats() };
+
+	// Let the loads around the final position finish.
+	const glm::ivec3 focus_chunk{ pmk::ChunkStreamer::WorldToChunkCoordinate(camera_position) };
+	for (uint32_t frame{ 0 }; frame < SETTLE_FRAME_LIMIT && streamer.GetStats().pending_count > 0; ++frame)
+	{
+		streamer.Update(camera_position);
+		peak_resident_bytes = std::max(peak_resident_bytes, streamer.GetStats().resident_bytes);
+		std::this_thread::sleep_for(FRAME_TIME);
+	}
+
+	bool passed{ true };
+	uint32_t checked_count{ 0 };
+	const glm::vec3 focus{ camera_position / CHUNK_WIDTH };
+	const int32_t radius{ (int32_t)std::ceil(settings.load_radius) };
+	for (int32_t z{ -radius }; z <= radius; ++z)
+	{
+		for (int32_t y{ -radius }; y <= radius; ++y)
+		{
+			for (int32_t x{ -radius }; x <= radius; ++x)
+			{
+				glm::ivec3 chunk_coord{ focus_chunk + glm::ivec3{ x, y, z } };
+				if (glm::distance(glm::vec3{ chunk_coord } + 0.5f, focus) > settings.load_radius) {
+					continue;
+				}
+
+				const renderer::VoxelChunk* chunk{ streamer.GetChunk(chunk_coord) };
+				if (!chunk)
+				{
+					logger::Error("Chunk (%d, %d, %d) near the camera is not resident.\n", chunk_coord.x, chunk_coord.y, chunk_coord.z);
+					passed = false;
+				}
+				else if (!ChunksEqual(*chunk, GenerateTerrainChunk(chunk_coord)))
+				{
+					logger::Error("Chunk (%d, %d, %d) read back from disk differs from the generated chunk.\n", chunk_coord.x, chunk_coord.y, chunk_coord.z);
+					passed = false;
+				}
+				++checked_count;
+			}
+		}
+	}
+
+	logger::Print("Camera path of %u frames, %u worker threads:\n", FRAME_COUNT, settings.worker_count);
+	logger::Print("  Worst Update():         %.3f ms\n", path_stats.worst_update_time * 1000.0f);
+	logger::Print("  Average Update():       %.3f ms\n", total_update_time / FRAME_COUNT * 1000.0f);
+	logger::Print("  Peak resident memory:   %.1f MB of a %.1f MB budget\n", peak_resident_bytes / (1024.0 * 1024.0), settings.memory_budget / (1024.0 * 1024.0));
+	logger::Print("  Resident at end:        %u chunks, %.1f MB\n", streamer.GetStats().resident_count, streamer.GetStats().resident_bytes / (1024.0 * 1024.0));
+	logger::Print("  Evicted to disk:        %u chunks\n", streamer.GetStats().evicted_count);
+	logger::Print("  Checked near camera:    %u chunks, %s\n", checked_count, passed ? "passed" : "FAILED");
+
+	streamer.CleanUp();
+	std::filesystem::remove_all(cache_directory);
+
+	return passed ? 0 : 1;
+}
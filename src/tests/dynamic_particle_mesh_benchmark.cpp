@@ -0,0 +1,102 @@
+#include <chrono>
+#include <bit>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "particle_gen.h"
+
+/*
+* Time of the CPU dynamic particle mesh builder for 100k to 1M particles, with every face exposed and with the faces
+* inside a solid block culled. No Vulkan device is needed since the mesh is only built, not uploaded.
+*
+* Fails if a mesh doesn't have the vertices and indices of one cube face for each exposed face.
+*/
+
+constexpr uint32_t BUILD_REPEAT_COUNT{ 5 };
+constexpr uint8_t PARTICLE_MATERIAL_INDEX{ 0 };
+constexpr float SCATTERED_SPACING{ 2.0f }; // Particles one voxel apart don't touch, so all their faces are exposed.
+
+// Particles in a cube shaped block. Scattered particles have all faces exposed, otherwise only the block's surface faces are.
+static std::vector<renderer::MaterialPosition> MakeParticleBlock(uint32_t particle_count, bool scattered, uint32_t* out_face_count)
+{
+	const uint32_t side{ (uint32_t)std::ceil(std::cbrt((double)particle_count)) };
+	std::vector<renderer::MaterialPosition> particles(particle_count);
+	*out_face_count = 0;
+
+	for (uint32_t i{ 0 }; i < particle_count; ++i)
+	{
+		const glm::uvec3 cell{ i % side, (i / side) % side, i / (side * side) };
+
+		// The last layer may be partial, so a positive side is only covered when the cell next to it is filled.
+		uint8_t exposed_faces{ (uint8_t)renderer::VoxelSidesFlagBits::ALL_SIDES };
+		if (!scattered)
+		{
+			exposed_faces = 0;
+			exposed_faces |= (cell.x == 0) ? (uint8_t)renderer::VoxelSidesFlagBits::X_NEGATIVE : 0;
+			exposed_faces |= (cell.x == side - 1 || i + 1 >= particle_count) ? (uint8_t)renderer::VoxelSidesFlagBits::X_POSITIVE : 0;
+			exposed_faces |= (cell.y == 0) ? (uint8_t)renderer::VoxelSidesFlagBits::Y_NEGATIVE : 0;
+			exposed_faces |= (cell.y == side - 1 || i + side >= particle_count) ? (uint8_t)renderer::VoxelSidesFlagBits::Y_POSITIVE : 0;
+			exposed_faces |= (cell.z == 0) ? (uint8_t)renderer::VoxelSidesFlagBits::Z_NEGATIVE : 0;
+			exposed_faces |= (i + side * side >= particle_count) ? (uint8_t)renderer::VoxelSidesFlagBits::Z_POSITIVE : 0;
+		}
+
+		particles[i] = renderer::MaterialPosition{
+			.physics_material_index = PARTICLE_MATERIAL_INDEX,
+			.exposed_faces = exposed_faces,
+			.position = glm::vec3{ cell } * (scattered ? SCATTERED_SPACING : 1.0f),
+		};
+		*out_face_count += (uint32_t)std::popcount(exposed_faces);
+	}
+
+	return particles;
+}
+
+int main()
+{
+	const std::vector<uint32_t> particle_counts{ 100000, 300000, 1000000 };
+
+	renderer::ParticleGenContext particle_gen_context{};
+	bool passed{ true };
+
+	logger::Print("%-12s %-10s %12s %12s\n", "Particles", "Faces", "Face count", "Best build");
+	for (uint32_t particle_count : particle_counts)
+	{
+		for (bool scattered : { true, false })
+		{
+			uint32_t face_count{};
+			const std::vector<renderer::MaterialPosition> particles{ MakeParticleBlock(particle_count, scattered, &face_count) };
+			const std::vector<renderer::MaterialRange> mat_ranges{ particle_gen_context.CreateMaterialRanges(particles) };
+
+			double best_seconds{ INFINITY };
+			for (uint32_t i{ 0 }; i < BUILD_REPEAT_COUNT; ++i)
+			{
+				auto start{ std::chrono::high_resolution_clock::now() };
+				renderer::Mesh* mesh{ particle_gen_context.BuildDynamicParticleMesh(
+					reinterpret_cast<const std::byte*>(particles.data()),
+					offsetof(renderer::MaterialPosition, position),
+					offsetof(renderer::MaterialPosition, exposed_faces),
+					sizeof(renderer::MaterialPosition),
+					mat_ranges) };
+				best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+
+				const renderer::Geometry& geometry{ mesh->geometries.front() };
+				if (geometry.vertices.size() != (size_t)face_count * renderer::PARTICLE_FACE_VERTEX_COUNT || geometry.indices.size() != (size_t)face_count * renderer::PARTICLE_FACE_INDEX_COUNT)
+				{
+					logger::Error("%u particles with %u exposed faces gave %zu vertices and %zu indices.\n",
+						particle_count, face_count, geometry.vertices.size(), geometry.indices.size());
+					passed = false;
+				}
+				delete mesh;
+			}
+
+			logger::Print("%-12u %-10s %12u %9.1f ms\n", particle_count, scattered ? "all" : "surface", face_count, best_seconds * 1000.0);
+		}
+	}
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
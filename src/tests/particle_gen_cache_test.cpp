@@ -0,0 +1,165 @@
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "particle_gen_cache.h"
+#include "particle_gen_cpu.h"
+
+/*
+* Checks that the particle gen cache returns what was stored for a key, that an entry stored under the same hash by a
+* different key is a miss rather than the wrong voxels, that unreadable entries are dropped, and that the least
+* recently used entries are the ones evicted.
+*/
+
+constexpr uint64_t SHADER_HASH{ 0x1234 };
+constexpr uint32_t EVICTION_KEY_COUNT{ 4 };
+
+static bool Check(bool condition, const char* description)
+{
+	if (!condition) {
+		logger::Error("%s\n", description);
+	}
+	return condition;
+}
+
+template<typename T>
+static std::vector<std::byte> ToBytes(const T& value)
+{
+	std::vector<std::byte> bytes(sizeof(T));
+	std::memcpy(bytes.data(), &value, sizeof(T));
+	return bytes;
+}
+
+static renderer::ParticleGenCacheKey MakeKey(float radius)
+{
+	return renderer::ParticleGenCacheKey{
+		.shader_hash = SHADER_HASH,
+		.built_in_ubo = ToBytes(renderer::ParticleGenBuiltIns{ .chunk_coordinate = { 0, 0, 0 } }),
+		.custom_ubo = ToBytes(renderer::SphereProductParameters{ .radius = radius, .center = { 32.0f, 40.0f, 32.0f } }),
+	};
+}
+
+static std::filesystem::path EntryPath(const std::filesystem::path& directory, const renderer::ParticleGenCacheKey& key)
+{
+	std::ostringstream name{};
+	name << std::hex << key.Hash() << ".pgc";
+	return directory / name.str();
+}
+
+static bool VoxelsEqual(const std::vector<renderer::Voxel>& a, const std::vector<renderer::Voxel>& b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i{ 0 }; i < a.size(); ++i)
+	{
+		if (a[i].physics_material_index != b[i].physics_material_index) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool TestLoadAndCollision(const std::filesystem::path& directory)
+{
+	bool passed{ true };
+	renderer::ParticleGenCache cache{};
+	cache.Initialize(directory, UINT64_MAX);
+
+	const renderer::ParticleGenCacheKey key{ MakeKey(300.0f) };
+	std::vector<renderer::Voxel> voxels{};
+	std::vector<uint8_t> side_flags{};
+	renderer::InvokeParticleGenKernel(renderer::SphereProductKernel, {}, key.custom_ubo, &voxels, &side_flags);
+
+	std::vector<renderer::Voxel> loaded_voxels{};
+	std::vector<uint8_t> loaded_side_flags{};
+	passed &= Check(!cache.Load(key, &loaded_voxels, &loaded_side_flags), "Loaded from an empty cache.");
+	cache.Store(key, voxels);
+	passed &= Check(cache.Load(key, &loaded_voxels, &loaded_side_flags), "Stored entry isn't loaded.");
+	passed &= Check(VoxelsEqual(voxels, loaded_voxels) && side_flags == loaded_side_flags, "Loaded entry differs from what was stored.");
+
+	// Put the entry where a different key would look for it, as if their hashes collided.
+	const renderer::ParticleGenCacheKey colliding_key{ MakeKey(200.0f) };
+	std::filesystem::copy_file(EntryPath(directory, key), EntryPath(directory, colliding_key));
+	cache.Initialize(directory, UINT64_MAX);
+	passed &= Check(!cache.Load(colliding_key, &loaded_voxels, &loaded_side_flags), "Loaded an entry stored by a different key with the same hash.");
+	passed &= Check(std::filesystem::exists(EntryPath(directory, colliding_key)), "Entry of a colliding key was dropped.");
+
+	// Storing the key replaces the other key's entry.
+	std::vector<renderer::Voxel> colliding_voxels{};
+	renderer::InvokeParticleGenKernel(renderer::SphereProductKernel, {}, colliding_key.custom_ubo, &colliding_voxels, &side_flags);
+	cache.Store(colliding_key, colliding_voxels);
+	passed &= Check(cache.Load(colliding_key, &loaded_voxels, &loaded_side_flags) && VoxelsEqual(colliding_voxels, loaded_voxels), "Replaced entry isn't loaded.");
+
+	// Unreadable entries are misses and are removed.
+	std::ofstream{ EntryPath(directory, key), std::ios::out | std::ios::binary | std::ios::trunc } << "not an entry";
+	logger::Print("Expecting an error for an invalid entry:\n");
+	passed &= Check(!cache.Load(key, &loaded_voxels, &loaded_side_flags), "Loaded an invalid entry.");
+	passed &= Check(!std::filesystem::exists(EntryPath(directory, key)), "Invalid entry wasn't removed.");
+	passed &= Check(cache.GetStats().entry_count == 1, "Entry count doesn't match the entries left.");
+
+	return passed;
+}
+
+static bool TestEviction(const std::filesystem::path& directory)
+{
+	bool passed{ true };
+	std::vector<renderer::Voxel> voxels{};
+	std::vector<uint8_t> side_flags{};
+	renderer::InvokeParticleGenKernel(renderer::SphereProductKernel, {}, MakeKey(300.0f).custom_ubo, &voxels, &side_flags);
+
+	// Measure the size of one entry, then make room for all but one.
+	renderer::ParticleGenCache cache{};
+	cache.Initialize(directory, UINT64_MAX);
+	cache.Store(MakeKey(0.0f), voxels);
+	const uint64_t entry_size{ cache.GetStats().size_bytes };
+	std::filesystem::remove_all(directory);
+	cache.Initialize(directory, entry_size * (EVICTION_KEY_COUNT - 1));
+
+	std::vector<renderer::ParticleGenCacheKey> keys{};
+	for (uint32_t i{ 0 }; i < EVICTION_KEY_COUNT; ++i) {
+		keys.push_back(MakeKey((float)i));
+	}
+	for (uint32_t i{ 0 }; i < EVICTION_KEY_COUNT - 1; ++i) {
+		cache.Store(keys[i], voxels);
+	}
+
+	// Using the oldest entry makes the second oldest the one to go.
+	std::vector<renderer::Voxel> loaded_voxels{};
+	passed &= Check(cache.Load(keys[0], &loaded_voxels, &side_flags), "Entry within the size cap isn't loaded.");
+	cache.Store(keys[EVICTION_KEY_COUNT - 1], voxels);
+
+	passed &= Check(!std::filesystem::exists(EntryPath(directory, keys[1])), "Least recently used entry wasn't evicted.");
+	passed &= Check(std::filesystem::exists(EntryPath(directory, keys[0])), "Recently loaded entry was evicted.");
+	passed &= Check(cache.GetStats().entry_count == EVICTION_KEY_COUNT - 1 && cache.GetStats().size_bytes == entry_size * (EVICTION_KEY_COUNT - 1),
+		"Stats don't match the entries left after eviction.");
+
+	// Entries on disk are indexed again by the next session.
+	renderer::ParticleGenCache next_session{};
+	next_session.Initialize(directory, entry_size * (EVICTION_KEY_COUNT - 1));
+	passed &= Check(next_session.GetStats().entry_count == EVICTION_KEY_COUNT - 1, "Entries on disk aren't indexed.");
+	passed &= Check(next_session.Load(keys[EVICTION_KEY_COUNT - 1], &loaded_voxels, &side_flags), "Entry from the last session isn't loaded.");
+
+	return passed;
+}
+
+int main()
+{
+	const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "pumpkin_particle_gen_cache_test" };
+
+	bool passed{ true };
+	std::filesystem::remove_all(directory);
+	passed &= TestLoadAndCollision(directory);
+	std::filesystem::remove_all(directory);
+	passed &= TestEviction(directory);
+	std::filesystem::remove_all(directory);
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "voxel_chunk.h"
+#include "distance_field.h"
+#include "connected_components.h"
+
+/*
+* Runs the voxel side of breaking a rigid body without a window or Vulkan device, the way XPBDRigidBodyContext::RemoveVoxels()
+* does: remove the bar joining two boxes, find the detached box with FindDetachedFragments(), move its voxels into a chunk
+* of its own, and update the distance field of what's left. Then adds the bar back, the way AddVoxels() does.
+*
+* Fails if the fragments aren't the detached box, or if the updated distance field differs from one built from scratch,
+* including its count of allocated bricks.
+*/
+
+constexpr glm::uvec3 CHUNK_DIMENSIONS{ 64, 32, 32 };
+constexpr glm::uvec3 BIG_BOX_MIN{ 0, 4, 4 };
+constexpr glm::uvec3 BIG_BOX_MAX{ 23, 27, 27 };
+constexpr glm::uvec3 BAR_MIN{ 24, 12, 12 };
+constexpr glm::uvec3 BAR_MAX{ 43, 19, 19 };
+constexpr glm::uvec3 SMALL_BOX_MIN{ 44, 8, 8 };
+constexpr glm::uvec3 SMALL_BOX_MAX{ 59, 23, 23 };
+constexpr uint8_t BOX_MATERIAL_INDEX{ 0 };
+constexpr uint8_t BAR_MATERIAL_INDEX{ 1 };
+constexpr float DISTANCE_TOLERANCE{ 1.0e-5f };
+
+static bool Check(bool condition, const char* description)
+{
+	if (!condition) {
+		logger::Error("%s\n", description);
+	}
+	return condition;
+}
+
+static uint32_t BoxVoxelCount(const glm::uvec3& min_coord, const glm::uvec3& max_coord)
+{
+	glm::uvec3 extents{ max_coord - min_coord + 1u };
+	return extents.x * extents.y * extents.z;
+}
+
+static void AddBox(const glm::uvec3& min_coord, const glm::uvec3& max_coord, uint8_t material_index, std::vector<std::pair<renderer::Voxel, glm::uvec3>>* out_voxels)
+{
+	for (uint32_t z{ min_coord.z }; z <= max_coord.z; ++z)
+	{
+		for (uint32_t y{ min_coord.y }; y <= max_coord.y; ++y)
+		{
+			for (uint32_t x{ min_coord.x }; x <= max_coord.x; ++x) {
+				out_voxels->push_back({ renderer::Voxel{ .physics_material_index = material_index }, glm::uvec3{ x, y, z } });
+			}
+		}
+	}
+}
+
+// Compares an updated distance field against one built from scratch at every sample, including the padding.
+static bool FieldMatchesBuild(const renderer::VoxelChunk& voxel_chunk, const pmk::SparseDistanceField& distance_field, const char* description)
+{
+	pmk::SparseDistanceField built{};
+	built.Build(voxel_chunk);
+
+	const glm::ivec3 padding{ (int32_t)pmk::DISTANCE_FIELD_PADDING };
+	const glm::ivec3 end{ glm::ivec3{ voxel_chunk.GetWidth(), voxel_chunk.GetHeight(), voxel_chunk.GetDepth() } + padding };
+	float max_error{ 0.0f };
+	for (int32_t z{ -padding.z }; z < end.z; ++z)
+	{
+		for (int32_t y{ -padding.y }; y < end.y; ++y)
+		{
+			for (int32_t x{ -padding.x }; x < end.x; ++x)
+			{
+				glm::vec3 coord{ x, y, z };
+				max_error = std::max(max_error, std::abs(distance_field.Distance(coord) - built.Distance(coord)));
+			}
+		}
+	}
+
+	if (max_error > DISTANCE_TOLERANCE || distance_field.GetAllocatedBrickCount() != built.GetAllocatedBrickCount())
+	{
+		logger::Error("%s: updated field is off by %f, with %u allocated bricks against %u when built.\n", description,
+			max_error, distance_field.GetAllocatedBrickCount(), built.GetAllocatedBrickCount());
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	bool passed{ true };
+	const renderer::Voxel empty_voxel{ .physics_material_index = renderer::PHYSICS_MATERIAL_EMPTY_INDEX };
+
+	std::vector<std::pair<renderer::Voxel, glm::uvec3>> voxels{};
+	AddBox(BIG_BOX_MIN, BIG_BOX_MAX, BOX_MATERIAL_INDEX, &voxels);
+	AddBox(BAR_MIN, BAR_MAX, BAR_MATERIAL_INDEX, &voxels);
+	AddBox(SMALL_BOX_MIN, SMALL_BOX_MAX, BOX_MATERIAL_INDEX, &voxels);
+	renderer::VoxelChunk voxel_chunk{ CHUNK_DIMENSIONS.x, CHUNK_DIMENSIONS.y, CHUNK_DIMENSIONS.z, std::move(voxels) };
+	pmk::SparseDistanceField distance_field{};
+	distance_field.Build(voxel_chunk);
+	const uint32_t whole_brick_count{ distance_field.GetAllocatedBrickCount() };
+
+	// Remove the bar, seeding the fragment search with the neighbors of the removed voxels.
+	constexpr glm::ivec3 offsets[6]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	auto break_start{ std::chrono::high_resolution_clock::now() };
+	std::vector<glm::uvec3> seeds{};
+	for (uint32_t z{ BAR_MIN.z }; z <= BAR_MAX.z; ++z)
+	{
+		for (uint32_t y{ BAR_MIN.y }; y <= BAR_MAX.y; ++y)
+		{
+			for (uint32_t x{ BAR_MIN.x }; x <= BAR_MAX.x; ++x)
+			{
+				glm::uvec3 coord{ x, y, z };
+				voxel_chunk.SetVoxel(coord, empty_voxel);
+				for (const glm::ivec3& offset : offsets) {
+					seeds.push_back(glm::uvec3{ glm::ivec3{ coord } + offset });
+				}
+			}
+		}
+	}
+
+	// Move each fragment into a chunk of its own, relative to its min extents.
+	std::vector<std::vector<uint32_t>> fragments{ pmk::FindDetachedFragments(voxel_chunk, seeds) };
+	glm::uvec3 min_coord{ BAR_MIN };
+	glm::uvec3 max_coord{ BAR_MAX };
+	std::vector<renderer::VoxelChunk> fragment_chunks{};
+	std::vector<pmk::SparseDistanceField> fragment_fields(fragments.size());
+	for (uint32_t f{ 0 }; f < (uint32_t)fragments.size(); ++f)
+	{
+		std::vector<std::pair<renderer::Voxel, glm::uvec3>> fragment_voxels{};
+		glm::uvec3 fragment_min{ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+		glm::uvec3 fragment_max{};
+		for (uint32_t voxel_idx : fragments[f])
+		{
+			glm::uvec3 coord{ voxel_chunk.IndexToCoordinate(voxel_idx) };
+			fragment_voxels.push_back({ voxel_chunk.Index(voxel_idx), coord });
+			voxel_chunk.SetVoxel(coord, empty_voxel);
+			fragment_min = glm::min(fragment_min, coord);
+			fragment_max = glm::max(fragment_max, coord);
+		}
+
+		for (auto& [voxel, coord] : fragment_voxels) {
+			coord -= fragment_min;
+		}
+		min_coord = glm::min(min_coord, fragment_min);
+		max_coord = glm::max(max_coord, fragment_max);
+
+		glm::uvec3 dimensions{ fragment_max - fragment_min + 1u };
+		fragment_chunks.emplace_back(dimensions.x, dimensions.y, dimensions.z, std::move(fragment_voxels));
+		fragment_fields[f].Build(fragment_chunks.back());
+	}
+
+	voxel_chunk.RebuildOuterVoxels();
+	distance_field.Update(voxel_chunk, min_coord, max_coord);
+	double break_seconds{ std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - break_start).count() };
+
+	passed &= Check(fragments.size() == 1, "Removing the bar didn't detach exactly one fragment.");
+	if (fragments.size() == 1)
+	{
+		const glm::uvec3 small_box_dimensions{ SMALL_BOX_MAX - SMALL_BOX_MIN + 1u };
+		const renderer::VoxelChunk& fragment_chunk{ fragment_chunks[0] };
+		passed &= Check(fragments[0].size() == BoxVoxelCount(SMALL_BOX_MIN, SMALL_BOX_MAX), "The fragment isn't the small box.");
+		passed &= Check(fragment_chunk.GetWidth() == small_box_dimensions.x && fragment_chunk.GetHeight() == small_box_dimensions.y &&
+			fragment_chunk.GetDepth() == small_box_dimensions.z, "The fragment's chunk isn't the size of the small box.");
+		passed &= FieldMatchesBuild(fragment_chunk, fragment_fields[0], "Fragment");
+	}
+	passed &= Check(voxel_chunk.OccupiedVoxelCount() == BoxVoxelCount(BIG_BOX_MIN, BIG_BOX_MAX), "The rigid body isn't left with the big box.");
+	passed &= FieldMatchesBuild(voxel_chunk, distance_field, "After breaking");
+	const uint32_t broken_brick_count{ distance_field.GetAllocatedBrickCount() };
+
+	// Add the bar back. The bricks freed by breaking are reused.
+	for (uint32_t z{ BAR_MIN.z }; z <= BAR_MAX.z; ++z)
+	{
+		for (uint32_t y{ BAR_MIN.y }; y <= BAR_MAX.y; ++y)
+		{
+			for (uint32_t x{ BAR_MIN.x }; x <= BAR_MAX.x; ++x) {
+				voxel_chunk.SetVoxel(glm::uvec3{ x, y, z }, renderer::Voxel{ .physics_material_index = BAR_MATERIAL_INDEX });
+			}
+		}
+	}
+	voxel_chunk.RebuildOuterVoxels();
+	distance_field.Update(voxel_chunk, BAR_MIN, BAR_MAX);
+	passed &= FieldMatchesBuild(voxel_chunk, distance_field, "After adding the bar back");
+
+	auto build_start{ std::chrono::high_resolution_clock::now() };
+	pmk::SparseDistanceField built{};
+	built.Build(voxel_chunk);
+	double build_seconds{ std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - build_start).count() };
+
+	logger::Print("Breaking a %ux%ux%u rigid body in two:\n", CHUNK_DIMENSIONS.x, CHUNK_DIMENSIONS.y, CHUNK_DIMENSIONS.z);
+	logger::Print("  Break event:            %.3f ms, including the fragment's chunk and distance field\n", break_seconds * 1000.0);
+	logger::Print("  Distance field Build(): %.3f ms\n", build_seconds * 1000.0);
+	logger::Print("  Allocated bricks:       %u whole, %u after breaking\n", whole_brick_count, broken_brick_count);
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
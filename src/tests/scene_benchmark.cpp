@@ -0,0 +1,182 @@
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include "volk.h"
+#include "GLFW/glfw3.h"
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "logger.h"
+#include "vulkan_renderer.h"
+
+/*
+* Renders a grid of cubes, 100k by default or the count passed as the first argument, each its own render object,
+* and reports the frame time and the commands recorded by the raster pass. Every MOVING_OBJECT_STRIDE-th cube bobs up
+* and down, so the TLAS is refit most frames, and the GPU time of its builds is reported too. Needs a window and a
+* Vulkan device with ray tracing. Registered as a test that's skipped, by returning SKIP_RETURN_CODE, where there's no
+* display or Vulkan device.
+*/
+
+constexpr uint32_t DEFAULT_OBJECT_COUNT{ 100000 };
+constexpr uint32_t WARM_UP_FRAME_COUNT{ 60 };
+constexpr uint32_t FRAME_COUNT{ 600 };
+constexpr float OBJECT_SPACING{ 3.0f };
+constexpr uint32_t MOVING_OBJECT_STRIDE{ 10 };
+constexpr float BOB_HEIGHT{ 1.0f };
+constexpr uint32_t WINDOW_WIDTH{ 1280 };
+constexpr uint32_t WINDOW_HEIGHT{ 720 };
+constexpr int SKIP_RETURN_CODE{ 77 }; // Matches SKIP_RETURN_CODE of the test in CMakeLists.txt.
+
+// Whether the Vulkan loader finds any physical device, checked before the renderer is initialized since it can't fail gracefully.
+static bool HasVulkanDevice()
+{
+	if (volkInitialize() != VK_SUCCESS) {
+		return false;
+	}
+
+	VkApplicationInfo app_info{
+		.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+		.apiVersion = VK_API_VERSION_1_3,
+	};
+	VkInstanceCreateInfo instance_info{
+		.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+		.pApplicationInfo = &app_info,
+	};
+	VkInstance instance{};
+	if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+		return false;
+	}
+
+	volkLoadInstanceOnly(instance);
+	uint32_t physical_device_count{ 0 };
+	vkEnumeratePhysicalDevices(instance, &physical_device_count, nullptr);
+	vkDestroyInstance(instance, nullptr);
+	return physical_device_count > 0;
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t object_count{ argc > 1 ? (uint32_t)std::stoul(argv[1]) : DEFAULT_OBJECT_COUNT };
+
+	if (glfwInit() != GLFW_TRUE)
+	{
+		logger::Print("Skipping, GLFW couldn't be initialized, such as without a display.\n");
+		return SKIP_RETURN_CODE;
+	}
+	if (!HasVulkanDevice())
+	{
+		logger::Print("Skipping, no Vulkan device.\n");
+		glfwTerminate();
+		return SKIP_RETURN_CODE;
+	}
+
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	GLFWwindow* window{ glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Scene Benchmark", nullptr, nullptr) };
+	if (!window)
+	{
+		logger::Print("Skipping, the window couldn't be created.\n");
+		glfwTerminate();
+		return SKIP_RETURN_CODE;
+	}
+
+	renderer::VulkanRenderer renderer{};
+#ifdef EDITOR_ENABLED
+	renderer.SetImGuiCallbacks(renderer::ImGuiCallbacks{
+		.initialization_callback = [](void*) {},
+		.gui_callback = [](ImTextureID*, void*) {},
+		.user_data = nullptr,
+		});
+#endif
+	renderer.Initialize(window);
+#ifdef EDITOR_ENABLED
+	renderer.SetImGuiViewportSize(renderer::Extent{ WINDOW_WIDTH, WINDOW_HEIGHT });
+#endif
+
+	// Every object shares one cube mesh, so the scene's cost is in the number of objects and not their geometry.
+	renderer::ParticleGenContext particle_gen_context{};
+	renderer::Mesh* cube_mesh{ new renderer::Mesh{} };
+	cube_mesh->geometries.push_back(renderer::Geometry{
+		.vertices = particle_gen_context.GetParticleVertices(),
+		.indices = particle_gen_context.GetParticleIndices(),
+		});
+
+	renderer.CreateDefaultMaterial();
+	const std::vector<int> material_indices{ 0 };
+	std::vector<renderer::RenderObjectHandle> render_objects{ renderer.CreateRenderObjectFromMesh(cube_mesh, material_indices) };
+	const uint32_t cube_mesh_index{ renderer.MeshCount() - 1 };
+	while ((uint32_t)render_objects.size() < object_count) {
+		render_objects.push_back(renderer.CreateRenderObject(cube_mesh_index, material_indices));
+	}
+	renderer.UpdateMaterials();
+
+	const uint32_t side{ (uint32_t)std::ceil(std::cbrt((double)object_count)) };
+	std::vector<glm::mat4> transforms(object_count);
+	for (uint32_t i{ 0 }; i < object_count; ++i) {
+		transforms[i] = glm::translate(glm::mat4{ 1.0f }, glm::vec3{ i % side, (i / side) % side, i / (side * side) } * OBJECT_SPACING);
+	}
+
+	const float grid_width{ side * OBJECT_SPACING };
+	const glm::mat4 view{ glm::lookAt(glm::vec3{ -0.5f, 0.75f, -0.5f } * grid_width, glm::vec3{ 0.5f } * grid_width, glm::vec3{ 0.0f, 1.0f, 0.0f }) };
+	glm::mat4 projection{ glm::perspective(glm::radians(60.0f), WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 4.0f * grid_width) };
+	projection[1][1] *= -1; // Vulkan's y-axis is opposite that of OpenGl's.
+
+	uint32_t measured_frame_count{ 0 };
+	double total_frame_seconds{ 0.0 };
+	double worst_frame_seconds{ 0.0 };
+	double total_tlas_build_ms{ 0.0 };
+	float worst_tlas_build_ms{ 0.0f };
+	uint32_t tlas_refit_count{ 0 };
+	uint64_t written_instance_count{ 0 };
+	auto frame_start{ std::chrono::high_resolution_clock::now() };
+	for (uint32_t frame{ 0 }; frame < WARM_UP_FRAME_COUNT + FRAME_COUNT && !glfwWindowShouldClose(window); ++frame)
+	{
+		glfwPollEvents();
+
+		renderer.WaitForLastFrame();
+		renderer.HostRenderWork();
+		const float bob{ BOB_HEIGHT * std::sin(frame * 0.1f) };
+		for (uint32_t i{ 0 }; i < object_count; ++i)
+		{
+			const glm::mat4 transform{ (i % MOVING_OBJECT_STRIDE == 0) ? glm::translate(transforms[i], glm::vec3{ 0.0f, bob, 0.0f }) : transforms[i] };
+			renderer.SetRenderObjectTransform(render_objects[i], transform);
+		}
+		renderer.SetCameraMatrix(view, projection);
+		renderer.ComputeWork();
+		renderer.Render();
+
+		auto frame_end{ std::chrono::high_resolution_clock::now() };
+		double frame_seconds{ std::chrono::duration<double>(frame_end - frame_start).count() };
+		frame_start = frame_end;
+		if (frame >= WARM_UP_FRAME_COUNT)
+		{
+			++measured_frame_count;
+			total_frame_seconds += frame_seconds;
+			worst_frame_seconds = std::max(worst_frame_seconds, frame_seconds);
+
+			const renderer::TlasBuildStats& tlas_stats{ renderer.GetTlasBuildStats() };
+			total_tlas_build_ms += tlas_stats.build_time_ms;
+			worst_tlas_build_ms = std::max(worst_tlas_build_ms, tlas_stats.build_time_ms);
+			tlas_refit_count += tlas_stats.refit ? 1 : 0;
+			written_instance_count += tlas_stats.written_instance_count;
+		}
+	}
+
+	const renderer::RasterPassStats& raster_stats{ renderer.GetRasterPassStats() };
+	logger::Print("%u render objects over %u frames:\n", object_count, measured_frame_count);
+	logger::Print("  Average frame:      %.3f ms\n", total_frame_seconds / measured_frame_count * 1000.0);
+	logger::Print("  Worst frame:        %.3f ms\n", worst_frame_seconds * 1000.0);
+	logger::Print("  Raster draws:       %u\n", raster_stats.draw_count);
+	logger::Print("  Raster draw calls:  %u\n", raster_stats.draw_call_count);
+	logger::Print("  Raster binds:       %u\n", raster_stats.bind_count);
+	logger::Print("  TLAS instances:     %u, %.0f written per frame\n", renderer.GetTlasBuildStats().instance_count, (double)written_instance_count / measured_frame_count);
+	logger::Print("  TLAS refits:        %u of %u builds\n", tlas_refit_count, measured_frame_count);
+	logger::Print("  Average TLAS build: %.3f ms\n", total_tlas_build_ms / measured_frame_count);
+	logger::Print("  Worst TLAS build:   %.3f ms\n", worst_tlas_build_ms);
+
+	renderer.CleanUp();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
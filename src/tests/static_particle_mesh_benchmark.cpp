@@ -0,0 +1,246 @@
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "renderer_constants.h"
+#include "particle_gen.h"
+#include "particle_gen_cpu.h"
+
+/*
+* Compares the greedy static particle mesher against meshing every exposed face as a cube, which is what static
+* particles fall back to, on the sample_game particle gen chunks and a few synthetic ones. Also prints each chunk's
+* exposed face density and which of the two GenerateStaticParticleMesh() picks for it.
+*
+* Then carves holes in the terrain chunk one at a time, remeshing only the slices around each with Regenerate().
+*
+* Fails if the greedy mesh has more triangles than the cubes for any chunk, or if a regenerated mesh differs from
+* meshing the edited chunk from scratch.
+*/
+
+constexpr uint32_t MESH_REPEAT_COUNT{ 5 };
+constexpr uint8_t SAMPLE_MATERIAL_INDEX{ 0 };
+constexpr float NOISE_FILL_FRACTION{ 0.3f };
+constexpr float RUBBLE_FILL_FRACTION{ 0.5f };
+constexpr glm::uvec3 RIGID_BODY_DIMENSIONS{ 13, 27, 40 };
+constexpr uint32_t HOLE_COUNT{ 20 };
+constexpr uint32_t HOLE_WIDTH{ 6 };
+
+struct SampleChunk
+{
+	std::string name;
+	renderer::VoxelChunk chunk;
+};
+
+static renderer::VoxelChunk MakeChunk(const glm::uvec3& dimensions, const std::function<bool(const glm::uvec3&)>& occupied)
+{
+	std::vector<renderer::Voxel> voxels(dimensions.x * dimensions.y * dimensions.z);
+	for (uint32_t z{ 0 }; z < dimensions.z; ++z)
+	{
+		for (uint32_t y{ 0 }; y < dimensions.y; ++y)
+		{
+			for (uint32_t x{ 0 }; x < dimensions.x; ++x)
+			{
+				voxels[x + y * dimensions.x + z * dimensions.x * dimensions.y].physics_material_index =
+					occupied(glm::uvec3{ x, y, z }) ? SAMPLE_MATERIAL_INDEX : renderer::PHYSICS_MATERIAL_EMPTY_INDEX;
+			}
+		}
+	}
+
+	renderer::VoxelChunk chunk{ dimensions.x, dimensions.y, dimensions.z };
+	chunk.AssignDense(voxels);
+	return chunk;
+}
+
+template<typename T>
+static std::vector<std::byte> MakeCustomUBO(const T& parameters)
+{
+	std::vector<std::byte> custom_ubo(sizeof(T));
+	std::memcpy(custom_ubo.data(), &parameters, sizeof(T));
+	return custom_ubo;
+}
+
+static uint32_t TriangleCount(const renderer::Mesh* mesh)
+{
+	uint32_t triangle_count{ 0 };
+	for (const renderer::Geometry& geometry : mesh->geometries) {
+		triangle_count += (uint32_t)geometry.indices.size() / 3;
+	}
+	return triangle_count;
+}
+
+static bool MeshesEqual(const renderer::Mesh* a, const renderer::Mesh* b, const std::vector<renderer::MaterialRange>& a_ranges, const std::vector<renderer::MaterialRange>& b_ranges)
+{
+	if (!a || !b) {
+		return a == b;
+	}
+	if (a->geometries.size() != b->geometries.size() || a_ranges.size() != b_ranges.size()) {
+		return false;
+	}
+
+	for (size_t i{ 0 }; i < a_ranges.size(); ++i)
+	{
+		if (a_ranges[i].physics_material_index != b_ranges[i].physics_material_index || a_ranges[i].offset != b_ranges[i].offset || a_ranges[i].count != b_ranges[i].count) {
+			return false;
+		}
+	}
+
+	for (size_t g{ 0 }; g < a->geometries.size(); ++g)
+	{
+		const renderer::Geometry& a_geometry{ a->geometries[g] };
+		const renderer::Geometry& b_geometry{ b->geometries[g] };
+		if (a_geometry.indices != b_geometry.indices || a_geometry.vertices.size() != b_geometry.vertices.size()) {
+			return false;
+		}
+		for (size_t v{ 0 }; v < a_geometry.vertices.size(); ++v)
+		{
+			if (a_geometry.vertices[v].position != b_geometry.vertices[v].position || a_geometry.vertices[v].normal != b_geometry.vertices[v].normal) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Best time of meshing the chunk, keeping the triangle count of the last mesh.
+template<typename Func>
+static double BestSeconds(Func&& build_mesh, uint32_t* out_triangle_count)
+{
+	double best_seconds{ INFINITY };
+	for (uint32_t i{ 0 }; i < MESH_REPEAT_COUNT; ++i)
+	{
+		auto start{ std::chrono::high_resolution_clock::now() };
+		renderer::Mesh* mesh{ build_mesh() };
+		best_seconds = std::min(best_seconds, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+
+		*out_triangle_count = mesh ? TriangleCount(mesh) : 0;
+		delete mesh;
+	}
+	return best_seconds;
+}
+
+int main()
+{
+	constexpr uint32_t n{ CHUNK_ROW_VOXEL_COUNT };
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> fill{ 0.0f, 1.0f };
+
+	std::vector<SampleChunk> samples{};
+	samples.push_back(SampleChunk{ "rb.comp", renderer::GenerateKernelChunk(renderer::SphereProductKernel, glm::ivec3{ 0 },
+		MakeCustomUBO(renderer::SphereProductParameters{ .radius = 300.0f, .center = { 32.0f, 40.0f, 32.0f } })) });
+	samples.push_back(SampleChunk{ "particle_gen_cube.comp", renderer::GenerateKernelChunk(renderer::BoxFillKernel, glm::ivec3{ 0 },
+		MakeCustomUBO(renderer::BoxFillParameters{ .radius = 16.0f, .center = { 32.0f, 32.0f, 32.0f } })) });
+	samples.push_back(SampleChunk{ "terrain", MakeChunk(glm::uvec3{ n }, [](const glm::uvec3& c) {
+		return (float)c.y < 32.0f + 12.0f * std::sin(c.x * 0.1f) + 12.0f * std::cos(c.z * 0.08f);
+		}) });
+	samples.push_back(SampleChunk{ "solid", MakeChunk(glm::uvec3{ n }, [](const glm::uvec3&) { return true; }) });
+	samples.push_back(SampleChunk{ "30% noise", MakeChunk(glm::uvec3{ n }, [&](const glm::uvec3&) { return fill(rng) < NOISE_FILL_FRACTION; }) });
+
+	// Small rigid body sized chunks, one smooth and one broken up like rubble so that nearly every voxel is on the surface.
+	auto in_ellipsoid = [](const glm::uvec3& c) {
+		glm::vec3 p{ (glm::vec3{ c } + 0.5f) / glm::vec3{ RIGID_BODY_DIMENSIONS } * 2.0f - 1.0f };
+		return glm::dot(p, p) <= 1.0f;
+		};
+	samples.push_back(SampleChunk{ "ellipsoid 13x27x40", MakeChunk(RIGID_BODY_DIMENSIONS, in_ellipsoid) });
+	samples.push_back(SampleChunk{ "rubble 13x27x40", MakeChunk(RIGID_BODY_DIMENSIONS, [&](const glm::uvec3& c) {
+		return in_ellipsoid(c) && fill(rng) < RUBBLE_FILL_FRACTION;
+		}) });
+
+	renderer::ParticleGenContext particle_gen_context{};
+	bool passed{ true };
+
+	logger::Print("%-24s %8s %8s %12s %10s %12s %10s\n", "Chunk", "Density", "Picks", "Greedy tris", "Greedy", "Cube tris", "Cubes");
+	for (const SampleChunk& sample : samples)
+	{
+		uint32_t greedy_triangle_count{};
+		double greedy_seconds{ BestSeconds([&]() {
+			renderer::StaticParticleMeshGenerator generator{};
+			std::vector<renderer::MaterialRange> mat_ranges{};
+			return generator.Generate(sample.chunk, glm::vec3{ 0.0f }, &mat_ranges);
+			}, &greedy_triangle_count) };
+
+		// Same steps as the cube path of GenerateStaticParticleMesh().
+		uint32_t cube_triangle_count{};
+		double cube_seconds{ BestSeconds([&]() {
+			std::vector<renderer::MaterialPosition> mat_positions{ renderer::VoxelChunkToMaterialPositions(sample.chunk, glm::vec3{ 0.0f }) };
+			std::sort(mat_positions.begin(), mat_positions.end(),
+				[](const renderer::MaterialPosition& p0, const renderer::MaterialPosition& p1) { return p0.physics_material_index < p1.physics_material_index; });
+
+			std::vector<renderer::MaterialRange> mat_ranges{ particle_gen_context.CreateMaterialRanges(mat_positions) };
+			return particle_gen_context.BuildDynamicParticleMesh(
+				reinterpret_cast<const std::byte*>(mat_positions.data()),
+				offsetof(renderer::MaterialPosition, position),
+				offsetof(renderer::MaterialPosition, exposed_faces),
+				sizeof(renderer::MaterialPosition),
+				mat_ranges);
+			}, &cube_triangle_count) };
+
+		if (greedy_triangle_count > cube_triangle_count)
+		{
+			logger::Error("%s has %u greedy triangles, more than its %u cube triangles.\n", sample.name.c_str(), greedy_triangle_count, cube_triangle_count);
+			passed = false;
+		}
+
+		float density{ renderer::ExposedFaceDensity(sample.chunk) };
+		logger::Print("%-24s %8.3f %8s %12u %7.2f ms %12u %7.2f ms\n",
+			sample.name.c_str(), density, density > renderer::STATIC_MESH_MAX_FACE_DENSITY ? "cubes" : "greedy",
+			greedy_triangle_count, greedy_seconds * 1000.0, cube_triangle_count, cube_seconds * 1000.0);
+	}
+
+	// Carve holes in the terrain, like a rigid body being broken, checking each regenerated mesh against a fresh one.
+	renderer::VoxelChunk edited_chunk{ samples[2].chunk };
+	renderer::StaticParticleMeshGenerator regenerator{};
+	std::vector<renderer::MaterialRange> regenerated_ranges{};
+	delete regenerator.Generate(edited_chunk, glm::vec3{ 0.0f }, &regenerated_ranges);
+
+	std::uniform_int_distribution<uint32_t> hole_start{ 0, n - HOLE_WIDTH };
+	const renderer::Voxel empty_voxel{ .physics_material_index = renderer::PHYSICS_MATERIAL_EMPTY_INDEX };
+	double regenerate_seconds{ 0.0 };
+	double generate_seconds{ 0.0 };
+	for (uint32_t hole{ 0 }; hole < HOLE_COUNT; ++hole)
+	{
+		glm::uvec3 min_coord{ hole_start(rng), hole_start(rng), hole_start(rng) };
+		glm::uvec3 max_coord{ min_coord + HOLE_WIDTH - 1u };
+		for (uint32_t z{ min_coord.z }; z <= max_coord.z; ++z)
+		{
+			for (uint32_t y{ min_coord.y }; y <= max_coord.y; ++y)
+			{
+				for (uint32_t x{ min_coord.x }; x <= max_coord.x; ++x) {
+					edited_chunk.SetVoxel(glm::uvec3{ x, y, z }, empty_voxel);
+				}
+			}
+		}
+
+		regenerated_ranges.clear();
+		auto start{ std::chrono::high_resolution_clock::now() };
+		renderer::Mesh* regenerated{ regenerator.Regenerate(edited_chunk, glm::vec3{ 0.0f }, min_coord, max_coord, &regenerated_ranges) };
+		auto middle{ std::chrono::high_resolution_clock::now() };
+		renderer::StaticParticleMeshGenerator generator{};
+		std::vector<renderer::MaterialRange> generated_ranges{};
+		renderer::Mesh* generated{ generator.Generate(edited_chunk, glm::vec3{ 0.0f }, &generated_ranges) };
+		auto end{ std::chrono::high_resolution_clock::now() };
+		regenerate_seconds += std::chrono::duration<double>(middle - start).count();
+		generate_seconds += std::chrono::duration<double>(end - middle).count();
+
+		if (!MeshesEqual(regenerated, generated, regenerated_ranges, generated_ranges))
+		{
+			logger::Error("Regenerated mesh after hole %u differs from meshing the chunk from scratch.\n", hole);
+			passed = false;
+		}
+		delete regenerated;
+		delete generated;
+	}
+	logger::Print("%u holes in terrain: %.2f ms per Regenerate(), %.2f ms per Generate()\n",
+		HOLE_COUNT, regenerate_seconds / HOLE_COUNT * 1000.0, generate_seconds / HOLE_COUNT * 1000.0);
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
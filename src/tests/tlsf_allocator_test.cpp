@@ -0,0 +1,189 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "logger.h"
+#include "common_constants.h"
+#include "tlsf_allocator.h"
+
+/*
+* Checks that TlsfAllocator splits, aligns and merges blocks, that its stats match the blocks it hands out, and that
+* random allocations never overlap and merge back into the whole range once they're all freed.
+*/
+
+constexpr uint64_t RANGE_SIZE{ 1 << 20 };
+constexpr uint32_t RANDOM_STEP_COUNT{ 20000 };
+constexpr uint64_t MAX_RANDOM_SIZE{ 4096 };
+
+struct LiveBlock
+{
+	uint32_t block;
+	uint64_t offset;
+	uint64_t size;
+};
+
+static bool Check(bool condition, const char* description)
+{
+	if (!condition) {
+		logger::Error("%s\n", description);
+	}
+	return condition;
+}
+
+static bool CheckStats(const renderer::TlsfAllocator& allocator, uint64_t used_bytes, uint32_t allocation_count, uint32_t free_block_count, uint64_t largest_free_block, const char* description)
+{
+	const renderer::TlsfStats stats{ allocator.GetStats() };
+	if (stats.used_bytes != used_bytes || stats.free_bytes != allocator.GetSize() - used_bytes || stats.allocation_count != allocation_count ||
+		stats.free_block_count != free_block_count || stats.largest_free_block != largest_free_block)
+	{
+		logger::Error("%s: used %llu, free %llu, %u allocations, %u free blocks, largest %llu.\n", description,
+			(unsigned long long)stats.used_bytes, (unsigned long long)stats.free_bytes, stats.allocation_count, stats.free_block_count,
+			(unsigned long long)stats.largest_free_block);
+		return false;
+	}
+	return true;
+}
+
+static bool TestSplitAndMerge()
+{
+	bool passed{ true };
+	renderer::TlsfAllocator allocator{};
+	allocator.Initialize(1024);
+	passed &= CheckStats(allocator, 0, 0, 1, 1024, "Initialized range");
+
+	// Each allocation splits the front off the free block.
+	uint32_t a{ allocator.Allocate(100, 1) };
+	uint32_t b{ allocator.Allocate(200, 1) };
+	uint32_t c{ allocator.Allocate(300, 1) };
+	passed &= Check(allocator.GetOffset(a) == 0 && allocator.GetOffset(b) == 100 && allocator.GetOffset(c) == 300, "Split blocks aren't packed in order.");
+	passed &= CheckStats(allocator, 600, 3, 1, 424, "After three splits");
+
+	// A block between two allocated blocks stays on its own.
+	allocator.Free(b);
+	passed &= CheckStats(allocator, 400, 2, 2, 424, "After freeing the middle block");
+
+	// Freeing the block before it merges forwards, and the one after it merges with both neighbours.
+	allocator.Free(a);
+	passed &= CheckStats(allocator, 300, 1, 2, 424, "After merging the first two blocks");
+	allocator.Free(c);
+	passed &= CheckStats(allocator, 0, 0, 1, 1024, "After merging everything");
+	passed &= Check(allocator.IsEmpty(), "Allocator isn't empty after freeing every block.");
+
+	// b's handle was recycled when it merged into a, so freeing it again must be rejected without touching the stats.
+	logger::Print("Expecting an error for freeing a merged block:\n");
+	allocator.Free(b);
+	passed &= CheckStats(allocator, 0, 0, 1, 1024, "After freeing a merged block");
+
+	// The whole range is one block again.
+	uint32_t whole{ allocator.Allocate(1024, 1) };
+	passed &= Check(whole != NULL_INDEX && allocator.GetOffset(whole) == 0, "The merged range can't be allocated whole.");
+	passed &= Check(allocator.Allocate(1, 1) == NULL_INDEX, "Allocated from a full range.");
+	passed &= CheckStats(allocator, 1024, 1, 0, 0, "Full range");
+
+	return passed;
+}
+
+static bool TestAlignment()
+{
+	bool passed{ true };
+	renderer::TlsfAllocator allocator{};
+	allocator.Initialize(4096);
+
+	uint32_t a{ allocator.Allocate(100, 1) };
+	uint32_t b{ allocator.Allocate(10, 256) };
+	passed &= Check(allocator.GetOffset(b) == 256, "Aligned block isn't at the next multiple of its alignment.");
+
+	// The padding before the aligned block is left free, along with the tail.
+	passed &= CheckStats(allocator, 110, 2, 2, 4096 - 266, "After an aligned allocation");
+
+	// The padding is in a smaller size class than the tail, so it's picked for allocations that fit in it.
+	uint32_t c{ allocator.Allocate(100, 4) };
+	passed &= Check(allocator.GetOffset(c) == 100, "Padding before an aligned block isn't reused.");
+
+	for (uint64_t alignment : { 1, 3, 16, 64, 1000, 1024 })
+	{
+		uint32_t block{ allocator.Allocate(7, alignment) };
+		passed &= Check(block != NULL_INDEX && allocator.GetOffset(block) % alignment == 0, "Block isn't aligned.");
+	}
+
+	allocator.Free(a);
+	passed &= Check(!allocator.IsEmpty(), "Allocator is empty with blocks still allocated.");
+	allocator.Free(b);
+	allocator.Free(c);
+	return passed;
+}
+
+// Random allocations and frees, checking that live blocks never overlap and that the stats track them.
+static bool TestRandom()
+{
+	bool passed{ true };
+	renderer::TlsfAllocator allocator{};
+	allocator.Initialize(RANGE_SIZE);
+
+	std::mt19937 rng{ 1 };
+	std::uniform_int_distribution<uint64_t> size_distribution{ 1, MAX_RANDOM_SIZE };
+	std::uniform_int_distribution<uint32_t> alignment_shift{ 0, 8 };
+	std::vector<LiveBlock> live_blocks{};
+	uint64_t used_bytes{ 0 };
+
+	for (uint32_t step{ 0 }; step < RANDOM_STEP_COUNT && passed; ++step)
+	{
+		if (live_blocks.empty() || rng() % 3 != 0)
+		{
+			uint64_t size{ size_distribution(rng) };
+			uint64_t alignment{ 1ull << alignment_shift(rng) };
+			uint32_t block{ allocator.Allocate(size, alignment) };
+			if (block == NULL_INDEX) {
+				continue;
+			}
+
+			uint64_t offset{ allocator.GetOffset(block) };
+			passed &= Check(offset % alignment == 0, "Random block isn't aligned.");
+			passed &= Check(offset + size <= RANGE_SIZE, "Random block is past the end of the range.");
+			for (const LiveBlock& live : live_blocks)
+			{
+				if (offset < live.offset + live.size && live.offset < offset + size)
+				{
+					passed &= Check(false, "Random blocks overlap.");
+					break;
+				}
+			}
+
+			used_bytes += size;
+			live_blocks.push_back(LiveBlock{ block, offset, size });
+		}
+		else
+		{
+			size_t index{ rng() % live_blocks.size() };
+			allocator.Free(live_blocks[index].block);
+			used_bytes -= live_blocks[index].size;
+			live_blocks[index] = live_blocks.back();
+			live_blocks.pop_back();
+		}
+
+		const renderer::TlsfStats stats{ allocator.GetStats() };
+		if (stats.used_bytes != used_bytes || stats.allocation_count != live_blocks.size())
+		{
+			logger::Error("Step %u: stats have %llu used bytes in %u allocations, but %llu bytes in %zu blocks are live.\n", step,
+				(unsigned long long)stats.used_bytes, stats.allocation_count, (unsigned long long)used_bytes, live_blocks.size());
+			passed = false;
+		}
+	}
+
+	for (const LiveBlock& live : live_blocks) {
+		allocator.Free(live.block);
+	}
+	passed &= CheckStats(allocator, 0, 0, 1, RANGE_SIZE, "After freeing every random block");
+	return passed;
+}
+
+int main()
+{
+	bool passed{ true };
+	passed &= TestSplitAndMerge();
+	passed &= TestAlignment();
+	passed &= TestRandom();
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "voxel_codec.h"
+#include "particle_gen_cpu.h"
+
+/*
+* Compression ratio and decode throughput of the voxel codec on chunks made by the CPU equivalents of the sample_game
+* particle gen shaders. Decoding into a chunk is compared against the dense decode followed by AssignDense().
+* Round trips and corrupt data are checked by VoxelCodecTest.
+*/
+
+constexpr uint32_t DECODE_REPEAT_COUNT{ 50 };
+
+struct SampleChunk
+{
+	std::string name;
+	renderer::ParticleGenKernel kernel;
+	std::vector<std::byte> custom_ubo;
+};
+
+template<typename T>
+static std::vector<std::byte> MakeCustomUBO(const T& parameters)
+{
+	std::vector<std::byte> custom_ubo(sizeof(T));
+	std::memcpy(custom_ubo.data(), &parameters, sizeof(T));
+	return custom_ubo;
+}
+
+template<typename Func>
+static double SecondsPerCall(Func&& func)
+{
+	auto start{ std::chrono::high_resolution_clock::now() };
+	for (uint32_t i{ 0 }; i < DECODE_REPEAT_COUNT; ++i) {
+		func();
+	}
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() / DECODE_REPEAT_COUNT;
+}
+
+int main()
+{
+	const std::vector<SampleChunk> samples{
+		SampleChunk{ "rb.comp", renderer::SphereProductKernel, MakeCustomUBO(renderer::SphereProductParameters{ .radius = 300.0f, .center = { 32.0f, 40.0f, 32.0f } }) },
+		SampleChunk{ "particle_gen_cube.comp", renderer::BoxFillKernel, MakeCustomUBO(renderer::BoxFillParameters{ .radius = 16.0f, .center = { 32.0f, 32.0f, 32.0f } }) },
+	};
+
+	bool passed{ true };
+	logger::Print("%-24s %10s %10s %8s %14s %14s %14s\n", "Chunk", "Dense", "Encoded", "Ratio", "Decode dense", "Dense+assign", "Decode chunk");
+	for (const SampleChunk& sample : samples)
+	{
+		const renderer::VoxelChunk chunk{ renderer::GenerateKernelChunk(sample.kernel, glm::ivec3{ 0 }, sample.custom_ubo) };
+		const std::vector<uint8_t> data{ renderer::EncodeVoxelChunk(chunk) };
+		const size_t dense_bytes{ (size_t)chunk.VoxelCount() * sizeof(renderer::Voxel) };
+
+		glm::uvec3 dimensions{};
+		std::vector<renderer::Voxel> voxels{};
+		double dense_seconds{ SecondsPerCall([&]() { renderer::DecodeDenseVoxels(data, &dimensions, &voxels); }) };
+
+		renderer::VoxelChunk assigned{};
+		double assign_seconds{ SecondsPerCall([&]() {
+			renderer::DecodeDenseVoxels(data, &dimensions, &voxels);
+			assigned = renderer::VoxelChunk{ dimensions.x, dimensions.y, dimensions.z };
+			assigned.AssignDense(voxels);
+			}) };
+
+		renderer::VoxelChunk decoded{};
+		double chunk_seconds{ SecondsPerCall([&]() { renderer::DecodeVoxelChunk(data, &decoded); }) };
+
+		for (uint32_t i{ 0 }; i < chunk.VoxelCount(); ++i)
+		{
+			if (decoded.Index(i).physics_material_index != chunk.Index(i).physics_material_index)
+			{
+				logger::Error("%s voxel %u differs after decoding.\n", sample.name.c_str(), i);
+				passed = false;
+				break;
+			}
+		}
+
+		logger::Print("%-24s %10zu %10zu %7.1fx %9.2f GB/s %9.2f GB/s %9.2f GB/s\n",
+			sample.name.c_str(), dense_bytes, data.size(), (double)dense_bytes / data.size(),
+			dense_bytes / dense_seconds / 1e9, dense_bytes / assign_seconds / 1e9, dense_bytes / chunk_seconds / 1e9);
+	}
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+#include <vector>
+#include <string>
+#include <random>
+#include <functional>
+#include <cstring>
+#include <cstddef>
+#include "glm/glm.hpp"
+
+#include "logger.h"
+#include "common_constants.h"
+#include "voxel_codec.h"
+
+/*
+* Checks that chunks round trip through the voxel codec with the same voxels, side flags and outer voxels as the original,
+* both into a chunk and into a dense array, and that truncated or corrupt data is rejected instead of decoded.
+*/
+
+constexpr uint32_t MATERIAL_COUNT{ 4 };
+constexpr float NOISE_FILL_FRACTION{ 0.4f };
+
+struct SampleChunk
+{
+	std::string name;
+	renderer::VoxelChunk chunk;
+};
+
+static bool Check(bool condition, const char* description)
+{
+	if (!condition) {
+		logger::Error("%s\n", description);
+	}
+	return condition;
+}
+
+static renderer::VoxelChunk MakeChunk(const glm::uvec3& dimensions, const std::function<uint8_t(const glm::uvec3&)>& material)
+{
+	std::vector<renderer::Voxel> voxels((size_t)dimensions.x * dimensions.y * dimensions.z);
+	for (uint32_t z{ 0 }; z < dimensions.z; ++z)
+	{
+		for (uint32_t y{ 0 }; y < dimensions.y; ++y)
+		{
+			for (uint32_t x{ 0 }; x < dimensions.x; ++x) {
+				voxels[x + y * dimensions.x + z * dimensions.x * dimensions.y].physics_material_index = material(glm::uvec3{ x, y, z });
+			}
+		}
+	}
+
+	renderer::VoxelChunk chunk{ dimensions.x, dimensions.y, dimensions.z };
+	chunk.AssignDense(voxels);
+	return chunk;
+}
+
+static bool ChunksEqual(const renderer::VoxelChunk& a, const renderer::VoxelChunk& b)
+{
+	if (a.GetWidth() != b.GetWidth() || a.GetHeight() != b.GetHeight() || a.GetDepth() != b.GetDepth() ||
+		a.OccupiedVoxelCount() != b.OccupiedVoxelCount() || a.GetOuterVoxels().size() != b.GetOuterVoxels().size())
+	{
+		return false;
+	}
+
+	for (uint32_t i{ 0 }; i < a.VoxelCount(); ++i)
+	{
+		if (a.Index(i).physics_material_index != b.Index(i).physics_material_index || (!a.IsEmpty(i) && a.GetSideFlags(i) != b.GetSideFlags(i))) {
+			return false;
+		}
+	}
+
+	for (size_t i{ 0 }; i < a.GetOuterVoxels().size(); ++i)
+	{
+		if (a.GetOuterVoxels()[i].coord != b.GetOuterVoxels()[i].coord || a.GetOuterVoxels()[i].normal != b.GetOuterVoxels()[i].normal) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool Decodes(const std::vector<uint8_t>& data)
+{
+	glm::uvec3 dimensions{};
+	std::vector<renderer::Voxel> voxels{};
+	renderer::VoxelChunk chunk{};
+	bool dense{ renderer::DecodeDenseVoxels(data, &dimensions, &voxels) };
+	bool bricks{ renderer::DecodeVoxelChunk(data, &chunk) };
+	if (dense != bricks) {
+		logger::Error("Dense and chunk decoding disagree on whether data is valid.\n");
+	}
+	return dense || bricks;
+}
+
+// Overwrite a field of valid data and check that decoding fails.
+template<typename T>
+static bool RejectsCorruptField(std::vector<uint8_t> data, size_t offset, T value, const char* description)
+{
+	std::memcpy(data.data() + offset, &value, sizeof(T));
+	if (Decodes(data))
+	{
+		logger::Error("Decoding data with %s did not fail.\n", description);
+		return false;
+	}
+	return true;
+}
+
+static bool TestRoundTrip(const std::vector<SampleChunk>& samples)
+{
+	bool passed{ true };
+	for (const SampleChunk& sample : samples)
+	{
+		const std::vector<uint8_t> data{ renderer::EncodeVoxelChunk(sample.chunk) };
+
+		renderer::VoxelChunk decoded{};
+		if (!renderer::DecodeVoxelChunk(data, &decoded) || !ChunksEqual(sample.chunk, decoded))
+		{
+			logger::Error("%s differs after decoding into a chunk.\n", sample.name.c_str());
+			passed = false;
+		}
+
+		glm::uvec3 dimensions{};
+		std::vector<renderer::Voxel> voxels{};
+		bool dense_passed{ renderer::DecodeDenseVoxels(data, &dimensions, &voxels) && voxels.size() == sample.chunk.VoxelCount() &&
+			dimensions == glm::uvec3{ sample.chunk.GetWidth(), sample.chunk.GetHeight(), sample.chunk.GetDepth() } };
+		for (uint32_t i{ 0 }; dense_passed && i < sample.chunk.VoxelCount(); ++i) {
+			dense_passed = voxels[i].physics_material_index == sample.chunk.Index(i).physics_material_index;
+		}
+		if (!dense_passed)
+		{
+			logger::Error("%s differs after decoding into a dense array.\n", sample.name.c_str());
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+static bool TestCorruptData(const renderer::VoxelChunk& chunk)
+{
+	bool passed{ true };
+	const std::vector<uint8_t> data{ renderer::EncodeVoxelChunk(chunk) };
+	renderer::VoxelCodecHeader header{};
+	std::memcpy(&header, data.data(), sizeof(header));
+	passed &= Check(Decodes(data), "Valid data doesn't decode.");
+
+	// Every truncation, including ones that cut the header short, and trailing bytes.
+	bool truncated_passed{ true };
+	for (size_t size{ 0 }; size < data.size(); ++size) {
+		truncated_passed &= !Decodes(std::vector<uint8_t>(data.begin(), data.begin() + size));
+	}
+	passed &= Check(truncated_passed, "Decoding truncated data did not fail.");
+	std::vector<uint8_t> extended{ data };
+	extended.push_back(0);
+	passed &= Check(!Decodes(extended), "Decoding data with a trailing byte did not fail.");
+
+	// Headers that would allocate more than a chunk, whose runs don't cover the chunk, or whose sections don't match the size.
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, magic), 0u, "a wrong magic number");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, width), 0u, "a zero width");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, height), CHUNK_ROW_VOXEL_COUNT + 1, "a height over the chunk size");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, depth), UINT32_MAX, "a huge depth");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, depth), header.depth - 1, "runs longer than the voxel count");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, run_count), header.run_count + 1, "a run count past the data");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, run_count), UINT32_MAX, "a huge run count");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, palette_size), (uint16_t)UINT16_MAX, "a huge palette");
+	passed &= RejectsCorruptField(data, offsetof(renderer::VoxelCodecHeader, index_bits), (uint8_t)9, "indices wider than a material");
+
+	// A run length that no longer adds up to the voxel count, and a palette index past the palette.
+	const size_t run_lengths_offset{ sizeof(header) + header.palette_size * sizeof(renderer::Voxel) };
+	const size_t indices_offset{ run_lengths_offset + header.run_count * sizeof(uint16_t) };
+	passed &= RejectsCorruptField(data, run_lengths_offset, (uint16_t)0, "a zero run length");
+	passed &= Check((1u << header.index_bits) > header.palette_size, "Test chunk's palette fills its index bits.");
+	passed &= RejectsCorruptField(data, indices_offset, UINT64_MAX, "palette indices past the palette");
+
+	// Runs that don't cover the chunk leave it empty instead of writing past it.
+	logger::Print("Expecting an error for runs that don't cover the chunk:\n");
+	renderer::VoxelChunk short_chunk{ 8, 8, 8 };
+	short_chunk.AssignRuns({ { renderer::Voxel{ .physics_material_index = 0 }, 1000 } });
+	passed &= Check(short_chunk.OccupiedVoxelCount() == 0, "Runs past the end of the chunk were assigned.");
+
+	return passed;
+}
+
+int main()
+{
+	constexpr uint32_t n{ CHUNK_ROW_VOXEL_COUNT };
+	std::mt19937 rng{ 1 };
+	std::uniform_real_distribution<float> fill{ 0.0f, 1.0f };
+	std::uniform_int_distribution<uint32_t> material{ 0, MATERIAL_COUNT - 1 };
+	auto noise = [&](const glm::uvec3&) {
+		return fill(rng) < NOISE_FILL_FRACTION ? (uint8_t)material(rng) : renderer::PHYSICS_MATERIAL_EMPTY_INDEX;
+		};
+
+	// Runs longer than the codec's maximum run length, dimensions that don't fill whole bricks, and runs across rows.
+	std::vector<SampleChunk> samples{};
+	samples.push_back(SampleChunk{ "empty", MakeChunk(glm::uvec3{ n }, [](const glm::uvec3&) { return renderer::PHYSICS_MATERIAL_EMPTY_INDEX; }) });
+	samples.push_back(SampleChunk{ "solid", MakeChunk(glm::uvec3{ n }, [](const glm::uvec3&) { return (uint8_t)0; }) });
+	samples.push_back(SampleChunk{ "single voxel", MakeChunk(glm::uvec3{ 1 }, [](const glm::uvec3&) { return (uint8_t)2; }) });
+	samples.push_back(SampleChunk{ "layers", MakeChunk(glm::uvec3{ n }, [](const glm::uvec3& c) {
+		return c.y < 20 ? (uint8_t)(c.y / 5) : renderer::PHYSICS_MATERIAL_EMPTY_INDEX;
+		}) });
+	samples.push_back(SampleChunk{ "noise 13x27x40", MakeChunk(glm::uvec3{ 13, 27, 40 }, noise) });
+	samples.push_back(SampleChunk{ "noise 64x64x64", MakeChunk(glm::uvec3{ n }, noise) });
+
+	bool passed{ true };
+	passed &= TestRoundTrip(samples);
+	passed &= TestCorruptData(samples[4].chunk);
+
+	logger::Print("%s\n", passed ? "Passed" : "FAILED");
+	return passed ? 0 : 1;
+}